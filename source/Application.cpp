@@ -10,10 +10,14 @@
  */
 
 #include <filesystem>
+#include <set>
+#include <sstream>
 
 #include "Application.h"
 #include "Arguments.h"
 #include "Defaults.h"
+#include "JsonFile.h"
+#include "JsonWriter.h"
 #include "Logger.h"
 #include "SQLiteDatabase.h"
 
@@ -36,6 +40,8 @@ Application::Application(const string &name,
   appInstance = this;
 
   m_arguments = std::make_shared<Arguments>(args);
+  configRecordTypes(Arguments::Key::Types, m_recordTypes);
+  configRecordTypes(Arguments::Key::JsonTypes, m_jsonTypes);
 
   if (m_arguments->hasFor(Arguments::Key::Init)) {
     if (m_arguments->hasFor(Arguments::Key::DatabasePath)) {
@@ -46,11 +52,58 @@ Application::Application(const string &name,
       }
     }
     if (m_arguments->hasFor(Arguments::Key::JsonPath)) {
-      if (std::filesystem::exists(m_arguments->getFor(Arguments::Key::JsonPath)) &&
-          (m_arguments->getFor(Arguments::Key::JsonPath) != "/dev/null")) {
-        logWarn() << "Removing existing json output file: "
-                  << m_arguments->getFor(Arguments::Key::JsonPath);
-        std::filesystem::remove(m_arguments->getFor(Arguments::Key::JsonPath));
+      const auto jsonPath = m_arguments->getFor(Arguments::Key::JsonPath);
+      if ((jsonPath != "stdout") && (jsonPath != "/dev/null")) {
+        JsonFile::removeFiles(jsonPath);
+      }
+    }
+    if (m_arguments->hasFor(Arguments::Key::MsgPackPath)) {
+      if (std::filesystem::exists(m_arguments->getFor(Arguments::Key::MsgPackPath)) &&
+          (m_arguments->getFor(Arguments::Key::MsgPackPath) != "/dev/null")) {
+        logWarn() << "Removing existing MessagePack output file: "
+                  << m_arguments->getFor(Arguments::Key::MsgPackPath);
+        std::filesystem::remove(m_arguments->getFor(Arguments::Key::MsgPackPath));
+      }
+    }
+    if (m_arguments->hasFor(Arguments::Key::CapturePath)) {
+      if (std::filesystem::exists(m_arguments->getFor(Arguments::Key::CapturePath)) &&
+          (m_arguments->getFor(Arguments::Key::CapturePath) != "/dev/null")) {
+        logWarn() << "Removing existing capture file: "
+                  << m_arguments->getFor(Arguments::Key::CapturePath);
+        std::filesystem::remove(m_arguments->getFor(Arguments::Key::CapturePath));
+      }
+      // The sparse index of the removed capture, see CaptureIndex
+      std::error_code ec;
+      std::filesystem::remove(m_arguments->getFor(Arguments::Key::CapturePath) + ".idx", ec);
+    }
+    if (m_arguments->hasFor(Arguments::Key::ColumnPath)) {
+      const auto columnPath = m_arguments->getFor(Arguments::Key::ColumnPath);
+      std::error_code ec;
+      for (const auto &entry : std::filesystem::directory_iterator(columnPath, ec)) {
+        if (entry.path().extension() == ".col") {
+          logWarn() << "Removing existing column file: " << entry.path().string();
+          std::filesystem::remove(entry.path());
+        }
+      }
+    }
+    if (m_arguments->hasFor(Arguments::Key::SeriesPath)) {
+      const auto seriesPath = m_arguments->getFor(Arguments::Key::SeriesPath) + "/" +
+                              m_arguments->getFor(Arguments::Key::Name) + ".tks";
+      if (std::filesystem::exists(seriesPath)) {
+        logWarn() << "Removing existing series file: " << seriesPath;
+        std::filesystem::remove(seriesPath);
+      }
+    }
+    if (m_arguments->hasFor(Arguments::Key::StorePath)) {
+      const auto storePath = m_arguments->getFor(Arguments::Key::StorePath);
+      std::error_code ec;
+      for (const auto &entry : std::filesystem::directory_iterator(storePath, ec)) {
+        const auto extension = entry.path().extension();
+        if ((extension == ".seg") || (extension == ".open") || (extension == ".tmp") ||
+            (extension == ".arc")) {
+          logWarn() << "Removing existing segment file: " << entry.path().string();
+          std::filesystem::remove(entry.path());
+        }
       }
     }
   }
@@ -65,12 +118,49 @@ Application::Application(const string &name,
     }
   }
 
+  if (m_arguments->hasFor(Arguments::Key::ReplayPath)) {
+    double speed = 0;
+    try {
+      speed = std::stod(m_arguments->getFor(Arguments::Key::ReplaySpeed));
+    } catch (const std::exception &e) {
+      logWarn() << "Cannot convert replay speed. Replay as fast as possible";
+    }
+    m_replay = std::make_shared<Replay>(m_arguments->getFor(Arguments::Key::ReplayPath), speed);
+  }
+
+  if (m_arguments->hasFor(Arguments::Key::LivePath)) {
+    m_liveServer = std::make_shared<LiveServer>(m_arguments->getFor(Arguments::Key::LivePath));
+    m_liveServer->enableEvents();
+  }
+
   m_connection = std::make_shared<Connection>();
+  m_requestTimeout = std::stoul(tkmDefaults.getFor(Defaults::Default::RequestTimeout));
 
   m_dispatcher = std::make_unique<Dispatcher>();
   m_dispatcher->enableEvents();
 }
 
+void Application::configRecordTypes(Arguments::Key key,
+                                    std::set<tkm::msg::monitor::Data_What> &types)
+{
+  // Both selections default to all
+  if (m_arguments->getFor(key) == tkmDefaults.getFor(Defaults::Default::Types)) {
+    return;
+  }
+
+  std::stringstream typeStream(m_arguments->getFor(key));
+  std::string typeName;
+
+  while (std::getline(typeStream, typeName, ',')) {
+    tkm::msg::monitor::Data_What what;
+    if (tkm::msg::monitor::Data_What_Parse(typeName, &what)) {
+      types.insert(what);
+    } else {
+      logWarn() << "Unknown data type: " << typeName;
+    }
+  }
+}
+
 void Application::resetConnection()
 {
   resetInactivityTimer(0);
@@ -79,10 +169,10 @@ void Application::resetConnection()
 
 void Application::printVerbose(const std::string &msg)
 {
-  std::time_t t = std::time(nullptr);
-  std::tm tm = *std::localtime(&t);
-
   if (verboseEnabled) {
+    std::time_t t = std::time(nullptr);
+    std::tm tm = *std::localtime(&t);
+
     std::cout << std::put_time(&tm, "%H:%M:%S") << " " << msg << std::endl;
   }
 }
@@ -104,404 +194,367 @@ void Application::requestStartupData(void)
   getConnection()->writeEnvelope(requestEnvelope);
 }
 
-void Application::startUpdateLanes(void)
+void Application::startUpdateScheduler(void)
 {
-  m_fastLaneTimer = std::make_shared<Timer>("FastLaneTimer", [this]() {
-    m_dataSources.foreach ([](const std::shared_ptr<DataSource> &entry) {
-      if ((entry->getUpdateLane() == DataSource::UpdateLane::Fast) ||
-          (entry->getUpdateLane() == DataSource::UpdateLane::Any)) {
-        entry->update();
-      }
-    });
-    return true;
-  });
+  auto resolution = std::stoul(tkmDefaults.getFor(Defaults::Default::SchedulerResolution));
 
-  m_paceLaneTimer = std::make_shared<Timer>("PaceLaneTimer", [this]() {
+  m_scheduler = std::make_shared<Scheduler>(
+      resolution,
+      [this](const std::vector<std::shared_ptr<DataSource>> &due) { requestDataSources(due); });
+
+  configDataSources();
+
+  m_dataSources.foreach (
+      [this](const std::shared_ptr<DataSource> &entry) { m_scheduler->schedule(entry); });
+  m_scheduler->enableEvents();
+
+  m_statsTimer = std::make_shared<Timer>("StatsTimer", [this]() {
     m_dataSources.foreach ([](const std::shared_ptr<DataSource> &entry) {
-      if ((entry->getUpdateLane() == DataSource::UpdateLane::Pace) ||
-          (entry->getUpdateLane() == DataSource::UpdateLane::Any)) {
-        entry->update();
-      }
+      logInfo() << "Stats " << entry->getStats();
     });
+    logInfo() << "Stats backlog=" << getBacklog() << " throttle_level=" << m_backlogLevel
+              << " throttle_changes=" << m_backlogChanges;
+    m_backlogChanges = 0;
+    if (JsonWriter::getInstance()->isEnabled()) {
+      logInfo() << "Stats " << JsonWriter::getInstance()->getStats();
+    }
     return true;
   });
+  m_statsTimer->start(std::stoul(tkmDefaults.getFor(Defaults::Default::StatsInterval)), true);
+  addEventSource(m_statsTimer);
 
-  m_slowLaneTimer = std::make_shared<Timer>("SlowLaneTimer", [this]() {
-    m_dataSources.foreach ([](const std::shared_ptr<DataSource> &entry) {
-      if ((entry->getUpdateLane() == DataSource::UpdateLane::Slow) ||
-          (entry->getUpdateLane() == DataSource::UpdateLane::Any)) {
-        entry->update();
-      }
-    });
+  m_backlogLevel = 0;
+  m_backlogCalmCount = 0;
+  m_backlogTimer = std::make_shared<Timer>("BacklogTimer", [this]() {
+    updateBacklogLevel();
     return true;
   });
-
-  configUpdateLanes();
-
-  m_fastLaneTimer->start(getSessionInfo().fast_lane_interval(), true);
-  m_paceLaneTimer->start(getSessionInfo().pace_lane_interval(), true);
-  m_slowLaneTimer->start(getSessionInfo().slow_lane_interval(), true);
-
-  addEventSource(m_fastLaneTimer);
-  addEventSource(m_paceLaneTimer);
-  addEventSource(m_slowLaneTimer);
+  m_backlogTimer->start(std::stoul(tkmDefaults.getFor(Defaults::Default::BacklogInterval)), true);
+  addEventSource(m_backlogTimer);
+
+  if (m_arguments->hasFor(Arguments::Key::BurstRules)) {
+    uint64_t intervalMs = 0;
+
+    // Checked against BurstMinInterval on the command line
+    if (Arguments::toNumber(m_arguments->getFor(Arguments::Key::BurstInterval), intervalMs)) {
+      m_burstSampler = std::make_shared<BurstSampler>(
+          m_arguments->getFor(Arguments::Key::BurstRules),
+          m_arguments->getFor(Arguments::Key::BurstSources),
+          intervalMs * 1000); // msec 2 usec
+    } else {
+      logWarn() << "Invalid burst interval, burst sampling disabled";
+    }
+  }
 }
 
-void Application::stopUpdateLanes(void)
+void Application::stopUpdateScheduler(void)
 {
-  if (m_fastLaneTimer != nullptr) {
-    m_fastLaneTimer->stop();
-    remEventSource(m_fastLaneTimer);
-    m_fastLaneTimer.reset();
+  if (m_scheduler != nullptr) {
+    m_scheduler->disableEvents();
+    m_scheduler.reset();
   }
 
-  if (m_paceLaneTimer != nullptr) {
-    m_paceLaneTimer->stop();
-    remEventSource(m_paceLaneTimer);
-    m_paceLaneTimer.reset();
+  if (m_statsTimer != nullptr) {
+    m_statsTimer->stop();
+    remEventSource(m_statsTimer);
+    m_statsTimer.reset();
   }
 
-  if (m_slowLaneTimer != nullptr) {
-    m_slowLaneTimer->stop();
-    remEventSource(m_slowLaneTimer);
-    m_slowLaneTimer.reset();
+  if (m_backlogTimer != nullptr) {
+    m_backlogTimer->stop();
+    remEventSource(m_backlogTimer);
+    m_backlogTimer.reset();
+  }
+
+  if (m_burstSampler != nullptr) {
+    m_burstSampler->stop();
+    m_burstSampler.reset();
   }
 }
 
-void Application::configUpdateLanes(void)
+void Application::setBurstInterval(const std::set<std::string> &sources, uint64_t intervalUs)
 {
-  const auto procAcctUpdateCallback = [this]() {
-    tkm::msg::Envelope requestEnvelope;
-    tkm::msg::collector::Request requestMessage;
-
-    App()->printVerbose("Request ProcAcct");
-    logInfo() << "Request ProcAcct data to " << App()->getDeviceData().name();
-
-    requestMessage.set_id("GetProcAcct");
-    requestMessage.set_type(tkm::msg::collector::Request_Type_GetProcAcct);
-    requestEnvelope.mutable_mesg()->PackFrom(requestMessage);
-    requestEnvelope.set_target(tkm::msg::Envelope_Recipient_Monitor);
-    requestEnvelope.set_origin(tkm::msg::Envelope_Recipient_Collector);
-
-    return getConnection()->writeEnvelope(requestEnvelope);
-  };
-
-  const auto procInfoUpdateCallback = [this]() -> bool {
-    tkm::msg::Envelope requestEnvelope;
-    tkm::msg::collector::Request requestMessage;
-
-    App()->printVerbose("Request ProcInfo");
-    logInfo() << "Request ProcInfo data to " << App()->getDeviceData().name();
-
-    requestMessage.set_id("GetProcInfo");
-    requestMessage.set_type(tkm::msg::collector::Request_Type_GetProcInfo);
-    requestEnvelope.mutable_mesg()->PackFrom(requestMessage);
-    requestEnvelope.set_target(tkm::msg::Envelope_Recipient_Monitor);
-    requestEnvelope.set_origin(tkm::msg::Envelope_Recipient_Collector);
-
-    return getConnection()->writeEnvelope(requestEnvelope);
-  };
-
-  const auto contextInfoUpdateCallback = [this]() {
-    tkm::msg::Envelope requestEnvelope;
-    tkm::msg::collector::Request requestMessage;
-
-    App()->printVerbose("Request ContextInfo");
-    logInfo() << "Request ContextInfo data to " << App()->getDeviceData().name();
-
-    requestMessage.set_id("GetContextInfo");
-    requestMessage.set_type(tkm::msg::collector::Request_Type_GetContextInfo);
-    requestEnvelope.mutable_mesg()->PackFrom(requestMessage);
-    requestEnvelope.set_target(tkm::msg::Envelope_Recipient_Monitor);
-    requestEnvelope.set_origin(tkm::msg::Envelope_Recipient_Collector);
-
-    return getConnection()->writeEnvelope(requestEnvelope);
-  };
-
-  const auto procEventUpdateCallback = [this]() {
-    tkm::msg::Envelope requestEnvelope;
-    tkm::msg::collector::Request requestMessage;
-
-    App()->printVerbose("Request ProcEvent");
-    logInfo() << "Request ProcEvent data to " << App()->getDeviceData().name();
-
-    requestMessage.set_id("GetProcEvent");
-    requestMessage.set_type(tkm::msg::collector::Request_Type_GetProcEventStats);
-    requestEnvelope.mutable_mesg()->PackFrom(requestMessage);
-    requestEnvelope.set_target(tkm::msg::Envelope_Recipient_Monitor);
-    requestEnvelope.set_origin(tkm::msg::Envelope_Recipient_Collector);
-
-    return getConnection()->writeEnvelope(requestEnvelope);
-  };
-
-  const auto sysProcStatUpdateCallback = [this]() {
-    tkm::msg::Envelope requestEnvelope;
-    tkm::msg::collector::Request requestMessage;
-
-    App()->printVerbose("Request SysProcStat");
-    logInfo() << "Request SysProcStat data to " << App()->getDeviceData().name();
-
-    requestMessage.set_id("GetSysProcStat");
-    requestMessage.set_type(tkm::msg::collector::Request_Type_GetSysProcStat);
-    requestEnvelope.mutable_mesg()->PackFrom(requestMessage);
-    requestEnvelope.set_target(tkm::msg::Envelope_Recipient_Monitor);
-    requestEnvelope.set_origin(tkm::msg::Envelope_Recipient_Collector);
-
-    return getConnection()->writeEnvelope(requestEnvelope);
-  };
-
-  const auto sysProcBuddyInfoUpdateCallback = [this]() {
-    tkm::msg::Envelope requestEnvelope;
-    tkm::msg::collector::Request requestMessage;
-
-    App()->printVerbose("Request SysProcBuddyInfo");
-    logInfo() << "Request SysProcBuddyInfo data to " << App()->getDeviceData().name();
+  m_dataSources.foreach ([this, &sources, intervalUs](const std::shared_ptr<DataSource> &entry) {
+    if (sources.count(entry->getName()) == 0) {
+      return;
+    }
 
-    requestMessage.set_id("GetSysProcBuddyInfo");
-    requestMessage.set_type(tkm::msg::collector::Request_Type_GetSysProcBuddyInfo);
-    requestEnvelope.mutable_mesg()->PackFrom(requestMessage);
-    requestEnvelope.set_target(tkm::msg::Envelope_Recipient_Monitor);
-    requestEnvelope.set_origin(tkm::msg::Envelope_Recipient_Collector);
+    entry->setBurstInterval(intervalUs);
+    logInfo() << "Data source " << entry->getName() << " interval=" << entry->getInterval();
 
-    return getConnection()->writeEnvelope(requestEnvelope);
-  };
+    // Apply the new interval now, a burst starts with an immediate request
+    if (m_scheduler != nullptr) {
+      m_scheduler->reschedule(entry, (intervalUs > 0) ? 0 : entry->getInterval());
+    }
+  });
+}
 
-  const auto sysProcWirelessUpdateCallback = [this]() {
-    tkm::msg::Envelope requestEnvelope;
-    tkm::msg::collector::Request requestMessage;
+auto Application::getBacklog(void) -> size_t
+{
+  size_t backlog = m_dispatcher->getQueueDepth();
 
-    App()->printVerbose("Request SysProcWireless");
-    logInfo() << "Request SysProcWireless data to " << App()->getDeviceData().name();
+  if (m_database != nullptr) {
+    backlog += m_database->getQueueDepth();
+  }
 
-    requestMessage.set_id("GetSysProcWireless");
-    requestMessage.set_type(tkm::msg::collector::Request_Type_GetSysProcWireless);
-    requestEnvelope.mutable_mesg()->PackFrom(requestMessage);
-    requestEnvelope.set_target(tkm::msg::Envelope_Recipient_Monitor);
-    requestEnvelope.set_origin(tkm::msg::Envelope_Recipient_Collector);
+  return backlog;
+}
 
-    return getConnection()->writeEnvelope(requestEnvelope);
-  };
+void Application::updateBacklogLevel(void)
+{
+  static const size_t highMark = std::stoul(tkmDefaults.getFor(Defaults::Default::BacklogHighMark));
+  static const size_t lowMark = std::stoul(tkmDefaults.getFor(Defaults::Default::BacklogLowMark));
+  static const size_t maxLevel = std::stoul(tkmDefaults.getFor(Defaults::Default::BacklogMaxLevel));
+  static const size_t calmChecks = 3;
+
+  auto backlog = getBacklog();
+  auto level = m_backlogLevel;
+
+  // Each check above the high mark doubles the intervals of expensive sources.
+  // Intervals are restored one level at a time only after the backlog stays
+  // below the low mark for several consecutive checks.
+  if (backlog > highMark) {
+    m_backlogCalmCount = 0;
+    if (level < maxLevel) {
+      level++;
+    }
+  } else if ((backlog < lowMark) && (level > 0)) {
+    if (++m_backlogCalmCount >= calmChecks) {
+      m_backlogCalmCount = 0;
+      level--;
+    }
+  } else {
+    m_backlogCalmCount = 0;
+  }
 
-  const auto sysProcMemInfoUpdateCallback = [this]() {
-    tkm::msg::Envelope requestEnvelope;
-    tkm::msg::collector::Request requestMessage;
+  if (level == m_backlogLevel) {
+    return;
+  }
 
-    App()->printVerbose("Request SysProcMemInfo");
-    logInfo() << "Request SysProcMemInfo data to " << App()->getDeviceData().name();
+  logWarn() << "Reader backlog " << backlog << " changed throttle level " << m_backlogLevel
+            << " -> " << level;
+  printVerbose("Reader backlog " + std::to_string(backlog) + " changed throttle level to " +
+               std::to_string(level));
 
-    requestMessage.set_id("GetSysProcMemInfo");
-    requestMessage.set_type(tkm::msg::collector::Request_Type_GetSysProcMemInfo);
-    requestEnvelope.mutable_mesg()->PackFrom(requestMessage);
-    requestEnvelope.set_target(tkm::msg::Envelope_Recipient_Monitor);
-    requestEnvelope.set_origin(tkm::msg::Envelope_Recipient_Collector);
+  m_backlogLevel = level;
+  m_backlogChanges++;
 
-    return getConnection()->writeEnvelope(requestEnvelope);
-  };
+  m_dataSources.foreach ([level](const std::shared_ptr<DataSource> &entry) {
+    if (entry->isThrottled()) {
+      entry->setStretch(1UL << level);
+      logInfo() << "Data source " << entry->getName() << " interval=" << entry->getInterval();
+    }
+  });
+}
 
-  const auto sysProcDiskStatsUpdateCallback = [this]() {
-    tkm::msg::Envelope requestEnvelope;
-    tkm::msg::collector::Request requestMessage;
+void Application::setDataReplied(tkm::msg::monitor::Data_What what)
+{
+  m_dataSources.foreach ([what](const std::shared_ptr<DataSource> &entry) {
+    if (entry->getDataType() == what) {
+      entry->setReplied();
+    }
+  });
+}
 
-    App()->printVerbose("Request SysProcDiskStats");
-    logInfo() << "Request SysProcDiskStats data to " << App()->getDeviceData().name();
+void Application::setStatusReplied(const std::string &requestId)
+{
+  m_dataSources.foreach ([&requestId](const std::shared_ptr<DataSource> &entry) {
+    if (entry->getRequestId() == requestId) {
+      entry->setReplied();
+    }
+  });
+}
 
-    requestMessage.set_id("GetSysProcDiskStats");
-    requestMessage.set_type(tkm::msg::collector::Request_Type_GetSysProcDiskStats);
-    requestEnvelope.mutable_mesg()->PackFrom(requestMessage);
-    requestEnvelope.set_target(tkm::msg::Envelope_Recipient_Monitor);
-    requestEnvelope.set_origin(tkm::msg::Envelope_Recipient_Collector);
+void Application::requestDataSources(const std::vector<std::shared_ptr<DataSource>> &sources)
+{
+  auto connection = m_connection;
+  size_t count = 0;
 
-    return getConnection()->writeEnvelope(requestEnvelope);
-  };
+  if (connection == nullptr) {
+    return;
+  }
 
-  const auto sysProcPressureUpdateCallback = [this]() -> bool {
-    tkm::msg::Envelope requestEnvelope;
-    tkm::msg::collector::Request requestMessage;
+  // All requests due in this tick go out with a single writer flush
+  for (const auto &entry : sources) {
+    if (!entry->canRequest(std::max(entry->getInterval(), m_requestTimeout))) {
+      logDebug() << "Skip " << entry->getName() << " request, previous request pending";
+      continue;
+    }
 
-    App()->printVerbose("Request SysProcPressure");
-    logInfo() << "Request SysProcPressure data to " << App()->getDeviceData().name();
+    printVerbose("Request " + entry->getName());
+    if (connection->queueEnvelope(entry->getRequest())) {
+      entry->setRequested();
+      count++;
+    } else {
+      logWarn() << "Failed to queue " << entry->getName() << " request";
+    }
+  }
 
-    requestMessage.set_id("GetSysProcPressure");
-    requestMessage.set_type(tkm::msg::collector::Request_Type_GetSysProcPressure);
-    requestEnvelope.mutable_mesg()->PackFrom(requestMessage);
-    requestEnvelope.set_target(tkm::msg::Envelope_Recipient_Monitor);
-    requestEnvelope.set_origin(tkm::msg::Envelope_Recipient_Collector);
+  if (count > 0) {
+    logDebug() << "Request " << count << " data sources from " << getDeviceData().name();
+    connection->flushEnvelopes();
+  }
+}
 
-    return getConnection()->writeEnvelope(requestEnvelope);
-  };
+static auto parseIntervals(const std::string &intervals) -> std::map<std::string, uint64_t>
+{
+  std::map<std::string, uint64_t> overrides;
+  std::stringstream stream(intervals);
+  std::string item;
 
-  const auto sysProcVMStatUpdateCallback = [this]() -> bool {
-    tkm::msg::Envelope requestEnvelope;
-    tkm::msg::collector::Request requestMessage;
+  while (std::getline(stream, item, ',')) {
+    auto pos = item.find('=');
 
-    App()->printVerbose("Request SysProcVMStat");
-    logInfo() << "Request SysProcVMStat data to " << App()->getDeviceData().name();
+    if (pos == std::string::npos) {
+      logWarn() << "Invalid data source interval override: " << item;
+      continue;
+    }
 
-    requestMessage.set_id("GetSysProcVMStat");
-    requestMessage.set_type(tkm::msg::collector::Request_Type_GetSysProcVMStat);
-    requestEnvelope.mutable_mesg()->PackFrom(requestMessage);
-    requestEnvelope.set_target(tkm::msg::Envelope_Recipient_Monitor);
-    requestEnvelope.set_origin(tkm::msg::Envelope_Recipient_Collector);
+    try {
+      overrides[item.substr(0, pos)] = std::stoul(item.substr(pos + 1)) * 1000; // msec 2 usec
+    } catch (const std::exception &e) {
+      logWarn() << "Invalid data source interval override: " << item;
+    }
+  }
 
-    return getConnection()->writeEnvelope(requestEnvelope);
-  };
+  return overrides;
+}
 
-  // Clear the existing list
-  m_dataSources.foreach (
-      [this](const std::shared_ptr<DataSource> &entry) { m_dataSources.remove(entry); });
-  m_dataSources.commit();
+void Application::configDataSources(void)
+{
+  std::vector<std::shared_ptr<DataSource>> sources;
 
-  for (const auto &dataSourceType : m_sessionInfo.fast_lane_sources()) {
+  const auto addDataSource = [&sources](int dataSourceType, uint64_t interval) {
     switch (dataSourceType) {
     case msg::monitor::SessionInfo_DataSource_ProcInfo:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "ProcInfo", DataSource::UpdateLane::Fast, procInfoUpdateCallback));
+      sources.push_back(std::make_shared<DataSource>("ProcInfo",
+                                                     interval,
+                                                     "GetProcInfo",
+                                                     tkm::msg::collector::Request_Type_GetProcInfo,
+                                                     tkm::msg::monitor::Data_What_ProcInfo));
       break;
     case msg::monitor::SessionInfo_DataSource_ProcAcct:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "ProcAcct", DataSource::UpdateLane::Fast, procAcctUpdateCallback));
+      sources.push_back(std::make_shared<DataSource>("ProcAcct",
+                                                     interval,
+                                                     "GetProcAcct",
+                                                     tkm::msg::collector::Request_Type_GetProcAcct,
+                                                     tkm::msg::monitor::Data_What_ProcAcct));
       break;
     case msg::monitor::SessionInfo_DataSource_ProcEvent:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "ProcEvent", DataSource::UpdateLane::Fast, procEventUpdateCallback));
+      sources.push_back(
+          std::make_shared<DataSource>("ProcEvent",
+                                       interval,
+                                       "GetProcEvent",
+                                       tkm::msg::collector::Request_Type_GetProcEventStats,
+                                       tkm::msg::monitor::Data_What_ProcEvent));
       break;
     case msg::monitor::SessionInfo_DataSource_ContextInfo:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "ContextInfo", DataSource::UpdateLane::Fast, contextInfoUpdateCallback));
+      sources.push_back(
+          std::make_shared<DataSource>("ContextInfo",
+                                       interval,
+                                       "GetContextInfo",
+                                       tkm::msg::collector::Request_Type_GetContextInfo,
+                                       tkm::msg::monitor::Data_What_ContextInfo));
       break;
     case msg::monitor::SessionInfo_DataSource_SysProcStat:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcStat", DataSource::UpdateLane::Fast, sysProcStatUpdateCallback));
+      sources.push_back(
+          std::make_shared<DataSource>("SysProcStat",
+                                       interval,
+                                       "GetSysProcStat",
+                                       tkm::msg::collector::Request_Type_GetSysProcStat,
+                                       tkm::msg::monitor::Data_What_SysProcStat));
       break;
     case msg::monitor::SessionInfo_DataSource_SysProcBuddyInfo:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcBuddyInfo", DataSource::UpdateLane::Fast, sysProcBuddyInfoUpdateCallback));
+      sources.push_back(
+          std::make_shared<DataSource>("SysProcBuddyInfo",
+                                       interval,
+                                       "GetSysProcBuddyInfo",
+                                       tkm::msg::collector::Request_Type_GetSysProcBuddyInfo,
+                                       tkm::msg::monitor::Data_What_SysProcBuddyInfo));
       break;
     case msg::monitor::SessionInfo_DataSource_SysProcWireless:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcWireless", DataSource::UpdateLane::Fast, sysProcWirelessUpdateCallback));
+      sources.push_back(
+          std::make_shared<DataSource>("SysProcWireless",
+                                       interval,
+                                       "GetSysProcWireless",
+                                       tkm::msg::collector::Request_Type_GetSysProcWireless,
+                                       tkm::msg::monitor::Data_What_SysProcWireless));
       break;
     case msg::monitor::SessionInfo_DataSource_SysProcMemInfo:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcMemInfo", DataSource::UpdateLane::Fast, sysProcMemInfoUpdateCallback));
+      sources.push_back(
+          std::make_shared<DataSource>("SysProcMemInfo",
+                                       interval,
+                                       "GetSysProcMemInfo",
+                                       tkm::msg::collector::Request_Type_GetSysProcMemInfo,
+                                       tkm::msg::monitor::Data_What_SysProcMemInfo));
       break;
     case msg::monitor::SessionInfo_DataSource_SysProcPressure:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcPressure", DataSource::UpdateLane::Fast, sysProcPressureUpdateCallback));
+      sources.push_back(
+          std::make_shared<DataSource>("SysProcPressure",
+                                       interval,
+                                       "GetSysProcPressure",
+                                       tkm::msg::collector::Request_Type_GetSysProcPressure,
+                                       tkm::msg::monitor::Data_What_SysProcPressure));
       break;
     case msg::monitor::SessionInfo_DataSource_SysProcDiskStats:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcDiskStats", DataSource::UpdateLane::Fast, sysProcDiskStatsUpdateCallback));
+      sources.push_back(
+          std::make_shared<DataSource>("SysProcDiskStats",
+                                       interval,
+                                       "GetSysProcDiskStats",
+                                       tkm::msg::collector::Request_Type_GetSysProcDiskStats,
+                                       tkm::msg::monitor::Data_What_SysProcDiskStats));
       break;
     case msg::monitor::SessionInfo_DataSource_SysProcVMStat:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcVMStat", DataSource::UpdateLane::Fast, sysProcVMStatUpdateCallback));
+      sources.push_back(
+          std::make_shared<DataSource>("SysProcVMStat",
+                                       interval,
+                                       "GetSysProcVMStat",
+                                       tkm::msg::collector::Request_Type_GetSysProcVMStat,
+                                       tkm::msg::monitor::Data_What_SysProcVMStat));
       break;
     default:
       break;
     }
-  }
+  };
+
+  // Clear the existing list
+  m_dataSources.foreach (
+      [this](const std::shared_ptr<DataSource> &entry) { m_dataSources.remove(entry); });
+  m_dataSources.commit();
 
+  // Monitor lanes provide the default interval for each data source
+  for (const auto &dataSourceType : m_sessionInfo.fast_lane_sources()) {
+    addDataSource(dataSourceType, m_sessionInfo.fast_lane_interval());
+  }
   for (const auto &dataSourceType : m_sessionInfo.pace_lane_sources()) {
-    switch (dataSourceType) {
-    case msg::monitor::SessionInfo_DataSource_ProcInfo:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "ProcInfo", DataSource::UpdateLane::Pace, procInfoUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_ProcAcct:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "ProcAcct", DataSource::UpdateLane::Pace, procAcctUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_ProcEvent:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "ProcEvent", DataSource::UpdateLane::Pace, procEventUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_ContextInfo:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "ContextInfo", DataSource::UpdateLane::Pace, contextInfoUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_SysProcStat:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcStat", DataSource::UpdateLane::Pace, sysProcStatUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_SysProcBuddyInfo:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcBuddyInfo", DataSource::UpdateLane::Pace, sysProcBuddyInfoUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_SysProcWireless:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcWireless", DataSource::UpdateLane::Pace, sysProcWirelessUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_SysProcMemInfo:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcMemInfo", DataSource::UpdateLane::Pace, sysProcMemInfoUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_SysProcPressure:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcPressure", DataSource::UpdateLane::Pace, sysProcPressureUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_SysProcDiskStats:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcDiskStats", DataSource::UpdateLane::Pace, sysProcDiskStatsUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_SysProcVMStat:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcVMStat", DataSource::UpdateLane::Pace, sysProcVMStatUpdateCallback));
-      break;
-    default:
-      break;
-    }
+    addDataSource(dataSourceType, m_sessionInfo.pace_lane_interval());
   }
-
   for (const auto &dataSourceType : m_sessionInfo.slow_lane_sources()) {
-    switch (dataSourceType) {
-    case msg::monitor::SessionInfo_DataSource_ProcInfo:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "ProcInfo", DataSource::UpdateLane::Slow, procInfoUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_ProcAcct:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "ProcAcct", DataSource::UpdateLane::Slow, procAcctUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_ProcEvent:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "ProcEvent", DataSource::UpdateLane::Slow, procEventUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_ContextInfo:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "ContextInfo", DataSource::UpdateLane::Slow, contextInfoUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_SysProcStat:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcStat", DataSource::UpdateLane::Slow, sysProcStatUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_SysProcBuddyInfo:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcBuddyInfo", DataSource::UpdateLane::Slow, sysProcBuddyInfoUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_SysProcWireless:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcWireless", DataSource::UpdateLane::Slow, sysProcWirelessUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_SysProcMemInfo:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcMemInfo", DataSource::UpdateLane::Slow, sysProcMemInfoUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_SysProcPressure:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcPressure", DataSource::UpdateLane::Slow, sysProcPressureUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_SysProcDiskStats:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcDiskStats", DataSource::UpdateLane::Slow, sysProcDiskStatsUpdateCallback));
-      break;
-    case msg::monitor::SessionInfo_DataSource_SysProcVMStat:
-      m_dataSources.append(std::make_shared<DataSource>(
-          "SysProcVMStat", DataSource::UpdateLane::Slow, sysProcVMStatUpdateCallback));
-      break;
-    default:
-      break;
+    addDataSource(dataSourceType, m_sessionInfo.slow_lane_interval());
+  }
+
+  // Sources with large payloads that are first to slow down under backpressure
+  const std::set<std::string> throttledSources{"ProcInfo", "ContextInfo"};
+
+  std::map<std::string, uint64_t> overrides;
+  if (m_arguments->hasFor(Arguments::Key::Intervals)) {
+    overrides = parseIntervals(m_arguments->getFor(Arguments::Key::Intervals));
+  }
+
+  // Spread the first request of each source over its interval so the
+  // requests don't burst at the same instant on both monitor and reader
+  for (size_t i = 0; i < sources.size(); i++) {
+    const auto &source = sources[i];
+
+    if (overrides.count(source->getName()) > 0) {
+      source->setInterval(overrides.at(source->getName()));
     }
+    source->setThrottled(throttledSources.count(source->getName()) > 0);
+    source->setOffset(source->getInterval() * i / sources.size());
+
+    logInfo() << "Data source " << source->getName() << " interval=" << source->getInterval()
+              << " offset=" << source->getOffset();
+    m_dataSources.append(source);
   }
 
   m_dataSources.commit();
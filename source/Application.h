@@ -11,15 +11,20 @@
 
 #pragma once
 
+#include <set>
 #include <string>
 #include <taskmonitor/taskmonitor.h>
 
 #include "Arguments.h"
+#include "BurstSampler.h"
 #include "Connection.h"
 #include "DataSource.h"
 #include "Defaults.h"
 #include "Dispatcher.h"
+#include "LiveServer.h"
+#include "Replay.h"
 #include "SQLiteDatabase.h"
+#include "Scheduler.h"
 
 #include "../bswinfra/source/IApplication.h"
 #include "../bswinfra/source/SafeList.h"
@@ -59,6 +64,8 @@ public:
   auto getConnection() -> const std::shared_ptr<Connection> { return m_connection; }
   auto getDatabase() -> const std::shared_ptr<SQLiteDatabase> { return m_database; }
   auto getArguments() -> const std::shared_ptr<Arguments> { return m_arguments; }
+  auto getReplay() -> const std::shared_ptr<Replay> { return m_replay; }
+  auto getLiveServer() -> const std::shared_ptr<LiveServer> { return m_liveServer; }
   auto getSessionInfo() -> tkm::msg::monitor::SessionInfo & { return m_sessionInfo; }
   auto getDeviceData() -> tkm::msg::control::DeviceData & { return m_deviceData; }
   auto getSessionData() -> tkm::msg::control::SessionData & { return m_sessionData; }
@@ -67,8 +74,24 @@ public:
   void resetConnection(void);
 
   void requestStartupData(void);
-  void startUpdateLanes(void);
-  void stopUpdateLanes(void);
+  void startUpdateScheduler(void);
+  void stopUpdateScheduler(void);
+  void setDataReplied(tkm::msg::monitor::Data_What what);
+  void setStatusReplied(const std::string &requestId);
+  auto getBacklog(void) -> size_t;
+  auto getThrottleLevel(void) -> size_t { return m_backlogLevel; }
+  auto getBurstSampler(void) -> const std::shared_ptr<BurstSampler> { return m_burstSampler; }
+  void setBurstInterval(const std::set<std::string> &sources, uint64_t intervalUs);
+  // Selected by --types for all record outputs
+  bool isRecordTypeSelected(tkm::msg::monitor::Data_What what)
+  {
+    return (m_recordTypes.empty() || (m_recordTypes.count(what) > 0));
+  }
+  // Selected by --json-types for the json output only
+  bool isJsonTypeSelected(tkm::msg::monitor::Data_What what)
+  {
+    return (m_jsonTypes.empty() || (m_jsonTypes.count(what) > 0));
+  }
   void resetInactivityTimer(size_t intervalUs);
 
 public:
@@ -76,13 +99,18 @@ public:
   void operator=(Application const &) = delete;
 
 private:
-  void configUpdateLanes(void);
+  void configDataSources(void);
+  void configRecordTypes(Arguments::Key key, std::set<tkm::msg::monitor::Data_What> &types);
+  void requestDataSources(const std::vector<std::shared_ptr<DataSource>> &sources);
+  void updateBacklogLevel(void);
 
 private:
   std::shared_ptr<Arguments> m_arguments = nullptr;
   std::shared_ptr<Connection> m_connection = nullptr;
   std::shared_ptr<Dispatcher> m_dispatcher = nullptr;
   std::shared_ptr<SQLiteDatabase> m_database = nullptr;
+  std::shared_ptr<Replay> m_replay = nullptr;
+  std::shared_ptr<LiveServer> m_liveServer = nullptr;
 
 private:
   tkm::msg::monitor::SessionInfo m_sessionInfo{};
@@ -92,9 +120,16 @@ private:
 
 private:
   bswi::util::SafeList<std::shared_ptr<DataSource>> m_dataSources{"DataSourceList"};
-  std::shared_ptr<Timer> m_fastLaneTimer = nullptr;
-  std::shared_ptr<Timer> m_paceLaneTimer = nullptr;
-  std::shared_ptr<Timer> m_slowLaneTimer = nullptr;
+  std::shared_ptr<Scheduler> m_scheduler = nullptr;
+  std::shared_ptr<BurstSampler> m_burstSampler = nullptr;
+  std::set<tkm::msg::monitor::Data_What> m_recordTypes{};
+  std::set<tkm::msg::monitor::Data_What> m_jsonTypes{};
+  std::shared_ptr<Timer> m_statsTimer = nullptr;
+  std::shared_ptr<Timer> m_backlogTimer = nullptr;
+  uint64_t m_requestTimeout = 0;
+  size_t m_backlogLevel = 0;
+  size_t m_backlogCalmCount = 0;
+  size_t m_backlogChanges = 0;
   std::shared_ptr<Timer> m_inactiveTimer = nullptr;
 };
 
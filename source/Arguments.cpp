@@ -12,6 +12,7 @@
 #include "Arguments.h"
 #include "Defaults.h"
 #include "Logger.h"
+#include <charconv>
 #include <stdexcept>
 
 using namespace std;
@@ -42,6 +43,52 @@ auto Arguments::getFor(Key key) -> string const
     return tkmDefaults.getFor(Defaults::Default::Strict);
   case Key::Verbose:
     return tkmDefaults.getFor(Defaults::Default::Verbose);
+  case Key::Intervals:
+    return tkmDefaults.getFor(Defaults::Default::Intervals);
+  case Key::BurstRules:
+    return tkmDefaults.getFor(Defaults::Default::BurstRules);
+  case Key::BurstSources:
+    return tkmDefaults.getFor(Defaults::Default::BurstSources);
+  case Key::BurstInterval:
+    return tkmDefaults.getFor(Defaults::Default::BurstInterval);
+  case Key::Types:
+    return tkmDefaults.getFor(Defaults::Default::Types);
+  case Key::JsonTypes:
+    return tkmDefaults.getFor(Defaults::Default::JsonTypes);
+  case Key::JsonFlush:
+    return tkmDefaults.getFor(Defaults::Default::JsonFlush);
+  case Key::JsonCompress:
+    return tkmDefaults.getFor(Defaults::Default::JsonCompress);
+  case Key::JsonRotate:
+    return tkmDefaults.getFor(Defaults::Default::JsonRotate);
+  case Key::JsonSplit:
+    return tkmDefaults.getFor(Defaults::Default::JsonSplit);
+  case Key::JsonFormat:
+    return tkmDefaults.getFor(Defaults::Default::JsonFormat);
+  case Key::MsgPackPath:
+    return tkmDefaults.getFor(Defaults::Default::MsgPackPath);
+  case Key::CapturePath:
+    return tkmDefaults.getFor(Defaults::Default::CapturePath);
+  case Key::CaptureSync:
+    return tkmDefaults.getFor(Defaults::Default::CaptureSync);
+  case Key::ReplayPath:
+    return tkmDefaults.getFor(Defaults::Default::ReplayPath);
+  case Key::ReplaySpeed:
+    return tkmDefaults.getFor(Defaults::Default::ReplaySpeed);
+  case Key::CaptureStreamPath:
+    return tkmDefaults.getFor(Defaults::Default::CaptureStreamPath);
+  case Key::ColumnPath:
+    return tkmDefaults.getFor(Defaults::Default::ColumnPath);
+  case Key::SeriesPath:
+    return tkmDefaults.getFor(Defaults::Default::SeriesPath);
+  case Key::StorePath:
+    return tkmDefaults.getFor(Defaults::Default::StorePath);
+  case Key::LivePath:
+    return tkmDefaults.getFor(Defaults::Default::LivePath);
+  case Key::LatestPath:
+    return tkmDefaults.getFor(Defaults::Default::LatestPath);
+  case Key::RingPath:
+    return tkmDefaults.getFor(Defaults::Default::RingPath);
   default:
     break;
   }
@@ -49,4 +96,12 @@ auto Arguments::getFor(Key key) -> string const
   throw std::runtime_error("Unknown value for key");
 }
 
+bool Arguments::toNumber(const std::string &text, uint64_t &value)
+{
+  auto end = text.data() + text.size();
+  auto [ptr, ec] = std::from_chars(text.data(), end, value);
+
+  return (!text.empty()) && (ec == std::errc()) && (ptr == end);
+}
+
 } // namespace tkm::reader
@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <map>
 #include <string>
 
@@ -20,7 +21,40 @@ namespace tkm::reader
 class Arguments
 {
 public:
-  enum class Key { Name, Init, Address, Port, DatabasePath, JsonPath, Timeout, Strict, Verbose };
+  enum class Key {
+    Name,
+    Init,
+    Address,
+    Port,
+    DatabasePath,
+    JsonPath,
+    Timeout,
+    Strict,
+    Verbose,
+    Intervals,
+    BurstRules,
+    BurstSources,
+    BurstInterval,
+    Types,
+    JsonTypes,
+    JsonFlush,
+    JsonCompress,
+    JsonRotate,
+    JsonSplit,
+    JsonFormat,
+    MsgPackPath,
+    CapturePath,
+    CaptureSync,
+    ReplayPath,
+    ReplaySpeed,
+    CaptureStreamPath,
+    ColumnPath,
+    SeriesPath,
+    StorePath,
+    LivePath,
+    LatestPath,
+    RingPath
+  };
 
 public:
   explicit Arguments(const std::map<Key, std::string> &opts)
@@ -35,6 +69,9 @@ public:
     m_opts.insert(std::pair<Key, std::string>(key, opt));
   }
 
+  // Decimal number without sign or trailing characters
+  static bool toNumber(const std::string &text, uint64_t &value);
+
 private:
   std::map<Key, std::string> m_opts;
 };
@@ -0,0 +1,218 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     BurstSampler Class
+ * @details   Temporary high resolution sampling on pressure spikes
+ *-
+ */
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+#include "Application.h"
+#include "BurstSampler.h"
+#include "Defaults.h"
+#include "Logger.h"
+
+namespace tkm::reader
+{
+
+enum class PressureGroup { CpuSome, CpuFull, MemSome, MemFull, IOSome, IOFull };
+enum class PressureField { Avg10, Avg60, Avg300 };
+
+template <class T>
+static auto pressureValue(const T &data, PressureField field) -> float
+{
+  switch (field) {
+  case PressureField::Avg10:
+    return data.avg10();
+  case PressureField::Avg60:
+    return data.avg60();
+  case PressureField::Avg300:
+  default:
+    break;
+  }
+  return data.avg300();
+}
+
+static auto pressureValue(const tkm::msg::monitor::SysProcPressure &psi,
+                          PressureGroup group,
+                          PressureField field) -> float
+{
+  switch (group) {
+  case PressureGroup::CpuSome:
+    return psi.has_cpu_some() ? pressureValue(psi.cpu_some(), field) : 0;
+  case PressureGroup::CpuFull:
+    return psi.has_cpu_full() ? pressureValue(psi.cpu_full(), field) : 0;
+  case PressureGroup::MemSome:
+    return psi.has_mem_some() ? pressureValue(psi.mem_some(), field) : 0;
+  case PressureGroup::MemFull:
+    return psi.has_mem_full() ? pressureValue(psi.mem_full(), field) : 0;
+  case PressureGroup::IOSome:
+    return psi.has_io_some() ? pressureValue(psi.io_some(), field) : 0;
+  case PressureGroup::IOFull:
+    return psi.has_io_full() ? pressureValue(psi.io_full(), field) : 0;
+  default:
+    break;
+  }
+  return 0;
+}
+
+BurstSampler::BurstSampler(const std::string &rules, const std::string &sources, uint64_t interval)
+: m_interval(interval)
+{
+  const std::map<std::string, PressureGroup> groups{
+      std::make_pair("cpu_some", PressureGroup::CpuSome),
+      std::make_pair("cpu_full", PressureGroup::CpuFull),
+      std::make_pair("mem_some", PressureGroup::MemSome),
+      std::make_pair("mem_full", PressureGroup::MemFull),
+      std::make_pair("io_some", PressureGroup::IOSome),
+      std::make_pair("io_full", PressureGroup::IOFull),
+  };
+  const std::map<std::string, PressureField> fields{
+      std::make_pair("avg10", PressureField::Avg10),
+      std::make_pair("avg60", PressureField::Avg60),
+      std::make_pair("avg300", PressureField::Avg300),
+  };
+  std::stringstream ruleStream(rules);
+  std::stringstream sourceStream(sources);
+  std::string item;
+
+  // Rule format: <group>.<field>=<threshold>, ex: mem_some.avg10=20
+  while (std::getline(ruleStream, item, ',')) {
+    auto dotPos = item.find('.');
+    auto eqPos = item.find('=');
+
+    if ((dotPos == std::string::npos) || (eqPos == std::string::npos) || (eqPos < dotPos)) {
+      logWarn() << "Invalid burst rule: " << item;
+      continue;
+    }
+
+    auto groupName = item.substr(0, dotPos);
+    auto fieldName = item.substr(dotPos + 1, eqPos - dotPos - 1);
+    if ((groups.count(groupName) == 0) || (fields.count(fieldName) == 0)) {
+      logWarn() << "Unknown burst rule metric: " << item;
+      continue;
+    }
+
+    try {
+      auto group = groups.at(groupName);
+      auto field = fields.at(fieldName);
+
+      Rule rule;
+
+      rule.name = item.substr(0, eqPos);
+      rule.value = [group, field](const tkm::msg::monitor::SysProcPressure &psi) {
+        return pressureValue(psi, group, field);
+      };
+      rule.threshold = std::stof(item.substr(eqPos + 1));
+      m_rules.push_back(rule);
+    } catch (const std::exception &e) {
+      logWarn() << "Invalid burst rule threshold: " << item;
+    }
+  }
+
+  while (std::getline(sourceStream, item, ',')) {
+    m_sources.insert(item);
+  }
+
+  m_duration = std::stoul(tkmDefaults.getFor(Defaults::Default::BurstDuration));
+  m_maxDuration = std::stoul(tkmDefaults.getFor(Defaults::Default::BurstMaxDuration));
+  m_cooldown = std::stoul(tkmDefaults.getFor(Defaults::Default::BurstCooldown));
+
+  logInfo() << "Burst sampling with " << m_rules.size() << " rules on " << m_sources.size()
+            << " sources";
+}
+
+void BurstSampler::checkPressure(const tkm::msg::monitor::SysProcPressure &sysProcPressure)
+{
+  for (const auto &rule : m_rules) {
+    auto value = rule.value(sysProcPressure);
+
+    if (value > rule.threshold) {
+      std::stringstream reason;
+      reason << rule.name << "=" << value << " above " << rule.threshold;
+      startBurst(reason.str());
+      return;
+    }
+  }
+}
+
+void BurstSampler::startBurst(const std::string &reason)
+{
+  using USec = std::chrono::microseconds;
+  auto timeNow = std::chrono::steady_clock::now();
+
+  if (m_active) {
+    // Extend the burst while the spike persists but never beyond the max duration
+    m_burstEnd = std::min(timeNow + USec(m_duration), m_burstStart + USec(m_maxDuration));
+    return;
+  }
+
+  if (timeNow < m_cooldownEnd) {
+    return;
+  }
+
+  // Don't add more load while the reader itself is throttled by backpressure
+  if (App()->getThrottleLevel() > 0) {
+    logDebug() << "Burst sampling ignored under backpressure: " << reason;
+    return;
+  }
+
+  logWarn() << "Start burst sampling: " << reason;
+  App()->printVerbose("Start burst sampling: " + reason);
+
+  m_active = true;
+  m_burstStart = timeNow;
+  m_burstEnd = timeNow + USec(m_duration);
+  App()->setBurstInterval(m_sources, m_interval);
+
+  if (m_timer != nullptr) {
+    m_timer->stop();
+    App()->remEventSource(m_timer);
+  }
+
+  // The timer is removed on next burst or on stop
+  m_timer = std::make_shared<Timer>("BurstTimer", [this]() {
+    if (std::chrono::steady_clock::now() < m_burstEnd) {
+      return true;
+    }
+    stopBurst();
+    return false;
+  });
+  m_timer->start(std::min<uint64_t>(m_duration, 1000000), true);
+  App()->addEventSource(m_timer);
+}
+
+void BurstSampler::stopBurst(void)
+{
+  using USec = std::chrono::microseconds;
+
+  if (!m_active) {
+    return;
+  }
+
+  logWarn() << "Stop burst sampling";
+  App()->printVerbose("Stop burst sampling");
+
+  m_active = false;
+  m_cooldownEnd = std::chrono::steady_clock::now() + USec(m_cooldown);
+  App()->setBurstInterval(m_sources, 0);
+}
+
+void BurstSampler::stop(void)
+{
+  stopBurst();
+
+  if (m_timer != nullptr) {
+    m_timer->stop();
+    App()->remEventSource(m_timer);
+    m_timer.reset();
+  }
+}
+
+} // namespace tkm::reader
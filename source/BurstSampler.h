@@ -0,0 +1,69 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     BurstSampler Class
+ * @details   Temporary high resolution sampling on pressure spikes
+ *-
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <taskmonitor/taskmonitor.h>
+#include <vector>
+
+#include "../bswinfra/source/Timer.h"
+
+using namespace bswi::event;
+
+namespace tkm::reader
+{
+
+class BurstSampler : public std::enable_shared_from_this<BurstSampler>
+{
+public:
+  // The interval in usec is validated against BurstMinInterval by the caller
+  explicit BurstSampler(const std::string &rules, const std::string &sources, uint64_t interval);
+  ~BurstSampler() = default;
+
+public:
+  BurstSampler(BurstSampler const &) = delete;
+  void operator=(BurstSampler const &) = delete;
+
+  // Rule hook for each received pressure sample
+  void checkPressure(const tkm::msg::monitor::SysProcPressure &sysProcPressure);
+  // Revert any active burst
+  void stop(void);
+
+private:
+  typedef struct Rule {
+    std::string name;
+    std::function<float(const tkm::msg::monitor::SysProcPressure &)> value;
+    float threshold;
+  } Rule;
+
+  void startBurst(const std::string &reason);
+  void stopBurst(void);
+
+private:
+  std::vector<Rule> m_rules{};
+  std::set<std::string> m_sources{};
+  std::shared_ptr<Timer> m_timer = nullptr;
+  std::chrono::time_point<std::chrono::steady_clock> m_burstStart{};
+  std::chrono::time_point<std::chrono::steady_clock> m_burstEnd{};
+  std::chrono::time_point<std::chrono::steady_clock> m_cooldownEnd{};
+  uint64_t m_interval = 0;
+  uint64_t m_duration = 0;
+  uint64_t m_maxDuration = 0;
+  uint64_t m_cooldown = 0;
+  bool m_active = false;
+};
+
+} // namespace tkm::reader
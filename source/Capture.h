@@ -0,0 +1,66 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     Capture file format
+ * @details   Layout of raw envelope capture files
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace tkm::reader::capture
+{
+
+/*
+ * A capture file starts with an 8 byte file header followed by frames.
+ * All integers are little endian.
+ *
+ *   file header: "TKMCAP" u16 format version
+ *   frame:       u32 payload size, u8 frame type, u64 receive time (usec), payload
+ *
+ * A Session frame is written when a session starts, its payload is a
+ * list of u16 size prefixed strings (see SessionField). Envelope frames
+ * hold a serialized tkm::msg::Envelope as received from the monitor.
+ * Appending to an existing capture only adds frames. A frame size above
+ * MaxFrameSize is taken as a corrupt file by readers.
+ */
+constexpr std::string_view Magic = "TKMCAP";
+constexpr uint16_t Version = 1;
+constexpr size_t FileHeaderSize = 8;
+constexpr size_t FrameHeaderSize = 13;
+constexpr size_t MaxFrameSize = 64 * 1024 * 1024;
+
+enum class FrameType : uint8_t { Session = 1, Envelope = 2 };
+enum class SessionField { Session, Device, DeviceLibVersion, ReaderLibVersion, Count };
+
+inline void putUint(std::string &out, uint64_t val, size_t size)
+{
+  for (size_t i = 0; i < size; i++) {
+    out.push_back(static_cast<char>((val >> (8 * i)) & 0xff));
+  }
+}
+
+inline auto getUint(const char *in, size_t size) -> uint64_t
+{
+  uint64_t val = 0;
+  for (size_t i = 0; i < size; i++) {
+    val |= static_cast<uint64_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+  }
+  return val;
+}
+
+inline void putString(std::string &out, std::string_view str)
+{
+  auto size = (str.size() > UINT16_MAX) ? UINT16_MAX : str.size();
+  putUint(out, size, sizeof(uint16_t));
+  out.append(str.data(), size);
+}
+
+} // namespace tkm::reader::capture
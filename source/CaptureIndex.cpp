@@ -0,0 +1,226 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     CaptureIndex Class
+ * @details   Sparse index of envelope frames in a capture file
+ *-
+ */
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <taskmonitor/taskmonitor.h>
+
+#include "Capture.h"
+#include "CaptureIndex.h"
+#include "Logger.h"
+
+namespace tkm::reader
+{
+
+static constexpr std::string_view IndexMagic = "TKMIDX";
+static constexpr uint16_t IndexVersion = 2;
+static constexpr size_t IndexHeaderSize = 24;
+static constexpr size_t IndexEntrySize = 40;
+
+// System and monotonic time of an envelope payload holding a data message
+static bool readDataTimes(const std::string &payload,
+                          uint64_t &systemTime,
+                          uint64_t &monotonicTime)
+{
+  tkm::msg::Envelope envelope;
+  tkm::msg::monitor::Message msg;
+  tkm::msg::monitor::Data data;
+
+  if (!envelope.ParseFromString(payload) || !envelope.mesg().UnpackTo(&msg) ||
+      (msg.type() != tkm::msg::monitor::Message_Type_Data) || !msg.payload().UnpackTo(&data)) {
+    return false;
+  }
+
+  systemTime = data.system_time_sec();
+  monotonicTime = data.monotonic_time_sec();
+  return true;
+}
+
+CaptureIndex::CaptureIndex(const std::string &capturePath)
+: m_capturePath(capturePath)
+, m_indexPath(capturePath + ".idx")
+{
+}
+
+bool CaptureIndex::open(void)
+{
+  if (load()) {
+    return true;
+  }
+
+  if (!build()) {
+    return false;
+  }
+
+  // A read only location only costs a scan on the next open
+  if (!save()) {
+    logWarn() << "Cannot write capture index " << m_indexPath;
+  }
+
+  return true;
+}
+
+auto CaptureIndex::endOffset(size_t index) const -> uint64_t
+{
+  return (index + 1 < m_entries.size()) ? m_entries[index + 1].offset : m_captureSize;
+}
+
+auto CaptureIndex::findRange(uint64_t begin, uint64_t end) const -> std::pair<size_t, size_t>
+{
+  auto byTime = [](uint64_t time, const Entry &entry) { return time < entry.systemTime; };
+
+  // The entry before the first one starting after begin may still hold data at begin
+  auto first = std::upper_bound(m_entries.cbegin(), m_entries.cend(), begin, byTime);
+  if (first != m_entries.cbegin()) {
+    first--;
+  }
+  auto last = std::upper_bound(first, m_entries.cend(), end, byTime);
+
+  return std::make_pair(static_cast<size_t>(first - m_entries.cbegin()),
+                        static_cast<size_t>(last - m_entries.cbegin()));
+}
+
+bool CaptureIndex::load(void)
+{
+  std::error_code ec;
+  auto captureSize = std::filesystem::file_size(m_capturePath, ec);
+  if (ec) {
+    return false;
+  }
+
+  std::ifstream in(m_indexPath, std::ifstream::in | std::ifstream::binary);
+  char header[IndexHeaderSize];
+  if (!in.read(header, sizeof(header))) {
+    return false;
+  }
+
+  if ((std::string_view(header, IndexMagic.size()) != IndexMagic) ||
+      (capture::getUint(header + IndexMagic.size(), sizeof(uint16_t)) != IndexVersion)) {
+    return false;
+  }
+
+  auto indexedSize = capture::getUint(header + 8, sizeof(uint64_t));
+  auto count = capture::getUint(header + 16, sizeof(uint64_t));
+  if (indexedSize != captureSize) {
+    return false;
+  }
+
+  std::string entries(count * IndexEntrySize, '\0');
+  if (!in.read(entries.data(), static_cast<std::streamsize>(entries.size()))) {
+    return false;
+  }
+
+  m_entries.clear();
+  m_entries.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    const char *entry = entries.data() + i * IndexEntrySize;
+    m_entries.push_back(Entry{.offset = capture::getUint(entry, sizeof(uint64_t)),
+                              .receiveTime = capture::getUint(entry + 8, sizeof(uint64_t)),
+                              .systemTime = capture::getUint(entry + 16, sizeof(uint64_t)),
+                              .monotonicTime = capture::getUint(entry + 24, sizeof(uint64_t)),
+                              .sessionOffset = capture::getUint(entry + 32, sizeof(uint64_t))});
+  }
+  m_captureSize = indexedSize;
+
+  return true;
+}
+
+bool CaptureIndex::build(void)
+{
+  std::error_code ec;
+  auto captureSize = std::filesystem::file_size(m_capturePath, ec);
+  if (ec) {
+    logError() << "Cannot read capture file " << m_capturePath << ": " << ec.message();
+    return false;
+  }
+
+  std::ifstream in(m_capturePath, std::ifstream::in | std::ifstream::binary);
+  char header[capture::FrameHeaderSize];
+
+  if (!in.read(header, capture::FileHeaderSize) ||
+      (std::string_view(header, capture::Magic.size()) != capture::Magic)) {
+    logError() << "Not a capture file: " << m_capturePath;
+    return false;
+  }
+
+  uint64_t offset = capture::FileHeaderSize;
+  uint64_t sessionOffset = 0;
+  size_t envelopes = 0;
+  bool pendingTimes = false;
+  std::string payload{};
+
+  m_entries.clear();
+
+  // Only frame headers are read and payloads skipped, except until the
+  // data times of the last entry are known. Frames appended during the
+  // scan are left for the next index update.
+  while ((offset + capture::FrameHeaderSize <= captureSize) && in.read(header, sizeof(header))) {
+    auto size = capture::getUint(header, sizeof(uint32_t));
+    auto type = static_cast<capture::FrameType>(capture::getUint(header + 4, sizeof(uint8_t)));
+    auto receiveTime = capture::getUint(header + 5, sizeof(uint64_t));
+
+    if (type == capture::FrameType::Session) {
+      sessionOffset = offset;
+    } else if (type == capture::FrameType::Envelope) {
+      if (m_entries.empty() || (envelopes >= Interval) ||
+          (receiveTime >= m_entries.back().receiveTime + IntervalTime * 1000000)) {
+        auto previous = m_entries.empty() ? Entry{} : m_entries.back();
+        m_entries.push_back(Entry{.offset = offset,
+                                  .receiveTime = receiveTime,
+                                  .systemTime = previous.systemTime,
+                                  .monotonicTime = previous.monotonicTime,
+                                  .sessionOffset = sessionOffset});
+        envelopes = 0;
+        pendingTimes = true;
+      }
+      envelopes++;
+
+      if (pendingTimes && (offset + capture::FrameHeaderSize + size <= captureSize)) {
+        payload.resize(size);
+        if (in.read(payload.data(), static_cast<std::streamsize>(size)) &&
+            readDataTimes(payload, m_entries.back().systemTime, m_entries.back().monotonicTime)) {
+          pendingTimes = false;
+        }
+      }
+    }
+
+    offset += capture::FrameHeaderSize + size;
+    in.seekg(static_cast<std::streamoff>(offset));
+  }
+  m_captureSize = captureSize;
+
+  return true;
+}
+
+bool CaptureIndex::save(void)
+{
+  std::string data{};
+
+  data.append(IndexMagic);
+  capture::putUint(data, IndexVersion, sizeof(uint16_t));
+  capture::putUint(data, m_captureSize, sizeof(uint64_t));
+  capture::putUint(data, m_entries.size(), sizeof(uint64_t));
+  for (const auto &entry : m_entries) {
+    capture::putUint(data, entry.offset, sizeof(uint64_t));
+    capture::putUint(data, entry.receiveTime, sizeof(uint64_t));
+    capture::putUint(data, entry.systemTime, sizeof(uint64_t));
+    capture::putUint(data, entry.monotonicTime, sizeof(uint64_t));
+    capture::putUint(data, entry.sessionOffset, sizeof(uint64_t));
+  }
+
+  std::ofstream out(m_indexPath, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+  out.write(data.data(), static_cast<std::streamsize>(data.size()));
+
+  return out.good();
+}
+
+} // namespace tkm::reader
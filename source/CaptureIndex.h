@@ -0,0 +1,79 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     CaptureIndex Class
+ * @details   Sparse index of envelope frames in a capture file
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tkm::reader
+{
+
+/*
+ * One entry every Interval envelope frames or IntervalTime seconds of
+ * receive time, whichever comes first. The index is stored next to the
+ * capture in '<capture path>.idx':
+ *
+ *   header: "TKMIDX" u16 version, u64 indexed capture size, u64 entry count
+ *   entry:  u64 frame offset, u64 receive time (usec), u64 system time (sec),
+ *           u64 monotonic time (sec), u64 session offset
+ *
+ * System and monotonic time are the ones of the first data message from
+ * the entry on, entries without data keep the times of the previous one.
+ * The session offset points to the session frame in effect at the entry
+ * (0 if none) so decoding can start at any entry. An index covering less
+ * than the capture size (capture appended since) is rebuilt.
+ */
+class CaptureIndex
+{
+public:
+  static constexpr size_t Interval = 512;
+  static constexpr uint64_t IntervalTime = 10;
+
+  typedef struct Entry {
+    uint64_t offset;
+    uint64_t receiveTime;
+    uint64_t systemTime;
+    uint64_t monotonicTime;
+    uint64_t sessionOffset;
+  } Entry;
+
+public:
+  explicit CaptureIndex(const std::string &capturePath);
+  ~CaptureIndex() = default;
+
+public:
+  CaptureIndex(CaptureIndex const &) = delete;
+  void operator=(CaptureIndex const &) = delete;
+
+  // Load the index file if up to date, otherwise scan the capture and save it
+  bool open(void);
+  auto getEntries(void) const -> const std::vector<Entry> & { return m_entries; }
+  // Capture offset where the frames of entry index end
+  auto endOffset(size_t index) const -> uint64_t;
+  // Entries [first, last) holding the data with system time in [begin, end]
+  auto findRange(uint64_t begin, uint64_t end) const -> std::pair<size_t, size_t>;
+
+private:
+  bool load(void);
+  bool build(void);
+  bool save(void);
+
+private:
+  std::string m_capturePath;
+  std::string m_indexPath;
+  std::vector<Entry> m_entries{};
+  uint64_t m_captureSize = 0;
+};
+
+} // namespace tkm::reader
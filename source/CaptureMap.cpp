@@ -0,0 +1,86 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     CaptureMap Class
+ * @details   Random access to the frames of a memory mapped capture file
+ *-
+ */
+
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CaptureMap.h"
+#include "Logger.h"
+
+namespace tkm::reader
+{
+
+CaptureMap::CaptureMap(const std::string &path)
+{
+  struct stat st;
+
+  auto fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    logError() << "Cannot open capture file " << path << ": " << strerror(errno);
+    return;
+  }
+
+  if ((::fstat(fd, &st) < 0) || (static_cast<uint64_t>(st.st_size) < capture::FileHeaderSize)) {
+    logError() << "Cannot read capture file header from " << path;
+    ::close(fd);
+    return;
+  }
+
+  auto data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    logError() << "Cannot map capture file " << path << ": " << strerror(errno);
+    return;
+  }
+
+  m_data = static_cast<const char *>(data);
+  m_size = static_cast<uint64_t>(st.st_size);
+
+  if ((std::string_view(m_data, capture::Magic.size()) != capture::Magic) ||
+      (capture::getUint(m_data + capture::Magic.size(), sizeof(uint16_t)) != capture::Version)) {
+    logError() << "Not a supported capture file: " << path;
+    ::munmap(const_cast<char *>(m_data), static_cast<size_t>(m_size));
+    m_data = nullptr;
+    m_size = 0;
+  }
+}
+
+CaptureMap::~CaptureMap()
+{
+  if (m_data != nullptr) {
+    ::munmap(const_cast<char *>(m_data), static_cast<size_t>(m_size));
+  }
+}
+
+auto CaptureMap::frameAt(uint64_t offset, Frame &frame) const -> uint64_t
+{
+  if ((m_data == nullptr) || (offset + capture::FrameHeaderSize > m_size)) {
+    return 0;
+  }
+
+  const char *header = m_data + offset;
+  auto size = capture::getUint(header, sizeof(uint32_t));
+  if (offset + capture::FrameHeaderSize + size > m_size) {
+    return 0;
+  }
+
+  frame.type = static_cast<capture::FrameType>(capture::getUint(header + 4, sizeof(uint8_t)));
+  frame.receiveTime = capture::getUint(header + 5, sizeof(uint64_t));
+  frame.payload = std::string_view(header + capture::FrameHeaderSize, size);
+
+  return offset + capture::FrameHeaderSize + size;
+}
+
+} // namespace tkm::reader
@@ -0,0 +1,55 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     CaptureMap Class
+ * @details   Random access to the frames of a memory mapped capture file
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "Capture.h"
+
+namespace tkm::reader
+{
+
+/*
+ * Frames are read in place from the mapping, only the pages of the frames
+ * visited are loaded. Offsets come from a CaptureIndex entry or from a
+ * previous frame. The map is read only and can be shared between threads.
+ */
+class CaptureMap
+{
+public:
+  typedef struct Frame {
+    capture::FrameType type;
+    uint64_t receiveTime;
+    std::string_view payload;
+  } Frame;
+
+public:
+  explicit CaptureMap(const std::string &path);
+  ~CaptureMap();
+
+public:
+  CaptureMap(CaptureMap const &) = delete;
+  void operator=(CaptureMap const &) = delete;
+
+  bool isOpen(void) const { return m_data != nullptr; }
+  auto getSize(void) const -> uint64_t { return m_size; }
+  // Read the frame at offset and return the next frame offset, 0 if none is complete
+  auto frameAt(uint64_t offset, Frame &frame) const -> uint64_t;
+
+private:
+  const char *m_data = nullptr;
+  uint64_t m_size = 0;
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,171 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     CaptureReader Class
+ * @details   Read frames from a raw envelope capture file
+ *-
+ */
+
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CaptureReader.h"
+#include "Logger.h"
+
+namespace tkm::reader
+{
+
+CaptureReader::CaptureReader(const std::string &path)
+: m_inStream(path, std::ifstream::in | std::ifstream::binary)
+{
+  char header[capture::FileHeaderSize];
+
+  if (!m_inStream.read(header, sizeof(header))) {
+    logError() << "Cannot read capture file header from " << path;
+    return;
+  }
+
+  if (std::string_view(header, capture::Magic.size()) != capture::Magic) {
+    m_streamFd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_streamFd < 0) {
+      logError() << "Cannot open capture stream " << path << ": " << strerror(errno);
+      return;
+    }
+    logInfo() << "Reading " << path << " as envelope stream";
+    m_streamReader = std::make_unique<tkm::EnvelopeReader>(m_streamFd);
+    m_valid = true;
+    return;
+  }
+
+  auto version = capture::getUint(header + capture::Magic.size(), sizeof(uint16_t));
+  if (version != capture::Version) {
+    logError() << "Unsupported capture file version " << version << " in " << path;
+    return;
+  }
+
+  std::error_code ec;
+  m_fileSize = std::filesystem::file_size(path, ec);
+  if (ec) {
+    logError() << "Cannot get capture file size of " << path << ": " << ec.message();
+    return;
+  }
+
+  m_valid = true;
+}
+
+CaptureReader::~CaptureReader()
+{
+  m_streamReader.reset();
+  if (m_streamFd >= 0) {
+    ::close(m_streamFd);
+  }
+}
+
+auto CaptureReader::next(Frame &frame) -> Status
+{
+  char header[capture::FrameHeaderSize];
+
+  if (!m_valid) {
+    return Status::Error;
+  }
+  if (m_streamReader != nullptr) {
+    return nextFromStream(frame);
+  }
+
+  if (!m_inStream.read(header, sizeof(header))) {
+    if (m_inStream.gcount() > 0) {
+      logWarn() << "Capture file ends with an incomplete frame header";
+    }
+    return Status::EndOfFile;
+  }
+
+  auto size = capture::getUint(header, sizeof(uint32_t));
+  frame.type = static_cast<capture::FrameType>(capture::getUint(header + 4, sizeof(uint8_t)));
+  frame.receiveTime = capture::getUint(header + 5, sizeof(uint64_t));
+
+  // The size is checked before any allocation, a corrupt one must not allocate gigabytes
+  auto offset = static_cast<uint64_t>(m_inStream.tellg());
+  if (size > capture::MaxFrameSize) {
+    logError() << "Capture frame of " << size << " bytes at offset "
+               << offset - capture::FrameHeaderSize << ", file is corrupt";
+    return Status::Error;
+  }
+  if (offset + size > m_fileSize) {
+    logWarn() << "Capture file ends with an incomplete frame";
+    return Status::EndOfFile;
+  }
+
+  frame.payload.resize(size);
+  if (!m_inStream.read(frame.payload.data(), static_cast<std::streamsize>(size))) {
+    logWarn() << "Capture file ends with an incomplete frame";
+    return Status::EndOfFile;
+  }
+
+  return Status::Ok;
+}
+
+auto CaptureReader::nextFromStream(Frame &frame) -> Status
+{
+  tkm::msg::Envelope envelope;
+  struct stat st;
+
+  auto status = m_streamReader->next(envelope);
+  while (status == tkm::IAsyncEnvelope::Status::Again) {
+    // The reader may stop at its buffer end, it is only done at the end of file
+    if ((::fstat(m_streamFd, &st) < 0) || (::lseek(m_streamFd, 0, SEEK_CUR) >= st.st_size)) {
+      logWarn() << "Capture stream ends with an incomplete envelope";
+      return Status::EndOfFile;
+    }
+    status = m_streamReader->next(envelope);
+  }
+
+  if (status == tkm::IAsyncEnvelope::Status::EndOfFile) {
+    return Status::EndOfFile;
+  }
+  if (status != tkm::IAsyncEnvelope::Status::Ok) {
+    return Status::Error;
+  }
+
+  tkm::msg::monitor::Message msg;
+  tkm::msg::monitor::Data data;
+  if (envelope.mesg().UnpackTo(&msg) && (msg.type() == tkm::msg::monitor::Message_Type_Data) &&
+      msg.payload().UnpackTo(&data)) {
+    m_streamTime = data.system_time_sec() * 1000000;
+  }
+
+  frame.type = capture::FrameType::Envelope;
+  frame.receiveTime = m_streamTime;
+  frame.payload = envelope.SerializeAsString();
+
+  return Status::Ok;
+}
+
+bool CaptureReader::parseSession(std::string_view payload, std::vector<std::string> &fields)
+{
+  size_t offset = 0;
+
+  fields.clear();
+  while (fields.size() < static_cast<size_t>(capture::SessionField::Count)) {
+    if (offset + sizeof(uint16_t) > payload.size()) {
+      return false;
+    }
+    auto size = capture::getUint(payload.data() + offset, sizeof(uint16_t));
+    offset += sizeof(uint16_t);
+    if (offset + size > payload.size()) {
+      return false;
+    }
+    fields.emplace_back(payload.substr(offset, size));
+    offset += size;
+  }
+
+  return true;
+}
+
+} // namespace tkm::reader
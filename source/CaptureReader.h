@@ -0,0 +1,69 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     CaptureReader Class
+ * @details   Read frames from a raw envelope capture file
+ *-
+ */
+
+#pragma once
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <taskmonitor/taskmonitor.h>
+#include <vector>
+
+#include "Capture.h"
+
+namespace tkm::reader
+{
+
+/*
+ * Reads capture files and, for files without the capture header, raw
+ * libtkm envelope streams (see StreamTee). Streams carry no receive time,
+ * the system time of the last data message stands in for it.
+ */
+class CaptureReader
+{
+public:
+  enum class Status { Ok, EndOfFile, Error };
+
+  typedef struct Frame {
+    capture::FrameType type;
+    uint64_t receiveTime;
+    std::string payload;
+  } Frame;
+
+public:
+  explicit CaptureReader(const std::string &path);
+  ~CaptureReader();
+
+public:
+  CaptureReader(CaptureReader const &) = delete;
+  void operator=(CaptureReader const &) = delete;
+
+  bool isOpen(void) { return m_valid; }
+  // A frame cut short at the end of the file (writer killed) ends the capture
+  auto next(Frame &frame) -> Status;
+
+  // Split a session frame payload in its SessionField strings
+  static bool parseSession(std::string_view payload, std::vector<std::string> &fields);
+
+private:
+  auto nextFromStream(Frame &frame) -> Status;
+
+private:
+  std::ifstream m_inStream;
+  uint64_t m_fileSize = 0;
+  std::unique_ptr<tkm::EnvelopeReader> m_streamReader = nullptr;
+  uint64_t m_streamTime = 0;
+  int m_streamFd = -1;
+  bool m_valid = false;
+};
+
+} // namespace tkm::reader
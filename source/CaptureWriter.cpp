@@ -0,0 +1,145 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     CaptureWriter Class
+ * @details   Append received envelopes to a raw capture file
+ *-
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../bswinfra/source/Logger.h"
+#include "Application.h"
+#include "Arguments.h"
+#include "CaptureWriter.h"
+
+namespace tkm::reader
+{
+
+CaptureWriter *CaptureWriter::instance = nullptr;
+
+CaptureWriter::CaptureWriter()
+{
+  if (!App()->getArguments()->hasFor(Arguments::Key::CapturePath)) {
+    return;
+  }
+
+  auto outPath = App()->getArguments()->getFor(Arguments::Key::CapturePath);
+  m_fd = ::open(outPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (m_fd < 0) {
+    logError() << "Cannot open capture file " << outPath << ": " << strerror(errno);
+    return;
+  }
+
+  struct stat st;
+  if ((fstat(m_fd, &st) == 0) && (st.st_size == 0)) {
+    m_buffer.append(capture::Magic);
+    capture::putUint(m_buffer, capture::Version, sizeof(uint16_t));
+  }
+
+  m_flushSize = std::stoul(tkmDefaults.getFor(Defaults::Default::CaptureFlushSize));
+  m_buffer.reserve(m_flushSize);
+
+  m_flushTimer = std::make_shared<Timer>("CaptureFlushTimer", [this]() {
+    flush();
+    return true;
+  });
+  m_flushTimer->start(std::stoul(tkmDefaults.getFor(Defaults::Default::JsonFlushInterval)), true);
+  App()->addEventSource(m_flushTimer);
+
+  uint64_t syncInterval = 0;
+  try {
+    syncInterval = std::stoul(App()->getArguments()->getFor(Arguments::Key::CaptureSync));
+  } catch (const std::exception &e) {
+    logWarn() << "Cannot convert capture sync interval. Sync disabled";
+  }
+  if (syncInterval > 0) {
+    m_syncTimer = std::make_shared<Timer>("CaptureSyncTimer", [this]() {
+      sync();
+      return true;
+    });
+    m_syncTimer->start(syncInterval * 1000, true); // msec 2 usec
+    App()->addEventSource(m_syncTimer);
+  }
+
+  std::atexit([]() { CaptureWriter::getInstance()->flush(); });
+}
+
+void CaptureWriter::beginFrame(capture::FrameType type, size_t size)
+{
+  auto receiveTime = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch());
+
+  capture::putUint(m_buffer, size, sizeof(uint32_t));
+  capture::putUint(m_buffer, static_cast<uint8_t>(type), sizeof(uint8_t));
+  capture::putUint(m_buffer, static_cast<uint64_t>(receiveTime.count()), sizeof(uint64_t));
+}
+
+void CaptureWriter::writeSession(const tkm::msg::monitor::SessionInfo &sessionInfo)
+{
+  if (m_fd < 0) {
+    return;
+  }
+
+  std::string payload{};
+  capture::putString(payload, sessionInfo.hash());
+  capture::putString(payload, App()->getArguments()->getFor(Arguments::Key::Name));
+  capture::putString(payload, sessionInfo.libtkm_version());
+  capture::putString(payload, TKMLIB_VERSION);
+
+  beginFrame(capture::FrameType::Session, payload.size());
+  m_buffer.append(payload);
+}
+
+void CaptureWriter::writeEnvelope(const tkm::msg::Envelope &envelope)
+{
+  if (m_fd < 0) {
+    return;
+  }
+
+  // Serialize in place after the frame header
+  beginFrame(capture::FrameType::Envelope, envelope.ByteSizeLong());
+  envelope.AppendToString(&m_buffer);
+
+  if (m_buffer.size() >= m_flushSize) {
+    flush();
+  }
+}
+
+void CaptureWriter::flush(void)
+{
+  size_t offset = 0;
+
+  while (offset < m_buffer.size()) {
+    auto written = ::write(m_fd, m_buffer.data() + offset, m_buffer.size() - offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      logError() << "Capture write failed: " << strerror(errno);
+      break;
+    }
+    offset += static_cast<size_t>(written);
+  }
+
+  m_buffer.clear();
+}
+
+void CaptureWriter::sync(void)
+{
+  flush();
+  if (::fdatasync(m_fd) < 0) {
+    logError() << "Capture sync failed: " << strerror(errno);
+  }
+}
+
+} // namespace tkm::reader
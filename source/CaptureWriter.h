@@ -0,0 +1,67 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     CaptureWriter Class
+ * @details   Append received envelopes to a raw capture file
+ *-
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <taskmonitor/taskmonitor.h>
+
+#include "Capture.h"
+
+#include "../bswinfra/source/Timer.h"
+
+using namespace bswi::event;
+
+namespace tkm::reader
+{
+
+/*
+ * Envelopes are stored as received, nothing is decoded. Frames are
+ * buffered and appended to the file (O_APPEND) when the buffer is full or
+ * on the flush timer. With a sync interval the file is also synced to
+ * disk at that interval.
+ */
+class CaptureWriter
+{
+public:
+  static CaptureWriter *getInstance()
+  {
+    return (!instance) ? instance = new CaptureWriter : instance;
+  }
+
+  bool isEnabled(void) { return (m_fd >= 0); }
+
+  void writeSession(const tkm::msg::monitor::SessionInfo &sessionInfo);
+  void writeEnvelope(const tkm::msg::Envelope &envelope);
+  void flush(void);
+  void sync(void);
+
+public:
+  CaptureWriter(CaptureWriter const &) = delete;
+  void operator=(CaptureWriter const &) = delete;
+
+private:
+  CaptureWriter();
+  ~CaptureWriter() = default;
+
+  void beginFrame(capture::FrameType type, size_t size);
+
+private:
+  static CaptureWriter *instance;
+  std::shared_ptr<Timer> m_flushTimer = nullptr;
+  std::shared_ptr<Timer> m_syncTimer = nullptr;
+  std::string m_buffer{};
+  size_t m_flushSize = 0;
+  int m_fd = -1;
+};
+
+} // namespace tkm::reader
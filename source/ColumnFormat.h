@@ -0,0 +1,79 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     Column file format
+ * @details   Layout of columnar table files
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace tkm::reader::columns
+{
+
+/*
+ * One file per table '<columns dir>/<table>.col'. Tables are the record
+ * types (stat, meminfo, ...) and, for records with keyed groups, one table
+ * per group kind (stat.core, procinfo.process, ...). All integers are little
+ * endian.
+ *
+ *   file header: "TKMCOL" u16 format version
+ *   block:       u32 block kind, u64 block size (header included), body
+ *
+ * RowGroup body:
+ *   u32 row count, u64 min system time, u64 max system time, u16 column count
+ *   per column: u16 name size, name, u8 type, u64 data offset (from block
+ *               start), u64 data size, u32 null count, u64 min, u64 max
+ *   column data
+ *
+ * Column data is a validity bitmap (only if the null count is not zero, bit
+ * set for present values) followed by the values: 8 byte numbers (doubles as
+ * IEEE 754 bits) or, for strings, the u32 end offset of each value followed by
+ * the string bytes. Min and max are those of the present values in the column
+ * type (0 for strings), a reader skips chunks by them without touching data.
+ *
+ * Footer body, written when the file is closed:
+ *   u64 group count, per group: u64 offset, u32 rows, u64 min time, u64 max time
+ *   u64 footer offset, "TKCOLEND"
+ *
+ * The trailer at the file end locates the footer. Files without it (writer
+ * killed) are read by walking the blocks, a block cut short ends the file.
+ * Writers append after the last complete block.
+ */
+constexpr std::string_view Magic = "TKMCOL";
+constexpr std::string_view Trailer = "TKCOLEND";
+constexpr uint16_t Version = 1;
+constexpr size_t FileHeaderSize = 8;
+constexpr size_t BlockHeaderSize = 12;
+constexpr size_t GroupHeaderSize = 22;
+constexpr size_t GroupEntrySize = 28;
+// Column entry without the name bytes, column info is the part after the name
+constexpr size_t ColumnInfoSize = 37;
+constexpr size_t ColumnEntrySize = sizeof(uint16_t) + ColumnInfoSize;
+constexpr size_t TrailerSize = 16;
+
+enum class BlockKind : uint32_t { RowGroup = 1, Footer = 2 };
+enum class Type : uint8_t { UInt64 = 1, Int64 = 2, Double = 3, String = 4 };
+
+typedef struct GroupEntry {
+  uint64_t offset;
+  uint32_t rows;
+  uint64_t minTime;
+  uint64_t maxTime;
+} GroupEntry;
+
+// Columns every table row starts with
+constexpr std::string_view SystemTime = "system_time";
+constexpr std::string_view MonotonicTime = "monotonic_time";
+constexpr std::string_view ReceiveTime = "receive_time";
+constexpr std::string_view Session = "session";
+// Key of keyed group rows that have no key field
+constexpr std::string_view Key = "key";
+
+} // namespace tkm::reader::columns
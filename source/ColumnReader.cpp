@@ -0,0 +1,230 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     ColumnReader Class
+ * @details   Read columns of memory mapped column table files
+ *-
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ColumnReader.h"
+#include "Logger.h"
+
+namespace tkm::reader
+{
+
+using capture::getUint;
+
+ColumnReader::ColumnReader(const std::string &path)
+{
+  struct stat st;
+
+  auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    logError() << "Cannot open column file " << path << ": " << strerror(errno);
+    return;
+  }
+
+  if ((::fstat(fd, &st) < 0) || (static_cast<uint64_t>(st.st_size) < columns::FileHeaderSize)) {
+    logError() << "Cannot read column file header from " << path;
+    ::close(fd);
+    return;
+  }
+
+  auto data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    logError() << "Cannot map column file " << path << ": " << strerror(errno);
+    return;
+  }
+
+  m_data = static_cast<const char *>(data);
+  m_size = static_cast<uint64_t>(st.st_size);
+
+  if ((std::string_view(m_data, columns::Magic.size()) != columns::Magic) ||
+      (getUint(m_data + columns::Magic.size(), sizeof(uint16_t)) != columns::Version)) {
+    logError() << "Not a supported column file: " << path;
+    ::munmap(const_cast<char *>(m_data), static_cast<size_t>(m_size));
+    m_data = nullptr;
+    m_size = 0;
+    return;
+  }
+
+  if (!readFooter()) {
+    walkBlocks();
+  }
+}
+
+ColumnReader::~ColumnReader()
+{
+  if (m_data != nullptr) {
+    ::munmap(const_cast<char *>(m_data), static_cast<size_t>(m_size));
+  }
+}
+
+bool ColumnReader::readFooter(void)
+{
+  if ((m_size < columns::FileHeaderSize + columns::BlockHeaderSize + columns::TrailerSize) ||
+      (std::string_view(m_data + m_size - columns::Trailer.size(), columns::Trailer.size()) !=
+       columns::Trailer)) {
+    return false;
+  }
+
+  auto offset = getUint(m_data + m_size - columns::TrailerSize, sizeof(uint64_t));
+  if ((offset < columns::FileHeaderSize) ||
+      (offset + columns::BlockHeaderSize + sizeof(uint64_t) > m_size) ||
+      (getUint(m_data + offset, sizeof(uint32_t)) !=
+       static_cast<uint32_t>(columns::BlockKind::Footer))) {
+    return false;
+  }
+
+  auto body = m_data + offset + columns::BlockHeaderSize;
+  auto count = getUint(body, sizeof(uint64_t));
+  if (offset + columns::BlockHeaderSize + sizeof(uint64_t) + count * columns::GroupEntrySize >
+      m_size) {
+    return false;
+  }
+
+  body += sizeof(uint64_t);
+  for (uint64_t i = 0; i < count; i++, body += columns::GroupEntrySize) {
+    m_groups.push_back(columns::GroupEntry{
+        .offset = getUint(body, sizeof(uint64_t)),
+        .rows = static_cast<uint32_t>(getUint(body + 8, sizeof(uint32_t))),
+        .minTime = getUint(body + 12, sizeof(uint64_t)),
+        .maxTime = getUint(body + 20, sizeof(uint64_t)),
+    });
+  }
+
+  m_footer = true;
+  m_validSize = offset;
+
+  return true;
+}
+
+void ColumnReader::walkBlocks(void)
+{
+  uint64_t offset = columns::FileHeaderSize;
+
+  while (offset + columns::BlockHeaderSize <= m_size) {
+    auto kind = getUint(m_data + offset, sizeof(uint32_t));
+    auto size = getUint(m_data + offset + 4, sizeof(uint64_t));
+    if ((size < columns::BlockHeaderSize) || (offset + size > m_size)) {
+      break;
+    }
+
+    if (kind == static_cast<uint32_t>(columns::BlockKind::RowGroup)) {
+      if (size < columns::BlockHeaderSize + columns::GroupHeaderSize) {
+        break;
+      }
+      auto body = m_data + offset + columns::BlockHeaderSize;
+      m_groups.push_back(columns::GroupEntry{
+          .offset = offset,
+          .rows = static_cast<uint32_t>(getUint(body, sizeof(uint32_t))),
+          .minTime = getUint(body + 4, sizeof(uint64_t)),
+          .maxTime = getUint(body + 12, sizeof(uint64_t)),
+      });
+    } else if (kind != static_cast<uint32_t>(columns::BlockKind::Footer)) {
+      break;
+    }
+
+    offset += size;
+    if (kind == static_cast<uint32_t>(columns::BlockKind::RowGroup)) {
+      m_validSize = offset;
+    }
+  }
+
+  if (m_validSize == 0) {
+    m_validSize = columns::FileHeaderSize;
+  }
+}
+
+bool ColumnReader::readColumns(const columns::GroupEntry &group,
+                               const std::vector<std::string> &names,
+                               std::vector<Column> &chunks) const
+{
+  chunks.clear();
+  if ((m_data == nullptr) ||
+      (group.offset + columns::BlockHeaderSize + columns::GroupHeaderSize > m_size)) {
+    return false;
+  }
+
+  auto block = m_data + group.offset;
+  auto blockSize = getUint(block + 4, sizeof(uint64_t));
+  if (group.offset + blockSize > m_size) {
+    return false;
+  }
+
+  auto count = getUint(block + columns::BlockHeaderSize + 20, sizeof(uint16_t));
+  auto entry = block + columns::BlockHeaderSize + columns::GroupHeaderSize;
+  auto end = block + blockSize;
+
+  for (uint64_t i = 0; i < count; i++) {
+    if (entry + sizeof(uint16_t) > end) {
+      return false;
+    }
+    auto nameSize = getUint(entry, sizeof(uint16_t));
+    if (entry + columns::ColumnEntrySize + nameSize > end) {
+      return false;
+    }
+
+    std::string_view name(entry + 2, nameSize);
+    auto info = entry + 2 + nameSize;
+    entry = info + columns::ColumnInfoSize;
+
+    if (!names.empty() && (std::find(names.cbegin(), names.cend(), name) == names.cend())) {
+      continue;
+    }
+
+    auto dataOffset = getUint(info + 1, sizeof(uint64_t));
+    auto dataSize = getUint(info + 9, sizeof(uint64_t));
+    if (dataOffset + dataSize > blockSize) {
+      return false;
+    }
+
+    Column column = {.name = name,
+                     .type = static_cast<columns::Type>(getUint(info, sizeof(uint8_t))),
+                     .rows = group.rows,
+                     .nulls = static_cast<uint32_t>(getUint(info + 17, sizeof(uint32_t))),
+                     .min = getUint(info + 21, sizeof(uint64_t)),
+                     .max = getUint(info + 29, sizeof(uint64_t)),
+                     .bitmap = nullptr,
+                     .data = block + dataOffset};
+    if (column.nulls > 0) {
+      column.bitmap = column.data;
+      column.data += (group.rows + 7) / 8;
+    }
+    chunks.push_back(column);
+  }
+
+  return true;
+}
+
+auto ColumnReader::doubleAt(const Column &column, size_t row) -> double
+{
+  double val;
+  auto bits = uintAt(column, row);
+
+  std::memcpy(&val, &bits, sizeof(val));
+  return val;
+}
+
+auto ColumnReader::stringAt(const Column &column, size_t row) -> std::string_view
+{
+  auto strings = column.data + static_cast<size_t>(column.rows) * sizeof(uint32_t);
+  auto begin = (row == 0) ? 0 : capture::getUint(column.data + (row - 1) * 4, sizeof(uint32_t));
+  auto end = capture::getUint(column.data + row * 4, sizeof(uint32_t));
+
+  return std::string_view(strings + begin, end - begin);
+}
+
+} // namespace tkm::reader
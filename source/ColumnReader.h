@@ -0,0 +1,90 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     ColumnReader Class
+ * @details   Read columns of memory mapped column table files
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Capture.h"
+#include "ColumnFormat.h"
+
+namespace tkm::reader
+{
+
+/*
+ * The row groups are listed from the footer, or by walking the blocks
+ * if the file was not closed. Columns point into the mapping, only the
+ * pages of the column chunks accessed are loaded.
+ */
+class ColumnReader
+{
+public:
+  typedef struct Column {
+    std::string_view name;
+    columns::Type type;
+    uint32_t rows;
+    uint32_t nulls;
+    uint64_t min;
+    uint64_t max;
+    const char *bitmap;
+    const char *data;
+  } Column;
+
+public:
+  explicit ColumnReader(const std::string &path);
+  ~ColumnReader();
+
+public:
+  ColumnReader(ColumnReader const &) = delete;
+  void operator=(ColumnReader const &) = delete;
+
+  bool isOpen(void) const { return m_data != nullptr; }
+  bool hasFooter(void) const { return m_footer; }
+  auto getGroups(void) const -> const std::vector<columns::GroupEntry> & { return m_groups; }
+  // End of the last complete row group, writers append from there
+  auto getValidSize(void) const -> uint64_t { return m_validSize; }
+
+  // Column chunks of a row group, all columns if names is empty
+  bool readColumns(const columns::GroupEntry &group,
+                   const std::vector<std::string> &names,
+                   std::vector<Column> &chunks) const;
+
+  static bool isNull(const Column &column, size_t row)
+  {
+    return (column.bitmap != nullptr) && ((column.bitmap[row / 8] & (1 << (row % 8))) == 0);
+  }
+  static auto uintAt(const Column &column, size_t row) -> uint64_t
+  {
+    return capture::getUint(column.data + row * sizeof(uint64_t), sizeof(uint64_t));
+  }
+  static auto intAt(const Column &column, size_t row) -> int64_t
+  {
+    return static_cast<int64_t>(uintAt(column, row));
+  }
+  static auto doubleAt(const Column &column, size_t row) -> double;
+  static auto stringAt(const Column &column, size_t row) -> std::string_view;
+
+private:
+  bool readFooter(void);
+  void walkBlocks(void);
+
+private:
+  const char *m_data = nullptr;
+  uint64_t m_size = 0;
+  uint64_t m_validSize = 0;
+  bool m_footer = false;
+  std::vector<columns::GroupEntry> m_groups{};
+};
+
+} // namespace tkm::reader
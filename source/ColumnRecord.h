@@ -0,0 +1,168 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     ColumnRecord Class
+ * @details   Build data records as rows of columnar tables
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "ColumnTable.h"
+
+namespace tkm::reader
+{
+
+/*
+ * Same builder interface as JsonRecord. Fields outside keyed groups form
+ * one row of the record type table, named after their groups ('cpu.all',
+ * 'cpu.full.avg10'). Each keyed group is a row of the '<type>.<kind>'
+ * table, with a 'key' column when the key is not one of its fields.
+ */
+class ColumnRecord
+{
+public:
+  explicit ColumnRecord(std::map<std::string, ColumnTable, std::less<>> &tables)
+  : m_tables(tables)
+  {
+  }
+  ~ColumnRecord() = default;
+
+public:
+  ColumnRecord(ColumnRecord const &) = delete;
+  void operator=(ColumnRecord const &) = delete;
+
+  void begin(const char *type,
+             const std::string &session,
+             uint64_t systemTime,
+             uint64_t monotonicTime,
+             uint64_t receiveTime)
+  {
+    m_type = type;
+    m_session = session;
+    m_systemTime = systemTime;
+    m_monotonicTime = monotonicTime;
+    m_receiveTime = receiveTime;
+    m_base = nullptr;
+    m_keyed = nullptr;
+    m_keyedDepth = SIZE_MAX;
+    m_groups.clear();
+  }
+  void end(void)
+  {
+    if (m_base != nullptr) {
+      m_base->endRow();
+    }
+  }
+
+  void beginGroup(const char *kind) { m_groups.push_back(kind); }
+  void beginGroup(const char *kind, std::string_view key, const char *keyField = nullptr)
+  {
+    beginKeyedGroup(kind);
+    if (keyField == nullptr) {
+      m_keyed->set(columns::Key, key);
+    }
+  }
+  void beginGroup(const char *kind, int64_t key, const char *keyField = nullptr)
+  {
+    beginKeyedGroup(kind);
+    if (keyField == nullptr) {
+      m_keyed->set(columns::Key, key);
+    }
+  }
+  void endGroup(void)
+  {
+    if (m_groups.size() == m_keyedDepth) {
+      if (m_keyed != nullptr) {
+        m_keyed->endRow();
+        m_keyed = nullptr;
+      }
+      m_keyedDepth = SIZE_MAX;
+      return;
+    }
+    if (!m_groups.empty()) {
+      m_groups.pop_back();
+    }
+  }
+
+  template <class T>
+  void field(std::string_view name, const T &val)
+  {
+    ColumnTable *table = m_keyed;
+    if (table == nullptr) {
+      table = baseRow();
+    }
+
+    auto column = columnName(name);
+    if constexpr (std::is_same_v<T, bool> || std::is_unsigned_v<T>) {
+      table->set(column, static_cast<uint64_t>(val));
+    } else if constexpr (std::is_integral_v<T>) {
+      table->set(column, static_cast<int64_t>(val));
+    } else if constexpr (std::is_floating_point_v<T>) {
+      table->set(column, static_cast<double>(val));
+    } else {
+      table->set(column, std::string_view(val));
+    }
+  }
+
+private:
+  auto beginRow(const std::string &name) -> ColumnTable *
+  {
+    auto &table = m_tables.try_emplace(name).first->second;
+
+    table.beginRow();
+    table.set(columns::SystemTime, m_systemTime);
+    table.set(columns::MonotonicTime, m_monotonicTime);
+    table.set(columns::ReceiveTime, m_receiveTime);
+    table.set(columns::Session, std::string_view(m_session));
+
+    return &table;
+  }
+  auto baseRow(void) -> ColumnTable *
+  {
+    // Records with keyed groups only have no base row
+    if (m_base == nullptr) {
+      m_base = beginRow(m_type);
+    }
+    return m_base;
+  }
+  void beginKeyedGroup(const char *kind)
+  {
+    m_keyed = beginRow(m_type + "." + kind);
+    m_keyedDepth = m_groups.size();
+  }
+  auto columnName(std::string_view name) const -> std::string
+  {
+    std::string column;
+    auto first = (m_keyed != nullptr) ? m_keyedDepth : 0;
+
+    for (size_t i = first; i < m_groups.size(); i++) {
+      column.append(m_groups[i]).push_back('.');
+    }
+    return column.append(name);
+  }
+
+private:
+  std::map<std::string, ColumnTable, std::less<>> &m_tables;
+  std::string m_type{};
+  std::string m_session{};
+  uint64_t m_systemTime = 0;
+  uint64_t m_monotonicTime = 0;
+  uint64_t m_receiveTime = 0;
+  ColumnTable *m_base = nullptr;
+  ColumnTable *m_keyed = nullptr;
+  size_t m_keyedDepth = SIZE_MAX;
+  std::vector<const char *> m_groups{};
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,243 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     ColumnTable Class
+ * @details   Build the row groups of a columnar table
+ *-
+ */
+
+#include <cstring>
+
+#include "Capture.h"
+#include "ColumnTable.h"
+
+namespace tkm::reader
+{
+
+using capture::putUint;
+
+static auto doubleBits(double val) -> uint64_t
+{
+  uint64_t bits;
+  std::memcpy(&bits, &val, sizeof(bits));
+  return bits;
+}
+
+static auto bitsDouble(uint64_t bits) -> double
+{
+  double val;
+  std::memcpy(&val, &bits, sizeof(val));
+  return val;
+}
+
+auto ColumnTable::column(std::string_view name, columns::Type type) -> Column *
+{
+  auto it = m_index.find(name);
+  if (it == m_index.end()) {
+    // Rows written before the column existed are nulls
+    m_columns.push_back(Column{.name = std::string(name),
+                               .type = type,
+                               .values = std::vector<uint64_t>(m_rows, 0),
+                               .ends = std::vector<uint32_t>(),
+                               .strings = std::string(),
+                               .present = std::vector<bool>(m_rows, false),
+                               .nulls = m_rows});
+    if (type == columns::Type::String) {
+      m_columns.back().values.clear();
+      m_columns.back().ends.assign(m_rows, 0);
+    }
+    it = m_index.emplace(std::string(name), m_columns.size() - 1).first;
+  }
+
+  auto col = &m_columns[it->second];
+  if (col->type != type) {
+    // Field types are fixed by the record definitions, ignore mismatches
+    return nullptr;
+  }
+
+  // Setting a column twice in a row keeps the last value
+  if (col->present.size() > m_rows) {
+    col->present.pop_back();
+    if (type == columns::Type::String) {
+      col->ends.pop_back();
+      col->strings.resize(col->ends.empty() ? 0 : col->ends.back());
+    } else {
+      col->values.pop_back();
+    }
+  }
+
+  return col;
+}
+
+void ColumnTable::set(std::string_view name, uint64_t val)
+{
+  if (auto col = column(name, columns::Type::UInt64); col != nullptr) {
+    col->values.push_back(val);
+    col->present.push_back(true);
+  }
+}
+
+void ColumnTable::set(std::string_view name, int64_t val)
+{
+  if (auto col = column(name, columns::Type::Int64); col != nullptr) {
+    col->values.push_back(static_cast<uint64_t>(val));
+    col->present.push_back(true);
+  }
+}
+
+void ColumnTable::set(std::string_view name, double val)
+{
+  if (auto col = column(name, columns::Type::Double); col != nullptr) {
+    col->values.push_back(doubleBits(val));
+    col->present.push_back(true);
+  }
+}
+
+void ColumnTable::set(std::string_view name, std::string_view val)
+{
+  if (auto col = column(name, columns::Type::String); col != nullptr) {
+    col->strings.append(val);
+    col->ends.push_back(static_cast<uint32_t>(col->strings.size()));
+    col->present.push_back(true);
+  }
+}
+
+void ColumnTable::endRow(void)
+{
+  m_rows++;
+
+  for (auto &col : m_columns) {
+    if (col.present.size() == m_rows) {
+      continue;
+    }
+    col.present.push_back(false);
+    col.nulls++;
+    if (col.type == columns::Type::String) {
+      col.ends.push_back(static_cast<uint32_t>(col.strings.size()));
+    } else {
+      col.values.push_back(0);
+    }
+  }
+}
+
+void ColumnTable::encode(std::string &out, columns::GroupEntry &entry)
+{
+  std::string header;
+  std::string data;
+  size_t headerSize = columns::BlockHeaderSize + columns::GroupHeaderSize;
+  uint16_t columnCount = 0;
+
+  entry.rows = static_cast<uint32_t>(m_rows);
+  entry.minTime = 0;
+  entry.maxTime = 0;
+
+  // Columns without values in this group are not written
+  for (const auto &col : m_columns) {
+    if (col.nulls < m_rows) {
+      headerSize += columns::ColumnEntrySize + col.name.size();
+      columnCount++;
+    }
+  }
+
+  for (const auto &col : m_columns) {
+    if (col.nulls >= m_rows) {
+      continue;
+    }
+    encodeColumn(col, headerSize, header, data);
+    if (col.name == columns::SystemTime) {
+      entry.minTime = capture::getUint(header.data() + header.size() - 16, sizeof(uint64_t));
+      entry.maxTime = capture::getUint(header.data() + header.size() - 8, sizeof(uint64_t));
+    }
+  }
+
+  auto blockSize = headerSize + data.size();
+  out.reserve(out.size() + blockSize);
+  putUint(out, static_cast<uint32_t>(columns::BlockKind::RowGroup), sizeof(uint32_t));
+  putUint(out, blockSize, sizeof(uint64_t));
+  putUint(out, entry.rows, sizeof(uint32_t));
+  putUint(out, entry.minTime, sizeof(uint64_t));
+  putUint(out, entry.maxTime, sizeof(uint64_t));
+  putUint(out, columnCount, sizeof(uint16_t));
+  out.append(header);
+  out.append(data);
+
+  // Keep the column definitions, the next group likely has the same
+  for (auto &col : m_columns) {
+    col.values.clear();
+    col.ends.clear();
+    col.strings.clear();
+    col.present.clear();
+    col.nulls = 0;
+  }
+  m_rows = 0;
+}
+
+void ColumnTable::encodeColumn(const Column &column,
+                               size_t headerSize,
+                               std::string &header,
+                               std::string &data)
+{
+  uint64_t minVal = 0;
+  uint64_t maxVal = 0;
+  bool first = true;
+  auto dataOffset = headerSize + data.size();
+
+  if (column.nulls > 0) {
+    std::string bitmap((m_rows + 7) / 8, '\0');
+    for (size_t i = 0; i < m_rows; i++) {
+      if (column.present[i]) {
+        bitmap[i / 8] = static_cast<char>(bitmap[i / 8] | (1 << (i % 8)));
+      }
+    }
+    data.append(bitmap);
+  }
+
+  if (column.type == columns::Type::String) {
+    for (auto end : column.ends) {
+      putUint(data, end, sizeof(uint32_t));
+    }
+    data.append(column.strings);
+  } else {
+    for (size_t i = 0; i < m_rows; i++) {
+      auto val = column.values[i];
+      putUint(data, val, sizeof(uint64_t));
+      if (!column.present[i]) {
+        continue;
+      }
+
+      bool less = false;
+      bool greater = false;
+      if (column.type == columns::Type::UInt64) {
+        less = (val < minVal);
+        greater = (val > maxVal);
+      } else if (column.type == columns::Type::Int64) {
+        less = (static_cast<int64_t>(val) < static_cast<int64_t>(minVal));
+        greater = (static_cast<int64_t>(val) > static_cast<int64_t>(maxVal));
+      } else {
+        less = (bitsDouble(val) < bitsDouble(minVal));
+        greater = (bitsDouble(val) > bitsDouble(maxVal));
+      }
+      if (first || less) {
+        minVal = val;
+      }
+      if (first || greater) {
+        maxVal = val;
+      }
+      first = false;
+    }
+  }
+
+  putUint(header, column.name.size(), sizeof(uint16_t));
+  header.append(column.name);
+  putUint(header, static_cast<uint8_t>(column.type), sizeof(uint8_t));
+  putUint(header, dataOffset, sizeof(uint64_t));
+  putUint(header, headerSize + data.size() - dataOffset, sizeof(uint64_t));
+  putUint(header, column.nulls, sizeof(uint32_t));
+  putUint(header, minVal, sizeof(uint64_t));
+  putUint(header, maxVal, sizeof(uint64_t));
+}
+
+} // namespace tkm::reader
@@ -0,0 +1,75 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     ColumnTable Class
+ * @details   Build the row groups of a columnar table
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ColumnFormat.h"
+
+namespace tkm::reader
+{
+
+/*
+ * Rows are added field by field between beginRow and endRow. Columns are
+ * created on first use, rows before that and rows not setting a column
+ * hold nulls. encode() writes the pending rows as a row group block.
+ */
+class ColumnTable
+{
+public:
+  ColumnTable() = default;
+  ~ColumnTable() = default;
+
+public:
+  ColumnTable(ColumnTable const &) = delete;
+  void operator=(ColumnTable const &) = delete;
+
+  void beginRow(void) {}
+  void endRow(void);
+  auto getRows(void) const -> size_t { return m_rows; }
+
+  void set(std::string_view name, uint64_t val);
+  void set(std::string_view name, int64_t val);
+  void set(std::string_view name, double val);
+  void set(std::string_view name, std::string_view val);
+
+  // Append the row group block of the pending rows to out and drop them
+  void encode(std::string &out, columns::GroupEntry &entry);
+
+private:
+  typedef struct Column {
+    std::string name;
+    columns::Type type;
+    std::vector<uint64_t> values;
+    std::vector<uint32_t> ends;
+    std::string strings;
+    std::vector<bool> present;
+    size_t nulls;
+  } Column;
+
+  auto column(std::string_view name, columns::Type type) -> Column *;
+  void encodeColumn(const Column &column,
+                    size_t headerSize,
+                    std::string &header,
+                    std::string &data);
+
+private:
+  std::map<std::string, size_t, std::less<>> m_index{};
+  std::vector<Column> m_columns{};
+  size_t m_rows = 0;
+};
+
+} // namespace tkm::reader
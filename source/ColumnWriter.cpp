@@ -0,0 +1,208 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     ColumnWriter Class
+ * @details   Write data records to columnar table files
+ *-
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <filesystem>
+#include <unistd.h>
+
+#include "../bswinfra/source/Logger.h"
+#include "Application.h"
+#include "Arguments.h"
+#include "ColumnReader.h"
+#include "ColumnWriter.h"
+
+namespace tkm::reader
+{
+
+using capture::putUint;
+
+ColumnWriter *ColumnWriter::instance = nullptr;
+
+ColumnWriter::ColumnWriter()
+{
+  if (!App()->getArguments()->hasFor(Arguments::Key::ColumnPath)) {
+    return;
+  }
+
+  auto outPath = App()->getArguments()->getFor(Arguments::Key::ColumnPath);
+  std::error_code ec;
+  std::filesystem::create_directories(outPath, ec);
+  if (!std::filesystem::is_directory(outPath)) {
+    logError() << "Cannot create column directory " << outPath;
+    return;
+  }
+  m_path = outPath;
+
+  m_groupRows = std::stoul(tkmDefaults.getFor(Defaults::Default::ColumnGroupRows));
+
+  // Bounds the rows lost on a crash, at the cost of smaller row groups
+  m_flushTimer = std::make_shared<Timer>("ColumnFlushTimer", [this]() {
+    flush();
+    return true;
+  });
+  m_flushTimer->start(std::stoul(tkmDefaults.getFor(Defaults::Default::ColumnFlushInterval)),
+                      true);
+  App()->addEventSource(m_flushTimer);
+
+  std::atexit([]() { ColumnWriter::getInstance()->close(); });
+}
+
+bool ColumnWriter::isEnabledFor(tkm::msg::monitor::Data_What what)
+{
+  if (m_path.empty()) {
+    return false;
+  }
+  return App()->isRecordTypeSelected(what);
+}
+
+void ColumnWriter::commit(void)
+{
+  for (auto &[name, table] : m_tables) {
+    if (table.getRows() >= m_groupRows) {
+      writeGroup(name, table);
+    }
+  }
+}
+
+void ColumnWriter::flush(void)
+{
+  for (auto &[name, table] : m_tables) {
+    if (table.getRows() > 0) {
+      writeGroup(name, table);
+    }
+  }
+}
+
+void ColumnWriter::close(void)
+{
+  flush();
+
+  for (auto &[name, file] : m_files) {
+    if (file.fd < 0) {
+      continue;
+    }
+
+    m_block.clear();
+    putUint(m_block, static_cast<uint32_t>(columns::BlockKind::Footer), sizeof(uint32_t));
+    putUint(m_block,
+            columns::BlockHeaderSize + sizeof(uint64_t) +
+                file.groups.size() * columns::GroupEntrySize + columns::TrailerSize,
+            sizeof(uint64_t));
+    putUint(m_block, file.groups.size(), sizeof(uint64_t));
+    for (const auto &group : file.groups) {
+      putUint(m_block, group.offset, sizeof(uint64_t));
+      putUint(m_block, group.rows, sizeof(uint32_t));
+      putUint(m_block, group.minTime, sizeof(uint64_t));
+      putUint(m_block, group.maxTime, sizeof(uint64_t));
+    }
+    putUint(m_block, file.size, sizeof(uint64_t));
+    m_block.append(columns::Trailer);
+
+    writeBlock(&file, m_block);
+    ::close(file.fd);
+    file.fd = -1;
+  }
+}
+
+auto ColumnWriter::tableFile(const std::string &name) -> TableFile *
+{
+  auto it = m_files.find(name);
+  if (it != m_files.end()) {
+    return (it->second.fd < 0) ? nullptr : &it->second;
+  }
+
+  auto filePath = m_path + "/" + name + ".col";
+  TableFile file = {.fd = -1, .size = 0, .groups = std::vector<columns::GroupEntry>()};
+
+  // Continue an existing table after its last complete row group
+  std::error_code ec;
+  auto fileSize = std::filesystem::file_size(filePath, ec);
+  if (!ec && (fileSize > 0)) {
+    ColumnReader reader(filePath);
+    if (reader.isOpen()) {
+      file.size = reader.getValidSize();
+      file.groups = reader.getGroups();
+    } else {
+      logError() << "Column table " << name << " disabled";
+      m_files.emplace(name, file);
+      return nullptr;
+    }
+  }
+
+  file.fd = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+  if (file.fd < 0) {
+    logError() << "Cannot open column file " << filePath << ": " << strerror(errno);
+    m_files.emplace(name, file);
+    return nullptr;
+  }
+
+  if ((::ftruncate(file.fd, static_cast<off_t>(file.size)) < 0) ||
+      (::lseek(file.fd, 0, SEEK_END) < 0)) {
+    logError() << "Cannot truncate column file " << filePath << ": " << strerror(errno);
+  }
+
+  auto tableFile = &m_files.emplace(name, file).first->second;
+  if (tableFile->size == 0) {
+    m_block.clear();
+    m_block.append(columns::Magic);
+    putUint(m_block, columns::Version, sizeof(uint16_t));
+    writeBlock(tableFile, m_block);
+  }
+
+  return tableFile;
+}
+
+void ColumnWriter::writeGroup(const std::string &name, ColumnTable &table)
+{
+  columns::GroupEntry entry{};
+  auto file = tableFile(name);
+
+  // Rows of disabled tables are dropped as well
+  m_block.clear();
+  table.encode(m_block, entry);
+  if (file == nullptr) {
+    return;
+  }
+
+  entry.offset = file->size;
+  if (writeBlock(file, m_block)) {
+    file->groups.push_back(entry);
+  }
+}
+
+bool ColumnWriter::writeBlock(TableFile *file, const std::string &block)
+{
+  size_t offset = 0;
+
+  while (offset < block.size()) {
+    auto written = ::write(file->fd, block.data() + offset, block.size() - offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      logError() << "Column write failed: " << strerror(errno);
+      // Cut the partial block so the next one starts on a block boundary
+      if (::ftruncate(file->fd, static_cast<off_t>(file->size)) == 0) {
+        ::lseek(file->fd, 0, SEEK_END);
+      }
+      return false;
+    }
+    offset += static_cast<size_t>(written);
+  }
+
+  file->size += block.size();
+  return true;
+}
+
+} // namespace tkm::reader
@@ -0,0 +1,83 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     ColumnWriter Class
+ * @details   Write data records to columnar table files
+ *-
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <taskmonitor/taskmonitor.h>
+#include <vector>
+
+#include "ColumnRecord.h"
+#include "ColumnTable.h"
+
+#include "../bswinfra/source/Timer.h"
+
+using namespace bswi::event;
+
+namespace tkm::reader
+{
+
+/*
+ * Rows are kept in memory per table and written as a row group once a
+ * table holds ColumnGroupRows rows, or on the flush timer. The footer is
+ * written at exit, reopened files are cut back to the last complete row
+ * group and appended to.
+ */
+class ColumnWriter
+{
+public:
+  static ColumnWriter *getInstance()
+  {
+    return (!instance) ? instance = new ColumnWriter : instance;
+  }
+
+  bool isEnabled(void) { return !m_path.empty(); }
+  bool isEnabledFor(tkm::msg::monitor::Data_What what);
+
+  auto getRecord(void) -> ColumnRecord & { return m_record; }
+
+  // Write the tables holding a full row group
+  void commit(void);
+  void flush(void);
+  void close(void);
+
+public:
+  ColumnWriter(ColumnWriter const &) = delete;
+  void operator=(ColumnWriter const &) = delete;
+
+private:
+  ColumnWriter();
+  ~ColumnWriter() = default;
+
+  typedef struct TableFile {
+    int fd;
+    uint64_t size;
+    std::vector<columns::GroupEntry> groups;
+  } TableFile;
+
+  auto tableFile(const std::string &name) -> TableFile *;
+  void writeGroup(const std::string &name, ColumnTable &table);
+  bool writeBlock(TableFile *file, const std::string &block);
+
+private:
+  static ColumnWriter *instance;
+  std::string m_path{};
+  std::map<std::string, ColumnTable, std::less<>> m_tables{};
+  ColumnRecord m_record{m_tables};
+  std::map<std::string, TableFile> m_files{};
+  std::shared_ptr<Timer> m_flushTimer = nullptr;
+  std::string m_block{};
+  size_t m_groupRows = 0;
+};
+
+} // namespace tkm::reader
@@ -19,6 +19,7 @@
 #include <unistd.h>
 
 #include "Application.h"
+#include "CaptureWriter.h"
 #include "Connection.h"
 #include "Defaults.h"
 #include "Logger.h"
@@ -33,10 +34,29 @@ Connection::Connection()
     throw std::runtime_error("Fail to create Connection socket");
   }
 
-  m_reader = std::make_unique<EnvelopeReader>(m_sockFd);
+  auto args = App()->getArguments();
+  if (args->hasFor(Arguments::Key::CaptureStreamPath)) {
+    m_streamTee = std::make_unique<StreamTee>(m_sockFd);
+    m_reader = std::make_unique<EnvelopeReader>(m_streamTee->getReaderFD());
+  } else {
+    m_reader = std::make_unique<EnvelopeReader>(m_sockFd);
+  }
   m_writer = std::make_unique<EnvelopeWriter>(m_sockFd);
   m_lastUpdateTime = std::chrono::steady_clock::now();
 
+  // In capture only mode data payloads are stored without being decoded
+  auto capture = CaptureWriter::getInstance()->isEnabled() || (m_streamTee != nullptr);
+  m_dispatchData = !capture || args->hasFor(Arguments::Key::DatabasePath) ||
+                   args->hasFor(Arguments::Key::JsonPath) ||
+                   args->hasFor(Arguments::Key::MsgPackPath) ||
+                   args->hasFor(Arguments::Key::ColumnPath) ||
+                   args->hasFor(Arguments::Key::SeriesPath) ||
+                   args->hasFor(Arguments::Key::StorePath) ||
+                   args->hasFor(Arguments::Key::LivePath) ||
+                   args->hasFor(Arguments::Key::LatestPath) ||
+                   args->hasFor(Arguments::Key::RingPath) ||
+                   args->hasFor(Arguments::Key::BurstRules);
+
   lateSetup(
       [this]() {
         auto status = true;
@@ -65,6 +85,13 @@ Connection::Connection()
           envelope.mesg().UnpackTo(&msg);
           m_lastUpdateTime = std::chrono::steady_clock::now();
 
+          if (msg.type() == tkm::msg::monitor::Message_Type_SetSession) {
+            tkm::msg::monitor::SessionInfo sessionInfo;
+            msg.payload().UnpackTo(&sessionInfo);
+            CaptureWriter::getInstance()->writeSession(sessionInfo);
+          }
+          CaptureWriter::getInstance()->writeEnvelope(envelope);
+
           switch (msg.type()) {
           case tkm::msg::monitor::Message_Type_SetSession: {
             Dispatcher::Request rq{.action = Dispatcher::Action::SetSession,
@@ -89,7 +116,13 @@ Connection::Connection()
                                    .args = std::map<tkm::reader::Defaults::Arg, std::string>()};
             tkm::msg::monitor::Data data;
 
+            // The data payload itself stays packed
             msg.payload().UnpackTo(&data);
+            App()->setDataReplied(data.what());
+            if (!m_dispatchData) {
+              break;
+            }
+
             data.set_receive_time_sec(static_cast<uint64_t>(time(NULL)));
             rq.bulkData = std::make_any<tkm::msg::monitor::Data>(data);
 
@@ -103,6 +136,7 @@ Connection::Connection()
             tkm::msg::monitor::Status s;
 
             msg.payload().UnpackTo(&s);
+            App()->setStatusReplied(s.request_id());
             rq.bulkData = std::make_any<tkm::msg::monitor::Status>(s);
 
             App()->getDispatcher()->pushRequest(rq);
@@ -229,6 +263,10 @@ auto Connection::connect() -> int
     return -1;
   }
 
+  if (m_streamTee != nullptr) {
+    m_streamTee->open(App()->getArguments()->getFor(Arguments::Key::CaptureStreamPath));
+  }
+
   // We are ready to process events
   logInfo() << "Connected to monitor";
   setPrepare([]() { return true; });
@@ -16,6 +16,7 @@
 #include <taskmonitor/taskmonitor.h>
 
 #include "Arguments.h"
+#include "StreamTee.h"
 
 #include "../bswinfra/source/Exceptions.h"
 #include "../bswinfra/source/IApplication.h"
@@ -45,7 +46,19 @@ public:
 
   auto readEnvelope(tkm::msg::Envelope &envelope) -> tkm::IAsyncEnvelope::Status
   {
-    return m_reader->next(envelope);
+    auto status = m_reader->next(envelope);
+
+    // With a stream tee the reader pipe is refilled from the socket on demand.
+    // An idle socket returns Again to the main loop, pumping again would spin.
+    while ((status == tkm::IAsyncEnvelope::Status::Again) && (m_streamTee != nullptr)) {
+      auto pumpStatus = m_streamTee->pump();
+      if (pumpStatus != tkm::IAsyncEnvelope::Status::Ok) {
+        return pumpStatus;
+      }
+      status = m_reader->next(envelope);
+    }
+
+    return status;
   }
 
   bool writeEnvelope(const tkm::msg::Envelope &envelope)
@@ -56,6 +69,15 @@ public:
     return true;
   }
 
+  // Append envelope to the writer buffer without flushing. Used to batch
+  // several requests in a single flushEnvelopes call.
+  bool queueEnvelope(const tkm::msg::Envelope &envelope)
+  {
+    return m_writer->send(envelope) == tkm::IAsyncEnvelope::Status::Ok;
+  }
+
+  bool flushEnvelopes(void) { return m_writer->flush(); }
+
   auto getLastUpdateTime() -> std::chrono::time_point<std::chrono::steady_clock> &
   {
     return m_lastUpdateTime;
@@ -65,7 +87,9 @@ private:
   std::chrono::time_point<std::chrono::steady_clock> m_lastUpdateTime{};
   std::unique_ptr<tkm::EnvelopeReader> m_reader = nullptr;
   std::unique_ptr<tkm::EnvelopeWriter> m_writer = nullptr;
+  std::unique_ptr<StreamTee> m_streamTee = nullptr;
   struct sockaddr_in m_addr = {};
+  bool m_dispatchData = true;
   int m_sockFd = -1;
 };
 
@@ -0,0 +1,397 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     Data records
+ * @details   Fields written for each monitor data type
+ *-
+ */
+
+#pragma once
+
+#include <taskmonitor/taskmonitor.h>
+
+namespace tkm::reader
+{
+
+/*
+ * Record builders (JsonRecord, MsgPackRecord) share the same interface so
+ * all outputs write the same fields from the functions below.
+ */
+template <class Record>
+void printRecord(Record &record, const tkm::msg::monitor::ProcAcct &acct)
+{
+  record.beginGroup("common");
+  record.field("ac_comm", acct.ac_comm());
+  record.field("ac_gid", acct.ac_gid());
+  record.field("ac_pid", acct.ac_pid());
+  record.field("ac_ppid", acct.ac_ppid());
+  record.field("ac_stime", acct.ac_stime());
+  record.field("ac_uid", acct.ac_uid());
+  record.field("ac_utime", acct.ac_utime());
+  record.endGroup();
+
+  record.beginGroup("cpu");
+  record.field("cpu_count", acct.cpu().cpu_count());
+  record.field("cpu_delay_average", acct.cpu().cpu_delay_average());
+  record.field("cpu_delay_total", acct.cpu().cpu_delay_total());
+  record.field("cpu_run_real_total", acct.cpu().cpu_run_real_total());
+  record.field("cpu_run_virtual_total", acct.cpu().cpu_run_virtual_total());
+  record.endGroup();
+
+  record.beginGroup("mem");
+  record.field("coremem", acct.mem().coremem());
+  record.field("hiwater_rss", acct.mem().hiwater_rss());
+  record.field("hiwater_vm", acct.mem().hiwater_vm());
+  record.field("virtmem", acct.mem().virtmem());
+  record.endGroup();
+
+  record.beginGroup("ctx");
+  record.field("nivcsw", acct.ctx().nivcsw());
+  record.field("nvcsw", acct.ctx().nvcsw());
+  record.endGroup();
+
+  // The swap object always carried the ctx values, keep the output unchanged
+  record.beginGroup("swap");
+  record.field("nivcsw", acct.ctx().nivcsw());
+  record.field("nvcsw", acct.ctx().nvcsw());
+  record.endGroup();
+
+  record.beginGroup("io");
+  record.field("blkio_count", acct.io().blkio_count());
+  record.field("blkio_delay_average", acct.io().blkio_delay_average());
+  record.field("blkio_delay_total", acct.io().blkio_delay_total());
+  record.field("read_bytes", acct.io().read_bytes());
+  record.field("read_char", acct.io().read_char());
+  record.field("read_syscalls", acct.io().read_syscalls());
+  record.field("write_bytes", acct.io().write_bytes());
+  record.field("write_char", acct.io().write_char());
+  record.field("write_syscalls", acct.io().write_syscalls());
+  record.endGroup();
+
+  record.beginGroup("reclaim");
+  record.field("freepages_count", acct.reclaim().freepages_count());
+  record.field("freepages_delay_average", acct.reclaim().freepages_delay_average());
+  record.field("freepages_delay_total", acct.reclaim().freepages_delay_total());
+  record.endGroup();
+
+  record.beginGroup("thrashing");
+  record.field("thrashing_count", acct.thrashing().thrashing_count());
+  record.field("thrashing_delay_average", acct.thrashing().thrashing_delay_average());
+  record.field("thrashing_delay_total", acct.thrashing().thrashing_delay_total());
+  record.endGroup();
+}
+
+template <class Record>
+void printRecord(Record &record, const tkm::msg::monitor::ProcInfo &info)
+{
+  for (const auto &procEntry : info.entry()) {
+    record.beginGroup("process", static_cast<int64_t>(procEntry.pid()), "pid");
+    record.field("comm", procEntry.comm());
+    record.field("cpu_percent", procEntry.cpu_percent());
+    record.field("cpu_time", procEntry.cpu_time());
+    record.field("ctx_id", procEntry.ctx_id());
+    record.field("ctx_name", procEntry.ctx_name());
+    record.field("fd_count", procEntry.fd_count());
+    record.field("mem_pss", procEntry.mem_pss());
+    record.field("mem_rss", procEntry.mem_rss());
+    record.field("pid", procEntry.pid());
+    record.field("ppid", procEntry.ppid());
+    record.endGroup();
+  }
+}
+
+template <class Record>
+void printRecord(Record &record, const tkm::msg::monitor::ContextInfo &info)
+{
+  for (const auto &ctxEntry : info.entry()) {
+    record.beginGroup("context", ctxEntry.ctx_name(), "ctx_name");
+    record.field("ctx_id", ctxEntry.ctx_id());
+    record.field("ctx_name", ctxEntry.ctx_name());
+    record.field("total_cpu_percent", ctxEntry.total_cpu_percent());
+    record.field("total_cpu_time", ctxEntry.total_cpu_time());
+    record.field("total_fd_count", ctxEntry.total_fd_count());
+    record.field("total_mem_pss", ctxEntry.total_mem_pss());
+    record.field("total_mem_rss", ctxEntry.total_mem_rss());
+    record.endGroup();
+  }
+}
+
+template <class Record>
+void printRecord(Record &record, const tkm::msg::monitor::ProcEvent &event)
+{
+  record.beginGroup("procstats");
+  record.field("exec_count", event.exec_count());
+  record.field("exit_count", event.exit_count());
+  record.field("fork_count", event.fork_count());
+  record.field("gid_count", event.gid_count());
+  record.field("uid_count", event.uid_count());
+  record.endGroup();
+}
+
+template <class Record>
+void printRecord(Record &record, const tkm::msg::monitor::SysProcStat &sysProcStat)
+{
+  record.beginGroup("cpu");
+  record.field("all", sysProcStat.cpu().all());
+  record.field("iow", sysProcStat.cpu().iow());
+  record.field("sys", sysProcStat.cpu().sys());
+  record.field("usr", sysProcStat.cpu().usr());
+  record.endGroup();
+
+  for (const auto &cpuCore : sysProcStat.core()) {
+    record.beginGroup("core", cpuCore.name());
+    record.field("all", cpuCore.all());
+    record.field("iow", cpuCore.iow());
+    record.field("sys", cpuCore.sys());
+    record.field("usr", cpuCore.usr());
+    record.endGroup();
+  }
+}
+
+template <class Record>
+void printRecord(Record &record, const tkm::msg::monitor::SysProcBuddyInfo &sysProcBuddyInfo)
+{
+  int64_t index = 0;
+  for (const auto &nodeEntry : sysProcBuddyInfo.node()) {
+    record.beginGroup("node", index++);
+    record.field("data", nodeEntry.data());
+    record.field("name", nodeEntry.name());
+    record.field("zone", nodeEntry.zone());
+    record.endGroup();
+  }
+}
+
+template <class Record>
+void printRecord(Record &record, const tkm::msg::monitor::SysProcWireless &sysProcWireless)
+{
+  int64_t index = 0;
+  for (const auto &ifw : sysProcWireless.ifw()) {
+    record.beginGroup("interface", index++);
+    record.field("discarded_crypt", ifw.discarded_crypt());
+    record.field("discarded_frag", ifw.discarded_frag());
+    record.field("discarded_misc", ifw.discarded_misc());
+    record.field("discarded_nwid", ifw.discarded_nwid());
+    record.field("discarded_retry", ifw.discarded_retry());
+    record.field("missed_beacon", ifw.missed_beacon());
+    record.field("name", ifw.name());
+    record.field("quality_level", ifw.quality_level());
+    record.field("quality_link", ifw.quality_link());
+    record.field("quality_noise", ifw.quality_noise());
+    record.field("status", ifw.status());
+    record.endGroup();
+  }
+}
+
+template <class Record>
+void printRecord(Record &record, const tkm::msg::monitor::SysProcMemInfo &sysProcMemInfo)
+{
+  record.beginGroup("meminfo");
+  record.field("active", sysProcMemInfo.active());
+  record.field("inactive", sysProcMemInfo.inactive());
+  record.field("kernel_stack", sysProcMemInfo.kernel_stack());
+  record.field("kreclaimable", sysProcMemInfo.kreclaimable());
+  record.field("mem_available", sysProcMemInfo.mem_available());
+  record.field("mem_available_percent", sysProcMemInfo.mem_percent());
+  record.field("mem_cached", sysProcMemInfo.mem_cached());
+  record.field("mem_free", sysProcMemInfo.mem_free());
+  record.field("mem_total", sysProcMemInfo.mem_total());
+  record.field("slab", sysProcMemInfo.slab());
+  record.field("sreclaimable", sysProcMemInfo.sreclaimable());
+  record.field("sunreclaim", sysProcMemInfo.sunreclaim());
+  record.field("swap_cached", sysProcMemInfo.swap_cached());
+  record.field("swap_free", sysProcMemInfo.swap_free());
+  record.field("swap_free_percent", sysProcMemInfo.swap_percent());
+  record.field("swap_total", sysProcMemInfo.swap_total());
+  record.endGroup();
+}
+
+template <class Record>
+void printRecord(Record &record, const tkm::msg::monitor::SysProcDiskStats &sysProcDiskStats)
+{
+  for (const auto &diskEntry : sysProcDiskStats.disk()) {
+    record.beginGroup("disk", diskEntry.name(), "name");
+    record.field("io_in_progress", diskEntry.io_in_progress());
+    record.field("io_spent_ms", diskEntry.io_spent_ms());
+    record.field("io_weighted_ms", diskEntry.io_weighted_ms());
+    record.field("major", diskEntry.node_major());
+    record.field("minor", diskEntry.node_minor());
+    record.field("name", diskEntry.name());
+    record.field("reads_completed", diskEntry.reads_completed());
+    record.field("reads_merged", diskEntry.reads_merged());
+    record.field("reads_spent_ms", diskEntry.reads_spent_ms());
+    record.field("writes_completed", diskEntry.writes_completed());
+    record.field("writes_merged", diskEntry.writes_merged());
+    record.field("writes_spent_ms", diskEntry.writes_spent_ms());
+    record.endGroup();
+  }
+}
+
+template <class Record, class T>
+void writePressureData(Record &record, const char *kind, const T &data)
+{
+  record.beginGroup(kind);
+  record.field("avg10", data.avg10());
+  record.field("avg300", data.avg300());
+  record.field("avg60", data.avg60());
+  record.field("total", data.total());
+  record.endGroup();
+}
+
+template <class Record>
+void printRecord(Record &record, const tkm::msg::monitor::SysProcPressure &sysProcPressure)
+{
+  if (sysProcPressure.has_cpu_some() || sysProcPressure.has_cpu_full()) {
+    record.beginGroup("cpu");
+    if (sysProcPressure.has_cpu_full()) {
+      writePressureData(record, "full", sysProcPressure.cpu_full());
+    }
+    if (sysProcPressure.has_cpu_some()) {
+      writePressureData(record, "some", sysProcPressure.cpu_some());
+    }
+    record.endGroup();
+  }
+
+  if (sysProcPressure.has_mem_some() || sysProcPressure.has_mem_full()) {
+    record.beginGroup("mem");
+    if (sysProcPressure.has_mem_full()) {
+      writePressureData(record, "full", sysProcPressure.mem_full());
+    }
+    if (sysProcPressure.has_mem_some()) {
+      writePressureData(record, "some", sysProcPressure.mem_some());
+    }
+    record.endGroup();
+  }
+
+  if (sysProcPressure.has_io_some() || sysProcPressure.has_io_full()) {
+    record.beginGroup("io");
+    if (sysProcPressure.has_io_full()) {
+      writePressureData(record, "full", sysProcPressure.io_full());
+    }
+    if (sysProcPressure.has_io_some()) {
+      writePressureData(record, "some", sysProcPressure.io_some());
+    }
+    record.endGroup();
+  }
+}
+
+template <class Record>
+void printRecord(Record &record, const tkm::msg::monitor::SysProcVMStat &sysProcVMStat)
+{
+  record.beginGroup("vmstat");
+  record.field("compact_fail", sysProcVMStat.compact_fail());
+  record.field("compact_stall", sysProcVMStat.compact_stall());
+  record.field("compact_success", sysProcVMStat.compact_success());
+  record.field("oom_kill", sysProcVMStat.oom_kill());
+  record.field("pgmajfault", sysProcVMStat.pgmajfault());
+  record.field("pgpgin", sysProcVMStat.pgpgin());
+  record.field("pgpgout", sysProcVMStat.pgpgout());
+  record.field("pgreuse", sysProcVMStat.pgreuse());
+  record.field("pgscan_anon", sysProcVMStat.pgscan_anon());
+  record.field("pgscan_direct", sysProcVMStat.pgscan_direct());
+  record.field("pgscan_direct_throttle", sysProcVMStat.pgscan_direct_throttle());
+  record.field("pgscan_file", sysProcVMStat.pgscan_file());
+  record.field("pgscan_khugepaged", sysProcVMStat.pgscan_khugepaged());
+  record.field("pgscan_kswapd", sysProcVMStat.pgscan_kswapd());
+  record.field("pgsteal_anon", sysProcVMStat.pgsteal_anon());
+  record.field("pgsteal_direct", sysProcVMStat.pgsteal_direct());
+  record.field("pgsteal_file", sysProcVMStat.pgsteal_file());
+  record.field("pgsteal_khugepaged", sysProcVMStat.pgsteal_khugepaged());
+  record.field("pgsteal_kswapd", sysProcVMStat.pgsteal_kswapd());
+  record.field("pswpin", sysProcVMStat.pswpin());
+  record.field("pswpout", sysProcVMStat.pswpout());
+  record.field("thp_collapse_alloc", sysProcVMStat.thp_collapse_alloc());
+  record.field("thp_collapse_alloc_failed", sysProcVMStat.thp_collapse_alloc_failed());
+  record.field("thp_fault_alloc", sysProcVMStat.thp_fault_alloc());
+  record.field("thp_file_alloc", sysProcVMStat.thp_file_alloc());
+  record.field("thp_file_mapped", sysProcVMStat.thp_file_mapped());
+  record.field("thp_split_page", sysProcVMStat.thp_split_page());
+  record.field("thp_split_page_failed", sysProcVMStat.thp_split_page_failed());
+  record.field("thp_swpout", sysProcVMStat.thp_swpout());
+  record.field("thp_swpout_fallback", sysProcVMStat.thp_swpout_fallback());
+  record.field("thp_zero_page_alloc", sysProcVMStat.thp_zero_page_alloc());
+  record.field("thp_zero_page_alloc_failed", sysProcVMStat.thp_zero_page_alloc_failed());
+  record.endGroup();
+}
+
+// Decode the data payload and call visit with the record type name and the message
+template <class Visit>
+bool visitData(const tkm::msg::monitor::Data &data, const Visit &visit)
+{
+  switch (data.what()) {
+  case tkm::msg::monitor::Data_What_ProcAcct: {
+    tkm::msg::monitor::ProcAcct message;
+    data.payload().UnpackTo(&message);
+    visit("acct", message);
+    return true;
+  }
+  case tkm::msg::monitor::Data_What_ProcInfo: {
+    tkm::msg::monitor::ProcInfo message;
+    data.payload().UnpackTo(&message);
+    visit("procinfo", message);
+    return true;
+  }
+  case tkm::msg::monitor::Data_What_ProcEvent: {
+    tkm::msg::monitor::ProcEvent message;
+    data.payload().UnpackTo(&message);
+    visit("procstats", message);
+    return true;
+  }
+  case tkm::msg::monitor::Data_What_ContextInfo: {
+    tkm::msg::monitor::ContextInfo message;
+    data.payload().UnpackTo(&message);
+    visit("ctxinfo", message);
+    return true;
+  }
+  case tkm::msg::monitor::Data_What_SysProcStat: {
+    tkm::msg::monitor::SysProcStat message;
+    data.payload().UnpackTo(&message);
+    visit("stat", message);
+    return true;
+  }
+  case tkm::msg::monitor::Data_What_SysProcMemInfo: {
+    tkm::msg::monitor::SysProcMemInfo message;
+    data.payload().UnpackTo(&message);
+    visit("meminfo", message);
+    return true;
+  }
+  case tkm::msg::monitor::Data_What_SysProcDiskStats: {
+    tkm::msg::monitor::SysProcDiskStats message;
+    data.payload().UnpackTo(&message);
+    visit("diskstats", message);
+    return true;
+  }
+  case tkm::msg::monitor::Data_What_SysProcPressure: {
+    tkm::msg::monitor::SysProcPressure message;
+    data.payload().UnpackTo(&message);
+    visit("psi", message);
+    return true;
+  }
+  case tkm::msg::monitor::Data_What_SysProcBuddyInfo: {
+    tkm::msg::monitor::SysProcBuddyInfo message;
+    data.payload().UnpackTo(&message);
+    visit("buddyinfo", message);
+    return true;
+  }
+  case tkm::msg::monitor::Data_What_SysProcWireless: {
+    tkm::msg::monitor::SysProcWireless message;
+    data.payload().UnpackTo(&message);
+    visit("wireless", message);
+    return true;
+  }
+  case tkm::msg::monitor::Data_What_SysProcVMStat: {
+    tkm::msg::monitor::SysProcVMStat message;
+    data.payload().UnpackTo(&message);
+    visit("vmstat", message);
+    return true;
+  }
+  default:
+    break;
+  }
+
+  return false;
+}
+
+} // namespace tkm::reader
@@ -11,42 +11,40 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstdint>
-#include <functional>
 #include <string>
+#include <taskmonitor/taskmonitor.h>
+
+#include "Histogram.h"
+
+#include "../bswinfra/source/Logger.h"
 
 namespace tkm::reader
 {
 
 class DataSource
 {
-public:
-  typedef enum _UpdateLane { Fast, Pace, Slow, Any } UpdateLane;
-
 public:
   explicit DataSource(const std::string &name,
-                      UpdateLane lane,
-                      const std::function<bool()> &callback)
-  : m_lane(lane)
-  , m_callback(callback)
+                      uint64_t intervalUs,
+                      const std::string &requestId,
+                      tkm::msg::collector::Request_Type requestType,
+                      tkm::msg::monitor::Data_What dataType)
+  : m_name(name)
+  , m_requestId(requestId)
+  , m_dataType(dataType)
+  , m_interval(intervalUs)
   {
-    std::string laneName{"Any"};
-
-    switch (lane) {
-    case UpdateLane::Fast:
-      laneName = "Fast";
-      break;
-    case UpdateLane::Pace:
-      laneName = "Pace";
-      break;
-    case UpdateLane::Slow:
-      laneName = "Slow";
-      break;
-    default:
-      break;
-    }
+    // The request never changes during a session so we pack it only once
+    tkm::msg::collector::Request requestMessage;
+    requestMessage.set_id(requestId);
+    requestMessage.set_type(requestType);
+    m_request.mutable_mesg()->PackFrom(requestMessage);
+    m_request.set_target(tkm::msg::Envelope_Recipient_Monitor);
+    m_request.set_origin(tkm::msg::Envelope_Recipient_Collector);
 
-    logDebug() << "New data source name='" << name << "' lane='" << laneName << "'";
+    logDebug() << "New data source name='" << name << "' interval='" << intervalUs << "'";
   };
   ~DataSource() = default;
 
@@ -55,18 +53,110 @@ public:
   void operator=(DataSource const &) = delete;
 
 public:
-  auto getUpdateLane(void) -> UpdateLane { return m_lane; }
-  bool update(void)
+  auto getName(void) -> const std::string & { return m_name; }
+  auto getRequestId(void) -> const std::string & { return m_requestId; }
+  auto getDataType(void) -> tkm::msg::monitor::Data_What { return m_dataType; }
+  auto getRequest(void) -> const tkm::msg::Envelope & { return m_request; }
+
+  // Request interval and first request delay in usec
+  auto getInterval(void) -> uint64_t
   {
-    if (m_callback != nullptr) {
-      return m_callback();
+    if ((m_burstInterval > 0) && (m_burstInterval < m_interval * m_stretch)) {
+      return m_burstInterval;
+    }
+    return m_interval * m_stretch;
+  }
+  auto getBaseInterval(void) -> uint64_t { return m_interval; }
+  void setInterval(uint64_t intervalUs) { m_interval = intervalUs; }
+  auto getOffset(void) -> uint64_t { return m_offset; }
+  void setOffset(uint64_t offsetUs) { m_offset = offsetUs; }
+
+  // Expensive sources have their interval stretched under reader backpressure
+  bool isThrottled(void) { return m_throttled; }
+  void setThrottled(bool throttled) { m_throttled = throttled; }
+  void setStretch(uint64_t stretch) { m_stretch = (stretch > 0) ? stretch : 1; }
+
+  // Temporary faster interval during burst sampling, 0 to disable
+  void setBurstInterval(uint64_t intervalUs) { m_burstInterval = intervalUs; }
+
+  // Scheduler entries from an older generation are dropped on expiry
+  auto getGeneration(void) -> uint64_t { return m_generation; }
+  void nextGeneration(void) { m_generation++; }
+
+  // In-flight request tracking. A new request is skipped while the previous
+  // one did not get a reply, unless it is older than timeoutUs.
+  bool canRequest(uint64_t timeoutUs)
+  {
+    if (!m_pending) {
+      return true;
+    }
+
+    if (elapsedUs() < timeoutUs) {
+      m_skipped++;
+      return false;
     }
-    return false;
-  };
+
+    logWarn() << "Request " << m_requestId << " timeout after " << elapsedUs() << " usec";
+    m_timeouts++;
+    m_pending = false;
+
+    return true;
+  }
+
+  void setRequested(void)
+  {
+    m_pending = true;
+    m_requestTime = std::chrono::steady_clock::now();
+  }
+
+  void setReplied(void)
+  {
+    if (m_pending) {
+      m_latency.add(elapsedUs());
+      m_pending = false;
+    }
+  }
+
+  // Report and reset request statistics
+  auto getStats(void) -> std::string
+  {
+    auto stats = m_name + " latency(usec) " + m_latency.toString() +
+                 " skipped=" + std::to_string(m_skipped) +
+                 " timeouts=" + std::to_string(m_timeouts);
+
+    m_latency.reset();
+    m_skipped = 0;
+    m_timeouts = 0;
+
+    return stats;
+  }
 
 private:
-  UpdateLane m_lane = UpdateLane::Any;
-  std::function<bool()> m_callback = nullptr;
+  auto elapsedUs(void) -> uint64_t
+  {
+    using USec = std::chrono::microseconds;
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<USec>(std::chrono::steady_clock::now() - m_requestTime)
+            .count());
+  }
+
+private:
+  std::string m_name;
+  std::string m_requestId;
+  tkm::msg::monitor::Data_What m_dataType;
+  uint64_t m_interval = 0;
+  uint64_t m_offset = 0;
+  uint64_t m_stretch = 1;
+  uint64_t m_burstInterval = 0;
+  uint64_t m_generation = 0;
+  bool m_throttled = false;
+  tkm::msg::Envelope m_request{};
+
+  std::chrono::time_point<std::chrono::steady_clock> m_requestTime{};
+  bool m_pending = false;
+  uint64_t m_skipped = 0;
+  uint64_t m_timeouts = 0;
+  Histogram m_latency{};
 };
 
 } // namespace tkm::reader
@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <string>
 #include <taskmonitor/taskmonitor.h>
@@ -33,6 +34,7 @@ public:
   enum class Action {
     PrepareData,
     Connect,
+    Replay,
     Reconnect,
     SendDescriptor,
     RequestSession,
@@ -52,8 +54,11 @@ public:
 public:
   Dispatcher()
   {
-    m_queue = std::make_shared<AsyncQueue<Request>>(
-        "DispatcherQueue", [this](const Request &request) { return requestHandler(request); });
+    m_queue = std::make_shared<AsyncQueue<Request>>("DispatcherQueue",
+                                                    [this](const Request &request) {
+                                                      m_queueDepth--;
+                                                      return requestHandler(request);
+                                                    });
   }
 
   auto getShared() -> std::shared_ptr<Dispatcher> { return shared_from_this(); }
@@ -62,6 +67,7 @@ public:
   auto hashForDevice(const tkm::msg::control::DeviceData &data) -> std::string;
 
   void resetRequestSessionTimer(void);
+  auto getQueueDepth(void) -> size_t { return m_queueDepth; }
 
 private:
   bool requestHandler(const Request &request);
@@ -69,6 +75,7 @@ private:
 private:
   std::shared_ptr<AsyncQueue<Request>> m_queue = nullptr;
   std::shared_ptr<Timer> m_reqSessionTimer = nullptr;
+  std::atomic<size_t> m_queueDepth = 0;
 };
 
 } // namespace tkm::reader
@@ -0,0 +1,149 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     GzipFrameWriter Class
+ * @details   Write data as independent gzip members with a sidecar index
+ *-
+ */
+
+#include <filesystem>
+#include <stdexcept>
+
+#include "GzipFrameWriter.h"
+#include "Logger.h"
+
+namespace tkm::reader
+{
+
+// Window bits for deflate with gzip header and trailer
+static constexpr int GzipWindowBits = 15 + 16;
+static constexpr size_t OutBufferSize = 256 * 1024;
+
+GzipFrameWriter::GzipFrameWriter(const std::string &path,
+                                 const std::string &indexPath,
+                                 size_t frameSize,
+                                 uint64_t frameIntervalUs)
+: m_outBuffer(OutBufferSize)
+, m_frameSize(frameSize)
+, m_frameInterval(frameIntervalUs)
+{
+  std::error_code ec;
+
+  // New frames are appended so offsets start at the current file size
+  auto fileSize = std::filesystem::file_size(path, ec);
+  m_offset = ec ? 0 : fileSize;
+
+  m_out.open(path, std::ofstream::out | std::ofstream::app | std::ofstream::binary);
+  m_index.open(indexPath, std::ofstream::out | std::ofstream::app);
+  if (!m_out.is_open() || !m_index.is_open()) {
+    throw std::runtime_error("Cannot open compressed json output");
+  }
+
+  if (deflateInit2(&m_stream,
+                   Z_DEFAULT_COMPRESSION,
+                   Z_DEFLATED,
+                   GzipWindowBits,
+                   8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    throw std::runtime_error("Cannot initialize deflate stream");
+  }
+  m_streamReady = true;
+
+  logInfo() << "Compressed json output with frame size " << m_frameSize << " and index "
+            << indexPath;
+}
+
+GzipFrameWriter::~GzipFrameWriter()
+{
+  finish();
+  if (m_streamReady) {
+    deflateEnd(&m_stream);
+  }
+}
+
+void GzipFrameWriter::write(const std::string &data,
+                            const std::string &header,
+                            time_t firstTime,
+                            time_t lastTime,
+                            size_t records)
+{
+  using USec = std::chrono::microseconds;
+
+  if (data.empty()) {
+    return;
+  }
+
+  if (!m_frameOpen) {
+    beginFrame();
+    m_firstTime = firstTime;
+    if (!header.empty()) {
+      deflateData(header.data(), header.size(), Z_NO_FLUSH);
+      m_frameInput += header.size();
+    }
+  }
+
+  deflateData(data.data(), data.size(), Z_NO_FLUSH);
+  m_frameInput += data.size();
+  m_frameRecords += records;
+  m_lastTime = lastTime;
+
+  auto frameAge = static_cast<uint64_t>(
+      std::chrono::duration_cast<USec>(std::chrono::steady_clock::now() - m_frameStart).count());
+  if ((m_frameInput >= m_frameSize) || (frameAge >= m_frameInterval)) {
+    finish();
+  }
+}
+
+void GzipFrameWriter::finish(void)
+{
+  if (!m_frameOpen) {
+    return;
+  }
+
+  deflateData(nullptr, 0, Z_FINISH);
+  m_out.flush();
+
+  m_index << m_frameOffset << " " << (m_offset - m_frameOffset) << " " << m_firstTime << " "
+          << m_lastTime << " " << m_frameRecords << "\n";
+  m_index.flush();
+
+  m_frameOpen = false;
+}
+
+void GzipFrameWriter::beginFrame(void)
+{
+  deflateReset(&m_stream);
+
+  m_frameStart = std::chrono::steady_clock::now();
+  m_frameOffset = m_offset;
+  m_frameInput = 0;
+  m_frameRecords = 0;
+  m_frameOpen = true;
+}
+
+void GzipFrameWriter::deflateData(const char *data, size_t size, int flush)
+{
+  // zlib takes a non const input pointer but never writes to it
+  m_stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+  m_stream.avail_in = static_cast<uInt>(size);
+
+  do {
+    m_stream.next_out = m_outBuffer.data();
+    m_stream.avail_out = static_cast<uInt>(m_outBuffer.size());
+
+    if (deflate(&m_stream, flush) == Z_STREAM_ERROR) {
+      logError() << "Deflate stream error";
+      return;
+    }
+
+    auto produced = m_outBuffer.size() - m_stream.avail_out;
+    m_out.write(reinterpret_cast<const char *>(m_outBuffer.data()),
+                static_cast<std::streamsize>(produced));
+    m_offset += produced;
+  } while ((m_stream.avail_out == 0) || (m_stream.avail_in > 0));
+}
+
+} // namespace tkm::reader
@@ -0,0 +1,77 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     GzipFrameWriter Class
+ * @details   Write data as independent gzip members with a sidecar index
+ *-
+ */
+
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+namespace tkm::reader
+{
+
+/*
+ * Each frame is a complete gzip member so the output stays a valid gzip file
+ * (zcat reads all frames) while every frame can be decompressed on its own.
+ * For each closed frame one line is appended to the index file:
+ *   <offset> <compressed size> <first time> <last time> <records>
+ * where times are the record receive times in seconds since epoch.
+ */
+class GzipFrameWriter
+{
+public:
+  explicit GzipFrameWriter(const std::string &path,
+                           const std::string &indexPath,
+                           size_t frameSize,
+                           uint64_t frameIntervalUs);
+  ~GzipFrameWriter();
+
+public:
+  GzipFrameWriter(GzipFrameWriter const &) = delete;
+  void operator=(GzipFrameWriter const &) = delete;
+
+  // Header lines are written at the start of every frame, they are not records
+  void write(const std::string &data,
+             const std::string &header,
+             time_t firstTime,
+             time_t lastTime,
+             size_t records);
+  // Close the current frame, if any
+  void finish(void);
+  // Bytes in the output file, compressed data written so far included
+  auto getSize(void) const -> uint64_t { return m_offset; }
+
+private:
+  void beginFrame(void);
+  void deflateData(const char *data, size_t size, int flush);
+
+private:
+  std::ofstream m_out;
+  std::ofstream m_index;
+  z_stream m_stream{};
+  std::vector<unsigned char> m_outBuffer;
+  std::chrono::time_point<std::chrono::steady_clock> m_frameStart{};
+  size_t m_frameSize = 0;
+  uint64_t m_frameInterval = 0;
+  uint64_t m_offset = 0;
+  uint64_t m_frameOffset = 0;
+  size_t m_frameInput = 0;
+  size_t m_frameRecords = 0;
+  time_t m_firstTime = 0;
+  time_t m_lastTime = 0;
+  bool m_frameOpen = false;
+  bool m_streamReady = false;
+};
+
+} // namespace tkm::reader
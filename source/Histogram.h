@@ -0,0 +1,90 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     Histogram Class
+ * @details   Log2 bucket histogram for latency reporting
+ *-
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+namespace tkm::reader
+{
+
+class Histogram
+{
+public:
+  Histogram() = default;
+  ~Histogram() = default;
+
+public:
+  void add(uint64_t value)
+  {
+    size_t bucket = 0;
+    while ((bucket < (BucketCount - 1)) && ((1UL << bucket) <= value)) {
+      bucket++;
+    }
+    m_buckets[bucket]++;
+    m_count++;
+    m_sum += value;
+    if (value > m_max) {
+      m_max = value;
+    }
+  }
+
+  void reset(void)
+  {
+    m_buckets.fill(0);
+    m_count = 0;
+    m_sum = 0;
+    m_max = 0;
+  }
+
+  auto getCount(void) -> uint64_t { return m_count; }
+  auto getMax(void) -> uint64_t { return m_max; }
+  auto getMean(void) -> uint64_t { return (m_count > 0) ? (m_sum / m_count) : 0; }
+
+  // Upper bound of the bucket holding the requested percentile
+  auto getPercentile(unsigned percent) -> uint64_t
+  {
+    uint64_t rank = (m_count * percent + 99) / 100;
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < BucketCount; i++) {
+      seen += m_buckets[i];
+      if ((seen >= rank) && (seen > 0)) {
+        return std::min<uint64_t>(1UL << i, m_max);
+      }
+    }
+
+    return m_max;
+  }
+
+  auto toString(void) -> std::string
+  {
+    std::stringstream out;
+
+    out << "count=" << m_count << " mean=" << getMean() << " p50=" << getPercentile(50)
+        << " p90=" << getPercentile(90) << " p99=" << getPercentile(99) << " max=" << m_max;
+
+    return out.str();
+  }
+
+private:
+  static constexpr size_t BucketCount = 40;
+  std::array<uint64_t, BucketCount> m_buckets{};
+  uint64_t m_count = 0;
+  uint64_t m_sum = 0;
+  uint64_t m_max = 0;
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,118 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     HotWindow Class
+ * @details   Keep the recent samples of every series in memory
+ *-
+ */
+
+#include <algorithm>
+
+#include "HotWindow.h"
+
+namespace tkm::reader
+{
+
+void HotWindow::append(std::string_view source,
+                       std::string_view entity,
+                       std::string_view field,
+                       series::Type type,
+                       uint64_t time,
+                       uint64_t value)
+{
+  m_key.assign(source).append(1, '\0').append(entity).append(1, '\0').append(field);
+
+  auto it = m_series.find(m_key);
+  if (it == m_series.end()) {
+    it = m_series.emplace(m_key, Series{.type = type, .samples = {}}).first;
+  }
+
+  auto &entry = it->second;
+  if (entry.type != type) {
+    return;
+  }
+  // Samples are kept in time order, a late one is dropped
+  if (!entry.samples.empty() && (time < entry.samples.back().time)) {
+    return;
+  }
+
+  entry.samples.push_back(Sample{.time = time, .value = value});
+  m_samples++;
+  m_newestTime = std::max(m_newestTime, time);
+
+  while (entry.samples.front().time + m_window < m_newestTime) {
+    entry.samples.pop_front();
+    m_samples--;
+  }
+
+  // Series that stopped, like exited processes, are dropped now and then
+  if (m_newestTime >= m_pruneTime + m_window / 4) {
+    prune();
+    m_pruneTime = m_newestTime;
+  }
+}
+
+void HotWindow::prune(void)
+{
+  for (auto it = m_series.begin(); it != m_series.end();) {
+    auto &samples = it->second.samples;
+    while (!samples.empty() && (samples.front().time + m_window < m_newestTime)) {
+      samples.pop_front();
+      m_samples--;
+    }
+    it = samples.empty() ? m_series.erase(it) : std::next(it);
+  }
+}
+
+auto HotWindow::find(std::string_view source,
+                     std::string_view entity,
+                     std::string_view field) const -> const Series *
+{
+  m_key.assign(source).append(1, '\0').append(entity).append(1, '\0').append(field);
+
+  auto it = m_series.find(m_key);
+  return (it == m_series.end()) ? nullptr : &it->second;
+}
+
+bool HotWindow::getFirstTime(std::string_view source,
+                             std::string_view entity,
+                             std::string_view field,
+                             uint64_t &time) const
+{
+  auto entry = find(source, entity, field);
+  if ((entry == nullptr) || entry->samples.empty()) {
+    return false;
+  }
+  time = entry->samples.front().time;
+  return true;
+}
+
+bool HotWindow::query(std::string_view source,
+                      std::string_view entity,
+                      std::string_view field,
+                      uint64_t begin,
+                      uint64_t end,
+                      series::Type &type,
+                      const Visit &visit) const
+{
+  auto entry = find(source, entity, field);
+  if (entry == nullptr) {
+    return false;
+  }
+  type = entry->type;
+
+  auto it = std::lower_bound(entry->samples.cbegin(),
+                             entry->samples.cend(),
+                             begin,
+                             [](const Sample &sample, uint64_t time) { return sample.time < time; });
+  for (; (it != entry->samples.cend()) && (it->time <= end); ++it) {
+    visit(it->time, it->value);
+  }
+
+  return true;
+}
+
+} // namespace tkm::reader
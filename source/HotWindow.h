@@ -0,0 +1,96 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     HotWindow Class
+ * @details   Keep the recent samples of every series in memory
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+
+#include "SeriesFormat.h"
+
+namespace tkm::reader
+{
+
+/*
+ * Samples of each series newer than the window, relative to the newest
+ * sample of any series. Series without a sample in the window are
+ * dropped. Only used from the main thread.
+ */
+class HotWindow
+{
+public:
+  using Visit = std::function<void(uint64_t time, uint64_t value)>;
+
+public:
+  explicit HotWindow(uint64_t window)
+  : m_window(window)
+  {
+  }
+  ~HotWindow() = default;
+
+public:
+  HotWindow(HotWindow const &) = delete;
+  void operator=(HotWindow const &) = delete;
+
+  void append(std::string_view source,
+              std::string_view entity,
+              std::string_view field,
+              series::Type type,
+              uint64_t time,
+              uint64_t value);
+
+  // False if the series has no sample in the window
+  bool getFirstTime(std::string_view source,
+                    std::string_view entity,
+                    std::string_view field,
+                    uint64_t &time) const;
+  // Samples in [begin, end] in time order, false if the series is unknown
+  bool query(std::string_view source,
+             std::string_view entity,
+             std::string_view field,
+             uint64_t begin,
+             uint64_t end,
+             series::Type &type,
+             const Visit &visit) const;
+
+  auto getWindow(void) const -> uint64_t { return m_window; }
+  auto getSeriesCount(void) const -> size_t { return m_series.size(); }
+  auto getSampleCount(void) const -> size_t { return m_samples; }
+
+private:
+  typedef struct Sample {
+    uint64_t time;
+    uint64_t value;
+  } Sample;
+
+  typedef struct Series {
+    series::Type type;
+    std::deque<Sample> samples;
+  } Series;
+
+  auto find(std::string_view source, std::string_view entity, std::string_view field) const
+      -> const Series *;
+  void prune(void);
+
+private:
+  uint64_t m_window;
+  uint64_t m_newestTime = 0;
+  uint64_t m_pruneTime = 0;
+  size_t m_samples = 0;
+  std::map<std::string, Series, std::less<>> m_series{};
+  mutable std::string m_key{};
+};
+
+} // namespace tkm::reader
@@ -12,6 +12,7 @@
 #pragma once
 
 #include "Defaults.h"
+#include <atomic>
 #include <map>
 #include <memory>
 #include <string>
@@ -53,11 +54,22 @@ public:
   IDatabase(void)
   {
     m_queue = std::make_shared<AsyncQueue<IDatabase::Request>>(
-        "DBQueue", [this](const IDatabase::Request &rq) { return requestHandler(rq); });
+        "DBQueue", [this](const IDatabase::Request &rq) {
+          m_queueDepth--;
+          return requestHandler(rq);
+        });
   }
   virtual ~IDatabase() = default;
 
-  bool pushRequest(Request &rq) { return m_queue->push(rq); }
+  bool pushRequest(Request &rq)
+  {
+    if (m_queue->push(rq)) {
+      m_queueDepth++;
+      return true;
+    }
+    return false;
+  }
+  auto getQueueDepth(void) -> size_t { return m_queueDepth; }
   virtual void enableEvents() = 0;
   virtual bool requestHandler(const IDatabase::Request &request) = 0;
 
@@ -67,6 +79,7 @@ public:
 
 protected:
   std::shared_ptr<AsyncQueue<IDatabase::Request>> m_queue = nullptr;
+  std::atomic<size_t> m_queueDepth = 0;
 };
 
 } // namespace tkm::reader
@@ -0,0 +1,331 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     JsonEncoder Class
+ * @details   Streaming JSON encoder into a reusable buffer
+ *-
+ */
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+#include "JsonEncoder.h"
+
+namespace tkm::reader
+{
+
+static bool requiresEscaping(std::string_view str)
+{
+  for (const auto c : str) {
+    auto uc = static_cast<unsigned char>(c);
+    if ((uc == '\\') || (uc == '"') || (uc < 0x20) || (uc > 0x7F)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Same decoding rules as jsoncpp, invalid sequences map to U+FFFD
+static auto utf8ToCodepoint(const char *&s, const char *e) -> unsigned int
+{
+  const unsigned int replacementCharacter = 0xFFFD;
+  auto byteAt = [s](int i) {
+    return static_cast<unsigned int>(static_cast<unsigned char>(s[i]));
+  };
+  unsigned int firstByte = byteAt(0);
+
+  if (firstByte < 0x80) {
+    return firstByte;
+  }
+
+  if (firstByte < 0xE0) {
+    if (e - s < 2) {
+      return replacementCharacter;
+    }
+    unsigned int calculated = ((firstByte & 0x1F) << 6) | (byteAt(1) & 0x3F);
+    s += 1;
+    return (calculated < 0x80) ? replacementCharacter : calculated;
+  }
+
+  if (firstByte < 0xF0) {
+    if (e - s < 3) {
+      return replacementCharacter;
+    }
+    unsigned int calculated =
+        ((firstByte & 0x0F) << 12) | ((byteAt(1) & 0x3F) << 6) | (byteAt(2) & 0x3F);
+    s += 2;
+    if ((calculated >= 0xD800) && (calculated <= 0xDFFF)) {
+      return replacementCharacter;
+    }
+    return (calculated < 0x800) ? replacementCharacter : calculated;
+  }
+
+  if (firstByte < 0xF8) {
+    if (e - s < 4) {
+      return replacementCharacter;
+    }
+    unsigned int calculated = ((firstByte & 0x07) << 18) | ((byteAt(1) & 0x3F) << 12) |
+                              ((byteAt(2) & 0x3F) << 6) | (byteAt(3) & 0x3F);
+    s += 3;
+    return (calculated < 0x10000) ? replacementCharacter : calculated;
+  }
+
+  return replacementCharacter;
+}
+
+static void appendHex(std::string &out, unsigned int codepoint)
+{
+  const char *hex = "0123456789abcdef";
+  char seq[6] = {'\\',
+                 'u',
+                 hex[(codepoint >> 12) & 0x0F],
+                 hex[(codepoint >> 8) & 0x0F],
+                 hex[(codepoint >> 4) & 0x0F],
+                 hex[codepoint & 0x0F]};
+  out.append(seq, sizeof(seq));
+}
+
+void JsonEncoder::reset(void)
+{
+  m_buffer.clear();
+  m_keys.clear();
+  m_frames.clear();
+  m_members.clear();
+}
+
+void JsonEncoder::beginObject(void)
+{
+  elementStart();
+  m_frames.push_back(Frame{.start = m_buffer.size(), .members = m_members.size(), .sorted = false});
+  m_buffer.push_back('{');
+}
+
+void JsonEncoder::beginSortedObject(void)
+{
+  elementStart();
+  m_frames.push_back(Frame{.start = m_buffer.size(), .members = m_members.size(), .sorted = true});
+  m_buffer.push_back('{');
+}
+
+void JsonEncoder::endObject(void)
+{
+  if (m_frames.empty()) {
+    return;
+  }
+
+  auto frame = m_frames.back();
+  m_frames.pop_back();
+
+  if (frame.sorted) {
+    sortMembers(frame);
+  }
+  m_buffer.push_back('}');
+}
+
+void JsonEncoder::beginArray(void)
+{
+  elementStart();
+  m_buffer.push_back('[');
+}
+
+void JsonEncoder::endArray(void)
+{
+  m_buffer.push_back(']');
+}
+
+void JsonEncoder::key(std::string_view name)
+{
+  memberStart(name);
+  writeString(name);
+  m_buffer.push_back(':');
+}
+
+void JsonEncoder::key(int64_t name)
+{
+  char str[24];
+  auto res = std::to_chars(str, str + sizeof(str), name);
+  key(std::string_view(str, static_cast<size_t>(res.ptr - str)));
+}
+
+void JsonEncoder::value(uint64_t val)
+{
+  char str[24];
+  auto res = std::to_chars(str, str + sizeof(str), val);
+  m_buffer.append(str, static_cast<size_t>(res.ptr - str));
+}
+
+void JsonEncoder::value(int64_t val)
+{
+  char str[24];
+  auto res = std::to_chars(str, str + sizeof(str), val);
+  m_buffer.append(str, static_cast<size_t>(res.ptr - str));
+}
+
+void JsonEncoder::value(double val)
+{
+  if (std::isnan(val)) {
+    m_buffer.append("null");
+    return;
+  }
+
+  if (std::isinf(val)) {
+    m_buffer.append((val < 0) ? "-1e+9999" : "1e+9999");
+    return;
+  }
+
+  // Equivalent of the "%.17g" format used by Json::Value
+  char str[40];
+  auto res = std::to_chars(str, str + sizeof(str), val, std::chars_format::general, 17);
+  std::string_view number(str, static_cast<size_t>(res.ptr - str));
+
+  m_buffer.append(number);
+  if ((number.find('.') == std::string_view::npos) &&
+      (number.find('e') == std::string_view::npos)) {
+    m_buffer.append(".0");
+  }
+}
+
+void JsonEncoder::value(bool val)
+{
+  m_buffer.append(val ? "true" : "false");
+}
+
+void JsonEncoder::value(std::string_view val)
+{
+  writeString(val);
+}
+
+void JsonEncoder::memberStart(std::string_view name)
+{
+  if (m_frames.empty()) {
+    return;
+  }
+
+  if (m_frames.back().sorted) {
+    m_members.push_back(
+        Member{.keyOffset = m_keys.size(), .keySize = name.size(), .begin = m_buffer.size()});
+    m_keys.append(name);
+  } else if (m_buffer.back() != '{') {
+    m_buffer.push_back(',');
+  }
+}
+
+void JsonEncoder::elementStart(void)
+{
+  if (m_buffer.empty()) {
+    return;
+  }
+
+  // First element of an array or the value of an object member
+  auto last = m_buffer.back();
+  if ((last != '[') && (last != ':')) {
+    m_buffer.push_back(',');
+  }
+}
+
+void JsonEncoder::writeString(std::string_view str)
+{
+  m_buffer.push_back('"');
+
+  if (!requiresEscaping(str)) {
+    m_buffer.append(str);
+    m_buffer.push_back('"');
+    return;
+  }
+
+  const char *end = str.data() + str.size();
+  for (const char *c = str.data(); c != end; ++c) {
+    switch (*c) {
+    case '\"':
+      m_buffer.append("\\\"");
+      break;
+    case '\\':
+      m_buffer.append("\\\\");
+      break;
+    case '\b':
+      m_buffer.append("\\b");
+      break;
+    case '\f':
+      m_buffer.append("\\f");
+      break;
+    case '\n':
+      m_buffer.append("\\n");
+      break;
+    case '\r':
+      m_buffer.append("\\r");
+      break;
+    case '\t':
+      m_buffer.append("\\t");
+      break;
+    default: {
+      auto codepoint = utf8ToCodepoint(c, end);
+      if (codepoint < 0x20) {
+        appendHex(m_buffer, codepoint);
+      } else if (codepoint < 0x80) {
+        m_buffer.push_back(static_cast<char>(codepoint));
+      } else if (codepoint < 0x10000) {
+        appendHex(m_buffer, codepoint);
+      } else {
+        // Non BMP codepoints are written as UTF-16 surrogate pairs
+        codepoint -= 0x10000;
+        appendHex(m_buffer, 0xD800 + ((codepoint >> 10) & 0x3FF));
+        appendHex(m_buffer, 0xDC00 + (codepoint & 0x3FF));
+      }
+    } break;
+    }
+  }
+
+  m_buffer.push_back('"');
+}
+
+void JsonEncoder::sortMembers(const Frame &frame)
+{
+  auto count = m_members.size() - frame.members;
+  auto bodyStart = frame.start + 1;
+
+  if (count == 0) {
+    return;
+  }
+
+  auto keyOf = [this](size_t index) {
+    const auto &member = m_members[index];
+    return std::string_view(m_keys.data() + member.keyOffset, member.keySize);
+  };
+  auto bodyEnd = m_buffer.size();
+  auto endOf = [this, bodyEnd](size_t index) {
+    return (index + 1 < m_members.size()) ? m_members[index + 1].begin : bodyEnd;
+  };
+
+  m_order.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    m_order[i] = frame.members + i;
+  }
+  std::stable_sort(m_order.begin(), m_order.end(), [&keyOf](size_t a, size_t b) {
+    return keyOf(a) < keyOf(b);
+  });
+
+  m_scratch.assign(m_buffer, bodyStart, std::string::npos);
+  m_buffer.resize(bodyStart);
+
+  for (size_t i = 0; i < count; i++) {
+    // Like Json::Value a duplicated key keeps the last assigned value
+    if ((i + 1 < count) && (keyOf(m_order[i]) == keyOf(m_order[i + 1]))) {
+      continue;
+    }
+
+    auto begin = m_members[m_order[i]].begin;
+    if (m_buffer.size() > bodyStart) {
+      m_buffer.push_back(',');
+    }
+    m_buffer.append(m_scratch, begin - bodyStart, endOf(m_order[i]) - begin);
+  }
+
+  m_keys.resize(m_members[frame.members].keyOffset);
+  m_members.resize(frame.members);
+}
+
+} // namespace tkm::reader
@@ -0,0 +1,118 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     JsonEncoder Class
+ * @details   Streaming JSON encoder into a reusable buffer
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tkm::reader
+{
+
+/*
+ * Writes JSON text with the same layout as the Json::StreamWriterBuilder
+ * setup used by JsonWriter (no indentation, no comments). Json::Value keeps
+ * object members ordered by key, so fixed objects must be written with their
+ * keys already sorted while objects with runtime keys are opened with
+ * beginSortedObject() and ordered on endObject().
+ */
+class JsonEncoder
+{
+public:
+  JsonEncoder() = default;
+  ~JsonEncoder() = default;
+
+public:
+  JsonEncoder(JsonEncoder const &) = delete;
+  void operator=(JsonEncoder const &) = delete;
+
+  void reset(void);
+  auto view(void) const -> std::string_view { return m_buffer; }
+
+  void beginObject(void);
+  void beginSortedObject(void);
+  void endObject(void);
+
+  // Array elements keep their order, objects and arrays can be elements
+  void beginArray(void);
+  void endArray(void);
+
+  // Key literals are copied without escaping or length computation
+  template <size_t N>
+  void key(const char (&name)[N])
+  {
+    static_assert(N > 1, "Empty JSON key");
+    memberStart(std::string_view(name, N - 1));
+    m_buffer.push_back('"');
+    m_buffer.append(name, N - 1);
+    m_buffer.append("\":", 2);
+  }
+  void key(std::string_view name);
+  void key(int64_t name);
+
+  void value(uint64_t val);
+  void value(int64_t val);
+  void value(uint32_t val) { value(static_cast<uint64_t>(val)); }
+  void value(int32_t val) { value(static_cast<int64_t>(val)); }
+  void value(double val);
+  void value(float val) { value(static_cast<double>(val)); }
+  void value(bool val);
+  void value(std::string_view val);
+  void value(const std::string &val) { value(std::string_view(val)); }
+  void value(const char *val) { value(std::string_view(val)); }
+  // JSON text written as is, ex: a number literal read back from output
+  void rawValue(std::string_view text) { m_buffer.append(text); }
+
+  template <size_t N, class T>
+  void field(const char (&name)[N], const T &val)
+  {
+    key(name);
+    value(val);
+  }
+
+  template <class T>
+  void element(const T &val)
+  {
+    elementStart();
+    value(val);
+  }
+
+private:
+  typedef struct Frame {
+    size_t start;
+    size_t members;
+    bool sorted;
+  } Frame;
+
+  typedef struct Member {
+    size_t keyOffset;
+    size_t keySize;
+    size_t begin;
+  } Member;
+
+  void memberStart(std::string_view name);
+  void elementStart(void);
+  void writeString(std::string_view str);
+  void sortMembers(const Frame &frame);
+
+private:
+  std::string m_buffer{};
+  std::string m_scratch{};
+  std::string m_keys{};
+  std::vector<Frame> m_frames{};
+  std::vector<Member> m_members{};
+  std::vector<size_t> m_order{};
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,204 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     JsonFile Class
+ * @details   Json output file with optional rotation and compression
+ *-
+ */
+
+#include <filesystem>
+#include <regex>
+
+#include "JsonFile.h"
+#include "Logger.h"
+
+namespace tkm::reader
+{
+
+JsonFile::JsonFile(const std::string &path, const Config &config)
+: m_path(path)
+, m_config(config)
+{
+#ifndef WITH_ZLIB
+  if (m_config.compress) {
+    logWarn() << "Compressed json output not supported by this build. Write uncompressed";
+    m_config.compress = false;
+  }
+#endif
+}
+
+JsonFile::~JsonFile()
+{
+  close();
+}
+
+auto JsonFile::pathWithTag(const std::string &path, const std::string &tag, char separator)
+    -> std::string
+{
+  auto namePos = path.rfind('/');
+  namePos = (namePos == std::string::npos) ? 0 : namePos + 1;
+
+  // Skip the first name character to keep hidden file names intact
+  auto extPos = path.find('.', namePos + 1);
+  if (extPos == std::string::npos) {
+    return path + separator + tag;
+  }
+
+  return path.substr(0, extPos) + separator + tag + path.substr(extPos);
+}
+
+void JsonFile::removeFiles(const std::string &path)
+{
+  const std::filesystem::path filePath(path);
+  const auto name = filePath.filename().string();
+  const auto dirPath = filePath.has_parent_path() ? filePath.parent_path() : ".";
+
+  // Names as built by pathWithTag: <base>[-<rotation time>][.<record type>]<ext>[.idx]
+  const std::regex tagPattern(R"((-\d{8}T\d{6}Z(-\d+)?)?(\.\w+)?)");
+  const auto extPos = name.find('.', 1);
+  const auto base = name.substr(0, extPos);
+  const auto ext = (extPos == std::string::npos) ? std::string() : name.substr(extPos);
+
+  std::error_code ec;
+  for (const auto &entry : std::filesystem::directory_iterator(dirPath, ec)) {
+    auto entryName = entry.path().filename().string();
+    if ((entryName.size() > 4) && (entryName.compare(entryName.size() - 4, 4, ".idx") == 0)) {
+      entryName.resize(entryName.size() - 4);
+    }
+    if ((entryName.size() < base.size() + ext.size()) ||
+        (entryName.compare(0, base.size(), base) != 0) ||
+        (entryName.compare(entryName.size() - ext.size(), ext.size(), ext) != 0)) {
+      continue;
+    }
+    auto tags = entryName.substr(base.size(), entryName.size() - base.size() - ext.size());
+    if (!std::regex_match(tags, tagPattern)) {
+      continue;
+    }
+    logWarn() << "Removing existing json output file: " << entry.path().string();
+    std::filesystem::remove(entry.path(), ec);
+  }
+}
+
+void JsonFile::write(const std::string &data,
+                     const std::string &header,
+                     time_t firstTime,
+                     time_t lastTime,
+                     size_t records)
+{
+  using USec = std::chrono::microseconds;
+  auto opened = false;
+
+  if (!isOpen()) {
+    open();
+    opened = true;
+  }
+
+#ifdef WITH_ZLIB
+  if (m_compressor != nullptr) {
+    m_compressor->write(data, header, firstTime, lastTime, records);
+    // Compressed bytes reach the file as zlib emits them, at most a frame later
+    m_written = m_compressor->getSize();
+  }
+#else
+  static_cast<void>(firstTime);
+  static_cast<void>(lastTime);
+  static_cast<void>(records);
+#endif
+  if (m_outStream != nullptr) {
+    if (opened && !header.empty()) {
+      m_outStream->write(header.data(), static_cast<std::streamsize>(header.size()));
+      m_written += header.size();
+    }
+    m_outStream->write(data.data(), static_cast<std::streamsize>(data.size()));
+    m_outStream->flush();
+    m_written += data.size();
+  }
+
+  if (!isRotationEnabled()) {
+    return;
+  }
+
+  auto fileAge = static_cast<uint64_t>(
+      std::chrono::duration_cast<USec>(std::chrono::steady_clock::now() - m_openTime).count());
+  if (((m_config.rotateSize > 0) && (m_written >= m_config.rotateSize)) ||
+      ((m_config.rotateInterval > 0) && (fileAge >= m_config.rotateInterval))) {
+    rotate();
+  }
+}
+
+bool JsonFile::isOpen(void)
+{
+#ifdef WITH_ZLIB
+  if (m_compressor != nullptr) {
+    return true;
+  }
+#endif
+  return (m_outStream != nullptr);
+}
+
+void JsonFile::open(void)
+{
+  m_openTime = std::chrono::steady_clock::now();
+  m_written = 0;
+
+#ifdef WITH_ZLIB
+  if (m_config.compress) {
+    try {
+      m_compressor = std::make_unique<GzipFrameWriter>(
+          m_path, m_path + ".idx", m_config.frameSize, m_config.frameInterval);
+      return;
+    } catch (const std::exception &e) {
+      logError() << "Compressed json output failed: " << e.what() << ". Write uncompressed";
+      m_config.compress = false;
+    }
+  }
+#endif
+
+  m_outStream = std::make_unique<std::ofstream>(m_path, std::ofstream::out | std::ofstream::app);
+  if (m_outStream->tellp() > 0) {
+    *m_outStream << std::endl;
+  }
+}
+
+void JsonFile::close(void)
+{
+#ifdef WITH_ZLIB
+  m_compressor.reset();
+#endif
+  m_outStream.reset();
+}
+
+void JsonFile::rotate(void)
+{
+  char timeStamp[32];
+  struct tm timeInfo;
+  auto timeNow = ::time(NULL);
+
+  close();
+
+  ::gmtime_r(&timeNow, &timeInfo);
+  ::strftime(timeStamp, sizeof(timeStamp), "%Y%m%dT%H%M%SZ", &timeInfo);
+
+  auto rotatedPath = pathWithTag(m_path, timeStamp, '-');
+  for (int i = 1; std::filesystem::exists(rotatedPath); i++) {
+    rotatedPath = pathWithTag(m_path, std::string(timeStamp) + "-" + std::to_string(i), '-');
+  }
+
+  // Readers only pick up rotated files so they always see complete files
+  std::error_code ec;
+  std::filesystem::rename(m_path, rotatedPath, ec);
+  if (ec) {
+    logError() << "Failed to rotate " << m_path << ": " << ec.message();
+    return;
+  }
+  if (m_config.compress) {
+    std::filesystem::rename(m_path + ".idx", rotatedPath + ".idx", ec);
+  }
+
+  logInfo() << "Rotated json output " << m_path << " to " << rotatedPath;
+}
+
+} // namespace tkm::reader
@@ -0,0 +1,85 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     JsonFile Class
+ * @details   Json output file with optional rotation and compression
+ *-
+ */
+
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#ifdef WITH_ZLIB
+#include "GzipFrameWriter.h"
+#endif
+
+namespace tkm::reader
+{
+
+class JsonFile
+{
+public:
+  typedef struct Config {
+    // Rotate when the file reaches rotateSize bytes, compressed bytes for
+    // compressed files, or is older than rotateInterval usec. Zero disables
+    // the rotation criteria.
+    uint64_t rotateSize;
+    uint64_t rotateInterval;
+    bool compress;
+    size_t frameSize;
+    uint64_t frameInterval;
+  } Config;
+
+public:
+  explicit JsonFile(const std::string &path, const Config &config);
+  ~JsonFile();
+
+public:
+  JsonFile(JsonFile const &) = delete;
+  void operator=(JsonFile const &) = delete;
+
+  // Data is a set of complete records so a file is never split mid record.
+  // Header lines (compact schemas) are written first in a new file or frame,
+  // so each of them can be read on its own.
+  void write(const std::string &data,
+             const std::string &header,
+             time_t firstTime,
+             time_t lastTime,
+             size_t records);
+  void close(void);
+
+  // Path with a tag inserted before the first extension, ex: out.json -> out.<tag>.json
+  static auto pathWithTag(const std::string &path, const std::string &tag, char separator)
+      -> std::string;
+  // Remove the file at path with its split and rotated files and their frame indexes
+  static void removeFiles(const std::string &path);
+
+private:
+  bool isOpen(void);
+  void open(void);
+  void rotate(void);
+  bool isRotationEnabled(void)
+  {
+    return (m_config.rotateSize > 0) || (m_config.rotateInterval > 0);
+  }
+
+private:
+  std::string m_path;
+  Config m_config;
+  std::unique_ptr<std::ofstream> m_outStream = nullptr;
+#ifdef WITH_ZLIB
+  std::unique_ptr<GzipFrameWriter> m_compressor = nullptr;
+#endif
+  std::chrono::time_point<std::chrono::steady_clock> m_openTime{};
+  uint64_t m_written = 0;
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,279 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     JsonParser Class
+ * @details   Minimal JSON parser for reading back tkmreader output
+ *-
+ */
+
+#include <cstring>
+
+#include "JsonParser.h"
+
+namespace tkm::reader
+{
+
+// Nesting limit, tkmreader records are at most three levels deep
+static constexpr int MaxDepth = 64;
+
+typedef struct Cursor {
+  const char *pos;
+  const char *end;
+} Cursor;
+
+static bool parseValue(Cursor &cur, JsonValue &value, int depth);
+
+static void skipSpace(Cursor &cur)
+{
+  while ((cur.pos < cur.end) &&
+         ((*cur.pos == ' ') || (*cur.pos == '\t') || (*cur.pos == '\n') || (*cur.pos == '\r'))) {
+    cur.pos++;
+  }
+}
+
+static bool consume(Cursor &cur, char c)
+{
+  skipSpace(cur);
+  if ((cur.pos < cur.end) && (*cur.pos == c)) {
+    cur.pos++;
+    return true;
+  }
+  return false;
+}
+
+static bool parseHex(Cursor &cur, unsigned int &codepoint)
+{
+  if (cur.end - cur.pos < 4) {
+    return false;
+  }
+
+  codepoint = 0;
+  for (int i = 0; i < 4; i++) {
+    char c = *cur.pos++;
+    codepoint <<= 4;
+    if ((c >= '0') && (c <= '9')) {
+      codepoint |= static_cast<unsigned int>(c - '0');
+    } else if ((c >= 'a') && (c <= 'f')) {
+      codepoint |= static_cast<unsigned int>(c - 'a' + 10);
+    } else if ((c >= 'A') && (c <= 'F')) {
+      codepoint |= static_cast<unsigned int>(c - 'A' + 10);
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static void appendUtf8(std::string &out, unsigned int codepoint)
+{
+  if (codepoint < 0x80) {
+    out.push_back(static_cast<char>(codepoint));
+  } else if (codepoint < 0x800) {
+    out.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+    out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+  } else if (codepoint < 0x10000) {
+    out.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+    out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+  } else {
+    out.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+    out.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+  }
+}
+
+static bool parseString(Cursor &cur, std::string &out)
+{
+  if (!consume(cur, '"')) {
+    return false;
+  }
+
+  out.clear();
+  while (cur.pos < cur.end) {
+    char c = *cur.pos++;
+
+    if (c == '"') {
+      return true;
+    }
+    if (c != '\\') {
+      out.push_back(c);
+      continue;
+    }
+    if (cur.pos == cur.end) {
+      return false;
+    }
+
+    switch (*cur.pos++) {
+    case '"':
+      out.push_back('"');
+      break;
+    case '\\':
+      out.push_back('\\');
+      break;
+    case '/':
+      out.push_back('/');
+      break;
+    case 'b':
+      out.push_back('\b');
+      break;
+    case 'f':
+      out.push_back('\f');
+      break;
+    case 'n':
+      out.push_back('\n');
+      break;
+    case 'r':
+      out.push_back('\r');
+      break;
+    case 't':
+      out.push_back('\t');
+      break;
+    case 'u': {
+      unsigned int codepoint = 0;
+      if (!parseHex(cur, codepoint)) {
+        return false;
+      }
+      // Non BMP codepoints are written as UTF-16 surrogate pairs
+      if ((codepoint >= 0xD800) && (codepoint <= 0xDBFF)) {
+        unsigned int low = 0;
+        if ((cur.end - cur.pos < 2) || (cur.pos[0] != '\\') || (cur.pos[1] != 'u')) {
+          return false;
+        }
+        cur.pos += 2;
+        if (!parseHex(cur, low) || (low < 0xDC00) || (low > 0xDFFF)) {
+          return false;
+        }
+        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+      }
+      appendUtf8(out, codepoint);
+    } break;
+    default:
+      return false;
+    }
+  }
+
+  return false;
+}
+
+static bool parseLiteral(Cursor &cur, const char *literal)
+{
+  auto size = strlen(literal);
+  if ((static_cast<size_t>(cur.end - cur.pos) < size) || (strncmp(cur.pos, literal, size) != 0)) {
+    return false;
+  }
+  cur.pos += size;
+  return true;
+}
+
+static bool parseNumber(Cursor &cur, JsonValue &value)
+{
+  auto start = cur.pos;
+
+  while ((cur.pos < cur.end) && (*cur.pos != '\0') &&
+         (strchr("0123456789+-.eE", *cur.pos) != nullptr)) {
+    cur.pos++;
+  }
+  if (cur.pos == start) {
+    return false;
+  }
+
+  value.type = JsonValue::Type::Number;
+  value.text.assign(start, static_cast<size_t>(cur.pos - start));
+  return true;
+}
+
+static bool parseArray(Cursor &cur, JsonValue &value, int depth)
+{
+  value.type = JsonValue::Type::Array;
+  cur.pos++;
+
+  if (consume(cur, ']')) {
+    return true;
+  }
+
+  do {
+    value.items.emplace_back();
+    if (!parseValue(cur, value.items.back(), depth + 1)) {
+      return false;
+    }
+  } while (consume(cur, ','));
+
+  return consume(cur, ']');
+}
+
+static bool parseObject(Cursor &cur, JsonValue &value, int depth)
+{
+  value.type = JsonValue::Type::Object;
+  cur.pos++;
+
+  if (consume(cur, '}')) {
+    return true;
+  }
+
+  do {
+    value.keys.emplace_back();
+    if (!parseString(cur, value.keys.back()) || !consume(cur, ':')) {
+      return false;
+    }
+    value.items.emplace_back();
+    if (!parseValue(cur, value.items.back(), depth + 1)) {
+      return false;
+    }
+  } while (consume(cur, ','));
+
+  return consume(cur, '}');
+}
+
+static bool parseValue(Cursor &cur, JsonValue &value, int depth)
+{
+  if (depth > MaxDepth) {
+    return false;
+  }
+
+  skipSpace(cur);
+  if (cur.pos == cur.end) {
+    return false;
+  }
+
+  switch (*cur.pos) {
+  case '{':
+    return parseObject(cur, value, depth);
+  case '[':
+    return parseArray(cur, value, depth);
+  case '"':
+    value.type = JsonValue::Type::String;
+    return parseString(cur, value.text);
+  case 't':
+  case 'f':
+    value.type = JsonValue::Type::Bool;
+    value.text = (*cur.pos == 't') ? "true" : "false";
+    return parseLiteral(cur, value.text.c_str());
+  case 'n':
+    // Written for NaN floats, kept as a number literal
+    value.type = JsonValue::Type::Number;
+    value.text = "null";
+    return parseLiteral(cur, "null");
+  default:
+    return parseNumber(cur, value);
+  }
+}
+
+bool JsonParser::parse(std::string_view text, JsonValue &value)
+{
+  Cursor cur{.pos = text.data(), .end = text.data() + text.size()};
+
+  value = JsonValue{};
+  if (!parseValue(cur, value, 0)) {
+    return false;
+  }
+
+  skipSpace(cur);
+  return (cur.pos == cur.end);
+}
+
+} // namespace tkm::reader
@@ -0,0 +1,54 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     JsonParser Class
+ * @details   Minimal JSON parser for reading back tkmreader output
+ *-
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tkm::reader
+{
+
+typedef struct JsonValue {
+  enum class Type { Null, Bool, Number, String, Array, Object };
+
+  Type type = Type::Null;
+  // Decoded string, number literal as written or "true" / "false"
+  std::string text{};
+  // Object member names, in input order
+  std::vector<std::string> keys{};
+  // Array elements or object member values
+  std::vector<JsonValue> items{};
+
+  auto member(std::string_view name) const -> const JsonValue *
+  {
+    for (size_t i = 0; i < keys.size(); i++) {
+      if (keys[i] == name) {
+        return &items[i];
+      }
+    }
+    return nullptr;
+  }
+} JsonValue;
+
+/*
+ * Numbers are kept as text so they can be written back unchanged, this also
+ * covers the "null" and +/-1e+9999 values written for non finite floats.
+ */
+class JsonParser
+{
+public:
+  // Parse one JSON text, false if the input is not valid JSON
+  static bool parse(std::string_view text, JsonValue &value);
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,174 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     JsonRecord Class
+ * @details   Build data records in verbose or compact JSON form
+ *-
+ */
+
+#include "JsonRecord.h"
+
+namespace tkm::reader
+{
+
+void JsonRecord::begin(const char *type,
+                       const std::string &session,
+                       uint64_t systemTime,
+                       uint64_t monotonicTime,
+                       uint64_t receiveTime)
+{
+  m_schema.reset();
+  m_groups.clear();
+  m_type = type;
+
+  if (m_format == Format::Verbose) {
+    m_json.beginSortedObject();
+    m_json.field("type", type);
+    m_json.field("system_time", systemTime);
+    m_json.field("monotonic_time", monotonicTime);
+    m_json.field("receive_time", receiveTime);
+    m_json.field("session", session);
+    return;
+  }
+
+  // Readers of a new session get all schemas again
+  if (session != m_session) {
+    m_session = session;
+    for (auto &[name, typeSchema] : m_types) {
+      typeSchema.written = false;
+    }
+  }
+
+  m_current = &m_types[type];
+  m_json.beginArray();
+  m_json.element(type);
+  m_json.element(systemTime);
+  m_json.element(monotonicTime);
+  m_json.element(receiveTime);
+}
+
+void JsonRecord::end(void)
+{
+  if (m_format == Format::Verbose) {
+    m_json.endObject();
+    return;
+  }
+
+  m_json.endArray();
+  if (!m_current->written) {
+    writeSchema();
+    m_current->written = true;
+  }
+}
+
+void JsonRecord::beginGroup(const char *kind)
+{
+  if (m_format == Format::Verbose) {
+    m_json.key(std::string_view(kind));
+    m_json.beginObject();
+    return;
+  }
+  beginCompactGroup(kind, false, nullptr);
+}
+
+void JsonRecord::beginGroup(const char *kind, std::string_view key, const char *keyField)
+{
+  if (m_format == Format::Verbose) {
+    m_json.key(key);
+    m_json.beginObject();
+    return;
+  }
+  if (beginCompactGroup(kind, true, keyField)) {
+    m_json.element(key);
+  }
+}
+
+void JsonRecord::beginGroup(const char *kind, int64_t key, const char *keyField)
+{
+  if (m_format == Format::Verbose) {
+    m_json.key(key);
+    m_json.beginObject();
+    return;
+  }
+  if (beginCompactGroup(kind, true, keyField)) {
+    m_json.element(key);
+  }
+}
+
+void JsonRecord::endGroup(void)
+{
+  if (m_format == Format::Verbose) {
+    m_json.endObject();
+    return;
+  }
+  m_json.endArray();
+  m_groups.pop_back();
+}
+
+bool JsonRecord::beginCompactGroup(const char *kind, bool keyed, const char *keyField)
+{
+  auto &kinds = m_current->kinds;
+  size_t index = 0;
+
+  while ((index < kinds.size()) && (kinds[index].name != kind)) {
+    index++;
+  }
+
+  // Field names of a new kind are taken from its first group
+  bool learning = (index == kinds.size());
+  if (learning) {
+    kinds.push_back(Kind{.name = kind,
+                         .keyed = keyed,
+                         .keyField = (keyField != nullptr) ? keyField : "",
+                         .fields = {}});
+    m_current->written = false;
+  }
+
+  m_groups.push_back(Group{.kind = index, .learning = learning});
+  m_json.beginArray();
+  m_json.element(static_cast<uint64_t>(index));
+
+  return keyed && kinds[index].keyField.empty();
+}
+
+void JsonRecord::writeSchema(void)
+{
+  m_schema.reset();
+  m_schema.beginObject();
+  m_schema.field("type", "schema");
+  m_schema.field("record", m_type);
+  m_schema.field("session", m_session);
+
+  m_schema.key("head");
+  m_schema.beginArray();
+  m_schema.element("system_time");
+  m_schema.element("monotonic_time");
+  m_schema.element("receive_time");
+  m_schema.endArray();
+
+  m_schema.key("kinds");
+  m_schema.beginArray();
+  for (const auto &kind : m_current->kinds) {
+    m_schema.beginObject();
+    m_schema.field("name", kind.name);
+    m_schema.field("keyed", kind.keyed);
+    if (!kind.keyField.empty()) {
+      m_schema.field("key_field", kind.keyField);
+    }
+    m_schema.key("fields");
+    m_schema.beginArray();
+    for (const auto &name : kind.fields) {
+      m_schema.element(name);
+    }
+    m_schema.endArray();
+    m_schema.endObject();
+  }
+  m_schema.endArray();
+
+  m_schema.endObject();
+}
+
+} // namespace tkm::reader
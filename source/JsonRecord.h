@@ -0,0 +1,128 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     JsonRecord Class
+ * @details   Build data records in verbose or compact JSON form
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "JsonEncoder.h"
+
+namespace tkm::reader
+{
+
+/*
+ * A record is a head (type, times and session) and a list of groups holding
+ * fields or nested groups. In verbose form a record is the sorted object
+ * written so far. In compact form a record is a positional array:
+ *   ["<type>",<system_time>,<monotonic_time>,<receive_time>,<group>,...]
+ * and every group is an array:
+ *   [<kind>,<key>,<field value>,...,<nested group>,...]
+ * where <kind> indexes the group kinds of the record type and <key> is only
+ * present for keyed kinds (ex: process entries keyed by pid) whose key is not
+ * already a field value. Field names are written once per record type and
+ * session in a schema record:
+ *   {"type":"schema","record":"<type>","session":"<hash>",
+ *    "head":["system_time","monotonic_time","receive_time"],
+ *    "kinds":[{"name":"<name>","keyed":<bool>,"key_field":"<field>",
+ *              "fields":[...]},...]}
+ * where "key_field" is only set for kinds keyed by one of their fields.
+ * The schema is written again, complete, only if a record uses a new kind.
+ */
+class JsonRecord
+{
+public:
+  enum class Format { Verbose, Compact };
+
+public:
+  explicit JsonRecord(JsonEncoder &encoder)
+  : m_json(encoder)
+  {
+  }
+  ~JsonRecord() = default;
+
+public:
+  JsonRecord(JsonRecord const &) = delete;
+  void operator=(JsonRecord const &) = delete;
+
+  void setFormat(Format format) { m_format = format; }
+  auto getFormat(void) const -> Format { return m_format; }
+
+  void begin(const char *type,
+             const std::string &session,
+             uint64_t systemTime,
+             uint64_t monotonicTime,
+             uint64_t receiveTime);
+  void end(void);
+
+  // Group with the kind name as key
+  void beginGroup(const char *kind);
+  // Group with a runtime key, many groups of the same kind per record.
+  // If keyField is set the key is also the value of that field.
+  void beginGroup(const char *kind, std::string_view key, const char *keyField = nullptr);
+  void beginGroup(const char *kind, int64_t key, const char *keyField = nullptr);
+  void endGroup(void);
+
+  template <size_t N, class T>
+  void field(const char (&name)[N], const T &val)
+  {
+    if (m_format == Format::Verbose) {
+      m_json.field(name, val);
+      return;
+    }
+    if (m_groups.back().learning) {
+      m_current->kinds[m_groups.back().kind].fields.emplace_back(name, N - 1);
+    }
+    m_json.element(val);
+  }
+
+  // Encoded record and the schema record to write before it, if any
+  auto view(void) const -> std::string_view { return m_json.view(); }
+  auto schema(void) const -> std::string_view { return m_schema.view(); }
+  auto type(void) const -> std::string_view { return (m_type != nullptr) ? m_type : ""; }
+
+private:
+  typedef struct Kind {
+    std::string name;
+    bool keyed;
+    std::string keyField;
+    std::vector<std::string> fields;
+  } Kind;
+
+  typedef struct TypeSchema {
+    std::vector<Kind> kinds;
+    bool written;
+  } TypeSchema;
+
+  typedef struct Group {
+    size_t kind;
+    bool learning;
+  } Group;
+
+  // Returns true if the key has to be written
+  bool beginCompactGroup(const char *kind, bool keyed, const char *keyField);
+  void writeSchema(void);
+
+private:
+  JsonEncoder &m_json;
+  JsonEncoder m_schema{};
+  Format m_format = Format::Verbose;
+  std::unordered_map<std::string, TypeSchema> m_types{};
+  std::vector<Group> m_groups{};
+  TypeSchema *m_current = nullptr;
+  const char *m_type = nullptr;
+  std::string m_session{};
+};
+
+} // namespace tkm::reader
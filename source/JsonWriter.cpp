@@ -13,17 +13,19 @@
 #include "../bswinfra/source/Logger.h"
 #include "Application.h"
 #include "Arguments.h"
+#include <cstdlib>
 #include <iostream>
-#include <json/writer.h>
 #include <memory>
+#include <sstream>
 
 namespace tkm::reader
 {
 
 JsonWriter *JsonWriter::instance = nullptr;
-static std::unique_ptr<std::ofstream> m_outStream = nullptr;
 static JsonWriter::OutputType outputType = JsonWriter::OutputType::Disabled;
 
+static auto parseRotation(const std::string &rotation, JsonFile::Config &config) -> bool;
+
 JsonWriter::JsonWriter()
 {
   if (App()->getArguments()->hasFor(Arguments::Key::JsonPath)) {
@@ -31,37 +33,385 @@ JsonWriter::JsonWriter()
       outputType = JsonWriter::OutputType::StandardOut;
     } else {
       outputType = JsonWriter::OutputType::FilePath;
+      m_path = App()->getArguments()->getFor(Arguments::Key::JsonPath);
+    }
+  }
+
+  m_fileConfig = JsonFile::Config{
+      .rotateSize = 0,
+      .rotateInterval = 0,
+      .compress = (App()->getArguments()->getFor(Arguments::Key::JsonCompress) == "gzip"),
+      .frameSize = std::stoul(tkmDefaults.getFor(Defaults::Default::JsonFrameSize)),
+      .frameInterval = std::stoul(tkmDefaults.getFor(Defaults::Default::JsonFrameInterval))};
+
+  auto rotation = App()->getArguments()->getFor(Arguments::Key::JsonRotate);
+  if ((rotation != tkmDefaults.getFor(Defaults::Default::JsonRotate)) &&
+      !parseRotation(rotation, m_fileConfig)) {
+    logWarn() << "Invalid json rotation: " << rotation << ". Rotation disabled";
+    m_fileConfig.rotateSize = 0;
+    m_fileConfig.rotateInterval = 0;
+  }
+
+  auto format = App()->getArguments()->getFor(Arguments::Key::JsonFormat);
+  if (format == "compact") {
+    m_record.setFormat(JsonRecord::Format::Compact);
+  } else if (format != tkmDefaults.getFor(Defaults::Default::JsonFormat)) {
+    logWarn() << "Unknown json format: " << format << ". Use default";
+  }
+
+  // Records go to a single stream on stdout
+  m_split = (outputType == OutputType::FilePath) &&
+            (App()->getArguments()->getFor(Arguments::Key::JsonSplit) ==
+             tkmDefaults.valFor(Defaults::Val::True));
+
+  auto flushPolicy = App()->getArguments()->getFor(Arguments::Key::JsonFlush);
+  if (flushPolicy == "size") {
+    m_flushPolicy = FlushPolicy::Size;
+  } else if (flushPolicy == "interval") {
+    m_flushPolicy = FlushPolicy::Interval;
+  } else if (flushPolicy == "line") {
+    m_flushPolicy = FlushPolicy::Line;
+  } else {
+    if (flushPolicy != tkmDefaults.getFor(Defaults::Default::JsonFlush)) {
+      logWarn() << "Unknown json flush policy: " << flushPolicy << ". Use default";
     }
+    // Keep stdout line buffered for live tailing
+    m_flushPolicy = (outputType == OutputType::StandardOut) ? FlushPolicy::Line
+                                                            : FlushPolicy::Interval;
+  }
+
+  if (outputType == OutputType::Disabled) {
+    return;
+  }
+
+  m_flushSize = std::stoul(tkmDefaults.getFor(Defaults::Default::JsonFlushSize));
+  m_partitions.push_back(
+      Partition{.name = "",
+                .buffer = "",
+                .records = 0,
+                .firstTime = 0,
+                .lastTime = 0,
+                .schemas = {},
+                .schemaLines = nullptr});
+  if (m_flushPolicy != FlushPolicy::Line) {
+    m_partitions.front().buffer.reserve(m_flushSize);
   }
 
-  if (outputType == JsonWriter::OutputType::FilePath) {
-    m_outStream =
-        std::make_unique<std::ofstream>(App()->getArguments()->getFor(Arguments::Key::JsonPath),
-                                        std::ofstream::out | std::ofstream::app);
+  if (m_flushPolicy == FlushPolicy::Interval) {
+    m_flushTimer = std::make_shared<Timer>("JsonFlushTimer", [this]() {
+      flush();
+      return true;
+    });
+    m_flushTimer->start(std::stoul(tkmDefaults.getFor(Defaults::Default::JsonFlushInterval)), true);
+    App()->addEventSource(m_flushTimer);
+  }
+
+  // Output files are only used by the writer thread from now on
+  m_writer = std::thread(&JsonWriter::writerThread, this);
+
+  // Buffered records are written on any exit path
+  std::atexit([]() { JsonWriter::getInstance()->stop(); });
+}
+
+static auto parseRotation(const std::string &rotation, JsonFile::Config &config) -> bool
+{
+  std::stringstream rotationStream(rotation);
+  std::string criteria;
+
+  while (std::getline(rotationStream, criteria, ',')) {
+    auto sepPos = criteria.find('=');
+    if (sepPos == std::string::npos) {
+      return false;
+    }
+
+    auto name = criteria.substr(0, sepPos);
+    uint64_t value = 0;
+    try {
+      value = std::stoull(criteria.substr(sepPos + 1));
+    } catch (...) {
+      return false;
+    }
 
-    if (m_outStream->tellp() > 0) {
-      *m_outStream << std::endl;
+    if (name == "size") {
+      config.rotateSize = value * 1024 * 1024;
+    } else if (name == "time") {
+      config.rotateInterval = value * 1000000;
+    } else {
+      return false;
     }
   }
 
-  builder["commentStyle"] = "None";
-  builder["indentation"] = "";
+  return (config.rotateSize > 0) || (config.rotateInterval > 0);
+}
+
+bool JsonWriter::isEnabled(void)
+{
+  return (outputType != OutputType::Disabled);
+}
+
+bool JsonWriter::isEnabledFor(tkm::msg::monitor::Data_What what)
+{
+  if (outputType == OutputType::Disabled) {
+    return false;
+  }
+  return App()->isRecordTypeSelected(what) && App()->isJsonTypeSelected(what);
+}
+
+auto JsonWriter::getEncoder(const std::string &recordType) -> JsonEncoder &
+{
+  m_partition = 0;
+
+  if (m_split) {
+    while ((m_partition < m_partitions.size()) &&
+           (m_partitions[m_partition].name != recordType)) {
+      m_partition++;
+    }
+
+    // The first partition is never used when split so take it over
+    if ((m_partition == m_partitions.size()) && m_partitions.front().name.empty()) {
+      m_partition = 0;
+      m_partitions.front().name = recordType;
+    } else if (m_partition == m_partitions.size()) {
+      m_partitions.push_back(
+          Partition{.name = recordType,
+                    .buffer = "",
+                    .records = 0,
+                    .firstTime = 0,
+                    .lastTime = 0,
+                    .schemas = {},
+                    .schemaLines = nullptr});
+      if (m_flushPolicy != FlushPolicy::Line) {
+        m_partitions.back().buffer.reserve(m_flushSize);
+      }
+    }
+  }
+
+  m_encoder.reset();
+  return m_encoder;
 }
 
 void JsonWriter::Payload::print()
+{
+  if (!m_schema.empty()) {
+    JsonWriter::getInstance()->cacheSchema(m_type, m_schema);
+    JsonWriter::getInstance()->append(m_schema);
+  }
+  JsonWriter::getInstance()->append(m_data);
+}
+
+void JsonWriter::append(std::string_view data)
+{
+  if (outputType == OutputType::Disabled) {
+    return;
+  }
+
+  auto &partition = m_partitions[m_partition];
+  auto timeNow = ::time(NULL);
+  if (partition.records == 0) {
+    partition.firstTime = timeNow;
+  }
+  partition.lastTime = timeNow;
+
+  partition.buffer.append(data);
+  partition.buffer.push_back('\n');
+  partition.records++;
+
+  if ((m_flushPolicy == FlushPolicy::Line) || (partition.buffer.size() >= m_flushSize)) {
+    flushPartition(partition);
+  }
+}
+
+void JsonWriter::cacheSchema(std::string_view type, std::string_view schema)
+{
+  if (outputType != OutputType::FilePath) {
+    return;
+  }
+
+  // A schema is complete, it replaces the previous one of the record type
+  auto &partition = m_partitions[m_partition];
+  auto it = partition.schemas.find(type);
+  if (it == partition.schemas.end()) {
+    it = partition.schemas.emplace(std::string(type), std::string()).first;
+  }
+  it->second.assign(schema).push_back('\n');
+
+  // Shared with the chunks in flight, only rebuilt when a schema changes
+  auto lines = std::make_shared<std::string>();
+  for (const auto &[name, line] : partition.schemas) {
+    lines->append(line);
+  }
+  partition.schemaLines = std::move(lines);
+}
+
+void JsonWriter::flush(void)
+{
+  for (auto &partition : m_partitions) {
+    flushPartition(partition);
+  }
+}
+
+void JsonWriter::flushPartition(Partition &partition)
+{
+  if (partition.buffer.empty()) {
+    return;
+  }
+
+  Chunk chunk{.data = std::move(partition.buffer),
+              .partition = partition.name,
+              .schemas = partition.schemaLines,
+              .queued = std::chrono::steady_clock::now(),
+              .records = partition.records,
+              .firstTime = partition.firstTime,
+              .lastTime = partition.lastTime};
+
+  if (!m_chunks.push(chunk)) {
+    if (outputType != OutputType::FilePath) {
+      // The pipe reader is behind, never block the main loop on it
+      partition.buffer = std::move(chunk.data);
+      if (partition.buffer.size() >= m_flushSize * QueueSize) {
+        logWarn() << "Json output not read in time, " << partition.records
+                  << " records dropped";
+        m_dropped += partition.records;
+        partition.buffer.clear();
+        partition.records = 0;
+      }
+      return;
+    }
+
+    // Files are written at disk speed, wait for a free slot instead of losing records
+    std::unique_lock<std::mutex> lock(m_wakeLock);
+    m_waits++;
+    m_wakeup.notify_one();
+    m_room.wait(lock, [this, &chunk]() { return m_chunks.push(chunk); });
+  }
+
+  partition.records = 0;
+  if (!m_spares.pop(partition.buffer)) {
+    partition.buffer = std::string();
+    if (m_flushPolicy != FlushPolicy::Line) {
+      partition.buffer.reserve(m_flushSize);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_wakeLock);
+  }
+  m_wakeup.notify_one();
+}
+
+void JsonWriter::stop(void)
+{
+  if (!m_writer.joinable()) {
+    return;
+  }
+
+  auto hasPending = [this]() {
+    for (const auto &partition : m_partitions) {
+      if (!partition.buffer.empty()) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  // Give the writer up to one second to make room for the last records
+  for (int retry = 0; (retry < 1000) && hasPending(); retry++) {
+    flush();
+    if (hasPending()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  m_stopping = true;
+  {
+    std::lock_guard<std::mutex> lock(m_wakeLock);
+  }
+  m_wakeup.notify_one();
+  m_writer.join();
+}
+
+void JsonWriter::writeChunk(const Chunk &chunk)
 {
   switch (outputType) {
   case OutputType::StandardOut:
-    std::cout << m_stream.str() << std::endl;
+    std::cout.write(chunk.data.data(), static_cast<std::streamsize>(chunk.data.size()));
+    std::cout.flush();
     break;
-  case OutputType::FilePath:
-    if (m_outStream != nullptr) {
-      *m_outStream << m_stream.str() << std::endl;
+  case OutputType::FilePath: {
+    auto &file = m_files[chunk.partition];
+    if (file == nullptr) {
+      auto filePath =
+          chunk.partition.empty() ? m_path : JsonFile::pathWithTag(m_path, chunk.partition, '.');
+      file = std::make_unique<JsonFile>(filePath, m_fileConfig);
     }
+    // Chunks hold complete records so rotation never splits a record
+    file->write(chunk.data,
+                (chunk.schemas != nullptr) ? *chunk.schemas : std::string(),
+                chunk.firstTime,
+                chunk.lastTime,
+                chunk.records);
     break;
+  }
   default:
     break;
   }
 }
 
+void JsonWriter::writerThread(void)
+{
+  using USec = std::chrono::microseconds;
+  Chunk chunk;
+
+  while (true) {
+    // Read the stop flag first so the last chunks are written before exit
+    bool stopping = m_stopping;
+
+    while (m_chunks.pop(chunk)) {
+      writeChunk(chunk);
+
+      auto lag = static_cast<uint64_t>(
+          std::chrono::duration_cast<USec>(std::chrono::steady_clock::now() - chunk.queued)
+              .count());
+      if (lag > m_maxLag) {
+        m_maxLag = lag;
+      }
+      m_bytesWritten += chunk.data.size();
+      m_recordsWritten += chunk.records;
+
+      chunk.data.clear();
+      m_spares.push(chunk.data);
+
+      // Wake up the main loop if it waits for a free slot
+      {
+        std::lock_guard<std::mutex> lock(m_wakeLock);
+      }
+      m_room.notify_one();
+    }
+
+    if (stopping) {
+      m_files.clear();
+      break;
+    }
+
+    std::unique_lock<std::mutex> lock(m_wakeLock);
+    m_wakeup.wait_for(lock, std::chrono::milliseconds(100), [this]() {
+      return (m_chunks.size() > 0) || m_stopping;
+    });
+  }
+}
+
+auto JsonWriter::getStats(void) -> std::string
+{
+  std::stringstream stats;
+
+  stats << "json queued=" << m_chunks.size() << " written_bytes=" << m_bytesWritten.exchange(0)
+        << " written_records=" << m_recordsWritten.exchange(0)
+        << " max_lag_usec=" << m_maxLag.exchange(0) << " dropped=" << m_dropped
+        << " waits=" << m_waits;
+  m_dropped = 0;
+  m_waits = 0;
+
+  return stats.str();
+}
+
 } // namespace tkm::reader
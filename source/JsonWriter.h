@@ -11,12 +11,27 @@
 
 #pragma once
 
-#include <fstream>
-#include <json/json.h>
-#include <json/writer.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <map>
 #include <memory>
-#include <sstream>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <taskmonitor/taskmonitor.h>
+#include <thread>
+#include <vector>
+
+#include "JsonEncoder.h"
+#include "JsonFile.h"
+#include "JsonRecord.h"
+#include "RingQueue.h"
+
+#include "../bswinfra/source/Timer.h"
+
+using namespace bswi::event;
 
 namespace tkm::reader
 {
@@ -25,6 +40,7 @@ class JsonWriter
 {
 public:
   enum class OutputType { Disabled, StandardOut, FilePath };
+  enum class FlushPolicy { Line, Size, Interval };
 
   static JsonWriter *getInstance() { return (!instance) ? instance = new JsonWriter : instance; }
 
@@ -32,26 +48,49 @@ public:
     Payload() = default;
     ~Payload() { print(); }
 
-    template <class T>
-    Payload &operator<<(const T &val)
+    Payload &operator<<(const JsonEncoder &encoder)
+    {
+      m_data = encoder.view();
+      return *this;
+    }
+
+    Payload &operator<<(const JsonRecord &record)
     {
-      const std::unique_ptr<Json::StreamWriter> writer(
-          JsonWriter::getInstance()->builder.newStreamWriter());
-      writer->write(val, &m_stream);
+      m_schema = record.schema();
+      m_type = record.type();
+      m_data = record.view();
       return *this;
     }
 
     void print();
 
   private:
-    std::ostringstream m_stream;
+    std::string_view m_schema{};
+    std::string_view m_type{};
+    std::string_view m_data{};
     friend class JsonWriter;
   };
 
   static Payload write() { return Payload{}; }
 
-public:
-  Json::StreamWriterBuilder builder;
+  // Records are only encoded for an enabled output and a selected data type
+  bool isEnabled(void);
+  bool isEnabledFor(tkm::msg::monitor::Data_What what);
+
+  // Hand over buffered records to the writer thread
+  void flush(void);
+  // Writer thread statistics since the last call
+  auto getStats(void) -> std::string;
+
+  // Encoder shared by all records, the returned instance is reset.
+  // The record type selects the output file when records are split by type.
+  auto getEncoder(const std::string &recordType) -> JsonEncoder &;
+  // Data record builder in the configured format, uses the shared encoder
+  auto getRecord(const std::string &recordType) -> JsonRecord &
+  {
+    getEncoder(recordType);
+    return m_record;
+  }
 
 public:
   JsonWriter(JsonWriter const &) = delete;
@@ -61,8 +100,67 @@ private:
   JsonWriter();
   ~JsonWriter() = default;
 
+  void append(std::string_view data);
+  void cacheSchema(std::string_view type, std::string_view schema);
+  void stop(void);
+  void writerThread(void);
+
 private:
+  typedef struct Chunk {
+    std::string data;
+    std::string partition;
+    // Schemas of the partition, written first in every new file or frame
+    std::shared_ptr<const std::string> schemas;
+    std::chrono::time_point<std::chrono::steady_clock> queued;
+    size_t records;
+    time_t firstTime;
+    time_t lastTime;
+  } Chunk;
+
+  // Records waiting to be handed over, one partition per output file
+  typedef struct Partition {
+    std::string name;
+    std::string buffer;
+    size_t records;
+    time_t firstTime;
+    time_t lastTime;
+    std::map<std::string, std::string, std::less<>> schemas;
+    std::shared_ptr<const std::string> schemaLines;
+  } Partition;
+
+  void flushPartition(Partition &partition);
+  void writeChunk(const Chunk &chunk);
+
+  static constexpr size_t QueueSize = 8;
+
   static JsonWriter *instance;
+  JsonEncoder m_encoder{};
+  JsonRecord m_record{m_encoder};
+  std::shared_ptr<Timer> m_flushTimer = nullptr;
+  FlushPolicy m_flushPolicy = FlushPolicy::Line;
+  std::vector<Partition> m_partitions{};
+  size_t m_partition = 0;
+  bool m_split = false;
+  size_t m_flushSize = 0;
+  uint64_t m_dropped = 0;
+  uint64_t m_waits = 0;
+
+  // Filled buffers go to the writer thread and come back empty for reuse
+  RingQueue<Chunk, QueueSize> m_chunks{};
+  RingQueue<std::string, QueueSize> m_spares{};
+  std::thread m_writer{};
+  std::mutex m_wakeLock{};
+  std::condition_variable m_wakeup{};
+  std::condition_variable m_room{};
+  std::atomic<bool> m_stopping{false};
+  std::atomic<uint64_t> m_bytesWritten{0};
+  std::atomic<uint64_t> m_recordsWritten{0};
+  std::atomic<uint64_t> m_maxLag{0};
+
+  // Output files are owned by the writer thread
+  std::map<std::string, std::unique_ptr<JsonFile>> m_files{};
+  JsonFile::Config m_fileConfig{};
+  std::string m_path{};
 };
 
 } // namespace tkm::reader
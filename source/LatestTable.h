@@ -0,0 +1,287 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     LatestTable Class
+ * @details   Shared memory table of the latest value of every series
+ *-
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Header only, readers only need this file. The table is a POSIX shared
+ * memory object (/dev/shm/<name>) written by one tkmreader:
+ *   Header (128 bytes)
+ *   Slot[slotCount] (128 bytes each)
+ * A slot holds the latest sample of one (source, entity, field) series of
+ * the device, the same series as the series outputs. Slots [0, usedSlots)
+ * are in use, a slot of a series without samples for a while can be given
+ * to a new series when the table is full.
+ *
+ * Every slot is guarded by a sequence lock: the writer makes seq odd,
+ * updates the slot and makes seq even again. A reader copies the slot and
+ * keeps the copy only if seq was even and did not change meanwhile. The
+ * writer never waits for readers and a read is retried a bounded number
+ * of times, so any number of readers add no load to the writer.
+ *
+ * A writer restart creates a new table, the old one is marked closed and
+ * readers have to open the name again.
+ */
+namespace tkm::reader::latest
+{
+
+constexpr std::string_view Magic = "TKMLATST";
+constexpr uint32_t Version = 1;
+
+constexpr size_t SourceSize = 16;
+constexpr size_t EntitySize = 40;
+constexpr size_t FieldSize = 48;
+
+// Same values as the series type of the series outputs
+enum class Type : uint8_t { UInt64 = 1, Int64 = 2, Double = 3 };
+
+typedef struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t slotSize;
+  uint32_t slotCount;
+  std::atomic<uint32_t> usedSlots;
+  std::atomic<uint32_t> closed;
+  uint32_t reserved0;
+  // System time of the newest sample written
+  std::atomic<uint64_t> updateTime;
+  char device[64];
+  char reserved1[24];
+} Header;
+
+typedef struct Slot {
+  std::atomic<uint32_t> seq;
+  uint8_t type;
+  uint8_t reserved[3];
+  std::atomic<uint64_t> time;
+  std::atomic<uint64_t> value;
+  char source[SourceSize];
+  char entity[EntitySize];
+  char field[FieldSize];
+} Slot;
+
+static_assert(sizeof(Header) == 128, "Latest table header layout");
+static_assert(sizeof(Slot) == 128, "Latest table slot layout");
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+                  std::atomic<uint64_t>::is_always_lock_free,
+              "Latest table needs lock free atomics");
+
+// Consistent copy of a slot
+typedef struct Value {
+  Type type;
+  uint64_t time;
+  uint64_t bits;
+  char source[SourceSize];
+  char entity[EntitySize];
+  char field[FieldSize];
+
+  auto getSource(void) const -> std::string_view { return source; }
+  auto getEntity(void) const -> std::string_view { return entity; }
+  auto getField(void) const -> std::string_view { return field; }
+  auto asUInt64(void) const -> uint64_t { return bits; }
+  auto asInt64(void) const -> int64_t { return static_cast<int64_t>(bits); }
+  auto asDouble(void) const -> double
+  {
+    switch (type) {
+    case Type::Int64:
+      return static_cast<double>(asInt64());
+    case Type::Double: {
+      double real;
+      std::memcpy(&real, &bits, sizeof(real));
+      return real;
+    }
+    case Type::UInt64:
+    default:
+      return static_cast<double>(bits);
+    }
+  }
+} Value;
+
+// Reads of a slot that keeps changing give up after MaxRetries
+constexpr unsigned MaxRetries = 64;
+
+class LatestTable
+{
+public:
+  LatestTable() = default;
+  ~LatestTable() { close(); }
+
+public:
+  LatestTable(LatestTable const &) = delete;
+  void operator=(LatestTable const &) = delete;
+
+  // Map the table of the shared memory name, ex: "tkm.<device>"
+  bool open(const std::string &name)
+  {
+    struct stat st;
+
+    close();
+    if (name.empty()) {
+      return false;
+    }
+
+    auto path = (name.front() == '/') ? name : "/" + name;
+    auto fd = ::shm_open(path.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+      return false;
+    }
+    if ((::fstat(fd, &st) < 0) || (static_cast<size_t>(st.st_size) < sizeof(Header))) {
+      ::close(fd);
+      return false;
+    }
+
+    m_size = static_cast<size_t>(st.st_size);
+    auto addr = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+      return false;
+    }
+    m_header = static_cast<const Header *>(addr);
+
+    if ((std::string_view(m_header->magic, sizeof(m_header->magic)) != Magic) ||
+        (m_header->version != Version) || (m_header->slotSize != sizeof(Slot)) ||
+        (sizeof(Header) + m_header->slotCount * sizeof(Slot) > m_size)) {
+      close();
+      return false;
+    }
+    m_slots = reinterpret_cast<const Slot *>(m_header + 1);
+    m_slotCount = m_header->slotCount;
+
+    return true;
+  }
+
+  void close(void)
+  {
+    if (m_header != nullptr) {
+      ::munmap(const_cast<Header *>(m_header), m_size);
+      m_header = nullptr;
+      m_slots = nullptr;
+      m_slotCount = 0;
+      m_size = 0;
+    }
+  }
+
+  bool isOpen(void) const { return m_header != nullptr; }
+  // The writer is gone or restarted, the name has to be opened again
+  bool isClosed(void) const
+  {
+    return (m_header == nullptr) || (m_header->closed.load(std::memory_order_acquire) != 0);
+  }
+
+  auto getDevice(void) const -> std::string_view
+  {
+    if (m_header == nullptr) {
+      return std::string_view();
+    }
+    return std::string_view(m_header->device, strnlen(m_header->device, sizeof(m_header->device)));
+  }
+  auto getUpdateTime(void) const -> uint64_t
+  {
+    return (m_header == nullptr) ? 0 : m_header->updateTime.load(std::memory_order_acquire);
+  }
+  // Bound by the mapped slots, the used count in shared memory is not trusted
+  auto getSlotCount(void) const -> size_t
+  {
+    if (m_header == nullptr) {
+      return 0;
+    }
+    auto used = m_header->usedSlots.load(std::memory_order_acquire);
+    return (used < m_slotCount) ? used : m_slotCount;
+  }
+
+  // False for an unused slot or a slot updated during every retry
+  bool read(size_t index, Value &value) const
+  {
+    if (index >= getSlotCount()) {
+      return false;
+    }
+
+    const auto &slot = m_slots[index];
+    for (unsigned retry = 0; retry < MaxRetries; retry++) {
+      auto seq = slot.seq.load(std::memory_order_acquire);
+      if (seq == 0) {
+        return false;
+      }
+      if (seq & 1) {
+        continue;
+      }
+
+      value.type = static_cast<Type>(slot.type);
+      value.time = slot.time.load(std::memory_order_relaxed);
+      value.bits = slot.value.load(std::memory_order_relaxed);
+      std::memcpy(value.source, slot.source, sizeof(value.source));
+      std::memcpy(value.entity, slot.entity, sizeof(value.entity));
+      std::memcpy(value.field, slot.field, sizeof(value.field));
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.seq.load(std::memory_order_relaxed) == seq) {
+        value.source[SourceSize - 1] = '\0';
+        value.entity[EntitySize - 1] = '\0';
+        value.field[FieldSize - 1] = '\0';
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // Slot index of a series. The index stays valid while read() returns
+  // the same series, slots of stale series can be reused.
+  bool find(std::string_view source,
+            std::string_view entity,
+            std::string_view field,
+            size_t &index) const
+  {
+    Value value;
+
+    for (size_t i = 0; i < getSlotCount(); i++) {
+      if (read(i, value) && (value.getField() == field) && (value.getSource() == source) &&
+          (value.getEntity() == entity)) {
+        index = i;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // Visit a consistent copy of every slot in use
+  template <class Visit>
+  void forEach(const Visit &visit) const
+  {
+    Value value;
+
+    for (size_t i = 0; i < getSlotCount(); i++) {
+      if (read(i, value)) {
+        visit(value);
+      }
+    }
+  }
+
+private:
+  const Header *m_header = nullptr;
+  const Slot *m_slots = nullptr;
+  size_t m_slotCount = 0;
+  size_t m_size = 0;
+};
+
+} // namespace tkm::reader::latest
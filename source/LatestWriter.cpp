@@ -0,0 +1,237 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     LatestWriter Class
+ * @details   Publish the latest value of every series in shared memory
+ *-
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "../bswinfra/source/Logger.h"
+#include "Application.h"
+#include "Arguments.h"
+#include "LatestWriter.h"
+
+namespace tkm::reader
+{
+
+LatestWriter *LatestWriter::instance = nullptr;
+
+// Copy a key into a slot field, the rest of the field is zeroed
+static void copyKey(char *dest, size_t size, std::string_view key)
+{
+  std::memset(dest, 0, size);
+  std::memcpy(dest, key.data(), std::min(key.size(), size - 1));
+}
+
+LatestWriter::LatestWriter()
+: m_record([this](std::string_view source,
+                  std::string_view entity,
+                  std::string_view field,
+                  series::Type type,
+                  uint64_t time,
+                  uint64_t value) { append(source, entity, field, type, time, value); })
+{
+  if (!App()->getArguments()->hasFor(Arguments::Key::LatestPath)) {
+    return;
+  }
+
+  m_name = App()->getArguments()->getFor(Arguments::Key::LatestPath);
+  if (m_name.empty()) {
+    return;
+  }
+  if (m_name.front() != '/') {
+    m_name.insert(0, "/");
+  }
+  m_expire = std::stoull(tkmDefaults.getFor(Defaults::Default::LatestExpire));
+
+  auto slotCount = std::clamp(std::stoul(tkmDefaults.getFor(Defaults::Default::LatestSlots)),
+                              64ul,
+                              1048576ul);
+  if (!createTable(App()->getArguments()->getFor(Arguments::Key::Name), slotCount)) {
+    return;
+  }
+
+  std::atexit([]() { LatestWriter::getInstance()->close(); });
+}
+
+bool LatestWriter::createTable(const std::string &device, size_t slotCount)
+{
+  // Readers still mapping the table of a previous run are told to reopen
+  auto fd = ::shm_open(m_name.c_str(), O_RDWR | O_CLOEXEC, 0);
+  if (fd >= 0) {
+    auto addr = ::mmap(nullptr, sizeof(latest::Header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr != MAP_FAILED) {
+      auto header = static_cast<latest::Header *>(addr);
+      if (std::string_view(header->magic, sizeof(header->magic)) == latest::Magic) {
+        header->closed.store(1, std::memory_order_release);
+      }
+      ::munmap(addr, sizeof(latest::Header));
+    }
+    ::close(fd);
+    ::shm_unlink(m_name.c_str());
+  }
+
+  fd = ::shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    logError() << "Cannot create latest table " << m_name << ": " << strerror(errno);
+    return false;
+  }
+
+  m_size = sizeof(latest::Header) + slotCount * sizeof(latest::Slot);
+  if (::ftruncate(fd, static_cast<off_t>(m_size)) < 0) {
+    logError() << "Cannot size latest table " << m_name << ": " << strerror(errno);
+    ::close(fd);
+    ::shm_unlink(m_name.c_str());
+    return false;
+  }
+
+  auto addr = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    logError() << "Cannot map latest table " << m_name << ": " << strerror(errno);
+    ::shm_unlink(m_name.c_str());
+    return false;
+  }
+
+  // A new object is zero filled, the header is written last
+  m_slots = reinterpret_cast<latest::Slot *>(static_cast<latest::Header *>(addr) + 1);
+  auto header = static_cast<latest::Header *>(addr);
+  header->version = latest::Version;
+  header->slotSize = sizeof(latest::Slot);
+  header->slotCount = static_cast<uint32_t>(slotCount);
+  copyKey(header->device, sizeof(header->device), device);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(header->magic, latest::Magic.data(), sizeof(header->magic));
+  m_header = header;
+
+  m_slotKeys.resize(slotCount);
+  logInfo() << "Latest values in shared memory " << m_name << " (" << slotCount << " slots)";
+
+  return true;
+}
+
+bool LatestWriter::isEnabledFor(tkm::msg::monitor::Data_What what)
+{
+  if (m_header == nullptr) {
+    return false;
+  }
+  return App()->isRecordTypeSelected(what);
+}
+
+void LatestWriter::append(std::string_view source,
+                          std::string_view entity,
+                          std::string_view field,
+                          series::Type type,
+                          uint64_t time,
+                          uint64_t value)
+{
+  size_t index;
+
+  m_newestTime = std::max(m_newestTime, time);
+  m_key.assign(source).append(1, '\0').append(entity).append(1, '\0').append(field);
+
+  auto it = m_index.find(m_key);
+  auto created = (it == m_index.end());
+  if (created) {
+    // Truncated keys could name two series, such series are not published
+    if ((source.size() >= latest::SourceSize) || (entity.size() >= latest::EntitySize) ||
+        (field.size() >= latest::FieldSize) || !allocSlot(index)) {
+      if ((m_dropped++ % 1024) == 0) {
+        logWarn() << "Latest table full or key too long, " << m_dropped << " samples dropped";
+      }
+      return;
+    }
+    it = m_index.emplace(m_key, index).first;
+    m_slotKeys[index] = m_key;
+  }
+
+  auto &slot = m_slots[it->second];
+  auto seq = slot.seq.load(std::memory_order_relaxed);
+
+  slot.seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  if (created) {
+    copyKey(slot.source, sizeof(slot.source), source);
+    copyKey(slot.entity, sizeof(slot.entity), entity);
+    copyKey(slot.field, sizeof(slot.field), field);
+  }
+  slot.type = static_cast<uint8_t>(type);
+  slot.time.store(time, std::memory_order_relaxed);
+  slot.value.store(value, std::memory_order_relaxed);
+  slot.seq.store(seq + 2, std::memory_order_release);
+
+  // A new slot is made visible once it holds its first sample
+  auto used = m_header->usedSlots.load(std::memory_order_relaxed);
+  if (it->second >= used) {
+    m_header->usedSlots.store(static_cast<uint32_t>(it->second + 1), std::memory_order_release);
+  }
+  if (time > m_header->updateTime.load(std::memory_order_relaxed)) {
+    m_header->updateTime.store(time, std::memory_order_release);
+  }
+}
+
+bool LatestWriter::allocSlot(size_t &index)
+{
+  if (m_freeSlots.empty()) {
+    auto used = m_header->usedSlots.load(std::memory_order_relaxed);
+    if (used < m_header->slotCount) {
+      index = used;
+      return true;
+    }
+    reclaimSlots();
+  }
+  if (m_freeSlots.empty()) {
+    return false;
+  }
+
+  index = m_freeSlots.back();
+  m_freeSlots.pop_back();
+
+  return true;
+}
+
+void LatestWriter::reclaimSlots(void)
+{
+  // A full table without stale slots is scanned again only on newer samples
+  if ((m_newestTime <= m_reclaimTime) || (m_newestTime < m_expire)) {
+    return;
+  }
+  m_reclaimTime = m_newestTime;
+
+  auto expireTime = m_newestTime - m_expire;
+  for (size_t i = 0; i < m_header->slotCount; i++) {
+    if (m_slotKeys[i].empty() ||
+        (m_slots[i].time.load(std::memory_order_relaxed) >= expireTime)) {
+      continue;
+    }
+    m_index.erase(m_slotKeys[i]);
+    m_slotKeys[i].clear();
+    m_freeSlots.push_back(i);
+  }
+}
+
+void LatestWriter::close(void)
+{
+  if (m_header == nullptr) {
+    return;
+  }
+
+  m_header->closed.store(1, std::memory_order_release);
+  ::munmap(m_header, m_size);
+  ::shm_unlink(m_name.c_str());
+  m_header = nullptr;
+  m_slots = nullptr;
+}
+
+} // namespace tkm::reader
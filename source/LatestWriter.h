@@ -0,0 +1,83 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     LatestWriter Class
+ * @details   Publish the latest value of every series in shared memory
+ *-
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <taskmonitor/taskmonitor.h>
+#include <vector>
+
+#include "LatestTable.h"
+#include "SeriesRecord.h"
+
+namespace tkm::reader
+{
+
+/*
+ * Writes the shared memory table read by LatestTable. Each series gets a
+ * slot on its first sample. When the table is full, slots of series
+ * without a sample for LatestExpire seconds (ex: exited processes) are
+ * reused, samples of new series are dropped if there are none.
+ */
+class LatestWriter
+{
+public:
+  static LatestWriter *getInstance()
+  {
+    return (!instance) ? instance = new LatestWriter : instance;
+  }
+
+  bool isEnabled(void) { return (m_header != nullptr); }
+  bool isEnabledFor(tkm::msg::monitor::Data_What what);
+
+  auto getRecord(void) -> SeriesRecord & { return m_record; }
+
+  void append(std::string_view source,
+              std::string_view entity,
+              std::string_view field,
+              series::Type type,
+              uint64_t time,
+              uint64_t value);
+  // Mark the table closed for its readers and remove it
+  void close(void);
+
+public:
+  LatestWriter(LatestWriter const &) = delete;
+  void operator=(LatestWriter const &) = delete;
+
+private:
+  LatestWriter();
+  ~LatestWriter() = default;
+
+  bool createTable(const std::string &device, size_t slotCount);
+  bool allocSlot(size_t &index);
+  void reclaimSlots(void);
+
+private:
+  static LatestWriter *instance;
+  std::string m_name{};
+  latest::Header *m_header = nullptr;
+  latest::Slot *m_slots = nullptr;
+  size_t m_size = 0;
+  uint64_t m_expire = 0;
+  uint64_t m_newestTime = 0;
+  uint64_t m_reclaimTime = 0;
+  uint64_t m_dropped = 0;
+  std::map<std::string, size_t, std::less<>> m_index{};
+  std::vector<std::string> m_slotKeys{};
+  std::vector<size_t> m_freeSlots{};
+  SeriesRecord m_record;
+  std::string m_key{};
+};
+
+} // namespace tkm::reader
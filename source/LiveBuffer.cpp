@@ -0,0 +1,297 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     LiveBuffer Class
+ * @details   Keep the recent records of every data type in memory
+ *-
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "../bswinfra/source/Logger.h"
+#include "Application.h"
+#include "Arguments.h"
+#include "LiveBuffer.h"
+#include "SegmentWriter.h"
+
+namespace tkm::reader
+{
+
+LiveBuffer *LiveBuffer::instance = nullptr;
+
+// Request values are plain decimal numbers
+static bool parseNumber(std::string_view text, uint64_t &number)
+{
+  if (text.empty() || (text.size() > 19) ||
+      (text.find_first_not_of("0123456789") != std::string_view::npos)) {
+    return false;
+  }
+  number = std::stoull(std::string(text));
+  return true;
+}
+
+LiveBuffer::LiveBuffer()
+: m_record([this](std::string_view type,
+                  std::string_view entity,
+                  uint64_t time,
+                  std::string_view json) { append(type, entity, time, json); })
+{
+  if (!App()->getArguments()->hasFor(Arguments::Key::LivePath)) {
+    return;
+  }
+
+  m_ringSize = std::max(std::stoul(tkmDefaults.getFor(Defaults::Default::LiveBufferSize)), 65536ul);
+
+  m_enabled = true;
+}
+
+bool LiveBuffer::isEnabledFor(tkm::msg::monitor::Data_What what)
+{
+  if (!m_enabled) {
+    return false;
+  }
+  return App()->isRecordTypeSelected(what);
+}
+
+void LiveBuffer::append(std::string_view type,
+                        std::string_view entity,
+                        uint64_t time,
+                        std::string_view json)
+{
+  auto &ring = m_rings[m_what];
+  auto size = json.size() + entity.size() + sizeof(Entry);
+  Entry entry{.time = time, .entity = {}, .json = {}};
+
+  if (ring.type.empty()) {
+    ring.type = type;
+  }
+
+  // The strings of dropped entries are reused for the new one
+  while (!ring.entries.empty() && (ring.bytes + size > m_ringSize)) {
+    auto &front = ring.entries.front();
+    ring.bytes -= front.json.size() + front.entity.size() + sizeof(Entry);
+    entry.entity = std::move(front.entity);
+    entry.json = std::move(front.json);
+    ring.entries.pop_front();
+  }
+
+  entry.entity.assign(entity);
+  entry.json.assign(json);
+  ring.entries.push_back(std::move(entry));
+  ring.bytes += size;
+  if (entity.empty()) {
+    ring.received++;
+  }
+
+  m_newestTime = std::max(m_newestTime, time);
+}
+
+auto LiveBuffer::findRing(std::string_view name) -> const Ring *
+{
+  tkm::msg::monitor::Data_What what;
+
+  if (tkm::msg::monitor::Data_What_Parse(std::string(name), &what)) {
+    auto it = m_rings.find(what);
+    return (it == m_rings.end()) ? nullptr : &it->second;
+  }
+
+  for (const auto &[ringWhat, ring] : m_rings) {
+    if (ring.type == name) {
+      return &ring;
+    }
+  }
+
+  return nullptr;
+}
+
+bool LiveBuffer::query(std::string_view request, std::string &response)
+{
+  std::map<std::string_view, std::string_view> args;
+  std::string_view command;
+  uint64_t count = 0;
+  uint64_t since = std::numeric_limits<uint64_t>::max();
+  bool hasCount = false;
+
+  // Words are separated by blanks, all but the first are key=value
+  size_t pos = 0;
+  while (pos < request.size()) {
+    auto start = request.find_first_not_of(" \t\r", pos);
+    if (start == std::string_view::npos) {
+      break;
+    }
+    auto stop = std::min(request.find_first_of(" \t\r", start), request.size());
+    auto word = request.substr(start, stop - start);
+    pos = stop;
+
+    if (command.empty()) {
+      command = word;
+      continue;
+    }
+    auto equal = word.find('=');
+    if ((equal == std::string_view::npos) || (equal == 0)) {
+      writeError("Invalid argument", response);
+      return false;
+    }
+    args[word.substr(0, equal)] = word.substr(equal + 1);
+  }
+
+  if (command.empty()) {
+    writeError("Empty request", response);
+    return false;
+  }
+
+  for (const auto &[key, value] : args) {
+    if (key == "count") {
+      if (!parseNumber(value, count)) {
+        writeError("Invalid count", response);
+        return false;
+      }
+      hasCount = true;
+    } else if (key == "since") {
+      if (!parseNumber(value, since)) {
+        writeError("Invalid since", response);
+        return false;
+      }
+    } else if ((key != "entity") && (key != "source") && (key != "field")) {
+      writeError("Unknown argument", response);
+      return false;
+    }
+  }
+
+  if (command == "types") {
+    queryTypes(response);
+    return true;
+  }
+
+  if (command == "series") {
+    if ((args.count("source") == 0) || (args.count("field") == 0)) {
+      writeError("Series source and field required", response);
+      return false;
+    }
+    return querySeries(args["source"], args["entity"], args["field"], since, response);
+  }
+
+  auto ring = findRing(command);
+  if (ring == nullptr) {
+    writeError("Unknown type", response);
+    return false;
+  }
+
+  // Without a time range only the latest record is returned
+  if (!hasCount) {
+    count = (since == std::numeric_limits<uint64_t>::max()) ? 1 : SIZE_MAX;
+  }
+
+  return queryRecords(*ring, args["entity"], static_cast<size_t>(count), since, response);
+}
+
+bool LiveBuffer::queryRecords(const Ring &ring,
+                              std::string_view entity,
+                              size_t count,
+                              uint64_t since,
+                              std::string &response)
+{
+  auto first = (since < m_newestTime) ? m_newestTime - since : 0;
+
+  m_matches.clear();
+  for (auto it = ring.entries.crbegin(); it != ring.entries.crend(); ++it) {
+    if ((m_matches.size() >= count) || (it->time < first)) {
+      break;
+    }
+    if (it->entity == entity) {
+      m_matches.push_back(&*it);
+    }
+  }
+
+  for (auto it = m_matches.crbegin(); it != m_matches.crend(); ++it) {
+    response.append((*it)->json).push_back('\n');
+  }
+  response.push_back('\n');
+
+  return true;
+}
+
+bool LiveBuffer::querySeries(std::string_view source,
+                             std::string_view entity,
+                             std::string_view field,
+                             uint64_t since,
+                             std::string &response)
+{
+  auto hotWindow = SegmentWriter::getInstance()->getHotWindow();
+  if (hotWindow == nullptr) {
+    writeError("Segment store not enabled", response);
+    return false;
+  }
+
+  // Only the hot window is served, store segments are read by tkmseries and
+  // never from the main loop
+  auto begin = (since < m_newestTime) ? m_newestTime - since : 0;
+  series::Type type = series::Type::UInt64;
+
+  hotWindow->query(source,
+                   entity,
+                   field,
+                   begin,
+                   std::numeric_limits<uint64_t>::max(),
+                   type,
+                   [this, &type, &response](uint64_t time, uint64_t value) {
+                     m_json.reset();
+                     m_json.beginArray();
+                     m_json.element(time);
+                     switch (type) {
+                     case series::Type::Int64:
+                       m_json.element(static_cast<int64_t>(value));
+                       break;
+                     case series::Type::Double: {
+                       double real;
+                       std::memcpy(&real, &value, sizeof(real));
+                       m_json.element(real);
+                       break;
+                     }
+                     case series::Type::UInt64:
+                     default:
+                       m_json.element(value);
+                       break;
+                     }
+                     m_json.endArray();
+                     response.append(m_json.view()).push_back('\n');
+                   });
+
+  response.push_back('\n');
+
+  return true;
+}
+
+void LiveBuffer::queryTypes(std::string &response)
+{
+  for (const auto &[what, ring] : m_rings) {
+    m_json.reset();
+    m_json.beginObject();
+    m_json.field("bytes", static_cast<uint64_t>(ring.bytes));
+    m_json.field("entries", static_cast<uint64_t>(ring.entries.size()));
+    m_json.field("first_time", ring.entries.empty() ? 0 : ring.entries.front().time);
+    m_json.field("last_time", ring.entries.empty() ? 0 : ring.entries.back().time);
+    m_json.field("name", tkm::msg::monitor::Data_What_Name(what));
+    m_json.field("received", ring.received);
+    m_json.field("type", ring.type);
+    m_json.endObject();
+    response.append(m_json.view()).push_back('\n');
+  }
+  response.push_back('\n');
+}
+
+void LiveBuffer::writeError(std::string_view error, std::string &response)
+{
+  m_json.reset();
+  m_json.beginObject();
+  m_json.field("error", error);
+  m_json.endObject();
+  response.append(m_json.view()).append("\n\n");
+}
+
+} // namespace tkm::reader
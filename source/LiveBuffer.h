@@ -0,0 +1,108 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     LiveBuffer Class
+ * @details   Keep the recent records of every data type in memory
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <taskmonitor/taskmonitor.h>
+
+#include "JsonEncoder.h"
+#include "LiveRecord.h"
+
+namespace tkm::reader
+{
+
+/*
+ * One ring of records per data type, bounded to LiveBufferSize bytes of
+ * JSON text. Records and their entity records are kept in arrival order,
+ * the oldest are dropped first. Queries are answered from memory only,
+ * one request line gives JSON lines ended by an empty line:
+ *   <type> [count=<n>] [since=<sec>] [entity=<key>]
+ *   series source=<type> field=<name> [entity=<key>] [since=<sec>]
+ *   types
+ * where <type> is a data type (SysProcStat) or a record type (stat) and
+ * since is relative to the newest record received. Series samples come
+ * from the hot window of the segment store only.
+ */
+class LiveBuffer
+{
+public:
+  static LiveBuffer *getInstance()
+  {
+    return (!instance) ? instance = new LiveBuffer : instance;
+  }
+
+  bool isEnabled(void) { return m_enabled; }
+  bool isEnabledFor(tkm::msg::monitor::Data_What what);
+
+  auto getRecord(tkm::msg::monitor::Data_What what) -> LiveRecord &
+  {
+    m_what = what;
+    return m_record;
+  }
+
+  // Answer a request line, false if the request is not valid
+  bool query(std::string_view request, std::string &response);
+
+public:
+  LiveBuffer(LiveBuffer const &) = delete;
+  void operator=(LiveBuffer const &) = delete;
+
+private:
+  LiveBuffer();
+  ~LiveBuffer() = default;
+
+  typedef struct Entry {
+    uint64_t time;
+    std::string entity;
+    std::string json;
+  } Entry;
+
+  typedef struct Ring {
+    std::string type;
+    std::deque<Entry> entries;
+    size_t bytes;
+    uint64_t received;
+  } Ring;
+
+  void append(std::string_view type, std::string_view entity, uint64_t time, std::string_view json);
+  auto findRing(std::string_view name) -> const Ring *;
+  bool queryRecords(const Ring &ring,
+                    std::string_view entity,
+                    size_t count,
+                    uint64_t since,
+                    std::string &response);
+  bool querySeries(std::string_view source,
+                   std::string_view entity,
+                   std::string_view field,
+                   uint64_t since,
+                   std::string &response);
+  void queryTypes(std::string &response);
+  void writeError(std::string_view error, std::string &response);
+
+private:
+  static LiveBuffer *instance;
+  bool m_enabled = false;
+  size_t m_ringSize = 0;
+  uint64_t m_newestTime = 0;
+  tkm::msg::monitor::Data_What m_what = tkm::msg::monitor::Data_What_ProcAcct;
+  std::map<tkm::msg::monitor::Data_What, Ring> m_rings{};
+  std::vector<const Entry *> m_matches{};
+  JsonEncoder m_json{};
+  LiveRecord m_record;
+};
+
+} // namespace tkm::reader
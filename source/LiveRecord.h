@@ -0,0 +1,152 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     LiveRecord Class
+ * @details   Build data records as verbose JSON for the live buffer
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "JsonEncoder.h"
+#include "JsonRecord.h"
+
+namespace tkm::reader
+{
+
+/*
+ * Same builder interface as JsonRecord. The record is committed as the
+ * verbose JSON line written by the json output. Every top level keyed
+ * group (ex: a process entry keyed by pid) is also committed on its own,
+ * as a record with the same head holding only that group, with the group
+ * key as entity. Entity records are committed before their record.
+ */
+class LiveRecord
+{
+public:
+  using Commit = std::function<void(
+      std::string_view type, std::string_view entity, uint64_t time, std::string_view json)>;
+
+  explicit LiveRecord(Commit commit)
+  : m_commit(std::move(commit))
+  {
+  }
+  ~LiveRecord() = default;
+
+public:
+  LiveRecord(LiveRecord const &) = delete;
+  void operator=(LiveRecord const &) = delete;
+
+  void begin(const char *type,
+             const std::string &session,
+             uint64_t systemTime,
+             uint64_t monotonicTime,
+             uint64_t receiveTime)
+  {
+    m_type = type;
+    m_session = session;
+    m_systemTime = systemTime;
+    m_monotonicTime = monotonicTime;
+    m_receiveTime = receiveTime;
+    m_depth = 0;
+    m_inEntity = false;
+    m_json.reset();
+    m_record.begin(type, session, systemTime, monotonicTime, receiveTime);
+  }
+  void end(void)
+  {
+    m_record.end();
+    m_commit(m_type, std::string_view(), m_systemTime, m_json.view());
+  }
+
+  void beginGroup(const char *kind)
+  {
+    m_record.beginGroup(kind);
+    if (m_inEntity) {
+      m_entityRecord.beginGroup(kind);
+    }
+    m_depth++;
+  }
+  void beginGroup(const char *kind, std::string_view key, const char *keyField = nullptr)
+  {
+    if (m_depth == 0) {
+      beginEntity(key);
+    }
+    m_record.beginGroup(kind, key, keyField);
+    if (m_inEntity) {
+      m_entityRecord.beginGroup(kind, key, keyField);
+    }
+    m_depth++;
+  }
+  void beginGroup(const char *kind, int64_t key, const char *keyField = nullptr)
+  {
+    if (m_depth == 0) {
+      beginEntity(std::to_string(key));
+    }
+    m_record.beginGroup(kind, key, keyField);
+    if (m_inEntity) {
+      m_entityRecord.beginGroup(kind, key, keyField);
+    }
+    m_depth++;
+  }
+  void endGroup(void)
+  {
+    m_record.endGroup();
+    if (m_depth > 0) {
+      m_depth--;
+    }
+    if (!m_inEntity) {
+      return;
+    }
+
+    m_entityRecord.endGroup();
+    if (m_depth == 0) {
+      m_entityRecord.end();
+      m_commit(m_type, m_entity, m_systemTime, m_entityJson.view());
+      m_inEntity = false;
+    }
+  }
+
+  template <size_t N, class T>
+  void field(const char (&name)[N], const T &val)
+  {
+    m_record.field(name, val);
+    if (m_inEntity) {
+      m_entityRecord.field(name, val);
+    }
+  }
+
+private:
+  void beginEntity(std::string_view key)
+  {
+    m_entity = key;
+    m_inEntity = true;
+    m_entityJson.reset();
+    m_entityRecord.begin(m_type, m_session, m_systemTime, m_monotonicTime, m_receiveTime);
+  }
+
+private:
+  Commit m_commit;
+  JsonEncoder m_json{};
+  JsonEncoder m_entityJson{};
+  JsonRecord m_record{m_json};
+  JsonRecord m_entityRecord{m_entityJson};
+  const char *m_type = nullptr;
+  std::string m_session{};
+  std::string m_entity{};
+  uint64_t m_systemTime = 0;
+  uint64_t m_monotonicTime = 0;
+  uint64_t m_receiveTime = 0;
+  size_t m_depth = 0;
+  bool m_inEntity = false;
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,258 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     LiveServer Class
+ * @details   Answer live buffer queries on a local socket
+ *-
+ */
+
+#include <cstring>
+#include <errno.h>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../bswinfra/source/Logger.h"
+#include "Application.h"
+#include "Defaults.h"
+#include "LiveBuffer.h"
+#include "LiveServer.h"
+
+namespace tkm::reader
+{
+
+// Longer request lines drop the client
+constexpr size_t MaxRequestSize = 1024;
+
+/*
+ * The event loop only waits for readable descriptors, so each client is
+ * polled through its own epoll instance. The socket is watched for input
+ * and, while answers are queued, for writability. The epoll descriptor is
+ * readable when either is ready.
+ */
+class LiveServer::Client final : public Pollable
+{
+public:
+  Client(LiveServer *server, int fd)
+  : Pollable("LiveClient")
+  , m_server(server)
+  , m_fd(fd)
+  {
+    m_pollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    if ((m_pollFd < 0) || !watch(EPOLL_CTL_ADD, EPOLLIN)) {
+      if (m_pollFd >= 0) {
+        ::close(m_pollFd);
+      }
+      throw std::runtime_error("Fail to poll live client: " + std::string(strerror(errno)));
+    }
+
+    lateSetup([this]() { return processEvents(); },
+              m_pollFd,
+              bswi::event::IPollable::Events::Level,
+              bswi::event::IEventSource::Priority::Normal);
+    setPrepare([]() { return true; });
+    setFinalize([this]() { m_server->m_clients--; });
+  }
+  ~Client()
+  {
+    ::close(m_pollFd);
+    ::close(m_fd);
+  }
+
+public:
+  Client(Client const &) = delete;
+  void operator=(Client const &) = delete;
+
+private:
+  bool watch(int op, uint32_t events)
+  {
+    struct epoll_event event = {.events = events, .data = {.fd = m_fd}};
+    return (::epoll_ctl(m_pollFd, op, m_fd, &event) == 0);
+  }
+
+  bool processEvents(void)
+  {
+    struct epoll_event event;
+
+    auto count = ::epoll_wait(m_pollFd, &event, 1, 0);
+    if (count <= 0) {
+      return (count == 0) || (errno == EINTR);
+    }
+    if ((event.events & EPOLLOUT) && !sendPending()) {
+      return false;
+    }
+    if (event.events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+      return readRequests();
+    }
+
+    return true;
+  }
+
+  bool readRequests(void)
+  {
+    char buffer[512];
+
+    auto count = ::recv(m_fd, buffer, sizeof(buffer), 0);
+    if (count == 0) {
+      return false;
+    }
+    if (count < 0) {
+      return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);
+    }
+    m_input.append(buffer, static_cast<size_t>(count));
+
+    // Keep only the part of the queued answers not sent yet
+    m_output.erase(0, m_sent);
+    m_sent = 0;
+
+    size_t start = 0;
+    size_t end;
+    while ((end = m_input.find('\n', start)) != std::string::npos) {
+      LiveBuffer::getInstance()->query(std::string_view(m_input).substr(start, end - start),
+                                       m_output);
+      start = end + 1;
+    }
+    m_input.erase(0, start);
+
+    if (m_output.size() > m_server->m_outputLimit) {
+      logWarn() << "Live client not reading, dropped";
+      return false;
+    }
+
+    return sendPending() && (m_input.size() <= MaxRequestSize);
+  }
+
+  // Send what the socket takes now, the rest waits for writability
+  bool sendPending(void)
+  {
+    while (m_sent < m_output.size()) {
+      auto count =
+          ::send(m_fd, m_output.data() + m_sent, m_output.size() - m_sent, MSG_NOSIGNAL);
+      if (count > 0) {
+        m_sent += static_cast<size_t>(count);
+        continue;
+      }
+      if ((count < 0) && (errno == EINTR)) {
+        continue;
+      }
+      if ((count < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+        if (m_writable) {
+          m_writable = false;
+          return watch(EPOLL_CTL_MOD, EPOLLIN | EPOLLOUT);
+        }
+        return true;
+      }
+      return false;
+    }
+
+    m_output.clear();
+    m_sent = 0;
+    if (!m_writable) {
+      m_writable = true;
+      return watch(EPOLL_CTL_MOD, EPOLLIN);
+    }
+
+    return true;
+  }
+
+private:
+  LiveServer *m_server;
+  int m_fd;
+  int m_pollFd = -1;
+  bool m_writable = true;
+  size_t m_sent = 0;
+  std::string m_input{};
+  std::string m_output{};
+};
+
+LiveServer::LiveServer(const std::string &path)
+: Pollable("LiveServer")
+, m_path(path)
+{
+  struct sockaddr_un addr = {};
+  struct stat st;
+
+  if (m_path.size() >= sizeof(addr.sun_path)) {
+    throw std::runtime_error("Live socket path too long");
+  }
+
+  // A socket left by a previous run is replaced, other files are kept
+  if (::stat(m_path.c_str(), &st) == 0) {
+    if (!S_ISSOCK(st.st_mode)) {
+      throw std::runtime_error("Live socket path exists and is not a socket");
+    }
+    ::unlink(m_path.c_str());
+  }
+
+  m_sockFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (m_sockFd < 0) {
+    throw std::runtime_error("Fail to create live socket");
+  }
+
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path, m_path.c_str(), m_path.size());
+  if ((::bind(m_sockFd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) ||
+      (::listen(m_sockFd, 16) < 0)) {
+    ::close(m_sockFd);
+    m_sockFd = -1;
+    throw std::runtime_error("Fail to listen on live socket " + m_path + ": " +
+                             strerror(errno));
+  }
+
+  m_maxClients = std::stoul(tkmDefaults.getFor(Defaults::Default::LiveClients));
+  m_outputLimit = std::stoul(tkmDefaults.getFor(Defaults::Default::LiveOutputLimit));
+
+  lateSetup(
+      [this]() {
+        acceptClients();
+        return true;
+      },
+      m_sockFd,
+      bswi::event::IPollable::Events::Level,
+      bswi::event::IEventSource::Priority::Normal);
+  setPrepare([]() { return true; });
+
+  logInfo() << "Live queries on " << m_path;
+}
+
+LiveServer::~LiveServer()
+{
+  if (m_sockFd >= 0) {
+    ::close(m_sockFd);
+    ::unlink(m_path.c_str());
+    m_sockFd = -1;
+  }
+}
+
+void LiveServer::enableEvents()
+{
+  App()->addEventSource(getShared());
+}
+
+void LiveServer::acceptClients(void)
+{
+  int fd;
+
+  while ((fd = ::accept4(m_sockFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+    if (m_clients >= m_maxClients) {
+      logWarn() << "Too many live clients, connection refused";
+      ::close(fd);
+      continue;
+    }
+    try {
+      App()->addEventSource(std::make_shared<Client>(this, fd));
+      m_clients++;
+    } catch (std::exception &e) {
+      logWarn() << e.what();
+      ::close(fd);
+    }
+  }
+}
+
+} // namespace tkm::reader
@@ -0,0 +1,58 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     LiveServer Class
+ * @details   Answer live buffer queries on a local socket
+ *-
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "../bswinfra/source/Pollable.h"
+
+using namespace bswi::event;
+
+namespace tkm::reader
+{
+
+/*
+ * Unix stream socket at LivePath. Clients send request lines and read the
+ * JSON lines of each answer up to an empty line. Requests are answered on
+ * the main loop from the live buffer. Answers a client does not read yet
+ * are queued and sent when its socket is writable, the main loop never
+ * waits for a client. A client with more than LiveOutputLimit bytes queued
+ * is dropped.
+ */
+class LiveServer final : public Pollable, public std::enable_shared_from_this<LiveServer>
+{
+public:
+  explicit LiveServer(const std::string &path);
+  ~LiveServer();
+
+public:
+  LiveServer(LiveServer const &) = delete;
+  void operator=(LiveServer const &) = delete;
+
+  void enableEvents();
+  auto getShared() -> std::shared_ptr<LiveServer> { return shared_from_this(); }
+
+private:
+  class Client;
+
+  void acceptClients(void);
+
+private:
+  std::string m_path;
+  size_t m_maxClients = 0;
+  size_t m_clients = 0;
+  size_t m_outputLimit = 0;
+  int m_sockFd = -1;
+};
+
+} // namespace tkm::reader
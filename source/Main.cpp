@@ -12,6 +12,7 @@
 #include "Application.h"
 #include "Arguments.h"
 #include "Defaults.h"
+#include "MsgPackWriter.h"
 
 #include <csignal>
 #include <cstdlib>
@@ -32,6 +33,7 @@ static void terminate(int signum)
 auto main(int argc, char **argv) -> int
 {
   std::map<Arguments::Key, std::string> args;
+  std::string usageError{};
   int longIndex = 0;
   bool version = false;
   bool help = false;
@@ -46,11 +48,38 @@ auto main(int argc, char **argv) -> int
                               {"verbose", no_argument, nullptr, 'x'},
                               {"timeout", required_argument, nullptr, 't'},
                               {"strict", no_argument, nullptr, 's'},
+                              {"intervals", required_argument, nullptr, 'I'},
+                              {"burst", required_argument, nullptr, 'b'},
+                              {"burst-sources", required_argument, nullptr, 'B'},
+                              {"burst-interval", required_argument, nullptr, 'u'},
+                              {"types", required_argument, nullptr, 'y'},
+                              {"json-types", required_argument, nullptr, 'J'},
+                              {"json-flush", required_argument, nullptr, 'F'},
+                              {"json-compress", required_argument, nullptr, 'z'},
+                              {"json-rotate", required_argument, nullptr, 'R'},
+                              {"json-split", no_argument, nullptr, 'S'},
+                              {"json-format", required_argument, nullptr, 'f'},
+                              {"msgpack", required_argument, nullptr, 'm'},
+                              {"capture", required_argument, nullptr, 'c'},
+                              {"capture-sync", required_argument, nullptr, 'C'},
+                              {"replay", required_argument, nullptr, 'r'},
+                              {"replay-speed", required_argument, nullptr, 'e'},
+                              {"capture-stream", required_argument, nullptr, 'T'},
+                              {"columns", required_argument, nullptr, 'k'},
+                              {"series", required_argument, nullptr, 'g'},
+                              {"store", required_argument, nullptr, 'o'},
+                              {"live", required_argument, nullptr, 'l'},
+                              {"latest", required_argument, nullptr, 'L'},
+                              {"ring", required_argument, nullptr, 'w'},
                               {"version", no_argument, nullptr, 'v'},
                               {"help", no_argument, nullptr, 'h'},
                               {nullptr, 0, nullptr, 0}};
 
-  while ((c = getopt_long(argc, argv, "n:a:p:d:j:t:ixsvh", longopts, &longIndex)) != -1) {
+  while ((c = getopt_long(argc,
+                          argv,
+                          "n:a:p:d:j:t:I:b:B:u:y:J:F:z:R:f:m:c:C:r:e:T:k:g:o:l:L:w:Sixsvh",
+                          longopts,
+                          &longIndex)) != -1) {
     switch (c) {
     case 'n':
       args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::Name, optarg));
@@ -82,6 +111,77 @@ auto main(int argc, char **argv) -> int
       args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::Strict,
                                                          tkmDefaults.valFor(Defaults::Val::True)));
       break;
+    case 'I':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::Intervals, optarg));
+      break;
+    case 'b':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::BurstRules, optarg));
+      break;
+    case 'B':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::BurstSources, optarg));
+      break;
+    case 'u':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::BurstInterval, optarg));
+      break;
+    case 'y':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::Types, optarg));
+      break;
+    case 'J':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::JsonTypes, optarg));
+      break;
+    case 'F':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::JsonFlush, optarg));
+      break;
+    case 'z':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::JsonCompress, optarg));
+      break;
+    case 'R':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::JsonRotate, optarg));
+      break;
+    case 'S':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::JsonSplit,
+                                                         tkmDefaults.valFor(Defaults::Val::True)));
+      break;
+    case 'f':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::JsonFormat, optarg));
+      break;
+    case 'm':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::MsgPackPath, optarg));
+      break;
+    case 'c':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::CapturePath, optarg));
+      break;
+    case 'C':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::CaptureSync, optarg));
+      break;
+    case 'r':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::ReplayPath, optarg));
+      break;
+    case 'e':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::ReplaySpeed, optarg));
+      break;
+    case 'T':
+      args.insert(
+          std::pair<Arguments::Key, std::string>(Arguments::Key::CaptureStreamPath, optarg));
+      break;
+    case 'k':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::ColumnPath, optarg));
+      break;
+    case 'g':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::SeriesPath, optarg));
+      break;
+    case 'o':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::StorePath, optarg));
+      break;
+    case 'l':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::LivePath, optarg));
+      break;
+    case 'L':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::LatestPath, optarg));
+      break;
+    case 'w':
+      args.insert(std::pair<Arguments::Key, std::string>(Arguments::Key::RingPath, optarg));
+      break;
     case 'v':
       version = true;
       break;
@@ -92,6 +192,38 @@ auto main(int argc, char **argv) -> int
     }
   }
 
+  // Standard output can take one record output only
+  auto isStandardOut = [&args](Arguments::Key key) {
+    return (args.count(key) > 0) && (args[key] == "stdout");
+  };
+  if (isStandardOut(Arguments::Key::JsonPath) && isStandardOut(Arguments::Key::MsgPackPath)) {
+    usageError = "--json and --msgpack cannot both write to stdout";
+  }
+  if ((args.count(Arguments::Key::JsonCompress) > 0) &&
+      (args[Arguments::Key::JsonCompress] != "none") &&
+      (args[Arguments::Key::JsonCompress] != "gzip")) {
+    usageError = "Invalid --json-compress value: " + args[Arguments::Key::JsonCompress];
+  }
+  if (args.count(Arguments::Key::BurstInterval) > 0) {
+    // A request interval longer than the burst itself is of no use
+    uint64_t minInterval = 0;
+    uint64_t maxInterval = 0;
+    uint64_t interval = 0;
+    Arguments::toNumber(tkmDefaults.getFor(Defaults::Default::BurstMinInterval), minInterval);
+    Arguments::toNumber(tkmDefaults.getFor(Defaults::Default::BurstDuration), maxInterval);
+    maxInterval /= 1000; // usec 2 msec
+    if (!Arguments::toNumber(args[Arguments::Key::BurstInterval], interval) ||
+        (interval < minInterval) || (interval > maxInterval)) {
+      usageError = "Invalid --burst-interval value, use " + std::to_string(minInterval) + " to " +
+                   std::to_string(maxInterval) + " msec";
+    }
+  }
+
+  if (!usageError.empty()) {
+    std::cerr << "tkmreader: " << usageError << "\n\n";
+    help = true;
+  }
+
   if (version) {
     std::cout << "tkmreader: " << tkmDefaults.getFor(tkm::reader::Defaults::Default::Version)
               << " libtkm: " << TKMLIB_VERSION << "\n";
@@ -111,19 +243,75 @@ auto main(int argc, char **argv) -> int
         << "     --timeout, -t   <int>     Number of seconds (>3) for session inactivity timeout\n";
     std::cout << "                               Default and minimum value is 3 seconds.\n";
     std::cout << "     --strict, -s              Stop if target libtkm version missmatch\n";
+    std::cout << "     --intervals, -I <string>  Override data source request intervals in msec\n";
+    std::cout << "                               Format: 'ProcInfo=2000,SysProcStat=500'\n";
+    std::cout << "                               Use 0 to disable a data source\n";
+    std::cout << "     --burst, -b     <string>  Pressure rules to trigger burst sampling\n";
+    std::cout << "                               Format: 'mem_some.avg10=20,io_full.avg60=5'\n";
+    std::cout << "     --burst-sources, -B <str> Data sources sampled faster during a burst\n";
+    std::cout << "                               Default: "
+              << tkmDefaults.getFor(tkm::reader::Defaults::Default::BurstSources) << "\n";
+    std::cout << "     --burst-interval, -u <num> Burst source request interval in msec\n";
+    std::cout << "                               Default: "
+              << tkmDefaults.getFor(tkm::reader::Defaults::Default::BurstInterval)
+              << ", minimum: "
+              << tkmDefaults.getFor(tkm::reader::Defaults::Default::BurstMinInterval) << "\n";
     std::cout << "     --verbose, -v             Print info messages\n";
+    std::cout << "     --replay, -r    <string>  Read data from a capture file, not a device\n";
+    std::cout << "     --replay-speed, -e <num>  Replay time scale, 1 for original timing\n";
+    std::cout << "                               Default 0, replay as fast as possible\n";
     std::cout << "  Output:\n";
     std::cout << "     --init, -i                Force output initialization if files exist\n";
     std::cout
         << "     --database, -d  <string>  Path to output database file. If not set DB output is "
            "disabled\n";
+    std::cout << "     --types, -y     <string>  Data types written to all record outputs\n";
+    std::cout << "                               Default all, format: 'ProcInfo,SysProcStat'\n";
     std::cout << "     --json, -j      <string>  Path to output json file. If not set json output "
                  "is disabled\n";
     std::cout << "                               Hint: Use 'stdout' for standard output\n";
+    std::cout << "     --json-types, -J <string> Data types written to json output (default all)\n";
+    std::cout << "                               Applied after --types, json output only\n";
+    std::cout << "     --json-flush, -F <string> Json flush policy: line, size or interval\n";
+    std::cout << "                               Default: line for stdout, interval for files\n";
+    std::cout << "     --json-compress, -z <str> Compress json file output: none or gzip\n";
+    std::cout << "                               Frames are indexed in '<json path>.idx'\n";
+    std::cout << "     --json-rotate, -R <str>   Rotate json files by size (MiB) or age (sec)\n";
+    std::cout << "                               Format: 'size=256,time=3600'\n";
+    std::cout << "                               Size on disk, compressed size with gzip\n";
+    std::cout << "     --json-split, -S          Write each json record type into its own file\n";
+    std::cout << "     --json-format, -f <str>   Json record format: verbose or compact\n";
+    std::cout << "                               Compact rows are converted back by tkmjsonconv\n";
+    std::cout << "     --msgpack, -m   <string>  Path to output MessagePack file. If not set "
+                 "MessagePack output is disabled\n";
+    std::cout << "                               Hint: Use 'stdout' for standard output\n";
+    std::cout << "     --capture, -c   <string>  Append received envelopes to a raw capture file\n";
+    std::cout << "                               Data is not decoded if no other output is set\n";
+    std::cout << "     --capture-sync, -C <int>  Sync capture file to disk every <int> msec\n";
+    std::cout << "                               Default 0, sync disabled\n";
+    std::cout << "     --capture-stream, -T <str> Copy the monitor byte stream to a file\n";
+    std::cout << "                               One file per connection, tagged with its time\n";
+    std::cout << "     --columns, -k <dir>       Write records to columnar table files in dir\n";
+    std::cout << "                               One file per record type, <type>.col\n";
+    std::cout << "     --series, -g <dir>        Write numeric fields as compressed series in dir\n";
+    std::cout << "                               One file per device, <device>.tks\n";
+    std::cout << "     --store, -o <dir>         Write numeric fields as series to a segment store\n";
+    std::cout << "                               Sealed segments are merged in the background\n";
+    std::cout << "     --live, -l <path>         Keep recent records in memory, query on socket\n";
+    std::cout << "                               Queried with tkmlive\n";
+    std::cout << "     --latest, -L <name>       Publish latest values in shared memory <name>\n";
+    std::cout << "                               Read with LatestTable.h or tkmlatest\n";
+    std::cout << "     --ring, -w <name>         Stream samples to shared memory ring <name>\n";
+    std::cout << "                               Read with SampleRing.h or tkmring\n";
     std::cout << "  Help:\n";
     std::cout << "     --help, -h                Print this help\n\n";
 
-    ::exit(EXIT_SUCCESS);
+    ::exit(usageError.empty() ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+
+  // Binary records own stdout, any text output goes to stderr
+  if (isStandardOut(Arguments::Key::MsgPackPath)) {
+    MsgPackWriter::takeStandardOutput();
   }
 
   ::signal(SIGINT, terminate);
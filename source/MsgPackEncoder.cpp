@@ -0,0 +1,165 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     MsgPackEncoder Class
+ * @details   Streaming MessagePack encoder into a reusable buffer
+ *-
+ */
+
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+#include "MsgPackEncoder.h"
+
+namespace tkm::reader
+{
+
+// Containers start with the largest header and shrink it when closed
+static constexpr size_t MaxHeaderSize = 5;
+
+void MsgPackEncoder::reset(void)
+{
+  m_buffer.clear();
+  m_frames.clear();
+}
+
+void MsgPackEncoder::key(std::string_view name)
+{
+  if (!m_frames.empty() && m_frames.back().map) {
+    m_frames.back().count++;
+  }
+  value(name);
+}
+
+void MsgPackEncoder::key(int64_t name)
+{
+  char str[24];
+  auto res = std::to_chars(str, str + sizeof(str), name);
+  key(std::string_view(str, static_cast<size_t>(res.ptr - str)));
+}
+
+void MsgPackEncoder::value(uint64_t val)
+{
+  if (val < 0x80) {
+    m_buffer.push_back(static_cast<char>(val));
+  } else if (val <= std::numeric_limits<uint8_t>::max()) {
+    writeUint(0xcc, val, 1);
+  } else if (val <= std::numeric_limits<uint16_t>::max()) {
+    writeUint(0xcd, val, 2);
+  } else if (val <= std::numeric_limits<uint32_t>::max()) {
+    writeUint(0xce, val, 4);
+  } else {
+    writeUint(0xcf, val, 8);
+  }
+}
+
+void MsgPackEncoder::value(int64_t val)
+{
+  auto bits = static_cast<uint64_t>(val);
+
+  if (val >= 0) {
+    value(bits);
+  } else if (val >= -32) {
+    m_buffer.push_back(static_cast<char>(bits & 0xff));
+  } else if (val >= std::numeric_limits<int8_t>::min()) {
+    writeUint(0xd0, bits, 1);
+  } else if (val >= std::numeric_limits<int16_t>::min()) {
+    writeUint(0xd1, bits, 2);
+  } else if (val >= std::numeric_limits<int32_t>::min()) {
+    writeUint(0xd2, bits, 4);
+  } else {
+    writeUint(0xd3, bits, 8);
+  }
+}
+
+void MsgPackEncoder::value(double val)
+{
+  uint64_t bits;
+  memcpy(&bits, &val, sizeof(bits));
+  writeUint(0xcb, bits, sizeof(bits));
+}
+
+void MsgPackEncoder::value(float val)
+{
+  uint32_t bits;
+  memcpy(&bits, &val, sizeof(bits));
+  writeUint(0xca, bits, sizeof(bits));
+}
+
+void MsgPackEncoder::value(bool val)
+{
+  m_buffer.push_back(static_cast<char>(val ? 0xc3 : 0xc2));
+}
+
+void MsgPackEncoder::value(std::string_view val)
+{
+  auto size = val.size();
+
+  if (size < 32) {
+    m_buffer.push_back(static_cast<char>(0xa0 | size));
+  } else if (size <= std::numeric_limits<uint8_t>::max()) {
+    writeUint(0xd9, size, 1);
+  } else if (size <= std::numeric_limits<uint16_t>::max()) {
+    writeUint(0xda, size, 2);
+  } else {
+    writeUint(0xdb, size, 4);
+  }
+  m_buffer.append(val);
+}
+
+void MsgPackEncoder::beginContainer(bool map)
+{
+  elementStart();
+  m_frames.push_back(Frame{.start = m_buffer.size(), .count = 0, .map = map});
+  m_buffer.append(MaxHeaderSize, '\0');
+}
+
+void MsgPackEncoder::endContainer(void)
+{
+  if (m_frames.empty()) {
+    return;
+  }
+
+  auto frame = m_frames.back();
+  m_frames.pop_back();
+
+  char header[MaxHeaderSize];
+  size_t headerSize = 0;
+  auto count = static_cast<uint32_t>(frame.count);
+
+  if (count < 16) {
+    header[headerSize++] = static_cast<char>((frame.map ? 0x80 : 0x90) | count);
+  } else if (count <= std::numeric_limits<uint16_t>::max()) {
+    header[headerSize++] = static_cast<char>(frame.map ? 0xde : 0xdc);
+    header[headerSize++] = static_cast<char>((count >> 8) & 0xff);
+    header[headerSize++] = static_cast<char>(count & 0xff);
+  } else {
+    header[headerSize++] = static_cast<char>(frame.map ? 0xdf : 0xdd);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      header[headerSize++] = static_cast<char>((count >> shift) & 0xff);
+    }
+  }
+
+  m_buffer.replace(frame.start, MaxHeaderSize, header, headerSize);
+}
+
+void MsgPackEncoder::elementStart(void)
+{
+  if (!m_frames.empty() && !m_frames.back().map) {
+    m_frames.back().count++;
+  }
+}
+
+void MsgPackEncoder::writeUint(uint8_t type, uint64_t val, size_t size)
+{
+  m_buffer.push_back(static_cast<char>(type));
+  for (size_t i = size; i > 0; i--) {
+    m_buffer.push_back(static_cast<char>((val >> (8 * (i - 1))) & 0xff));
+  }
+}
+
+} // namespace tkm::reader
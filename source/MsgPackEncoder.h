@@ -0,0 +1,96 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     MsgPackEncoder Class
+ * @details   Streaming MessagePack encoder into a reusable buffer
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tkm::reader
+{
+
+/*
+ * Same interface as JsonEncoder so records are built by the same code.
+ * Integers use the smallest MessagePack integer type holding the value,
+ * floats are written as float 32 and doubles as float 64. Strings are
+ * copied as is. Map keys are always strings (like JSON object keys) so
+ * strict decoders accept the output. Map and array sizes are patched in
+ * when the container is closed, member order is the write order.
+ */
+class MsgPackEncoder
+{
+public:
+  MsgPackEncoder() = default;
+  ~MsgPackEncoder() = default;
+
+public:
+  MsgPackEncoder(MsgPackEncoder const &) = delete;
+  void operator=(MsgPackEncoder const &) = delete;
+
+  void reset(void);
+  auto view(void) const -> std::string_view { return m_buffer; }
+
+  void beginObject(void) { beginContainer(true); }
+  // Member order carries no meaning in MessagePack output
+  void beginSortedObject(void) { beginContainer(true); }
+  void endObject(void) { endContainer(); }
+
+  void beginArray(void) { beginContainer(false); }
+  void endArray(void) { endContainer(); }
+
+  void key(std::string_view name);
+  void key(int64_t name);
+
+  void value(uint64_t val);
+  void value(int64_t val);
+  void value(uint32_t val) { value(static_cast<uint64_t>(val)); }
+  void value(int32_t val) { value(static_cast<int64_t>(val)); }
+  void value(double val);
+  void value(float val);
+  void value(bool val);
+  void value(std::string_view val);
+  void value(const std::string &val) { value(std::string_view(val)); }
+  void value(const char *val) { value(std::string_view(val)); }
+
+  template <class T>
+  void field(std::string_view name, const T &val)
+  {
+    key(name);
+    value(val);
+  }
+
+  template <class T>
+  void element(const T &val)
+  {
+    elementStart();
+    value(val);
+  }
+
+private:
+  typedef struct Frame {
+    size_t start;
+    size_t count;
+    bool map;
+  } Frame;
+
+  void beginContainer(bool map);
+  void endContainer(void);
+  void elementStart(void);
+  void writeUint(uint8_t type, uint64_t val, size_t size);
+
+private:
+  std::string m_buffer{};
+  std::vector<Frame> m_frames{};
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,85 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     MsgPackRecord Class
+ * @details   Build data records as MessagePack maps
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "MsgPackEncoder.h"
+
+namespace tkm::reader
+{
+
+/*
+ * Same builder interface as JsonRecord. A record is written like the
+ * verbose JSON record: a map with the head fields (type, times, session)
+ * and one nested map per group.
+ */
+class MsgPackRecord
+{
+public:
+  explicit MsgPackRecord(MsgPackEncoder &encoder)
+  : m_encoder(encoder)
+  {
+  }
+  ~MsgPackRecord() = default;
+
+public:
+  MsgPackRecord(MsgPackRecord const &) = delete;
+  void operator=(MsgPackRecord const &) = delete;
+
+  void begin(const char *type,
+             const std::string &session,
+             uint64_t systemTime,
+             uint64_t monotonicTime,
+             uint64_t receiveTime)
+  {
+    m_encoder.beginObject();
+    m_encoder.field("type", type);
+    m_encoder.field("system_time", systemTime);
+    m_encoder.field("monotonic_time", monotonicTime);
+    m_encoder.field("receive_time", receiveTime);
+    m_encoder.field("session", session);
+  }
+  void end(void) { m_encoder.endObject(); }
+
+  void beginGroup(const char *kind)
+  {
+    m_encoder.key(std::string_view(kind));
+    m_encoder.beginObject();
+  }
+  void beginGroup(const char *, std::string_view key, const char * = nullptr)
+  {
+    m_encoder.key(key);
+    m_encoder.beginObject();
+  }
+  void beginGroup(const char *, int64_t key, const char * = nullptr)
+  {
+    m_encoder.key(key);
+    m_encoder.beginObject();
+  }
+  void endGroup(void) { m_encoder.endObject(); }
+
+  template <class T>
+  void field(std::string_view name, const T &val)
+  {
+    m_encoder.field(name, val);
+  }
+
+  auto view(void) const -> std::string_view { return m_encoder.view(); }
+
+private:
+  MsgPackEncoder &m_encoder;
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,123 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     MsgPackWriter Class
+ * @details   Write MessagePack records to file or standard output
+ *-
+ */
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+#include "../bswinfra/source/Logger.h"
+#include "Application.h"
+#include "Arguments.h"
+#include "MsgPackWriter.h"
+
+namespace tkm::reader
+{
+
+MsgPackWriter *MsgPackWriter::instance = nullptr;
+int MsgPackWriter::standardOutFd = STDOUT_FILENO;
+
+void MsgPackWriter::takeStandardOutput(void)
+{
+  std::cout.flush();
+
+  auto fd = ::fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 0);
+  if ((fd < 0) || (::dup2(STDERR_FILENO, STDOUT_FILENO) < 0)) {
+    logWarn() << "Cannot move text output to stderr: " << strerror(errno);
+    if (fd >= 0) {
+      ::close(fd);
+    }
+    return;
+  }
+  standardOutFd = fd;
+}
+
+MsgPackWriter::MsgPackWriter()
+{
+  if (!App()->getArguments()->hasFor(Arguments::Key::MsgPackPath)) {
+    return;
+  }
+
+  auto outPath = App()->getArguments()->getFor(Arguments::Key::MsgPackPath);
+  if (outPath == "stdout") {
+    m_outputType = OutputType::StandardOut;
+  } else {
+    m_outputType = OutputType::FilePath;
+    m_outStream = std::make_unique<std::ofstream>(
+        outPath, std::ofstream::out | std::ofstream::app | std::ofstream::binary);
+  }
+
+  // Standard output is written per record, files in large blocks
+  if (m_outputType == OutputType::FilePath) {
+    m_flushSize = std::stoul(tkmDefaults.getFor(Defaults::Default::JsonFlushSize));
+    m_buffer.reserve(m_flushSize);
+
+    m_flushTimer = std::make_shared<Timer>("MsgPackFlushTimer", [this]() {
+      flush();
+      return true;
+    });
+    m_flushTimer->start(std::stoul(tkmDefaults.getFor(Defaults::Default::JsonFlushInterval)), true);
+    App()->addEventSource(m_flushTimer);
+  }
+
+  std::atexit([]() { MsgPackWriter::getInstance()->flush(); });
+}
+
+bool MsgPackWriter::isEnabledFor(tkm::msg::monitor::Data_What what)
+{
+  if (m_outputType == OutputType::Disabled) {
+    return false;
+  }
+  return App()->isRecordTypeSelected(what);
+}
+
+void MsgPackWriter::write(std::string_view data)
+{
+  if (m_outputType == OutputType::Disabled) {
+    return;
+  }
+
+  m_buffer.append(data);
+  if (m_buffer.size() >= m_flushSize) {
+    flush();
+  }
+}
+
+void MsgPackWriter::flush(void)
+{
+  if (m_buffer.empty()) {
+    return;
+  }
+
+  if (m_outputType == OutputType::StandardOut) {
+    std::string_view data = m_buffer;
+    while (!data.empty()) {
+      auto written = ::write(standardOutFd, data.data(), data.size());
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        logError() << "MessagePack write to stdout failed: " << strerror(errno);
+        break;
+      }
+      data.remove_prefix(static_cast<size_t>(written));
+    }
+  } else if (m_outStream != nullptr) {
+    m_outStream->write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    m_outStream->flush();
+  }
+
+  m_buffer.clear();
+}
+
+} // namespace tkm::reader
@@ -0,0 +1,86 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     MsgPackWriter Class
+ * @details   Write MessagePack records to file or standard output
+ *-
+ */
+
+#pragma once
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <taskmonitor/taskmonitor.h>
+
+#include "MsgPackEncoder.h"
+#include "MsgPackRecord.h"
+
+#include "../bswinfra/source/Timer.h"
+
+using namespace bswi::event;
+
+namespace tkm::reader
+{
+
+/*
+ * Records are written back to back without separators, MessagePack values
+ * are self delimiting so the output is read with a streaming unpacker.
+ */
+class MsgPackWriter
+{
+public:
+  enum class OutputType { Disabled, StandardOut, FilePath };
+
+  static MsgPackWriter *getInstance()
+  {
+    return (!instance) ? instance = new MsgPackWriter : instance;
+  }
+
+  bool isEnabled(void) { return (m_outputType != OutputType::Disabled); }
+  bool isEnabledFor(tkm::msg::monitor::Data_What what);
+
+  // Encoder and record builder are shared by all records, returned reset
+  auto getEncoder(void) -> MsgPackEncoder &
+  {
+    m_encoder.reset();
+    return m_encoder;
+  }
+  auto getRecord(void) -> MsgPackRecord &
+  {
+    m_encoder.reset();
+    return m_record;
+  }
+
+  void write(std::string_view data);
+  void flush(void);
+
+  // Keep stdout for MessagePack records only, text written to stdout by any
+  // part of the process goes to stderr from now on
+  static void takeStandardOutput(void);
+
+public:
+  MsgPackWriter(MsgPackWriter const &) = delete;
+  void operator=(MsgPackWriter const &) = delete;
+
+private:
+  MsgPackWriter();
+  ~MsgPackWriter() = default;
+
+private:
+  static MsgPackWriter *instance;
+  static int standardOutFd;
+  OutputType m_outputType = OutputType::Disabled;
+  std::unique_ptr<std::ofstream> m_outStream = nullptr;
+  std::shared_ptr<Timer> m_flushTimer = nullptr;
+  MsgPackEncoder m_encoder{};
+  MsgPackRecord m_record{m_encoder};
+  std::string m_buffer{};
+  size_t m_flushSize = 0;
+};
+
+} // namespace tkm::reader
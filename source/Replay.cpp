@@ -0,0 +1,213 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     Replay Class
+ * @details   Feed captured envelopes through the dispatcher
+ *-
+ */
+
+#include <vector>
+
+#include "Application.h"
+#include "ColumnWriter.h"
+#include "JsonWriter.h"
+#include "Logger.h"
+#include "MsgPackWriter.h"
+#include "Replay.h"
+#include "SegmentWriter.h"
+#include "SeriesWriter.h"
+
+namespace tkm::reader
+{
+
+// Interval to check the dispatcher backlog and the next frame due time
+static constexpr uint64_t ReplayStepInterval = 1000;
+
+Replay::Replay(const std::string &path, double speed)
+: m_reader(path)
+, m_speed(speed)
+{
+}
+
+bool Replay::start(void)
+{
+  if (!m_reader.isOpen()) {
+    return false;
+  }
+
+  App()->printVerbose("Replay started");
+  logInfo() << "Replay started with speed " << m_speed;
+
+  m_startTime = std::chrono::steady_clock::now();
+  m_timer = std::make_shared<Timer>("ReplayTimer", [this]() { return step(); });
+  m_timer->start(ReplayStepInterval, true);
+  App()->addEventSource(m_timer);
+
+  return true;
+}
+
+bool Replay::step(void)
+{
+  static const size_t highMark = std::stoul(tkmDefaults.getFor(Defaults::Default::BacklogHighMark));
+  auto backlog = App()->getBacklog();
+
+  switch (m_state) {
+  case State::Reading:
+    break;
+  case State::Draining:
+    // All messages are processed, end the last session
+    if (backlog == 0) {
+      endSession();
+      m_state = State::Ending;
+    }
+    return true;
+  case State::Ending:
+  default:
+    if (backlog == 0) {
+      auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - m_startTime);
+      logInfo() << "Replay done messages=" << m_messages << " time_ms=" << elapsed.count();
+      App()->printVerbose("Replay done. Messages: " + std::to_string(m_messages) +
+                          " Time: " + std::to_string(elapsed.count()) + " msec");
+
+      Dispatcher::Request rq{.action = Dispatcher::Action::Quit,
+                             .bulkData = std::make_any<int>(0),
+                             .args = std::map<Defaults::Arg, std::string>()};
+      App()->getDispatcher()->pushRequest(rq);
+      return false;
+    }
+    return true;
+  }
+
+  while (backlog < highMark) {
+    if (!m_hasNext && !readNext()) {
+      m_state = State::Draining;
+      break;
+    }
+
+    if (!isDue(m_nextTime)) {
+      break;
+    }
+
+    // Data of the previous session is written out before the next one starts
+    if ((m_next.action == Dispatcher::Action::SetSession) &&
+        (App()->getSessionInfo().hash().length() > 0)) {
+      if (backlog > 0) {
+        break;
+      }
+      endSession();
+    }
+
+    App()->getDispatcher()->pushRequest(m_next);
+    m_hasNext = false;
+    m_messages++;
+    backlog++;
+  }
+
+  return true;
+}
+
+bool Replay::readNext(void)
+{
+  CaptureReader::Frame frame{};
+
+  while (m_reader.next(frame) == CaptureReader::Status::Ok) {
+    if (frame.type == capture::FrameType::Session) {
+      std::vector<std::string> fields;
+      if (CaptureReader::parseSession(frame.payload, fields)) {
+        logInfo() << "Replay session "
+                  << fields[static_cast<size_t>(capture::SessionField::Session)] << " device "
+                  << fields[static_cast<size_t>(capture::SessionField::Device)];
+      }
+      continue;
+    }
+    if (frame.type != capture::FrameType::Envelope) {
+      continue;
+    }
+
+    tkm::msg::Envelope envelope;
+    if (!envelope.ParseFromString(frame.payload)) {
+      logWarn() << "Skip invalid envelope in capture";
+      continue;
+    }
+    if (envelope.origin() != tkm::msg::Envelope_Recipient_Monitor) {
+      continue;
+    }
+
+    tkm::msg::monitor::Message msg;
+    envelope.mesg().UnpackTo(&msg);
+
+    uint64_t receiveSec = frame.receiveTime / 1000000;
+    if (msg.type() == tkm::msg::monitor::Message_Type_SetSession) {
+      tkm::msg::monitor::SessionInfo sessionInfo;
+
+      msg.payload().UnpackTo(&sessionInfo);
+      sessionInfo.set_name("Replay." + std::to_string(receiveSec));
+      m_next = Dispatcher::Request{.action = Dispatcher::Action::SetSession,
+                                   .bulkData = std::make_any<tkm::msg::monitor::SessionInfo>(
+                                       sessionInfo),
+                                   .args = std::map<Defaults::Arg, std::string>()};
+    } else if (msg.type() == tkm::msg::monitor::Message_Type_Data) {
+      tkm::msg::monitor::Data data;
+
+      msg.payload().UnpackTo(&data);
+      data.set_receive_time_sec(receiveSec);
+      m_next = Dispatcher::Request{.action = Dispatcher::Action::ProcessData,
+                                   .bulkData = std::make_any<tkm::msg::monitor::Data>(data),
+                                   .args = std::map<Defaults::Arg, std::string>()};
+    } else {
+      continue;
+    }
+
+    if (m_firstTime == 0) {
+      m_firstTime = frame.receiveTime;
+    }
+    m_nextTime = frame.receiveTime;
+    m_hasNext = true;
+    return true;
+  }
+
+  return false;
+}
+
+bool Replay::isDue(uint64_t receiveTime)
+{
+  if ((m_speed <= 0) || (receiveTime <= m_firstTime)) {
+    return true;
+  }
+
+  auto offset = static_cast<double>(receiveTime - m_firstTime) / m_speed;
+  auto due = m_startTime + std::chrono::microseconds(static_cast<uint64_t>(offset));
+
+  return (std::chrono::steady_clock::now() >= due);
+}
+
+void Replay::endSession(void)
+{
+  if ((App()->getSessionInfo().hash().length() > 0) && (App()->getSessionData().ended() == 0)) {
+    if (App()->getArguments()->hasFor(Arguments::Key::DatabasePath)) {
+      IDatabase::Request dbrq = {.action = IDatabase::Action::EndSession,
+                                 .bulkData = std::make_any<int>(0),
+                                 .args = std::map<Defaults::Arg, std::string>()};
+      App()->getDatabase()->pushRequest(dbrq);
+    }
+  }
+
+  if (JsonWriter::getInstance()->isEnabled()) {
+    JsonWriter::getInstance()->flush();
+  }
+  if (MsgPackWriter::getInstance()->isEnabled()) {
+    MsgPackWriter::getInstance()->flush();
+  }
+  if (ColumnWriter::getInstance()->isEnabled()) {
+    ColumnWriter::getInstance()->flush();
+  }
+  if (SegmentWriter::getInstance()->isEnabled()) {
+    SegmentWriter::getInstance()->seal();
+  }
+}
+
+} // namespace tkm::reader
@@ -0,0 +1,69 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     Replay Class
+ * @details   Feed captured envelopes through the dispatcher
+ *-
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <taskmonitor/taskmonitor.h>
+
+#include "CaptureReader.h"
+#include "Dispatcher.h"
+
+#include "../bswinfra/source/Timer.h"
+
+using namespace bswi::event;
+
+namespace tkm::reader
+{
+
+/*
+ * Session and data messages from a capture file are pushed to the
+ * dispatcher as if they were received from a live connection. Status
+ * replies are skipped since no requests are sent. With speed 0 frames
+ * are pushed as fast as the dispatcher backlog allows, otherwise the
+ * original receive times are replayed scaled by the speed factor.
+ */
+class Replay
+{
+public:
+  explicit Replay(const std::string &path, double speed);
+  ~Replay() = default;
+
+public:
+  Replay(Replay const &) = delete;
+  void operator=(Replay const &) = delete;
+
+  bool start(void);
+
+private:
+  enum class State { Reading, Draining, Ending };
+
+  bool step(void);
+  bool readNext(void);
+  bool isDue(uint64_t receiveTime);
+  void endSession(void);
+
+private:
+  CaptureReader m_reader;
+  double m_speed = 0;
+  State m_state = State::Reading;
+  std::shared_ptr<Timer> m_timer = nullptr;
+  Dispatcher::Request m_next{};
+  uint64_t m_nextTime = 0;
+  bool m_hasNext = false;
+  uint64_t m_firstTime = 0;
+  std::chrono::time_point<std::chrono::steady_clock> m_startTime{};
+  size_t m_messages = 0;
+};
+
+} // namespace tkm::reader
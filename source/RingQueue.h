@@ -0,0 +1,77 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     RingQueue Class
+ * @details   Bounded lock-free single producer single consumer queue
+ *-
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace tkm::reader
+{
+
+template <class T, size_t N>
+class RingQueue
+{
+  static_assert((N > 1) && ((N & (N - 1)) == 0), "RingQueue size must be a power of 2");
+
+public:
+  RingQueue() = default;
+  ~RingQueue() = default;
+
+public:
+  RingQueue(RingQueue const &) = delete;
+  void operator=(RingQueue const &) = delete;
+
+  // Producer side. The item is moved only if there is a free slot
+  bool push(T &item)
+  {
+    auto tail = m_tail.load(std::memory_order_relaxed);
+
+    if (tail - m_head.load(std::memory_order_acquire) == N) {
+      return false;
+    }
+
+    m_slots[tail & (N - 1)] = std::move(item);
+    m_tail.store(tail + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  // Consumer side
+  bool pop(T &item)
+  {
+    auto head = m_head.load(std::memory_order_relaxed);
+
+    if (head == m_tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    item = std::move(m_slots[head & (N - 1)]);
+    m_head.store(head + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  auto size(void) const -> size_t
+  {
+    return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+  }
+  auto capacity(void) const -> size_t { return N; }
+
+private:
+  std::array<T, N> m_slots{};
+  alignas(64) std::atomic<size_t> m_head{0};
+  alignas(64) std::atomic<size_t> m_tail{0};
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,324 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SampleRing Class
+ * @details   Read the shared memory sample stream of a running reader
+ *-
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*
+ * Header only, consumers only need this file. The stream is a POSIX shared
+ * memory object (/dev/shm/<name>) with one producer, the tkmreader:
+ *   Header (192 bytes)
+ *   Data (capacity bytes, a power of 2)
+ * Records are written one after the other at increasing stream positions,
+ * the data offset of a position is position % capacity. A record never
+ * wraps, the end of the data is skipped with a padding record. All values
+ * are in host byte order, records are 8 bytes aligned:
+ *   Sample record:
+ *     u16 size, u8 kind (1), u8 type, u8 source size, u8 entity size,
+ *     u8 field size, u8 reserved, u64 system time, u64 value bits,
+ *     source, entity, field, padding
+ *   Padding record:
+ *     u16 size (0), u8 kind (0), u8 reserved[5], the rest of the data is
+ *     skipped
+ * Samples are the numeric fields of the records, the same (source,
+ * entity, field) series as the series outputs. The value type is the
+ * series type (1 uint64, 2 int64, 3 double).
+ *
+ * The producer never waits for consumers. Before overwriting old records
+ * it moves tail past them, head is moved past new records once a whole
+ * data record is written. Every consumer keeps its own read position and
+ * checks tail after copying a record: a record overwritten meanwhile is an
+ * overrun, counted, and reading goes on from tail.
+ */
+namespace tkm::reader::ring
+{
+
+constexpr std::string_view Magic = "TKMRING1";
+constexpr uint32_t Version = 1;
+constexpr size_t HeaderSize = 192;
+constexpr size_t RecordHeaderSize = 24;
+// Size and kind, the part of a record header a padding record has
+constexpr size_t RecordPrefixSize = 8;
+constexpr size_t MaxRecordSize = RecordHeaderSize + 3 * 255 + 7;
+
+constexpr uint8_t PaddingKind = 0;
+constexpr uint8_t SampleKind = 1;
+
+typedef struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t headerSize;
+  uint64_t capacity;
+  char device[40];
+  // Stream position after the last published record
+  alignas(64) std::atomic<uint64_t> head;
+  // Stream position of the oldest record not overwritten
+  alignas(64) std::atomic<uint64_t> tail;
+  // Futex word, changed on publish while consumers wait
+  std::atomic<uint32_t> notify;
+  std::atomic<uint32_t> waiters;
+  std::atomic<uint32_t> closed;
+} Header;
+
+static_assert(sizeof(Header) == HeaderSize, "Sample ring header layout");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Sample ring needs lock free atomics");
+
+typedef struct RecordHeader {
+  uint16_t size;
+  uint8_t kind;
+  uint8_t type;
+  uint8_t sourceSize;
+  uint8_t entitySize;
+  uint8_t fieldSize;
+  uint8_t reserved;
+  uint64_t time;
+  uint64_t value;
+} RecordHeader;
+
+static_assert(sizeof(RecordHeader) == RecordHeaderSize, "Sample ring record layout");
+
+// Same values as the series type of the series outputs
+enum class Type : uint8_t { UInt64 = 1, Int64 = 2, Double = 3 };
+
+// A sample read from the ring, the views are valid until the next read
+typedef struct Sample {
+  Type type;
+  uint64_t time;
+  uint64_t bits;
+  std::string_view source;
+  std::string_view entity;
+  std::string_view field;
+
+  auto asUInt64(void) const -> uint64_t { return bits; }
+  auto asInt64(void) const -> int64_t { return static_cast<int64_t>(bits); }
+  auto asDouble(void) const -> double
+  {
+    switch (type) {
+    case Type::Int64:
+      return static_cast<double>(asInt64());
+    case Type::Double: {
+      double real;
+      std::memcpy(&real, &bits, sizeof(real));
+      return real;
+    }
+    case Type::UInt64:
+    default:
+      return static_cast<double>(bits);
+    }
+  }
+} Sample;
+
+class SampleRing
+{
+public:
+  SampleRing() = default;
+  ~SampleRing() { close(); }
+
+public:
+  SampleRing(SampleRing const &) = delete;
+  void operator=(SampleRing const &) = delete;
+
+  // Start with the next record published or with the oldest one kept
+  bool open(const std::string &name, bool fromOldest = false)
+  {
+    struct stat st;
+
+    close();
+    if (name.empty()) {
+      return false;
+    }
+
+    auto path = (name.front() == '/') ? name : "/" + name;
+    auto fd = ::shm_open(path.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+      return false;
+    }
+    if ((::fstat(fd, &st) < 0) || (static_cast<size_t>(st.st_size) <= HeaderSize)) {
+      ::close(fd);
+      return false;
+    }
+
+    // Mapped writable for the waiters count and the futex word only
+    m_size = static_cast<size_t>(st.st_size);
+    auto addr = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+      return false;
+    }
+    m_header = static_cast<Header *>(addr);
+
+    auto capacity = m_header->capacity;
+    if ((std::string_view(m_header->magic, sizeof(m_header->magic)) != Magic) ||
+        (m_header->version != Version) || (m_header->headerSize != HeaderSize) ||
+        (capacity < MaxRecordSize) || ((capacity & (capacity - 1)) != 0) ||
+        (HeaderSize + capacity > m_size)) {
+      close();
+      return false;
+    }
+    m_data = static_cast<const char *>(addr) + HeaderSize;
+    m_mask = capacity - 1;
+    m_position = fromOldest ? m_header->tail.load(std::memory_order_acquire)
+                            : m_header->head.load(std::memory_order_acquire);
+    m_overruns = 0;
+    m_lostBytes = 0;
+
+    return true;
+  }
+
+  void close(void)
+  {
+    if (m_header != nullptr) {
+      ::munmap(m_header, m_size);
+      m_header = nullptr;
+      m_data = nullptr;
+      m_size = 0;
+    }
+  }
+
+  bool isOpen(void) const { return m_header != nullptr; }
+  // The producer is gone or restarted, the name has to be opened again
+  bool isClosed(void) const
+  {
+    return (m_header == nullptr) || (m_header->closed.load(std::memory_order_acquire) != 0);
+  }
+
+  auto getDevice(void) const -> std::string_view
+  {
+    return (m_header == nullptr) ? std::string_view() : std::string_view(m_header->device);
+  }
+  auto getPosition(void) const -> uint64_t { return m_position; }
+  // Overruns seen and bytes skipped, records overwritten before they were read
+  auto getOverruns(void) const -> uint64_t { return m_overruns; }
+  auto getLostBytes(void) const -> uint64_t { return m_lostBytes; }
+
+  // False if there is no published record left to read
+  bool next(Sample &sample)
+  {
+    if (m_header == nullptr) {
+      return false;
+    }
+
+    for (;;) {
+      auto head = m_header->head.load(std::memory_order_acquire);
+      if (m_position >= head) {
+        return false;
+      }
+      if (checkOverrun()) {
+        continue;
+      }
+
+      auto offset = m_position & m_mask;
+      RecordHeader record;
+      std::memcpy(&record, m_data + offset, RecordPrefixSize);
+
+      if (record.kind == PaddingKind) {
+        if (checkOverrun()) {
+          continue;
+        }
+        m_position += m_mask + 1 - offset;
+        continue;
+      }
+
+      // A torn header only shows as an overrun once tail is checked
+      auto size = static_cast<size_t>(record.size);
+      if ((size < RecordHeaderSize) || (size > MaxRecordSize) || (offset + size > m_mask + 1)) {
+        if (!checkOverrun()) {
+          m_position = head;
+          m_overruns++;
+        }
+        continue;
+      }
+
+      std::memcpy(m_record, m_data + offset, size);
+      if (checkOverrun()) {
+        continue;
+      }
+      m_position += size;
+      std::memcpy(&record, m_record, sizeof(record));
+
+      auto names = m_record + RecordHeaderSize;
+      if (RecordHeaderSize + record.sourceSize + record.entitySize + record.fieldSize > size) {
+        continue;
+      }
+      sample.type = static_cast<Type>(record.type);
+      sample.time = record.time;
+      sample.bits = record.value;
+      sample.source = std::string_view(names, record.sourceSize);
+      sample.entity = std::string_view(names + record.sourceSize, record.entitySize);
+      sample.field =
+          std::string_view(names + record.sourceSize + record.entitySize, record.fieldSize);
+
+      return true;
+    }
+  }
+
+  // Wait up to timeout msec for new records, true if there are some
+  bool wait(unsigned timeout)
+  {
+    if (m_header == nullptr) {
+      return false;
+    }
+    if (m_position < m_header->head.load(std::memory_order_acquire)) {
+      return true;
+    }
+
+    m_header->waiters.fetch_add(1, std::memory_order_seq_cst);
+    auto notify = m_header->notify.load(std::memory_order_seq_cst);
+    if ((m_position >= m_header->head.load(std::memory_order_seq_cst)) && !isClosed()) {
+      struct timespec ts = {.tv_sec = static_cast<time_t>(timeout / 1000),
+                            .tv_nsec = static_cast<long>(timeout % 1000) * 1000000};
+      ::syscall(SYS_futex, &m_header->notify, FUTEX_WAIT, notify, &ts, nullptr, 0);
+    }
+    m_header->waiters.fetch_sub(1, std::memory_order_relaxed);
+
+    return m_position < m_header->head.load(std::memory_order_acquire);
+  }
+
+private:
+  // Records before tail were overwritten, reading goes on from tail
+  bool checkOverrun(void)
+  {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    auto tail = m_header->tail.load(std::memory_order_relaxed);
+    if (m_position >= tail) {
+      return false;
+    }
+    m_overruns++;
+    m_lostBytes += tail - m_position;
+    m_position = tail;
+    return true;
+  }
+
+private:
+  Header *m_header = nullptr;
+  const char *m_data = nullptr;
+  size_t m_size = 0;
+  uint64_t m_mask = 0;
+  uint64_t m_position = 0;
+  uint64_t m_overruns = 0;
+  uint64_t m_lostBytes = 0;
+  char m_record[MaxRecordSize]{};
+};
+
+} // namespace tkm::reader::ring
@@ -0,0 +1,204 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SampleRingBuffer Class
+ * @details   Producer side of the shared memory sample ring
+ *-
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "SampleRingBuffer.h"
+
+namespace tkm::reader
+{
+
+bool SampleRingBuffer::create(const std::string &name, const std::string &device, size_t capacity)
+{
+  close();
+  if (name.empty()) {
+    return false;
+  }
+  m_name = (name.front() == '/') ? name : "/" + name;
+
+  size_t size = 4096;
+  while (size < std::max(capacity, ring::MaxRecordSize)) {
+    size <<= 1;
+  }
+
+  // Consumers still mapping the ring of a previous run are told to reopen
+  auto fd = ::shm_open(m_name.c_str(), O_RDWR | O_CLOEXEC, 0);
+  if (fd >= 0) {
+    auto addr = ::mmap(nullptr, ring::HeaderSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr != MAP_FAILED) {
+      auto header = static_cast<ring::Header *>(addr);
+      if (std::string_view(header->magic, sizeof(header->magic)) == ring::Magic) {
+        header->closed.store(1, std::memory_order_release);
+        header->notify.fetch_add(1, std::memory_order_release);
+        ::syscall(SYS_futex, &header->notify, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+      }
+      ::munmap(addr, ring::HeaderSize);
+    }
+    ::close(fd);
+    ::shm_unlink(m_name.c_str());
+  }
+
+  fd = ::shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+
+  auto total = ring::HeaderSize + size;
+  if (::ftruncate(fd, static_cast<off_t>(total)) < 0) {
+    auto error = errno;
+    ::close(fd);
+    ::shm_unlink(m_name.c_str());
+    errno = error;
+    return false;
+  }
+
+  auto addr = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  auto error = errno;
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    ::shm_unlink(m_name.c_str());
+    errno = error;
+    return false;
+  }
+
+  // A new object is zero filled, the header is written last
+  auto header = static_cast<ring::Header *>(addr);
+  header->version = ring::Version;
+  header->headerSize = ring::HeaderSize;
+  header->capacity = size;
+  std::memcpy(header->device, device.data(), std::min(device.size(), sizeof(header->device) - 1));
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(header->magic, ring::Magic.data(), sizeof(header->magic));
+
+  m_header = header;
+  m_data = static_cast<char *>(addr) + ring::HeaderSize;
+  m_size = total;
+  m_mask = size - 1;
+  m_head = 0;
+  m_tail = 0;
+  m_dropped = 0;
+
+  return true;
+}
+
+void SampleRingBuffer::reserve(size_t size)
+{
+  auto tail = m_tail;
+
+  while (m_head + size - tail > m_mask + 1) {
+    auto offset = tail & m_mask;
+    ring::RecordHeader record;
+    std::memcpy(&record, m_data + offset, ring::RecordPrefixSize);
+    tail += (record.kind == ring::PaddingKind) ? m_mask + 1 - offset : record.size;
+  }
+
+  // Consumers check tail after copying, it has to move before the bytes change
+  if (tail != m_tail) {
+    m_tail = tail;
+    m_header->tail.store(tail, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+}
+
+void SampleRingBuffer::append(std::string_view source,
+                              std::string_view entity,
+                              std::string_view field,
+                              series::Type type,
+                              uint64_t time,
+                              uint64_t value)
+{
+  if (m_header == nullptr) {
+    return;
+  }
+
+  // Sizes are single bytes in the record
+  if ((source.size() > UINT8_MAX) || (entity.size() > UINT8_MAX) || (field.size() > UINT8_MAX)) {
+    m_dropped++;
+    return;
+  }
+
+  auto nameSize = source.size() + entity.size() + field.size();
+  auto size = (ring::RecordHeaderSize + nameSize + 7) & ~static_cast<size_t>(7);
+
+  // Records never wrap, the end of the data is skipped
+  auto offset = m_head & m_mask;
+  if (offset + size > m_mask + 1) {
+    auto padding = m_mask + 1 - offset;
+    reserve(padding);
+    ring::RecordHeader record{};
+    record.kind = ring::PaddingKind;
+    std::memcpy(m_data + offset, &record, ring::RecordPrefixSize);
+    m_head += padding;
+    offset = 0;
+  }
+  reserve(size);
+
+  ring::RecordHeader record{.size = static_cast<uint16_t>(size),
+                            .kind = ring::SampleKind,
+                            .type = static_cast<uint8_t>(type),
+                            .sourceSize = static_cast<uint8_t>(source.size()),
+                            .entitySize = static_cast<uint8_t>(entity.size()),
+                            .fieldSize = static_cast<uint8_t>(field.size()),
+                            .reserved = 0,
+                            .time = time,
+                            .value = value};
+  auto dest = m_data + offset;
+  std::memcpy(dest, &record, sizeof(record));
+  dest += sizeof(record);
+  std::memcpy(dest, source.data(), source.size());
+  dest += source.size();
+  std::memcpy(dest, entity.data(), entity.size());
+  dest += entity.size();
+  std::memcpy(dest, field.data(), field.size());
+
+  m_head += size;
+}
+
+void SampleRingBuffer::publish(void)
+{
+  if ((m_header == nullptr) || (m_header->head.load(std::memory_order_relaxed) == m_head)) {
+    return;
+  }
+
+  m_header->head.store(m_head, std::memory_order_release);
+
+  // Pairs with the waiters increment of SampleRing::wait, no syscall if nobody waits
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (m_header->waiters.load(std::memory_order_relaxed) > 0) {
+    m_header->notify.fetch_add(1, std::memory_order_release);
+    ::syscall(SYS_futex, &m_header->notify, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+  }
+}
+
+void SampleRingBuffer::close(void)
+{
+  if (m_header == nullptr) {
+    return;
+  }
+
+  publish();
+  m_header->closed.store(1, std::memory_order_release);
+  m_header->notify.fetch_add(1, std::memory_order_release);
+  ::syscall(SYS_futex, &m_header->notify, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+  ::munmap(m_header, m_size);
+  ::shm_unlink(m_name.c_str());
+  m_header = nullptr;
+  m_data = nullptr;
+}
+
+} // namespace tkm::reader
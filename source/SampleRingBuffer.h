@@ -0,0 +1,73 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SampleRingBuffer Class
+ * @details   Producer side of the shared memory sample ring
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "SampleRing.h"
+#include "SeriesFormat.h"
+
+namespace tkm::reader
+{
+
+/*
+ * Single producer of the stream read by SampleRing. Samples are appended
+ * and become visible to consumers on publish(), once per data record.
+ * Appending never waits: old records are overwritten and consumers that
+ * fall behind see an overrun.
+ */
+class SampleRingBuffer
+{
+public:
+  SampleRingBuffer() = default;
+  ~SampleRingBuffer() { close(); }
+
+public:
+  SampleRingBuffer(SampleRingBuffer const &) = delete;
+  void operator=(SampleRingBuffer const &) = delete;
+
+  // Capacity is rounded up to a power of 2
+  bool create(const std::string &name, const std::string &device, size_t capacity);
+  bool isOpen(void) const { return m_header != nullptr; }
+
+  void append(std::string_view source,
+              std::string_view entity,
+              std::string_view field,
+              series::Type type,
+              uint64_t time,
+              uint64_t value);
+  // Make the appended samples visible and wake waiting consumers
+  void publish(void);
+  // Mark the ring closed for its consumers and remove it
+  void close(void);
+
+  auto getName(void) const -> const std::string & { return m_name; }
+  auto getDropped(void) const -> uint64_t { return m_dropped; }
+
+private:
+  // Move tail past the records overwritten by the next size bytes
+  void reserve(size_t size);
+
+private:
+  std::string m_name{};
+  ring::Header *m_header = nullptr;
+  char *m_data = nullptr;
+  size_t m_size = 0;
+  uint64_t m_mask = 0;
+  uint64_t m_head = 0;
+  uint64_t m_tail = 0;
+  uint64_t m_dropped = 0;
+};
+
+} // namespace tkm::reader
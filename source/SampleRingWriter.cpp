@@ -0,0 +1,82 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SampleRingWriter Class
+ * @details   Stream decoded samples to local consumers in shared memory
+ *-
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+
+#include "../bswinfra/source/Logger.h"
+#include "Application.h"
+#include "Arguments.h"
+#include "SampleRingWriter.h"
+
+namespace tkm::reader
+{
+
+SampleRingWriter *SampleRingWriter::instance = nullptr;
+
+SampleRingWriter::SampleRingWriter()
+: m_record([this](std::string_view source,
+                  std::string_view entity,
+                  std::string_view field,
+                  series::Type type,
+                  uint64_t time,
+                  uint64_t value) { append(source, entity, field, type, time, value); })
+{
+  if (!App()->getArguments()->hasFor(Arguments::Key::RingPath)) {
+    return;
+  }
+
+  auto name = App()->getArguments()->getFor(Arguments::Key::RingPath);
+  if (name.empty()) {
+    return;
+  }
+
+  auto size = std::clamp(std::stoull(tkmDefaults.getFor(Defaults::Default::RingSize)),
+                         65536ull,
+                         1073741824ull);
+  if (!m_ring.create(name, App()->getArguments()->getFor(Arguments::Key::Name), size)) {
+    logError() << "Cannot create sample ring " << name << ": " << strerror(errno);
+    return;
+  }
+  logInfo() << "Sample ring in shared memory " << m_ring.getName() << " (" << size << " bytes)";
+
+  std::atexit([]() { SampleRingWriter::getInstance()->close(); });
+}
+
+bool SampleRingWriter::isEnabledFor(tkm::msg::monitor::Data_What what)
+{
+  if (!m_ring.isOpen()) {
+    return false;
+  }
+  return App()->isRecordTypeSelected(what);
+}
+
+void SampleRingWriter::append(std::string_view source,
+                              std::string_view entity,
+                              std::string_view field,
+                              series::Type type,
+                              uint64_t time,
+                              uint64_t value)
+{
+  m_ring.append(source, entity, field, type, time, value);
+
+  // Only keys longer than a record can hold are dropped
+  if (m_ring.getDropped() > m_dropped) {
+    m_dropped = m_ring.getDropped();
+    if ((m_dropped % 1024) == 1) {
+      logWarn() << "Sample ring key too long, " << m_dropped << " samples dropped";
+    }
+  }
+}
+
+} // namespace tkm::reader
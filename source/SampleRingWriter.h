@@ -0,0 +1,66 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SampleRingWriter Class
+ * @details   Stream decoded samples to local consumers in shared memory
+ *-
+ */
+
+#pragma once
+
+#include <string_view>
+#include <taskmonitor/taskmonitor.h>
+
+#include "SampleRingBuffer.h"
+#include "SeriesRecord.h"
+
+namespace tkm::reader
+{
+
+/*
+ * Appends every numeric field of the selected records to the shared memory
+ * ring read by SampleRing, the samples of a record are published together.
+ */
+class SampleRingWriter
+{
+public:
+  static SampleRingWriter *getInstance()
+  {
+    return (!instance) ? instance = new SampleRingWriter : instance;
+  }
+
+  bool isEnabled(void) { return m_ring.isOpen(); }
+  bool isEnabledFor(tkm::msg::monitor::Data_What what);
+
+  auto getRecord(void) -> SeriesRecord & { return m_record; }
+
+  // Make the samples of the last record visible to consumers
+  void commit(void) { m_ring.publish(); }
+  void close(void) { m_ring.close(); }
+
+public:
+  SampleRingWriter(SampleRingWriter const &) = delete;
+  void operator=(SampleRingWriter const &) = delete;
+
+private:
+  SampleRingWriter();
+  ~SampleRingWriter() = default;
+
+  void append(std::string_view source,
+              std::string_view entity,
+              std::string_view field,
+              series::Type type,
+              uint64_t time,
+              uint64_t value);
+
+private:
+  static SampleRingWriter *instance;
+  SampleRingBuffer m_ring{};
+  SeriesRecord m_record;
+  uint64_t m_dropped = 0;
+};
+
+} // namespace tkm::reader
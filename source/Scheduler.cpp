@@ -0,0 +1,64 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     Scheduler Class
+ * @details   Per data source request scheduler based on a hierarchical timing wheel
+ *-
+ */
+
+#include "Scheduler.h"
+#include "Application.h"
+#include "Logger.h"
+
+namespace tkm::reader
+{
+
+Scheduler::Scheduler(uint64_t resolutionUs, const DueCallback &callback)
+: m_wheel(resolutionUs)
+, m_callback(callback)
+{
+  m_startTime = std::chrono::steady_clock::now();
+  m_timer = std::make_shared<Timer>("SchedulerTimer", [this]() {
+    using USec = std::chrono::microseconds;
+    auto elapsedUs =
+        std::chrono::duration_cast<USec>(std::chrono::steady_clock::now() - m_startTime).count();
+    std::vector<std::shared_ptr<DataSource>> due;
+
+    // Catch up with all ticks elapsed since the last callback in case the
+    // main loop was busy, so we never drift behind wall time
+    m_wheel.advanceTo(static_cast<uint64_t>(elapsedUs) / m_wheel.getResolution(), due);
+
+    if (!due.empty() && (m_callback != nullptr)) {
+      m_callback(due);
+    }
+
+    return true;
+  });
+}
+
+void Scheduler::enableEvents()
+{
+  m_timer->start(m_wheel.getResolution(), true);
+  App()->addEventSource(m_timer);
+}
+
+void Scheduler::disableEvents()
+{
+  m_timer->stop();
+  App()->remEventSource(m_timer);
+}
+
+void Scheduler::schedule(const std::shared_ptr<DataSource> &source)
+{
+  m_wheel.schedule(source);
+}
+
+void Scheduler::reschedule(const std::shared_ptr<DataSource> &source, uint64_t delayUs)
+{
+  m_wheel.reschedule(source, delayUs);
+}
+
+} // namespace tkm::reader
@@ -0,0 +1,59 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     Scheduler Class
+ * @details   Per data source request scheduler based on a hierarchical timing wheel
+ *-
+ */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "DataSource.h"
+#include "TimingWheel.h"
+
+#include "../bswinfra/source/Timer.h"
+
+using namespace bswi::event;
+
+namespace tkm::reader
+{
+
+class Scheduler : public std::enable_shared_from_this<Scheduler>
+{
+public:
+  using DueCallback = std::function<void(const std::vector<std::shared_ptr<DataSource>> &)>;
+
+public:
+  explicit Scheduler(uint64_t resolutionUs, const DueCallback &callback);
+  ~Scheduler() = default;
+
+public:
+  Scheduler(Scheduler const &) = delete;
+  void operator=(Scheduler const &) = delete;
+
+  auto getShared() -> std::shared_ptr<Scheduler> { return shared_from_this(); }
+  void enableEvents();
+  void disableEvents();
+
+  // First request is sent after the data source offset and repeated at its interval
+  void schedule(const std::shared_ptr<DataSource> &source);
+  // Drop the pending entry of the source and request it again after delayUs
+  void reschedule(const std::shared_ptr<DataSource> &source, uint64_t delayUs);
+  auto getResolution(void) -> uint64_t { return m_wheel.getResolution(); }
+
+private:
+  TimingWheel m_wheel;
+  std::chrono::time_point<std::chrono::steady_clock> m_startTime{};
+  std::shared_ptr<Timer> m_timer = nullptr;
+  DueCallback m_callback = nullptr;
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,271 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SegmentCompactor Class
+ * @details   Merge small sealed segments in a background thread
+ *-
+ */
+
+#include <algorithm>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <unistd.h>
+
+#include "Logger.h"
+#include "SegmentCompactor.h"
+#include "SegmentFile.h"
+#include "SeriesCodec.h"
+
+namespace tkm::reader
+{
+
+void SegmentCompactor::start(void)
+{
+  if (m_compactor.joinable()) {
+    return;
+  }
+  m_stopping = false;
+  m_compactor = std::thread(&SegmentCompactor::compactorThread, this);
+}
+
+void SegmentCompactor::stop(void)
+{
+  if (!m_compactor.joinable()) {
+    return;
+  }
+
+  m_stopping = true;
+  {
+    std::lock_guard<std::mutex> lock(m_wakeLock);
+  }
+  m_wakeup.notify_one();
+  m_compactor.join();
+}
+
+void SegmentCompactor::notify(void)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_wakeLock);
+    m_pending = true;
+  }
+  m_wakeup.notify_one();
+}
+
+void SegmentCompactor::compactorThread(void)
+{
+  while (!m_stopping) {
+    {
+      std::unique_lock<std::mutex> lock(m_wakeLock);
+      m_wakeup.wait(lock, [this]() { return m_pending || m_stopping; });
+      m_pending = false;
+    }
+
+    // One merge may leave another run behind it
+    while (!m_stopping && (compactOnce() || archiveOnce())) {
+    }
+  }
+}
+
+bool SegmentCompactor::compactOnce(void)
+{
+  std::vector<SegmentStore::Segment> run;
+  uint64_t runSize = 0;
+
+  for (const auto &segment : SegmentStore::listSegments(m_config.path)) {
+    auto large = segment.archived || (segment.size >= m_config.compactSize);
+    if (large || (runSize + segment.size > m_config.segmentSize)) {
+      if (run.size() >= m_config.compactCount) {
+        break;
+      }
+      run.clear();
+      runSize = 0;
+      if (large) {
+        continue;
+      }
+    }
+    run.push_back(segment);
+    runSize += segment.size;
+  }
+
+  if (run.size() < m_config.compactCount) {
+    return false;
+  }
+
+  return merge(run, m_config.blockSize, segments::SealedExtension, false);
+}
+
+bool SegmentCompactor::archiveOnce(void)
+{
+  if (m_config.archiveAge == 0) {
+    return false;
+  }
+
+  auto now = static_cast<uint64_t>(::time(nullptr));
+  auto cutoff = (now > m_config.archiveAge) ? now - m_config.archiveAge : 0;
+  std::vector<SegmentStore::Segment> run;
+  uint64_t runSize = 0;
+
+  // Segments are in sequence order, the first recent one ends the run
+  for (const auto &segment : SegmentStore::listSegments(m_config.path)) {
+    if (segment.archived) {
+      if (!run.empty()) {
+        break;
+      }
+      continue;
+    }
+    if (!run.empty() && (runSize + segment.size > m_config.archiveSize)) {
+      break;
+    }
+
+    SegmentReader reader(segment.path);
+    if (!reader.isOpen() || !reader.isSealed()) {
+      break;
+    }
+    uint64_t lastTime = 0;
+    for (const auto &series : reader.getSeries()) {
+      for (const auto &block : series.blocks) {
+        lastTime = std::max(lastTime, block.lastTime);
+      }
+    }
+    if (lastTime >= cutoff) {
+      break;
+    }
+
+    run.push_back(segment);
+    runSize += segment.size;
+  }
+
+  if (run.empty()) {
+    return false;
+  }
+
+  return merge(run, m_config.archiveBlockSize, segments::ArchiveExtension, true);
+}
+
+bool SegmentCompactor::merge(const std::vector<SegmentStore::Segment> &run,
+                             size_t blockSize,
+                             std::string_view extension,
+                             bool deflate)
+{
+  typedef struct Source {
+    const SegmentReader *reader;
+    const SegmentReader::Series *series;
+  } Source;
+
+  std::vector<std::unique_ptr<SegmentReader>> readers;
+  std::map<std::string, std::vector<Source>> sources;
+  std::string key;
+
+  for (const auto &segment : run) {
+    auto reader = std::make_unique<SegmentReader>(segment.path);
+    if (!reader->isOpen() || !reader->isSealed()) {
+      logError() << "Cannot compact unreadable segment " << segment.path;
+      return false;
+    }
+    for (const auto &series : reader->getSeries()) {
+      key.assign(series.device).append(1, '\0').append(series.source).append(1, '\0');
+      key.append(series.entity).append(1, '\0').append(series.field);
+      sources[key].push_back(Source{.reader = reader.get(), .series = &series});
+    }
+    readers.push_back(std::move(reader));
+  }
+
+  auto firstSeq = run.front().firstSeq;
+  auto lastSeq = run.back().lastSeq;
+  auto sealedName = SegmentStore::getSealedName(firstSeq, lastSeq, extension);
+  auto tmpPath = m_config.path + "/" +
+                 SegmentStore::getSealedName(firstSeq, lastSeq, segments::CompactExtension);
+
+  SegmentFile output;
+  if (!output.create(tmpPath, firstSeq, lastSeq)) {
+    return false;
+  }
+
+  // Segments are in sequence order, so are the blocks of each series
+  SeriesReader::Block block;
+  std::string buffer;
+  for (const auto &[name, list] : sources) {
+    const auto &first = *list.front().series;
+    SeriesReader::Block merged{.type = first.type,
+                               .count = 0,
+                               .firstTime = 0,
+                               .lastTime = 0,
+                               .device = first.device,
+                               .source = first.source,
+                               .entity = first.entity,
+                               .field = first.field,
+                               .samples = {}};
+    auto encoder = std::make_unique<SeriesEncoder>(first.type);
+    encoder->reset();
+
+    auto emit = [&]() -> bool {
+      if (encoder->getCount() == 0) {
+        return true;
+      }
+      merged.type = encoder->getType();
+      merged.count = encoder->getCount();
+      merged.firstTime = encoder->getFirstTime();
+      merged.lastTime = encoder->getLastTime();
+      merged.samples = encoder->view();
+      auto status = output.appendBlock(merged, deflate);
+      encoder->reset();
+      return status;
+    };
+
+    for (const auto &source : list) {
+      if (m_stopping) {
+        output.discard();
+        return false;
+      }
+      if (source.series->type != encoder->getType()) {
+        if (!emit()) {
+          output.discard();
+          return false;
+        }
+        encoder = std::make_unique<SeriesEncoder>(source.series->type);
+        encoder->reset();
+      }
+
+      for (const auto &entry : source.series->blocks) {
+        if (!source.reader->readBlock(entry, block, buffer)) {
+          continue;
+        }
+        SeriesDecoder decoder(block.type, block.samples, block.count);
+        uint64_t time;
+        uint64_t value;
+        while (decoder.next(time, value)) {
+          if (series::BlockHeaderSize + encoder->getBytes() + (series::MaxSampleBits + 7) / 8 >
+              blockSize) {
+            if (!emit()) {
+              output.discard();
+              return false;
+            }
+          }
+          encoder->append(time, value);
+        }
+      }
+    }
+    if (!emit()) {
+      output.discard();
+      return false;
+    }
+  }
+
+  if (!output.seal(m_config.path + "/" + sealedName)) {
+    return false;
+  }
+
+  for (const auto &segment : run) {
+    ::unlink(segment.path.c_str());
+  }
+  logInfo() << (deflate ? "Archived " : "Compacted ") << run.size() << " segments into "
+            << sealedName;
+
+  return true;
+}
+
+} // namespace tkm::reader
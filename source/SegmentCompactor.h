@@ -0,0 +1,84 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SegmentCompactor Class
+ * @details   Merge small sealed segments in a background thread
+ *-
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SegmentStore.h"
+
+namespace tkm::reader
+{
+
+/*
+ * A run of at least CompactCount consecutive sealed segments smaller than
+ * CompactSize is merged into one segment covering their sequence range.
+ * Runs of sealed segments holding no sample newer than ArchiveAge are
+ * merged into an archive segment with large, deflated blocks. Samples of a
+ * series are re-encoded into full blocks. The merged segment is sealed
+ * before the inputs are removed, readers see either.
+ */
+class SegmentCompactor
+{
+public:
+  typedef struct Config {
+    std::string path;
+    uint64_t compactSize;
+    size_t compactCount;
+    uint64_t segmentSize;
+    size_t blockSize;
+    // Seconds, zero disables archiving
+    uint64_t archiveAge;
+    uint64_t archiveSize;
+    size_t archiveBlockSize;
+  } Config;
+
+public:
+  explicit SegmentCompactor(const Config &config)
+  : m_config(config)
+  {
+  }
+  ~SegmentCompactor() { stop(); }
+
+public:
+  SegmentCompactor(SegmentCompactor const &) = delete;
+  void operator=(SegmentCompactor const &) = delete;
+
+  void start(void);
+  void stop(void);
+  // Check for segments to merge, called when a segment is sealed
+  void notify(void);
+
+private:
+  void compactorThread(void);
+  bool compactOnce(void);
+  bool archiveOnce(void);
+  bool merge(const std::vector<SegmentStore::Segment> &run,
+             size_t blockSize,
+             std::string_view extension,
+             bool deflate);
+
+private:
+  Config m_config;
+  std::thread m_compactor{};
+  std::mutex m_wakeLock{};
+  std::condition_variable m_wakeup{};
+  bool m_pending = false;
+  std::atomic<bool> m_stopping{false};
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,253 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SegmentFile Class
+ * @details   Append series blocks to a segment file and seal it
+ *-
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#include "Capture.h"
+#include "Logger.h"
+#include "SegmentFile.h"
+#include "SegmentReader.h"
+
+namespace tkm::reader
+{
+
+using capture::putString;
+using capture::putUint;
+
+bool SegmentFile::create(const std::string &path, uint64_t firstSeq, uint64_t lastSeq)
+{
+  discard();
+
+  m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (m_fd < 0) {
+    logError() << "Cannot create segment file " << path << ": " << strerror(errno);
+    return false;
+  }
+  m_path = path;
+
+  m_buffer.assign(segments::Magic);
+  putUint(m_buffer, segments::Version, sizeof(uint16_t));
+  putUint(m_buffer, firstSeq, sizeof(uint64_t));
+  putUint(m_buffer, lastSeq, sizeof(uint64_t));
+  if (!writeData(m_buffer)) {
+    discard();
+    return false;
+  }
+
+  return true;
+}
+
+bool SegmentFile::recover(const std::string &path)
+{
+  discard();
+
+  SegmentReader reader(path);
+  if (!reader.isOpen()) {
+    return false;
+  }
+
+  m_fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+  if (m_fd < 0) {
+    logError() << "Cannot open segment file " << path << ": " << strerror(errno);
+    return false;
+  }
+  m_path = path;
+  m_size = reader.getValidSize();
+
+  if ((::ftruncate(m_fd, static_cast<off_t>(m_size)) < 0) ||
+      (::lseek(m_fd, static_cast<off_t>(m_size), SEEK_SET) < 0)) {
+    logError() << "Cannot truncate segment file " << path << ": " << strerror(errno);
+    ::close(m_fd);
+    m_fd = -1;
+    return false;
+  }
+
+  SeriesReader::Block block;
+  for (const auto &series : reader.getSeries()) {
+    for (const auto &entry : series.blocks) {
+      if (reader.readBlock(entry, block, m_deflated)) {
+        addIndex(block, entry);
+      }
+    }
+  }
+
+  return true;
+}
+
+bool SegmentFile::appendBlock(const SeriesReader::Block &block, bool deflate)
+{
+  if (m_fd < 0) {
+    return false;
+  }
+
+  auto type = static_cast<uint8_t>(block.type);
+  auto samples = block.samples;
+#ifdef WITH_ZLIB
+  if (deflate) {
+    auto size = ::compressBound(static_cast<uLong>(samples.size()));
+    m_deflated.clear();
+    putUint(m_deflated, samples.size(), sizeof(uint32_t));
+    m_deflated.resize(sizeof(uint32_t) + size);
+    if (::compress2(reinterpret_cast<Bytef *>(m_deflated.data() + sizeof(uint32_t)),
+                    &size,
+                    reinterpret_cast<const Bytef *>(samples.data()),
+                    static_cast<uLong>(samples.size()),
+                    Z_BEST_COMPRESSION) == Z_OK) {
+      m_deflated.resize(sizeof(uint32_t) + size);
+      samples = m_deflated;
+      type |= segments::Deflated;
+    }
+  }
+#else
+  static_cast<void>(deflate);
+#endif
+
+  auto size = series::BlockHeaderSize + 4 * sizeof(uint16_t) + block.device.size() +
+              block.source.size() + block.entity.size() + block.field.size() + samples.size();
+
+  m_buffer.clear();
+  putUint(m_buffer, size, sizeof(uint32_t));
+  putUint(m_buffer, type, sizeof(uint8_t));
+  putUint(m_buffer, block.count, sizeof(uint32_t));
+  putUint(m_buffer, block.firstTime, sizeof(uint64_t));
+  putUint(m_buffer, block.lastTime, sizeof(uint64_t));
+  putString(m_buffer, block.device);
+  putString(m_buffer, block.source);
+  putString(m_buffer, block.entity);
+  putString(m_buffer, block.field);
+  m_buffer.append(samples);
+
+  segments::BlockEntry entry{.offset = m_size,
+                             .size = static_cast<uint32_t>(m_buffer.size()),
+                             .count = block.count,
+                             .firstTime = block.firstTime,
+                             .lastTime = block.lastTime};
+  if (!writeData(m_buffer)) {
+    return false;
+  }
+  addIndex(block, entry);
+
+  return true;
+}
+
+bool SegmentFile::seal(const std::string &sealedPath)
+{
+  if (m_fd < 0) {
+    return false;
+  }
+
+  auto footerOffset = m_size;
+
+  m_buffer.clear();
+  putUint(m_buffer, m_index.size(), sizeof(uint32_t));
+  for (const auto &[key, entry] : m_index) {
+    putString(m_buffer, entry.device);
+    putString(m_buffer, entry.source);
+    putString(m_buffer, entry.entity);
+    putString(m_buffer, entry.field);
+    putUint(m_buffer, static_cast<uint8_t>(entry.type), sizeof(uint8_t));
+    putUint(m_buffer, entry.blocks.size(), sizeof(uint32_t));
+    for (const auto &block : entry.blocks) {
+      putUint(m_buffer, block.offset, sizeof(uint64_t));
+      putUint(m_buffer, block.size, sizeof(uint32_t));
+      putUint(m_buffer, block.count, sizeof(uint32_t));
+      putUint(m_buffer, block.firstTime, sizeof(uint64_t));
+      putUint(m_buffer, block.lastTime, sizeof(uint64_t));
+    }
+  }
+  putUint(m_buffer, footerOffset, sizeof(uint64_t));
+  m_buffer.append(segments::Trailer);
+
+  // The sealed name is only visible once the data is on disk
+  auto sealed = writeData(m_buffer) && (::fdatasync(m_fd) == 0) &&
+                (::rename(m_path.c_str(), sealedPath.c_str()) == 0);
+  if (!sealed) {
+    // Left in place under its open name, the next start recovers it
+    logError() << "Cannot seal segment file " << m_path << ": " << strerror(errno);
+  }
+
+  ::close(m_fd);
+  m_fd = -1;
+  m_path.clear();
+  m_size = 0;
+  m_blocks = 0;
+  m_index.clear();
+
+  return sealed;
+}
+
+void SegmentFile::discard(void)
+{
+  if (m_fd >= 0) {
+    ::close(m_fd);
+    m_fd = -1;
+    ::unlink(m_path.c_str());
+  }
+  m_path.clear();
+  m_size = 0;
+  m_blocks = 0;
+  m_index.clear();
+}
+
+void SegmentFile::addIndex(const SeriesReader::Block &block, const segments::BlockEntry &entry)
+{
+  m_key.assign(block.device).append(1, '\0').append(block.source).append(1, '\0');
+  m_key.append(block.entity).append(1, '\0').append(block.field);
+
+  auto it = m_index.find(m_key);
+  if (it == m_index.end()) {
+    it = m_index
+             .emplace(m_key,
+                      IndexEntry{.device = std::string(block.device),
+                                 .source = std::string(block.source),
+                                 .entity = std::string(block.entity),
+                                 .field = std::string(block.field),
+                                 .type = static_cast<series::Type>(
+                                     static_cast<uint8_t>(block.type) & ~segments::Deflated),
+                                 .blocks = {}})
+             .first;
+  }
+  it->second.blocks.push_back(entry);
+  m_blocks++;
+}
+
+bool SegmentFile::writeData(const std::string &data)
+{
+  size_t offset = 0;
+
+  while (offset < data.size()) {
+    auto written = ::write(m_fd, data.data() + offset, data.size() - offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      logError() << "Segment write failed: " << strerror(errno);
+      // Keep the file made of whole blocks
+      if (::ftruncate(m_fd, static_cast<off_t>(m_size)) == 0) {
+        ::lseek(m_fd, static_cast<off_t>(m_size), SEEK_SET);
+      }
+      return false;
+    }
+    offset += static_cast<size_t>(written);
+  }
+  m_size += data.size();
+
+  return true;
+}
+
+} // namespace tkm::reader
@@ -0,0 +1,77 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SegmentFile Class
+ * @details   Append series blocks to a segment file and seal it
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "SegmentFormat.h"
+#include "SeriesReader.h"
+
+namespace tkm::reader
+{
+
+/*
+ * Blocks are only appended. Sealing writes the footer index of the
+ * blocks and renames the file to its sealed name, readers never see a
+ * sealed segment before it is complete.
+ */
+class SegmentFile
+{
+public:
+  SegmentFile() = default;
+  ~SegmentFile() { discard(); }
+
+public:
+  SegmentFile(SegmentFile const &) = delete;
+  void operator=(SegmentFile const &) = delete;
+
+  bool create(const std::string &path, uint64_t firstSeq, uint64_t lastSeq);
+  // Reopen an open segment left by a crash, a block cut short is dropped
+  bool recover(const std::string &path);
+  // Deflate the bit stream, stored as is without zlib support
+  bool appendBlock(const SeriesReader::Block &block, bool deflate = false);
+  bool seal(const std::string &sealedPath);
+  // Close and remove an unsealed file
+  void discard(void);
+
+  bool isOpen(void) const { return m_fd >= 0; }
+  auto getSize(void) const -> uint64_t { return m_size; }
+  auto getBlockCount(void) const -> size_t { return m_blocks; }
+
+private:
+  typedef struct IndexEntry {
+    std::string device;
+    std::string source;
+    std::string entity;
+    std::string field;
+    series::Type type;
+    std::vector<segments::BlockEntry> blocks;
+  } IndexEntry;
+
+  void addIndex(const SeriesReader::Block &block, const segments::BlockEntry &entry);
+  bool writeData(const std::string &data);
+
+private:
+  int m_fd = -1;
+  std::string m_path{};
+  uint64_t m_size = 0;
+  size_t m_blocks = 0;
+  std::map<std::string, IndexEntry> m_index{};
+  std::string m_key{};
+  std::string m_buffer{};
+  std::string m_deflated{};
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,68 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     Segment file format
+ * @details   Layout of append-only series segment files
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace tkm::reader::segments
+{
+
+/*
+ * A store is a directory of segment files. The segment being written is
+ * '<seq>.open', sealed segments are '<first seq>-<last seq>.seg' (16 hex
+ * digits each) and never change once renamed into place. A compacted
+ * segment covers the sequence range of the segments merged into it, a
+ * segment whose range is covered by another one is ignored by readers.
+ * Segments older than the archive age are merged into archive segments
+ * '<first seq>-<last seq>.arc' with large, deflated blocks, an archive
+ * covers the segments of the same range. Integers are little endian.
+ *
+ *   file header: "TKMSEG" u16 format version, u64 first seq, u64 last seq
+ *   block:       u32 block size (header included), u8 value type,
+ *                u32 sample count, u64 first time, u64 last time,
+ *                device, source, entity, field (u16 size + bytes each),
+ *                sample bit stream (SeriesCodec.h)
+ *   footer:      u32 series count, per series sorted by key:
+ *                  device, source, entity, field, u8 value type,
+ *                  u32 block count, per block: u64 offset, u32 size,
+ *                  u32 sample count, u64 first time, u64 last time
+ *                u64 footer offset, "TKSEGEND"
+ *
+ * Blocks are appended in write order, blocks of a series appear in time
+ * order. An open segment has no footer and is read by walking its blocks,
+ * a block cut short ends the segment. The Deflated flag in the block value
+ * type marks a bit stream stored as u32 stream size followed by the zlib
+ * compressed stream.
+ */
+constexpr std::string_view Magic = "TKMSEG";
+constexpr std::string_view Trailer = "TKSEGEND";
+constexpr uint16_t Version = 1;
+constexpr size_t FileHeaderSize = 24;
+constexpr size_t TrailerSize = 16;
+
+constexpr std::string_view SealedExtension = ".seg";
+constexpr std::string_view OpenExtension = ".open";
+constexpr std::string_view ArchiveExtension = ".arc";
+constexpr std::string_view CompactExtension = ".tmp";
+
+constexpr uint8_t Deflated = 0x80;
+
+typedef struct BlockEntry {
+  uint64_t offset;
+  uint32_t size;
+  uint32_t count;
+  uint64_t firstTime;
+  uint64_t lastTime;
+} BlockEntry;
+
+} // namespace tkm::reader::segments
@@ -0,0 +1,275 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SegmentReader Class
+ * @details   Read memory mapped series segment files
+ *-
+ */
+
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <map>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#include "Capture.h"
+#include "Logger.h"
+#include "SegmentReader.h"
+
+namespace tkm::reader
+{
+
+using capture::getUint;
+
+// Read an u16 sized string, false if it runs past the end
+static bool readString(const char *data, uint64_t end, uint64_t &offset, std::string_view &str)
+{
+  if (offset + sizeof(uint16_t) > end) {
+    return false;
+  }
+  auto size = getUint(data + offset, sizeof(uint16_t));
+  if (offset + sizeof(uint16_t) + size > end) {
+    return false;
+  }
+  str = std::string_view(data + offset + sizeof(uint16_t), size);
+  offset += sizeof(uint16_t) + size;
+  return true;
+}
+
+SegmentReader::SegmentReader(const std::string &path)
+{
+  struct stat st;
+
+  auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    logError() << "Cannot open segment file " << path << ": " << strerror(errno);
+    return;
+  }
+
+  if ((::fstat(fd, &st) < 0) ||
+      (static_cast<uint64_t>(st.st_size) < segments::FileHeaderSize)) {
+    logError() << "Cannot read segment file header from " << path;
+    ::close(fd);
+    return;
+  }
+
+  auto data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    logError() << "Cannot map segment file " << path << ": " << strerror(errno);
+    return;
+  }
+
+  m_data = static_cast<const char *>(data);
+  m_size = static_cast<uint64_t>(st.st_size);
+
+  if ((std::string_view(m_data, segments::Magic.size()) != segments::Magic) ||
+      (getUint(m_data + segments::Magic.size(), sizeof(uint16_t)) != segments::Version)) {
+    logError() << "Not a supported segment file: " << path;
+    ::munmap(const_cast<char *>(m_data), static_cast<size_t>(m_size));
+    m_data = nullptr;
+    m_size = 0;
+    return;
+  }
+  m_firstSeq = getUint(m_data + 8, sizeof(uint64_t));
+  m_lastSeq = getUint(m_data + 16, sizeof(uint64_t));
+
+  if (!readFooter()) {
+    walkBlocks();
+  }
+}
+
+SegmentReader::~SegmentReader()
+{
+  if (m_data != nullptr) {
+    ::munmap(const_cast<char *>(m_data), static_cast<size_t>(m_size));
+  }
+}
+
+bool SegmentReader::readFooter(void)
+{
+  if ((m_size < segments::FileHeaderSize + segments::TrailerSize) ||
+      (std::string_view(m_data + m_size - segments::Trailer.size(), segments::Trailer.size()) !=
+       segments::Trailer)) {
+    return false;
+  }
+
+  auto end = m_size - segments::TrailerSize;
+  auto offset = getUint(m_data + end, sizeof(uint64_t));
+  if ((offset < segments::FileHeaderSize) || (offset + sizeof(uint32_t) > end)) {
+    return false;
+  }
+  auto footerOffset = offset;
+
+  auto count = getUint(m_data + offset, sizeof(uint32_t));
+  offset += sizeof(uint32_t);
+
+  std::vector<Series> series;
+  for (uint64_t i = 0; i < count; i++) {
+    Series entry{};
+    if (!readString(m_data, end, offset, entry.device) ||
+        !readString(m_data, end, offset, entry.source) ||
+        !readString(m_data, end, offset, entry.entity) ||
+        !readString(m_data, end, offset, entry.field) ||
+        (offset + sizeof(uint8_t) + sizeof(uint32_t) > end)) {
+      return false;
+    }
+    entry.type = static_cast<series::Type>(getUint(m_data + offset, sizeof(uint8_t)));
+    auto blocks = getUint(m_data + offset + 1, sizeof(uint32_t));
+    offset += sizeof(uint8_t) + sizeof(uint32_t);
+
+    constexpr size_t entrySize = 32;
+    if (offset + blocks * entrySize > end) {
+      return false;
+    }
+    entry.blocks.reserve(blocks);
+    for (uint64_t j = 0; j < blocks; j++) {
+      segments::BlockEntry block{
+          .offset = getUint(m_data + offset, sizeof(uint64_t)),
+          .size = static_cast<uint32_t>(getUint(m_data + offset + 8, sizeof(uint32_t))),
+          .count = static_cast<uint32_t>(getUint(m_data + offset + 12, sizeof(uint32_t))),
+          .firstTime = getUint(m_data + offset + 16, sizeof(uint64_t)),
+          .lastTime = getUint(m_data + offset + 24, sizeof(uint64_t))};
+      if ((block.offset < segments::FileHeaderSize) || (block.offset + block.size > footerOffset)) {
+        return false;
+      }
+      entry.blocks.push_back(block);
+      offset += entrySize;
+    }
+    series.push_back(std::move(entry));
+  }
+
+  m_series = std::move(series);
+  m_validSize = footerOffset;
+  m_sealed = true;
+
+  return true;
+}
+
+void SegmentReader::walkBlocks(void)
+{
+  std::map<std::string, size_t> index;
+  SeriesReader::Block block;
+  uint64_t offset = segments::FileHeaderSize;
+
+  while (offset + series::BlockHeaderSize <= m_size) {
+    auto size = getUint(m_data + offset, sizeof(uint32_t));
+    if ((size < series::BlockHeaderSize) || (offset + size > m_size)) {
+      break;
+    }
+
+    segments::BlockEntry entry{.offset = offset,
+                               .size = static_cast<uint32_t>(size),
+                               .count = 0,
+                               .firstTime = 0,
+                               .lastTime = 0};
+    if (!readHeader(entry, block)) {
+      break;
+    }
+    entry.count = block.count;
+    entry.firstTime = block.firstTime;
+    entry.lastTime = block.lastTime;
+
+    std::string key;
+    key.append(block.device).append(1, '\0').append(block.source).append(1, '\0');
+    key.append(block.entity).append(1, '\0').append(block.field);
+    auto it = index.find(key);
+    if (it == index.end()) {
+      it = index.emplace(key, m_series.size()).first;
+      m_series.push_back(Series{.device = block.device,
+                                .source = block.source,
+                                .entity = block.entity,
+                                .field = block.field,
+                                .type = static_cast<series::Type>(
+                                    static_cast<uint8_t>(block.type) & ~segments::Deflated),
+                                .blocks = {}});
+    }
+    m_series[it->second].blocks.push_back(entry);
+    offset += size;
+  }
+
+  m_validSize = offset;
+}
+
+auto SegmentReader::findSeries(std::string_view source,
+                               std::string_view entity,
+                               std::string_view field) const -> const Series *
+{
+  for (const auto &entry : m_series) {
+    if ((entry.source == source) && (entry.entity == entity) && (entry.field == field)) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+bool SegmentReader::readBlock(const segments::BlockEntry &entry,
+                              SeriesReader::Block &block,
+                              std::string &buffer) const
+{
+  if (!readHeader(entry, block)) {
+    return false;
+  }
+
+  auto type = static_cast<uint8_t>(block.type);
+  if ((type & segments::Deflated) == 0) {
+    return true;
+  }
+  block.type = static_cast<series::Type>(type & ~segments::Deflated);
+
+#ifdef WITH_ZLIB
+  if (block.samples.size() < sizeof(uint32_t)) {
+    return false;
+  }
+  auto size = static_cast<uLongf>(getUint(block.samples.data(), sizeof(uint32_t)));
+  if (size > series::MaxBlockSize) {
+    return false;
+  }
+  buffer.resize(size);
+  if (::uncompress(reinterpret_cast<Bytef *>(buffer.data()),
+                   &size,
+                   reinterpret_cast<const Bytef *>(block.samples.data() + sizeof(uint32_t)),
+                   static_cast<uLong>(block.samples.size() - sizeof(uint32_t))) != Z_OK) {
+    return false;
+  }
+  buffer.resize(size);
+  block.samples = buffer;
+  return true;
+#else
+  static_cast<void>(buffer);
+  return false;
+#endif
+}
+
+bool SegmentReader::readHeader(const segments::BlockEntry &entry, SeriesReader::Block &block) const
+{
+  if ((entry.size < series::BlockHeaderSize) || (entry.offset + entry.size > m_size)) {
+    return false;
+  }
+
+  auto data = m_data + entry.offset;
+  block.type = static_cast<series::Type>(getUint(data + 4, sizeof(uint8_t)));
+  block.count = static_cast<uint32_t>(getUint(data + 5, sizeof(uint32_t)));
+  block.firstTime = getUint(data + 9, sizeof(uint64_t));
+  block.lastTime = getUint(data + 17, sizeof(uint64_t));
+
+  uint64_t offset = series::BlockHeaderSize;
+  for (auto key : {&block.device, &block.source, &block.entity, &block.field}) {
+    if (!readString(data, entry.size, offset, *key)) {
+      return false;
+    }
+  }
+  block.samples = std::string_view(data + offset, entry.size - offset);
+
+  return true;
+}
+
+} // namespace tkm::reader
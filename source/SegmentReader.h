@@ -0,0 +1,82 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SegmentReader Class
+ * @details   Read memory mapped series segment files
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SegmentFormat.h"
+#include "SeriesFormat.h"
+#include "SeriesReader.h"
+
+namespace tkm::reader
+{
+
+/*
+ * Sealed segments never change, the mapping is read without locks. The
+ * footer index lists the blocks of each series, reading a series only
+ * touches its blocks. Open segments are indexed by walking the blocks.
+ */
+class SegmentReader
+{
+public:
+  typedef struct Series {
+    std::string_view device;
+    std::string_view source;
+    std::string_view entity;
+    std::string_view field;
+    series::Type type;
+    std::vector<segments::BlockEntry> blocks;
+  } Series;
+
+public:
+  explicit SegmentReader(const std::string &path);
+  ~SegmentReader();
+
+public:
+  SegmentReader(SegmentReader const &) = delete;
+  void operator=(SegmentReader const &) = delete;
+
+  bool isOpen(void) const { return m_data != nullptr; }
+  bool isSealed(void) const { return m_sealed; }
+  auto getFirstSeq(void) const -> uint64_t { return m_firstSeq; }
+  auto getLastSeq(void) const -> uint64_t { return m_lastSeq; }
+  // Size of the header and the complete blocks
+  auto getValidSize(void) const -> uint64_t { return m_validSize; }
+  auto getSeries(void) const -> const std::vector<Series> & { return m_series; }
+  // nullptr if the series has no blocks in this segment
+  auto findSeries(std::string_view source, std::string_view entity, std::string_view field) const
+      -> const Series *;
+
+  // Deflated bit streams are inflated into the buffer, others are read in place
+  bool readBlock(const segments::BlockEntry &entry,
+                 SeriesReader::Block &block,
+                 std::string &buffer) const;
+
+private:
+  bool readHeader(const segments::BlockEntry &entry, SeriesReader::Block &block) const;
+  bool readFooter(void);
+  void walkBlocks(void);
+
+private:
+  const char *m_data = nullptr;
+  uint64_t m_size = 0;
+  uint64_t m_validSize = 0;
+  uint64_t m_firstSeq = 0;
+  uint64_t m_lastSeq = 0;
+  bool m_sealed = false;
+  std::vector<Series> m_series{};
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,103 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SegmentStore Class
+ * @details   Sealed segments of a series store directory
+ *-
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+
+#include "SegmentStore.h"
+
+namespace tkm::reader
+{
+
+static bool parseSeq(std::string_view str, uint64_t &seq)
+{
+  if ((str.size() != 16) || (str.find_first_not_of("0123456789abcdef") != str.npos)) {
+    return false;
+  }
+  seq = std::stoull(std::string(str), nullptr, 16);
+  return true;
+}
+
+SegmentStore::SegmentStore(const std::string &path)
+{
+  for (const auto &segment : listSegments(path)) {
+    auto reader = std::make_unique<SegmentReader>(segment.path);
+    if (reader->isOpen() && reader->isSealed()) {
+      m_readers.push_back(std::move(reader));
+      m_segments.push_back(segment);
+    }
+  }
+}
+
+auto SegmentStore::listSegments(const std::string &path) -> std::vector<Segment>
+{
+  std::vector<Segment> segments;
+  std::error_code ec;
+
+  for (const auto &entry : std::filesystem::directory_iterator(path, ec)) {
+    Segment segment{.path = entry.path().string(),
+                    .firstSeq = 0,
+                    .lastSeq = 0,
+                    .size = 0,
+                    .archived = (entry.path().extension() == segments::ArchiveExtension)};
+    if (!parseName(entry.path().filename().string(), segment.firstSeq, segment.lastSeq)) {
+      continue;
+    }
+    segment.size = static_cast<uint64_t>(entry.file_size(ec));
+    if (!ec) {
+      segments.push_back(segment);
+    }
+  }
+
+  // Widest range first for equal starts, so covered segments follow it. An
+  // archive replaces the segment of the same range.
+  std::sort(segments.begin(), segments.end(), [](const Segment &a, const Segment &b) {
+    if (a.firstSeq != b.firstSeq) {
+      return a.firstSeq < b.firstSeq;
+    }
+    if (a.lastSeq != b.lastSeq) {
+      return a.lastSeq > b.lastSeq;
+    }
+    return a.archived && !b.archived;
+  });
+
+  std::vector<Segment> visible;
+  for (const auto &segment : segments) {
+    if (visible.empty() || (segment.lastSeq > visible.back().lastSeq)) {
+      visible.push_back(segment);
+    }
+  }
+
+  return visible;
+}
+
+bool SegmentStore::parseName(std::string_view name, uint64_t &firstSeq, uint64_t &lastSeq)
+{
+  if ((name.size() < 33) || (name[16] != '-') ||
+      ((name.substr(33) != segments::SealedExtension) &&
+       (name.substr(33) != segments::ArchiveExtension))) {
+    return false;
+  }
+  return parseSeq(name.substr(0, 16), firstSeq) && parseSeq(name.substr(17, 16), lastSeq) &&
+         (firstSeq <= lastSeq);
+}
+
+auto SegmentStore::getSealedName(uint64_t firstSeq, uint64_t lastSeq, std::string_view extension)
+    -> std::string
+{
+  char name[40];
+  std::snprintf(name, sizeof(name), "%016" PRIx64 "-%016" PRIx64, firstSeq, lastSeq);
+  return std::string(name).append(extension);
+}
+
+} // namespace tkm::reader
@@ -0,0 +1,70 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SegmentStore Class
+ * @details   Sealed segments of a series store directory
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SegmentReader.h"
+
+namespace tkm::reader
+{
+
+/*
+ * A snapshot of the sealed and archive segments in sequence order.
+ * Segments replaced by a compacted or archive one are left out, the mapped
+ * segments stay readable after the compactor removes their files.
+ */
+class SegmentStore
+{
+public:
+  typedef struct Segment {
+    std::string path;
+    uint64_t firstSeq;
+    uint64_t lastSeq;
+    uint64_t size;
+    bool archived;
+  } Segment;
+
+public:
+  explicit SegmentStore(const std::string &path);
+  ~SegmentStore() = default;
+
+public:
+  SegmentStore(SegmentStore const &) = delete;
+  void operator=(SegmentStore const &) = delete;
+
+  auto getReaders(void) const -> const std::vector<std::unique_ptr<SegmentReader>> &
+  {
+    return m_readers;
+  }
+  // Segment of each reader
+  auto getSegments(void) const -> const std::vector<Segment> & { return m_segments; }
+
+  // Sealed segments of a directory in sequence order, covered ones left out
+  static auto listSegments(const std::string &path) -> std::vector<Segment>;
+  // Sealed and archive segment names
+  static bool parseName(std::string_view name, uint64_t &firstSeq, uint64_t &lastSeq);
+  static auto getSealedName(uint64_t firstSeq,
+                            uint64_t lastSeq,
+                            std::string_view extension = segments::SealedExtension)
+      -> std::string;
+
+private:
+  std::vector<std::unique_ptr<SegmentReader>> m_readers{};
+  std::vector<Segment> m_segments{};
+};
+
+} // namespace tkm::reader
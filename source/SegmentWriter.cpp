@@ -0,0 +1,249 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SegmentWriter Class
+ * @details   Write data records as series blocks to a segment store
+ *-
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+
+#include "../bswinfra/source/Logger.h"
+#include "Application.h"
+#include "Arguments.h"
+#include "SegmentStore.h"
+#include "SegmentWriter.h"
+
+namespace tkm::reader
+{
+
+SegmentWriter *SegmentWriter::instance = nullptr;
+
+static auto getOpenName(uint64_t seq) -> std::string
+{
+  char name[20];
+  std::snprintf(name, sizeof(name), "%016" PRIx64, seq);
+  return std::string(name).append(segments::OpenExtension);
+}
+
+SegmentWriter::SegmentWriter()
+: m_record([this](std::string_view source,
+                  std::string_view entity,
+                  std::string_view field,
+                  series::Type type,
+                  uint64_t time,
+                  uint64_t value) { append(source, entity, field, type, time, value); })
+{
+  if (!App()->getArguments()->hasFor(Arguments::Key::StorePath)) {
+    return;
+  }
+
+  auto outPath = App()->getArguments()->getFor(Arguments::Key::StorePath);
+  std::error_code ec;
+  std::filesystem::create_directories(outPath, ec);
+  if (!std::filesystem::is_directory(outPath)) {
+    logError() << "Cannot create store directory " << outPath;
+    return;
+  }
+  m_path = outPath;
+
+  m_device = App()->getArguments()->getFor(Arguments::Key::Name);
+  m_blockSize = std::clamp(std::stoul(tkmDefaults.getFor(Defaults::Default::StoreBlockSize)),
+                           series::MinBlockSize,
+                           series::MaxBlockSize);
+  m_segmentSize = std::stoull(tkmDefaults.getFor(Defaults::Default::StoreSegmentSize));
+  auto sealInterval = std::stoul(tkmDefaults.getFor(Defaults::Default::StoreSealInterval));
+  // Sample times are in seconds
+  m_sealInterval = sealInterval / 1000000 + 1;
+
+  recover();
+
+  m_compactor = std::make_unique<SegmentCompactor>(SegmentCompactor::Config{
+      .path = m_path,
+      .compactSize = std::stoull(tkmDefaults.getFor(Defaults::Default::StoreCompactSize)),
+      .compactCount = std::max(2ul, std::stoul(tkmDefaults.getFor(
+                                        Defaults::Default::StoreCompactCount))),
+      .segmentSize = m_segmentSize,
+      .blockSize = m_blockSize,
+      .archiveAge = std::stoull(tkmDefaults.getFor(Defaults::Default::StoreArchiveAge)),
+      .archiveSize = std::stoull(tkmDefaults.getFor(Defaults::Default::StoreArchiveSize)),
+      .archiveBlockSize =
+          std::clamp(std::stoul(tkmDefaults.getFor(Defaults::Default::StoreArchiveBlockSize)),
+                     series::MinBlockSize,
+                     series::MaxBlockSize)});
+  m_compactor->start();
+  m_compactor->notify();
+
+  // Bounds the samples lost on a crash and the age of unsealed data
+  m_sealTimer = std::make_shared<Timer>("StoreSealTimer", [this]() {
+    seal();
+    return true;
+  });
+  m_sealTimer->start(sealInterval, true);
+  App()->addEventSource(m_sealTimer);
+
+  // Samples of the open segment are only queried from memory
+  m_hotWindow = std::make_unique<HotWindow>(
+      std::max(std::stoull(tkmDefaults.getFor(Defaults::Default::StoreHotWindow)),
+               static_cast<unsigned long long>(m_sealInterval)));
+
+  std::atexit([]() { SegmentWriter::getInstance()->close(); });
+}
+
+void SegmentWriter::recover(void)
+{
+  std::error_code ec;
+
+  for (const auto &entry : std::filesystem::directory_iterator(m_path, ec)) {
+    auto name = entry.path().filename().string();
+    uint64_t firstSeq = 0;
+    uint64_t lastSeq = 0;
+
+    if (SegmentStore::parseName(name, firstSeq, lastSeq)) {
+      m_seq = std::max(m_seq, lastSeq + 1);
+      continue;
+    }
+
+    // Merge output of an interrupted compaction, the inputs are still there
+    if (entry.path().extension() == segments::CompactExtension) {
+      std::filesystem::remove(entry.path(), ec);
+      continue;
+    }
+
+    if ((entry.path().extension() != segments::OpenExtension) || (name.size() != 21) ||
+        (name.find_first_not_of("0123456789abcdef") != 16)) {
+      continue;
+    }
+    auto seq = static_cast<uint64_t>(std::stoull(name.substr(0, 16), nullptr, 16));
+    m_seq = std::max(m_seq, seq + 1);
+
+    if (!m_segment.recover(entry.path().string())) {
+      continue;
+    }
+    if (m_segment.getBlockCount() == 0) {
+      m_segment.discard();
+      continue;
+    }
+    logWarn() << "Sealing segment left open: " << entry.path().string();
+    m_segment.seal(m_path + "/" + SegmentStore::getSealedName(seq, seq));
+  }
+}
+
+bool SegmentWriter::isEnabledFor(tkm::msg::monitor::Data_What what)
+{
+  if (m_path.empty()) {
+    return false;
+  }
+  return App()->isRecordTypeSelected(what);
+}
+
+void SegmentWriter::append(std::string_view source,
+                           std::string_view entity,
+                           std::string_view field,
+                           series::Type type,
+                           uint64_t time,
+                           uint64_t value)
+{
+  m_hotWindow->append(source, entity, field, type, time, value);
+
+  m_key.assign(source).append(1, '\0').append(entity).append(1, '\0').append(field);
+
+  auto it = m_series.find(m_key);
+  if (it == m_series.end()) {
+    it = m_series
+             .emplace(m_key,
+                      Series{.source = std::string(source),
+                             .entity = std::string(entity),
+                             .field = std::string(field),
+                             .lastTime = time,
+                             .encoder = SeriesEncoder(type)})
+             .first;
+    it->second.encoder.reset();
+  }
+
+  auto &entry = it->second;
+  // Type changes are not sampled
+  if (entry.encoder.getType() != type) {
+    return;
+  }
+
+  if ((entry.encoder.getCount() > 0) &&
+      (series::BlockHeaderSize + entry.encoder.getBytes() + (series::MaxSampleBits + 7) / 8 >
+       m_blockSize)) {
+    writeBlock(entry);
+    if (m_segment.getSize() >= m_segmentSize) {
+      sealSegment();
+    }
+  }
+  entry.encoder.append(time, value);
+  entry.lastTime = time;
+  m_lastTime = std::max(m_lastTime, time);
+}
+
+void SegmentWriter::seal(void)
+{
+  sealSegment();
+
+  // All blocks are written, idle series have nothing left in memory
+  for (auto it = m_series.begin(); it != m_series.end();) {
+    if (it->second.lastTime + m_sealInterval <= m_lastTime) {
+      it = m_series.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void SegmentWriter::sealSegment(void)
+{
+  for (auto &[key, entry] : m_series) {
+    if (entry.encoder.getCount() > 0) {
+      writeBlock(entry);
+    }
+  }
+
+  if (!m_segment.isOpen()) {
+    return;
+  }
+  if (m_segment.seal(m_path + "/" + SegmentStore::getSealedName(m_seq, m_seq))) {
+    m_compactor->notify();
+  }
+  m_seq++;
+}
+
+void SegmentWriter::close(void)
+{
+  seal();
+  m_compactor->stop();
+}
+
+void SegmentWriter::writeBlock(Series &entry)
+{
+  auto &encoder = entry.encoder;
+
+  // The open segment is created with its first block
+  if (!m_segment.isOpen() && !m_segment.create(m_path + "/" + getOpenName(m_seq), m_seq, m_seq)) {
+    encoder.reset();
+    return;
+  }
+
+  m_segment.appendBlock(SeriesReader::Block{.type = encoder.getType(),
+                                            .count = encoder.getCount(),
+                                            .firstTime = encoder.getFirstTime(),
+                                            .lastTime = encoder.getLastTime(),
+                                            .device = m_device,
+                                            .source = entry.source,
+                                            .entity = entry.entity,
+                                            .field = entry.field,
+                                            .samples = encoder.view()});
+  encoder.reset();
+}
+
+} // namespace tkm::reader
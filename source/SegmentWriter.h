@@ -0,0 +1,107 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SegmentWriter Class
+ * @details   Write data records as series blocks to a segment store
+ *-
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <taskmonitor/taskmonitor.h>
+
+#include "HotWindow.h"
+#include "SegmentCompactor.h"
+#include "SegmentFile.h"
+#include "SeriesCodec.h"
+#include "SeriesRecord.h"
+
+#include "../bswinfra/source/Timer.h"
+
+using namespace bswi::event;
+
+namespace tkm::reader
+{
+
+/*
+ * Each series keeps one open block in memory, appended to the open
+ * segment once full. The open segment is sealed when it reaches
+ * StoreSegmentSize, on the seal timer, at session end and at exit. An
+ * open segment left by a crash is sealed on the next start. A series
+ * without samples for a seal interval is dropped on seal, its samples are
+ * all written by then.
+ *
+ * The hot window keeps the samples of at least one seal interval in
+ * memory, samples not sealed yet are always answered from it.
+ */
+class SegmentWriter
+{
+public:
+  static SegmentWriter *getInstance()
+  {
+    return (!instance) ? instance = new SegmentWriter : instance;
+  }
+
+  bool isEnabled(void) { return !m_path.empty(); }
+  bool isEnabledFor(tkm::msg::monitor::Data_What what);
+
+  auto getRecord(void) -> SeriesRecord & { return m_record; }
+  auto getPath(void) const -> const std::string & { return m_path; }
+  auto getHotWindow(void) const -> const HotWindow * { return m_hotWindow.get(); }
+
+  void append(std::string_view source,
+              std::string_view entity,
+              std::string_view field,
+              series::Type type,
+              uint64_t time,
+              uint64_t value);
+  // Write the open blocks, seal the open segment and drop idle series
+  void seal(void);
+  void close(void);
+
+public:
+  SegmentWriter(SegmentWriter const &) = delete;
+  void operator=(SegmentWriter const &) = delete;
+
+private:
+  SegmentWriter();
+  ~SegmentWriter() = default;
+
+  typedef struct Series {
+    std::string source;
+    std::string entity;
+    std::string field;
+    uint64_t lastTime;
+    SeriesEncoder encoder;
+  } Series;
+
+  void recover(void);
+  void writeBlock(Series &series);
+  void sealSegment(void);
+
+private:
+  static SegmentWriter *instance;
+  std::string m_path{};
+  std::string m_device{};
+  size_t m_blockSize = 0;
+  uint64_t m_segmentSize = 0;
+  uint64_t m_seq = 0;
+  uint64_t m_sealInterval = 0;
+  uint64_t m_lastTime = 0;
+  SegmentFile m_segment{};
+  std::unique_ptr<SegmentCompactor> m_compactor = nullptr;
+  std::unique_ptr<HotWindow> m_hotWindow = nullptr;
+  std::map<std::string, Series, std::less<>> m_series{};
+  std::shared_ptr<Timer> m_sealTimer = nullptr;
+  SeriesRecord m_record;
+  std::string m_key{};
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,258 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SeriesCodec Class
+ * @details   Compress time series samples into bit streams
+ *-
+ */
+
+#include <algorithm>
+
+#include "SeriesCodec.h"
+
+namespace tkm::reader
+{
+
+// Delta of delta buckets: prefix size, value bits
+static constexpr struct {
+  unsigned prefix;
+  unsigned bits;
+} dodBuckets[] = {{2, 7}, {3, 9}, {4, 12}};
+
+static auto zigzag(int64_t val) -> uint64_t
+{
+  return (static_cast<uint64_t>(val) << 1) ^ static_cast<uint64_t>(val >> 63);
+}
+
+static auto unzigzag(uint64_t val) -> int64_t
+{
+  return static_cast<int64_t>(val >> 1) ^ -static_cast<int64_t>(val & 1);
+}
+
+void BitWriter::write(uint64_t val, unsigned bits)
+{
+  while (bits > 0) {
+    auto used = static_cast<unsigned>(m_bits % 8);
+    if (used == 0) {
+      m_data.push_back('\0');
+    }
+
+    auto take = std::min(bits, 8 - used);
+    auto chunk = (val >> (bits - take)) & ((1u << take) - 1);
+    m_data.back() = static_cast<char>(static_cast<uint8_t>(m_data.back()) |
+                                      (chunk << (8 - used - take)));
+    bits -= take;
+    m_bits += take;
+  }
+}
+
+auto BitReader::read(unsigned bits) -> uint64_t
+{
+  uint64_t val = 0;
+
+  while (bits > 0) {
+    if (m_pos / 8 >= m_data.size()) {
+      m_overrun = true;
+      return (bits < 64) ? (val << bits) : 0;
+    }
+
+    auto used = static_cast<unsigned>(m_pos % 8);
+    auto take = std::min(bits, 8 - used);
+    auto byte = static_cast<uint8_t>(m_data[m_pos / 8]);
+    val = (val << take) | ((byte >> (8 - used - take)) & ((1u << take) - 1));
+    bits -= take;
+    m_pos += take;
+  }
+
+  return val;
+}
+
+void SeriesEncoder::reset(void)
+{
+  m_bits.reset();
+  m_count = 0;
+  m_firstTime = 0;
+  m_time = 0;
+  m_timeDelta = 0;
+  m_value = 0;
+  m_valueDelta = 0;
+  m_leading = 64;
+  m_trailing = 0;
+}
+
+void SeriesEncoder::append(uint64_t time, uint64_t value)
+{
+  if (m_count == 0) {
+    m_bits.write(time, 64);
+    m_bits.write(value, 64);
+    m_firstTime = time;
+    m_time = time;
+    m_value = value;
+    m_leading = 64;
+    m_count++;
+    return;
+  }
+
+  appendTime(time);
+  if (m_type == series::Type::Double) {
+    appendDouble(value);
+  } else {
+    appendInteger(value);
+  }
+  m_count++;
+}
+
+void SeriesEncoder::appendTime(uint64_t time)
+{
+  // Unsigned arithmetic, deltas of unordered or wrapped times stay defined
+  auto delta = static_cast<int64_t>(time - m_time);
+  auto dod = static_cast<int64_t>(static_cast<uint64_t>(delta) -
+                                  static_cast<uint64_t>(m_timeDelta));
+
+  m_time = time;
+  m_timeDelta = delta;
+
+  if (dod == 0) {
+    m_bits.writeBit(false);
+    return;
+  }
+
+  for (const auto &bucket : dodBuckets) {
+    auto bias = (int64_t(1) << (bucket.bits - 1)) - 1;
+    if ((dod >= -bias) && (dod <= bias + 1)) {
+      // Prefix is bucket.prefix - 1 ones followed by a zero
+      m_bits.write(((1u << bucket.prefix) - 1) & ~1u, bucket.prefix);
+      m_bits.write(static_cast<uint64_t>(dod + bias), bucket.bits);
+      return;
+    }
+  }
+
+  m_bits.write(0xf, 4);
+  m_bits.write(static_cast<uint64_t>(dod), 64);
+}
+
+void SeriesEncoder::appendDouble(uint64_t value)
+{
+  auto xorValue = value ^ m_value;
+  m_value = value;
+
+  if (xorValue == 0) {
+    m_bits.writeBit(false);
+    return;
+  }
+  m_bits.writeBit(true);
+
+  auto leading = std::min(31u, static_cast<unsigned>(__builtin_clzll(xorValue)));
+  auto trailing = static_cast<unsigned>(__builtin_ctzll(xorValue));
+
+  // Reuse the previous window if the meaningful bits fit in it
+  if ((m_leading < 64) && (leading >= m_leading) && (trailing >= m_trailing)) {
+    m_bits.writeBit(false);
+    m_bits.write(xorValue >> m_trailing, 64 - m_leading - m_trailing);
+    return;
+  }
+
+  auto size = 64 - leading - trailing;
+  m_bits.writeBit(true);
+  m_bits.write(leading, 5);
+  m_bits.write(size & 0x3f, 6);
+  m_bits.write(xorValue >> trailing, size);
+  m_leading = leading;
+  m_trailing = trailing;
+}
+
+void SeriesEncoder::appendInteger(uint64_t value)
+{
+  auto delta = static_cast<int64_t>(value - m_value);
+  auto dod = zigzag(static_cast<int64_t>(static_cast<uint64_t>(delta) -
+                                         static_cast<uint64_t>(m_valueDelta)));
+
+  m_value = value;
+  m_valueDelta = delta;
+
+  if (dod == 0) {
+    m_bits.writeBit(false);
+    return;
+  }
+  m_bits.writeBit(true);
+
+  do {
+    auto group = dod & 0x7f;
+    dod >>= 7;
+    m_bits.writeBit(dod != 0);
+    m_bits.write(group, 7);
+  } while (dod != 0);
+}
+
+bool SeriesDecoder::next(uint64_t &time, uint64_t &value)
+{
+  if (m_index >= m_count) {
+    return false;
+  }
+
+  if (m_index++ == 0) {
+    m_time = m_bits.read(64);
+    m_value = m_bits.read(64);
+    m_leading = 64;
+    time = m_time;
+    value = m_value;
+    return !m_bits.isOverrun();
+  }
+
+  int64_t dod = 0;
+  if (m_bits.readBit()) {
+    unsigned prefix = 1;
+    while ((prefix < 4) && m_bits.readBit()) {
+      prefix++;
+    }
+    if (prefix == 4) {
+      dod = static_cast<int64_t>(m_bits.read(64));
+    } else {
+      const auto &bucket = dodBuckets[prefix - 1];
+      auto bias = (int64_t(1) << (bucket.bits - 1)) - 1;
+      dod = static_cast<int64_t>(m_bits.read(bucket.bits)) - bias;
+    }
+  }
+  m_timeDelta = static_cast<int64_t>(static_cast<uint64_t>(m_timeDelta) +
+                                     static_cast<uint64_t>(dod));
+  m_time += static_cast<uint64_t>(m_timeDelta);
+
+  if (m_type == series::Type::Double) {
+    if (m_bits.readBit()) {
+      if (m_bits.readBit()) {
+        m_leading = static_cast<unsigned>(m_bits.read(5));
+        auto size = static_cast<unsigned>(m_bits.read(6));
+        size = (size == 0) ? 64 : size;
+        if (m_leading + size > 64) {
+          return false;
+        }
+        m_trailing = 64 - m_leading - size;
+      }
+      m_value ^= m_bits.read(64 - m_leading - m_trailing) << m_trailing;
+    }
+  } else {
+    uint64_t dodValue = 0;
+    if (m_bits.readBit()) {
+      unsigned shift = 0;
+      bool more = true;
+      while (more && (shift < 70)) {
+        more = m_bits.readBit();
+        dodValue |= m_bits.read(7) << shift;
+        shift += 7;
+      }
+    }
+    m_valueDelta = static_cast<int64_t>(static_cast<uint64_t>(m_valueDelta) +
+                                        static_cast<uint64_t>(unzigzag(dodValue)));
+    m_value += static_cast<uint64_t>(m_valueDelta);
+  }
+
+  time = m_time;
+  value = m_value;
+
+  return !m_bits.isOverrun();
+}
+
+} // namespace tkm::reader
@@ -0,0 +1,139 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SeriesCodec Class
+ * @details   Compress time series samples into bit streams
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "SeriesFormat.h"
+
+namespace tkm::reader
+{
+
+// Bit streams are packed most significant bit first
+class BitWriter
+{
+public:
+  void reset(void)
+  {
+    m_data.clear();
+    m_bits = 0;
+  }
+  void write(uint64_t val, unsigned bits);
+  void writeBit(bool bit) { write(bit ? 1 : 0, 1); }
+
+  auto view(void) const -> std::string_view { return m_data; }
+  auto getBits(void) const -> size_t { return m_bits; }
+
+private:
+  std::string m_data{};
+  size_t m_bits = 0;
+};
+
+class BitReader
+{
+public:
+  explicit BitReader(std::string_view data)
+  : m_data(data)
+  {
+  }
+
+  auto read(unsigned bits) -> uint64_t;
+  bool readBit(void) { return read(1) != 0; }
+  // Reading past the end returns zero bits and sets the overrun flag
+  bool isOverrun(void) const { return m_overrun; }
+
+private:
+  std::string_view m_data;
+  size_t m_pos = 0;
+  bool m_overrun = false;
+};
+
+/*
+ * Gorilla style encoding of (time, value) samples:
+ *
+ *   first sample:  64 bit time, 64 bit value
+ *   time:          delta of delta, '0' if the interval did not change,
+ *                  else a prefix selecting 7, 9, 12 or 64 bits
+ *   double value:  xor with the previous value, '0' if equal, else the
+ *                  meaningful bits within the previous leading/trailing
+ *                  zero window or a new window (5 bit leading, 6 bit size)
+ *   integer value: delta of delta, '0' if unchanged, else '1' and the
+ *                  zigzag value as 7 bit groups with a continuation bit
+ *
+ * Monitor samples are regular and mostly slow moving gauges and counters,
+ * most samples take a few bits.
+ */
+class SeriesEncoder
+{
+public:
+  explicit SeriesEncoder(series::Type type)
+  : m_type(type)
+  {
+  }
+
+  void reset(void);
+  void append(uint64_t time, uint64_t value);
+
+  auto getType(void) const -> series::Type { return m_type; }
+  auto getCount(void) const -> uint32_t { return m_count; }
+  auto getFirstTime(void) const -> uint64_t { return m_firstTime; }
+  auto getLastTime(void) const -> uint64_t { return m_time; }
+  auto getBytes(void) const -> size_t { return (m_bits.getBits() + 7) / 8; }
+  auto view(void) const -> std::string_view { return m_bits.view(); }
+
+private:
+  void appendTime(uint64_t time);
+  void appendDouble(uint64_t value);
+  void appendInteger(uint64_t value);
+
+private:
+  series::Type m_type;
+  BitWriter m_bits{};
+  uint32_t m_count = 0;
+  uint64_t m_firstTime = 0;
+  uint64_t m_time = 0;
+  int64_t m_timeDelta = 0;
+  uint64_t m_value = 0;
+  int64_t m_valueDelta = 0;
+  unsigned m_leading = 0;
+  unsigned m_trailing = 0;
+};
+
+class SeriesDecoder
+{
+public:
+  SeriesDecoder(series::Type type, std::string_view data, uint32_t count)
+  : m_type(type)
+  , m_bits(data)
+  , m_count(count)
+  {
+  }
+
+  // Values are the raw 64 bits, doubles as IEEE 754 bits
+  bool next(uint64_t &time, uint64_t &value);
+
+private:
+  series::Type m_type;
+  BitReader m_bits;
+  uint32_t m_count;
+  uint32_t m_index = 0;
+  uint64_t m_time = 0;
+  int64_t m_timeDelta = 0;
+  uint64_t m_value = 0;
+  int64_t m_valueDelta = 0;
+  unsigned m_leading = 0;
+  unsigned m_trailing = 0;
+};
+
+} // namespace tkm::reader
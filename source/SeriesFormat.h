@@ -0,0 +1,48 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     Series file format
+ * @details   Layout of compressed series block files
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace tkm::reader::series
+{
+
+/*
+ * One file per device '<series dir>/<device>.tks' made of fixed size
+ * blocks. Each block holds samples of a single series, identified by
+ * (device, source, entity, field): source is the record type, entity the
+ * key of a keyed group (pid, core or disk name, empty otherwise) and field
+ * the record field name prefixed by its groups. Integers are little endian.
+ *
+ *   file header: "TKMSER" u16 format version, u32 block size
+ *   block:       u32 used size (0 for a free block), u8 value type,
+ *                u32 sample count, u64 first time, u64 last time,
+ *                device, source, entity, field (u16 size + bytes each),
+ *                sample bit stream (SeriesCodec.h), zero padding
+ *
+ * Times are the data system times. A series continues in a new block when
+ * its block is full, blocks of a series appear in time order.
+ */
+constexpr std::string_view Magic = "TKMSER";
+constexpr uint16_t Version = 1;
+constexpr size_t FileHeaderSize = 12;
+constexpr size_t BlockHeaderSize = 25;
+constexpr size_t MinBlockSize = 256;
+constexpr size_t MaxBlockSize = 1 << 20;
+
+enum class Type : uint8_t { UInt64 = 1, Int64 = 2, Double = 3 };
+
+// Worst case size of a sample after the first one
+constexpr size_t MaxSampleBits = 4 + 64 + 1 + 10 * 8;
+
+} // namespace tkm::reader::series
@@ -0,0 +1,110 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SeriesReader Class
+ * @details   Read blocks of memory mapped series files
+ *-
+ */
+
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Capture.h"
+#include "Logger.h"
+#include "SeriesReader.h"
+
+namespace tkm::reader
+{
+
+using capture::getUint;
+
+SeriesReader::SeriesReader(const std::string &path)
+{
+  struct stat st;
+
+  auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    logError() << "Cannot open series file " << path << ": " << strerror(errno);
+    return;
+  }
+
+  if ((::fstat(fd, &st) < 0) || (static_cast<uint64_t>(st.st_size) < series::FileHeaderSize)) {
+    logError() << "Cannot read series file header from " << path;
+    ::close(fd);
+    return;
+  }
+
+  auto data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    logError() << "Cannot map series file " << path << ": " << strerror(errno);
+    return;
+  }
+
+  m_data = static_cast<const char *>(data);
+  m_size = static_cast<uint64_t>(st.st_size);
+  m_blockSize = getUint(m_data + 8, sizeof(uint32_t));
+
+  if ((std::string_view(m_data, series::Magic.size()) != series::Magic) ||
+      (getUint(m_data + series::Magic.size(), sizeof(uint16_t)) != series::Version) ||
+      (m_blockSize < series::MinBlockSize) || (m_blockSize > series::MaxBlockSize)) {
+    logError() << "Not a supported series file: " << path;
+    ::munmap(const_cast<char *>(m_data), static_cast<size_t>(m_size));
+    m_data = nullptr;
+    m_size = 0;
+    return;
+  }
+
+  // A trailing partial block is ignored
+  m_blockCount = (m_size - series::FileHeaderSize) / m_blockSize;
+}
+
+SeriesReader::~SeriesReader()
+{
+  if (m_data != nullptr) {
+    ::munmap(const_cast<char *>(m_data), static_cast<size_t>(m_size));
+  }
+}
+
+bool SeriesReader::readBlock(size_t index, Block &block) const
+{
+  if (index >= m_blockCount) {
+    return false;
+  }
+
+  auto data = m_data + series::FileHeaderSize + index * m_blockSize;
+  auto used = getUint(data, sizeof(uint32_t));
+  if ((used < series::BlockHeaderSize) || (used > m_blockSize)) {
+    return false;
+  }
+
+  block.type = static_cast<series::Type>(getUint(data + 4, sizeof(uint8_t)));
+  block.count = static_cast<uint32_t>(getUint(data + 5, sizeof(uint32_t)));
+  block.firstTime = getUint(data + 9, sizeof(uint64_t));
+  block.lastTime = getUint(data + 17, sizeof(uint64_t));
+
+  size_t offset = series::BlockHeaderSize;
+  for (auto key : {&block.device, &block.source, &block.entity, &block.field}) {
+    if (offset + sizeof(uint16_t) > used) {
+      return false;
+    }
+    auto size = getUint(data + offset, sizeof(uint16_t));
+    if (offset + sizeof(uint16_t) + size > used) {
+      return false;
+    }
+    *key = std::string_view(data + offset + sizeof(uint16_t), size);
+    offset += sizeof(uint16_t) + size;
+  }
+  block.samples = std::string_view(data + offset, used - offset);
+
+  return true;
+}
+
+} // namespace tkm::reader
@@ -0,0 +1,64 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SeriesReader Class
+ * @details   Read blocks of memory mapped series files
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "SeriesFormat.h"
+
+namespace tkm::reader
+{
+
+/*
+ * Blocks are read in place from the mapping. The block header tells the
+ * series and time range, only the bit streams of the blocks decoded are
+ * loaded.
+ */
+class SeriesReader
+{
+public:
+  typedef struct Block {
+    series::Type type;
+    uint32_t count;
+    uint64_t firstTime;
+    uint64_t lastTime;
+    std::string_view device;
+    std::string_view source;
+    std::string_view entity;
+    std::string_view field;
+    std::string_view samples;
+  } Block;
+
+public:
+  explicit SeriesReader(const std::string &path);
+  ~SeriesReader();
+
+public:
+  SeriesReader(SeriesReader const &) = delete;
+  void operator=(SeriesReader const &) = delete;
+
+  bool isOpen(void) const { return m_data != nullptr; }
+  auto getBlockSize(void) const -> size_t { return m_blockSize; }
+  auto getBlockCount(void) const -> size_t { return m_blockCount; }
+  // False for free or corrupted blocks
+  bool readBlock(size_t index, Block &block) const;
+
+private:
+  const char *m_data = nullptr;
+  uint64_t m_size = 0;
+  size_t m_blockSize = 0;
+  size_t m_blockCount = 0;
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,128 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SeriesRecord Class
+ * @details   Build data records as samples of numeric series
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "SeriesFormat.h"
+
+namespace tkm::reader
+{
+
+/*
+ * Same builder interface as JsonRecord. Every numeric field is a sample of
+ * the (source, entity, field) series: source is the record type, entity
+ * the keyed group key and field the name prefixed by its groups. String
+ * fields are not sampled.
+ */
+class SeriesRecord
+{
+public:
+  using Sample = std::function<void(std::string_view source,
+                                    std::string_view entity,
+                                    std::string_view field,
+                                    series::Type type,
+                                    uint64_t time,
+                                    uint64_t value)>;
+
+  explicit SeriesRecord(Sample sample)
+  : m_sample(std::move(sample))
+  {
+  }
+  ~SeriesRecord() = default;
+
+public:
+  SeriesRecord(SeriesRecord const &) = delete;
+  void operator=(SeriesRecord const &) = delete;
+
+  void begin(const char *type, const std::string &, uint64_t systemTime, uint64_t, uint64_t)
+  {
+    m_source = type;
+    m_time = systemTime;
+    m_entity.clear();
+    m_keyedDepth = SIZE_MAX;
+    m_groups.clear();
+  }
+  void end(void) {}
+
+  void beginGroup(const char *kind) { m_groups.push_back(kind); }
+  void beginGroup(const char *, std::string_view key, const char * = nullptr)
+  {
+    m_entity = key;
+    m_keyedDepth = m_groups.size();
+  }
+  void beginGroup(const char *, int64_t key, const char * = nullptr)
+  {
+    m_entity = std::to_string(key);
+    m_keyedDepth = m_groups.size();
+  }
+  void endGroup(void)
+  {
+    if (m_groups.size() == m_keyedDepth) {
+      m_entity.clear();
+      m_keyedDepth = SIZE_MAX;
+      return;
+    }
+    if (!m_groups.empty()) {
+      m_groups.pop_back();
+    }
+  }
+
+  template <class T>
+  void field(std::string_view name, const T &val)
+  {
+    if constexpr (std::is_same_v<T, bool> || std::is_unsigned_v<T>) {
+      sample(name, series::Type::UInt64, static_cast<uint64_t>(val));
+    } else if constexpr (std::is_integral_v<T>) {
+      sample(name, series::Type::Int64, static_cast<uint64_t>(static_cast<int64_t>(val)));
+    } else if constexpr (std::is_floating_point_v<T>) {
+      auto real = static_cast<double>(val);
+      uint64_t bits;
+      std::memcpy(&bits, &real, sizeof(bits));
+      sample(name, series::Type::Double, bits);
+    }
+  }
+
+private:
+  void sample(std::string_view name, series::Type type, uint64_t value)
+  {
+    auto first = (m_keyedDepth != SIZE_MAX) ? m_keyedDepth : 0;
+    if (first == m_groups.size()) {
+      m_sample(m_source, m_entity, name, type, m_time, value);
+      return;
+    }
+
+    m_field.clear();
+    for (size_t i = first; i < m_groups.size(); i++) {
+      m_field.append(m_groups[i]).push_back('.');
+    }
+    m_field.append(name);
+    m_sample(m_source, m_entity, m_field, type, m_time, value);
+  }
+
+private:
+  Sample m_sample;
+  std::string m_source{};
+  std::string m_entity{};
+  std::string m_field{};
+  uint64_t m_time = 0;
+  size_t m_keyedDepth = SIZE_MAX;
+  std::vector<const char *> m_groups{};
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,242 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SeriesWriter Class
+ * @details   Write data records as compressed series blocks
+ *-
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../bswinfra/source/Logger.h"
+#include "Application.h"
+#include "Arguments.h"
+#include "Capture.h"
+#include "SeriesWriter.h"
+
+namespace tkm::reader
+{
+
+using capture::putString;
+using capture::putUint;
+
+SeriesWriter *SeriesWriter::instance = nullptr;
+
+SeriesWriter::SeriesWriter()
+: m_record([this](std::string_view source,
+                  std::string_view entity,
+                  std::string_view field,
+                  series::Type type,
+                  uint64_t time,
+                  uint64_t value) { append(source, entity, field, type, time, value); })
+{
+  if (!App()->getArguments()->hasFor(Arguments::Key::SeriesPath)) {
+    return;
+  }
+
+  auto outPath = App()->getArguments()->getFor(Arguments::Key::SeriesPath);
+  std::error_code ec;
+  std::filesystem::create_directories(outPath, ec);
+  if (!std::filesystem::is_directory(outPath)) {
+    logError() << "Cannot create series directory " << outPath;
+    return;
+  }
+
+  m_device = App()->getArguments()->getFor(Arguments::Key::Name);
+  m_blockSize = std::clamp(std::stoul(tkmDefaults.getFor(Defaults::Default::SeriesBlockSize)),
+                           series::MinBlockSize,
+                           series::MaxBlockSize);
+  m_idleTime = std::stoul(tkmDefaults.getFor(Defaults::Default::SeriesIdleTime));
+  if (!openFile(outPath + "/" + m_device + ".tks")) {
+    return;
+  }
+
+  std::atexit([]() { SeriesWriter::getInstance()->flush(); });
+}
+
+bool SeriesWriter::openFile(const std::string &path)
+{
+  struct stat st;
+
+  m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if ((m_fd < 0) || (::fstat(m_fd, &st) < 0)) {
+    logError() << "Cannot open series file " << path << ": " << strerror(errno);
+    if (m_fd >= 0) {
+      ::close(m_fd);
+      m_fd = -1;
+    }
+    return false;
+  }
+
+  auto size = static_cast<uint64_t>(st.st_size);
+  if (size == 0) {
+    m_block.assign(series::Magic);
+    putUint(m_block, series::Version, sizeof(uint16_t));
+    putUint(m_block, m_blockSize, sizeof(uint32_t));
+    if (::write(m_fd, m_block.data(), m_block.size()) != static_cast<ssize_t>(m_block.size())) {
+      logError() << "Cannot write series file header " << path << ": " << strerror(errno);
+      ::close(m_fd);
+      m_fd = -1;
+      return false;
+    }
+    return true;
+  }
+
+  // Existing files keep their block size
+  char header[series::FileHeaderSize];
+  if ((::pread(m_fd, header, sizeof(header), 0) != sizeof(header)) ||
+      (std::string_view(header, series::Magic.size()) != series::Magic) ||
+      (capture::getUint(header + series::Magic.size(), sizeof(uint16_t)) != series::Version)) {
+    logError() << "Not a supported series file: " << path;
+    ::close(m_fd);
+    m_fd = -1;
+    return false;
+  }
+  m_blockSize = capture::getUint(header + 8, sizeof(uint32_t));
+  if ((m_blockSize < series::MinBlockSize) || (m_blockSize > series::MaxBlockSize)) {
+    logError() << "Invalid block size in series file: " << path;
+    ::close(m_fd);
+    m_fd = -1;
+    return false;
+  }
+
+  // Drop a block cut short by a crash
+  auto blocks = (size - series::FileHeaderSize) / m_blockSize;
+  auto validSize = series::FileHeaderSize + blocks * m_blockSize;
+  if ((validSize != size) && (::ftruncate(m_fd, static_cast<off_t>(validSize)) < 0)) {
+    logWarn() << "Cannot truncate series file " << path << ": " << strerror(errno);
+  }
+  ::lseek(m_fd, static_cast<off_t>(validSize), SEEK_SET);
+
+  return true;
+}
+
+bool SeriesWriter::isEnabledFor(tkm::msg::monitor::Data_What what)
+{
+  if (m_fd < 0) {
+    return false;
+  }
+  return App()->isRecordTypeSelected(what);
+}
+
+void SeriesWriter::append(std::string_view source,
+                          std::string_view entity,
+                          std::string_view field,
+                          series::Type type,
+                          uint64_t time,
+                          uint64_t value)
+{
+  m_key.assign(source).append(1, '\0').append(entity).append(1, '\0').append(field);
+
+  auto it = m_series.find(m_key);
+  if (it == m_series.end()) {
+    auto headerSize = series::BlockHeaderSize + 4 * sizeof(uint16_t) + m_device.size() +
+                      source.size() + entity.size() + field.size();
+    it = m_series
+             .emplace(m_key,
+                      Series{.source = std::string(source),
+                             .entity = std::string(entity),
+                             .field = std::string(field),
+                             .headerSize = headerSize,
+                             .lastTime = time,
+                             .encoder = SeriesEncoder(type)})
+             .first;
+    it->second.encoder.reset();
+  }
+
+  auto &entry = it->second;
+  // Keys too large for a block and type changes are not sampled
+  if ((entry.headerSize > m_blockSize / 2) || (entry.encoder.getType() != type)) {
+    return;
+  }
+
+  if ((entry.encoder.getCount() > 0) &&
+      (entry.headerSize + entry.encoder.getBytes() + (series::MaxSampleBits + 7) / 8 >
+       m_blockSize)) {
+    writeBlock(entry);
+  }
+  entry.encoder.append(time, value);
+  entry.lastTime = time;
+
+  // Times are data system times, a sweep runs at most once per idle time
+  if (time > m_lastTime) {
+    m_lastTime = time;
+  }
+  if (m_lastTime >= m_nextIdleCheck) {
+    dropIdle();
+    m_nextIdleCheck = m_lastTime + m_idleTime;
+  }
+}
+
+void SeriesWriter::dropIdle(void)
+{
+  for (auto it = m_series.begin(); it != m_series.end();) {
+    auto &entry = it->second;
+    if (entry.lastTime + m_idleTime > m_lastTime) {
+      ++it;
+      continue;
+    }
+    if (entry.encoder.getCount() > 0) {
+      writeBlock(entry);
+    }
+    it = m_series.erase(it);
+  }
+}
+
+void SeriesWriter::flush(void)
+{
+  for (auto &[key, entry] : m_series) {
+    if (entry.encoder.getCount() > 0) {
+      writeBlock(entry);
+    }
+  }
+}
+
+void SeriesWriter::writeBlock(Series &entry)
+{
+  auto &encoder = entry.encoder;
+
+  m_block.clear();
+  putUint(m_block, entry.headerSize + encoder.getBytes(), sizeof(uint32_t));
+  putUint(m_block, static_cast<uint8_t>(encoder.getType()), sizeof(uint8_t));
+  putUint(m_block, encoder.getCount(), sizeof(uint32_t));
+  putUint(m_block, encoder.getFirstTime(), sizeof(uint64_t));
+  putUint(m_block, encoder.getLastTime(), sizeof(uint64_t));
+  putString(m_block, m_device);
+  putString(m_block, entry.source);
+  putString(m_block, entry.entity);
+  putString(m_block, entry.field);
+  m_block.append(encoder.view());
+  m_block.resize(m_blockSize, '\0');
+  encoder.reset();
+
+  auto start = ::lseek(m_fd, 0, SEEK_CUR);
+  size_t offset = 0;
+  while (offset < m_block.size()) {
+    auto written = ::write(m_fd, m_block.data() + offset, m_block.size() - offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      logError() << "Series write failed: " << strerror(errno);
+      // Keep the file made of whole blocks
+      if ((start >= 0) && (::ftruncate(m_fd, start) == 0)) {
+        ::lseek(m_fd, start, SEEK_SET);
+      }
+      return;
+    }
+    offset += static_cast<size_t>(written);
+  }
+}
+
+} // namespace tkm::reader
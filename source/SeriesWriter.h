@@ -0,0 +1,89 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SeriesWriter Class
+ * @details   Write data records as compressed series blocks
+ *-
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <taskmonitor/taskmonitor.h>
+
+#include "SeriesCodec.h"
+#include "SeriesRecord.h"
+
+namespace tkm::reader
+{
+
+/*
+ * Each series keeps one open block in memory, written once full. Open
+ * blocks stay open across sessions and are written at exit, a crash loses
+ * the samples of the open blocks only. A series without samples for the
+ * idle time (ex: an exited process) writes its open block and is dropped.
+ * Files are appended to, a partial block left by a crash is dropped on open.
+ */
+class SeriesWriter
+{
+public:
+  static SeriesWriter *getInstance()
+  {
+    return (!instance) ? instance = new SeriesWriter : instance;
+  }
+
+  bool isEnabled(void) { return (m_fd >= 0); }
+  bool isEnabledFor(tkm::msg::monitor::Data_What what);
+
+  auto getRecord(void) -> SeriesRecord & { return m_record; }
+
+  void append(std::string_view source,
+              std::string_view entity,
+              std::string_view field,
+              series::Type type,
+              uint64_t time,
+              uint64_t value);
+  // Write the open blocks
+  void flush(void);
+
+public:
+  SeriesWriter(SeriesWriter const &) = delete;
+  void operator=(SeriesWriter const &) = delete;
+
+private:
+  SeriesWriter();
+  ~SeriesWriter() = default;
+
+  typedef struct Series {
+    std::string source;
+    std::string entity;
+    std::string field;
+    size_t headerSize;
+    uint64_t lastTime;
+    SeriesEncoder encoder;
+  } Series;
+
+  bool openFile(const std::string &path);
+  void writeBlock(Series &series);
+  void dropIdle(void);
+
+private:
+  static SeriesWriter *instance;
+  int m_fd = -1;
+  size_t m_blockSize = 0;
+  uint64_t m_idleTime = 0;
+  uint64_t m_lastTime = 0;
+  uint64_t m_nextIdleCheck = 0;
+  std::string m_device{};
+  std::map<std::string, Series, std::less<>> m_series{};
+  SeriesRecord m_record;
+  std::string m_key{};
+  std::string m_block{};
+};
+
+} // namespace tkm::reader
@@ -0,0 +1,144 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     StreamTee Class
+ * @details   Zero copy tee of the monitor socket stream to a file
+ *-
+ */
+
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <filesystem>
+#include <poll.h>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "Defaults.h"
+#include "JsonFile.h"
+#include "Logger.h"
+#include "StreamTee.h"
+
+namespace tkm::reader
+{
+
+StreamTee::StreamTee(int sockFd)
+: m_sockFd(sockFd)
+{
+  if ((::pipe2(m_capturePipe, O_NONBLOCK | O_CLOEXEC) < 0) ||
+      (::pipe2(m_readerPipe, O_NONBLOCK | O_CLOEXEC) < 0)) {
+    throw std::runtime_error("Fail to create StreamTee pipes");
+  }
+
+  // Larger pipes take more of the socket buffer per pump
+  auto pipeSize = std::stoi(tkmDefaults.getFor(Defaults::Default::CapturePipeSize));
+  if ((::fcntl(m_capturePipe[1], F_SETPIPE_SZ, pipeSize) < 0) ||
+      (::fcntl(m_readerPipe[1], F_SETPIPE_SZ, pipeSize) < 0)) {
+    logWarn() << "Cannot set capture pipe size: " << strerror(errno);
+  }
+  m_pipeSize = static_cast<size_t>(::fcntl(m_capturePipe[1], F_GETPIPE_SZ));
+
+  m_fileFd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+}
+
+StreamTee::~StreamTee()
+{
+  for (auto fd : {m_capturePipe[0], m_capturePipe[1], m_readerPipe[0], m_readerPipe[1], m_fileFd}) {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+}
+
+void StreamTee::open(const std::string &path)
+{
+  char timeStamp[32];
+  struct tm timeInfo;
+  auto timeNow = ::time(NULL);
+
+  ::gmtime_r(&timeNow, &timeInfo);
+  ::strftime(timeStamp, sizeof(timeStamp), "%Y%m%dT%H%M%SZ", &timeInfo);
+
+  // A connection may end within an envelope, the next one gets its own file
+  auto streamPath = JsonFile::pathWithTag(path, timeStamp, '-');
+  for (int i = 1; std::filesystem::exists(streamPath); i++) {
+    streamPath = JsonFile::pathWithTag(path, std::string(timeStamp) + "-" + std::to_string(i), '-');
+  }
+
+  auto fd = ::open(streamPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    logError() << "Cannot open capture stream file " << streamPath << ": " << strerror(errno);
+    return;
+  }
+
+  ::close(m_fileFd);
+  m_fileFd = fd;
+  logInfo() << "Capture stream to " << streamPath;
+}
+
+auto StreamTee::pump(void) -> tkm::IAsyncEnvelope::Status
+{
+  if (m_pending == 0) {
+    struct pollfd pfd = {.fd = m_sockFd, .events = POLLIN, .revents = 0};
+
+    // The socket is blocking with a receive timeout, only splice when readable
+    auto ready = ::poll(&pfd, 1, 0);
+    if (ready <= 0) {
+      return (ready == 0) ? tkm::IAsyncEnvelope::Status::Again
+                          : tkm::IAsyncEnvelope::Status::Error;
+    }
+
+    m_pending = ::splice(m_sockFd,
+                         nullptr,
+                         m_capturePipe[1],
+                         nullptr,
+                         m_pipeSize,
+                         SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (m_pending == 0) {
+      return tkm::IAsyncEnvelope::Status::EndOfFile;
+    }
+    if (m_pending < 0) {
+      m_pending = 0;
+      return (errno == EAGAIN) ? tkm::IAsyncEnvelope::Status::Again
+                               : tkm::IAsyncEnvelope::Status::Error;
+    }
+  }
+
+  // Duplicate for the envelope reader, then move the same bytes to the file
+  auto teed = ::tee(
+      m_capturePipe[0], m_readerPipe[1], static_cast<size_t>(m_pending), SPLICE_F_NONBLOCK);
+  if (teed <= 0) {
+    return ((teed < 0) && (errno == EAGAIN)) ? tkm::IAsyncEnvelope::Status::Again
+                                             : tkm::IAsyncEnvelope::Status::Error;
+  }
+
+  for (auto left = teed; left > 0;) {
+    auto written = ::splice(
+        m_capturePipe[0], nullptr, m_fileFd, nullptr, static_cast<size_t>(left), SPLICE_F_MOVE);
+    if (written <= 0) {
+      logError() << "Capture stream write failed: " << strerror(errno);
+      if (!discard()) {
+        return tkm::IAsyncEnvelope::Status::Error;
+      }
+      continue;
+    }
+    left -= written;
+  }
+  m_pending -= teed;
+
+  return tkm::IAsyncEnvelope::Status::Ok;
+}
+
+bool StreamTee::discard(void)
+{
+  // Keep reading the monitor, the capture is lost from here on
+  ::close(m_fileFd);
+  m_fileFd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+
+  return (m_fileFd >= 0);
+}
+
+} // namespace tkm::reader
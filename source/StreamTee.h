@@ -0,0 +1,63 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     StreamTee Class
+ * @details   Zero copy tee of the monitor socket stream to a file
+ *-
+ */
+
+#pragma once
+
+#include <string>
+#include <sys/types.h>
+#include <taskmonitor/taskmonitor.h>
+
+namespace tkm::reader
+{
+
+/*
+ * The envelope reader does not read the socket directly but the reader
+ * pipe, fed by pump():
+ *
+ *   socket --splice--> capture pipe --splice--> file
+ *                           |
+ *                          tee
+ *                           v
+ *                      reader pipe --read--> EnvelopeReader
+ *
+ * The bytes never reach user space on the capture path and the file keeps
+ * the libtkm envelope framing as sent by the monitor. The capture pipe is
+ * empty between pumps so tee always duplicates new bytes only.
+ */
+class StreamTee
+{
+public:
+  explicit StreamTee(int sockFd);
+  ~StreamTee();
+
+public:
+  StreamTee(StreamTee const &) = delete;
+  void operator=(StreamTee const &) = delete;
+
+  [[nodiscard]] int getReaderFD() const { return m_readerPipe[0]; }
+  // Open the capture file for a new connection, tagged with the current time
+  void open(const std::string &path);
+  // Move the pending socket bytes to the file and the reader pipe
+  auto pump(void) -> tkm::IAsyncEnvelope::Status;
+
+private:
+  bool discard(void);
+
+private:
+  int m_sockFd = -1;
+  int m_fileFd = -1;
+  int m_capturePipe[2] = {-1, -1};
+  int m_readerPipe[2] = {-1, -1};
+  size_t m_pipeSize = 0;
+  ssize_t m_pending = 0;
+};
+
+} // namespace tkm::reader
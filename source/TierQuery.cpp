@@ -0,0 +1,96 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     TierQuery Class
+ * @details   Query a series across the memory, store and archive tiers
+ *-
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include "SegmentStore.h"
+#include "SeriesCodec.h"
+#include "TierQuery.h"
+
+namespace tkm::reader
+{
+
+bool TierQuery::query(std::string_view source,
+                      std::string_view entity,
+                      std::string_view field,
+                      uint64_t begin,
+                      uint64_t end,
+                      series::Type &type,
+                      const Visit &visit)
+{
+  auto hotStart = std::numeric_limits<uint64_t>::max();
+  bool found = false;
+
+  m_stats = Stats{.hotSamples = 0, .storeSamples = 0, .archiveSamples = 0, .blocksRead = 0};
+
+  if (m_hotWindow != nullptr) {
+    m_hotWindow->getFirstTime(source, entity, field, hotStart);
+  }
+
+  // The disk tiers are only read for the part older than the hot window
+  if ((begin < hotStart) && !m_storePath.empty()) {
+    SegmentStore store(m_storePath);
+    SeriesReader::Block block;
+    std::string buffer;
+    auto diskEnd = std::min(end, hotStart - 1);
+
+    for (size_t i = 0; i < store.getReaders().size(); i++) {
+      const auto &reader = store.getReaders()[i];
+      auto &counter = store.getSegments()[i].archived ? m_stats.archiveSamples
+                                                      : m_stats.storeSamples;
+      auto series = reader->findSeries(source, entity, field);
+      if (series == nullptr) {
+        continue;
+      }
+      type = series->type;
+      found = true;
+
+      for (const auto &entry : series->blocks) {
+        if ((entry.lastTime < begin) || (entry.firstTime > diskEnd)) {
+          continue;
+        }
+        if (!reader->readBlock(entry, block, buffer)) {
+          continue;
+        }
+        m_stats.blocksRead++;
+
+        SeriesDecoder decoder(block.type, block.samples, block.count);
+        uint64_t time;
+        uint64_t value;
+        while (decoder.next(time, value)) {
+          if ((time >= begin) && (time <= diskEnd)) {
+            visit(time, value);
+            counter++;
+          }
+        }
+      }
+    }
+  }
+
+  if ((m_hotWindow != nullptr) && (end >= hotStart)) {
+    found = m_hotWindow->query(source,
+                               entity,
+                               field,
+                               std::max(begin, hotStart),
+                               end,
+                               type,
+                               [this, &visit](uint64_t time, uint64_t value) {
+                                 visit(time, value);
+                                 m_stats.hotSamples++;
+                               }) ||
+            found;
+  }
+
+  return found;
+}
+
+} // namespace tkm::reader
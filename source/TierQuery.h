@@ -0,0 +1,74 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     TierQuery Class
+ * @details   Query a series across the memory, store and archive tiers
+ *-
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "HotWindow.h"
+#include "SeriesFormat.h"
+
+namespace tkm::reader
+{
+
+/*
+ * Samples newer than the first sample of the series in the hot window are
+ * answered from memory only. Older samples come from the sealed and
+ * archive segments of the store, only the blocks of the series in the
+ * time range are read.
+ */
+class TierQuery
+{
+public:
+  using Visit = std::function<void(uint64_t time, uint64_t value)>;
+
+  typedef struct Stats {
+    uint64_t hotSamples;
+    uint64_t storeSamples;
+    uint64_t archiveSamples;
+    uint64_t blocksRead;
+  } Stats;
+
+public:
+  // Either tier can be left out with an empty path or a null window
+  TierQuery(const std::string &storePath, const HotWindow *hotWindow)
+  : m_storePath(storePath)
+  , m_hotWindow(hotWindow)
+  {
+  }
+  ~TierQuery() = default;
+
+public:
+  TierQuery(TierQuery const &) = delete;
+  void operator=(TierQuery const &) = delete;
+
+  // Samples in [begin, end] in time order, false if no tier has the series
+  bool query(std::string_view source,
+             std::string_view entity,
+             std::string_view field,
+             uint64_t begin,
+             uint64_t end,
+             series::Type &type,
+             const Visit &visit);
+
+  // Counters of the last query
+  auto getStats(void) const -> const Stats & { return m_stats; }
+
+private:
+  std::string m_storePath;
+  const HotWindow *m_hotWindow;
+  Stats m_stats{};
+};
+
+} // namespace tkm::reader
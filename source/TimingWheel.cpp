@@ -0,0 +1,112 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     TimingWheel Class
+ * @details   Hierarchical timing wheel of data source request expiries
+ *-
+ */
+
+#include <algorithm>
+
+#include "TimingWheel.h"
+
+namespace tkm::reader
+{
+
+auto TimingWheel::ticksFor(uint64_t usec) const -> uint64_t
+{
+  return (usec + m_resolution - 1) / m_resolution;
+}
+
+void TimingWheel::schedule(const std::shared_ptr<DataSource> &source)
+{
+  if (source->getInterval() == 0) {
+    logInfo() << "Data source " << source->getName() << " disabled";
+    return;
+  }
+
+  // Entries are always placed in the future, the current slot is already processed
+  auto expiry = m_tick + std::max<uint64_t>(ticksFor(source->getOffset()), 1);
+  place(Entry{.expiry = expiry, .generation = source->getGeneration(), .source = source});
+}
+
+void TimingWheel::reschedule(const std::shared_ptr<DataSource> &source, uint64_t delayUs)
+{
+  source->nextGeneration();
+
+  if (source->getInterval() == 0) {
+    return;
+  }
+
+  auto expiry = m_tick + std::max<uint64_t>(ticksFor(delayUs), 1);
+  place(Entry{.expiry = expiry, .generation = source->getGeneration(), .source = source});
+}
+
+void TimingWheel::advanceTo(uint64_t tick, std::vector<std::shared_ptr<DataSource>> &due)
+{
+  while (m_tick < tick) {
+    advance(due);
+  }
+}
+
+void TimingWheel::place(Entry &&entry)
+{
+  auto delta = (entry.expiry > m_tick) ? (entry.expiry - m_tick) : 0;
+
+  if (delta >= WheelSpan) {
+    entry.expiry = m_tick + WheelSpan - 1;
+    delta = WheelSpan - 1;
+  }
+
+  for (unsigned level = 0; level < WheelLevels; level++) {
+    if (delta < (1UL << (WheelBits * (level + 1)))) {
+      auto slot = (entry.expiry >> (WheelBits * level)) & WheelMask;
+      m_wheel[level][slot].push_back(std::move(entry));
+      return;
+    }
+  }
+}
+
+void TimingWheel::advance(std::vector<std::shared_ptr<DataSource>> &due)
+{
+  m_tick++;
+
+  // Cascade higher levels when the lower level completes a full rotation
+  for (unsigned level = WheelLevels - 1; level > 0; level--) {
+    if ((m_tick & ((1UL << (WheelBits * level)) - 1)) != 0) {
+      continue;
+    }
+
+    auto slot = (m_tick >> (WheelBits * level)) & WheelMask;
+    std::vector<Entry> entries;
+    entries.swap(m_wheel[level][slot]);
+    for (auto &entry : entries) {
+      place(std::move(entry));
+    }
+  }
+
+  std::vector<Entry> expired;
+  expired.swap(m_wheel[0][m_tick & WheelMask]);
+  for (auto &entry : expired) {
+    // Entry was replaced by a reschedule
+    if (entry.generation != entry.source->getGeneration()) {
+      continue;
+    }
+
+    // While catching up a source may expire more than once, request it only once
+    if (std::find(due.cbegin(), due.cend(), entry.source) == due.cend()) {
+      due.push_back(entry.source);
+    }
+
+    // The interval is read on each period so runtime changes apply on next request
+    if (entry.source->getInterval() > 0) {
+      entry.expiry += std::max<uint64_t>(ticksFor(entry.source->getInterval()), 1);
+      place(std::move(entry));
+    }
+  }
+}
+
+} // namespace tkm::reader
@@ -0,0 +1,75 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     TimingWheel Class
+ * @details   Hierarchical timing wheel of data source request expiries
+ *-
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "DataSource.h"
+
+namespace tkm::reader
+{
+
+/*
+ * Expiries are counted in ticks of the wheel resolution. The wheel does
+ * not keep time, Scheduler moves it to the tick of the elapsed time.
+ */
+class TimingWheel
+{
+public:
+  explicit TimingWheel(uint64_t resolutionUs)
+  : m_resolution((resolutionUs > 0) ? resolutionUs : 1)
+  {
+  }
+  ~TimingWheel() = default;
+
+public:
+  TimingWheel(TimingWheel const &) = delete;
+  void operator=(TimingWheel const &) = delete;
+
+  // First request is due after the data source offset and repeated at its interval
+  void schedule(const std::shared_ptr<DataSource> &source);
+  // Drop the pending entry of the source and make it due again after delayUs
+  void reschedule(const std::shared_ptr<DataSource> &source, uint64_t delayUs);
+  // Process all ticks up to tick, each due source is added once
+  void advanceTo(uint64_t tick, std::vector<std::shared_ptr<DataSource>> &due);
+
+  auto getResolution(void) const -> uint64_t { return m_resolution; }
+  auto getTick(void) const -> uint64_t { return m_tick; }
+
+private:
+  // 4 levels of 64 slots cover 2^24 ticks (~19 days with 100ms resolution)
+  static constexpr unsigned WheelBits = 6;
+  static constexpr unsigned WheelLevels = 4;
+  static constexpr uint64_t WheelSlots = (1UL << WheelBits);
+  static constexpr uint64_t WheelMask = (WheelSlots - 1);
+  static constexpr uint64_t WheelSpan = (1UL << (WheelBits * WheelLevels));
+
+  typedef struct Entry {
+    uint64_t expiry;
+    uint64_t generation;
+    std::shared_ptr<DataSource> source;
+  } Entry;
+
+  void place(Entry &&entry);
+  void advance(std::vector<std::shared_ptr<DataSource>> &due);
+  auto ticksFor(uint64_t usec) const -> uint64_t;
+
+private:
+  std::array<std::array<std::vector<Entry>, WheelSlots>, WheelLevels> m_wheel{};
+  uint64_t m_resolution = 0;
+  uint64_t m_tick = 0;
+};
+
+} // namespace tkm::reader
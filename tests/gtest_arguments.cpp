@@ -0,0 +1,76 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     Arguments Unit Tests
+ * @details   GTests for the reader arguments and their defaults
+ *-
+ */
+
+#include <string>
+
+#include "../source/Arguments.h"
+#include "Defaults.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+class GTestArguments : public ::testing::Test
+{
+};
+
+TEST_F(GTestArguments, toNumber)
+{
+  uint64_t value = 0;
+
+  EXPECT_TRUE(Arguments::toNumber("0", value));
+  EXPECT_EQ(value, 0u);
+  EXPECT_TRUE(Arguments::toNumber("1500", value));
+  EXPECT_EQ(value, 1500u);
+  EXPECT_TRUE(Arguments::toNumber("18446744073709551615", value));
+  EXPECT_EQ(value, UINT64_MAX);
+
+  for (const auto *invalid :
+       {"", "-1", "+1", " 1", "1 ", "1s", "1.5", "0x10", "18446744073709551616"}) {
+    EXPECT_FALSE(Arguments::toNumber(invalid, value)) << invalid;
+  }
+}
+
+TEST_F(GTestArguments, defaults)
+{
+  Arguments arguments({{Arguments::Key::BurstInterval, "750"}});
+
+  EXPECT_TRUE(arguments.hasFor(Arguments::Key::BurstInterval));
+  EXPECT_EQ(arguments.getFor(Arguments::Key::BurstInterval), "750");
+  EXPECT_FALSE(arguments.hasFor(Arguments::Key::BurstRules));
+  EXPECT_EQ(arguments.getFor(Arguments::Key::BurstRules),
+            tkmDefaults.getFor(Defaults::Default::BurstRules));
+
+  // Options given on the command line are not replaced
+  arguments.setFor(Arguments::Key::BurstInterval, "2000");
+  EXPECT_EQ(arguments.getFor(Arguments::Key::BurstInterval), "750");
+}
+
+TEST_F(GTestArguments, burstIntervalDefaults)
+{
+  uint64_t interval = 0;
+  uint64_t minInterval = 0;
+  uint64_t duration = 0;
+
+  // The default interval passes the command line check of --burst-interval
+  ASSERT_TRUE(Arguments::toNumber(tkmDefaults.getFor(Defaults::Default::BurstInterval), interval));
+  ASSERT_TRUE(
+      Arguments::toNumber(tkmDefaults.getFor(Defaults::Default::BurstMinInterval), minInterval));
+  ASSERT_TRUE(Arguments::toNumber(tkmDefaults.getFor(Defaults::Default::BurstDuration), duration));
+  EXPECT_GE(interval, minInterval);
+  EXPECT_LE(interval, duration / 1000);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,93 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     Capture Format Unit Tests
+ * @details   GTests for the capture file integer and string encoding
+ *-
+ */
+
+#include <limits>
+#include <string>
+
+#include "../source/Capture.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+class GTestCapture : public ::testing::Test
+{
+};
+
+TEST_F(GTestCapture, littleEndian)
+{
+  string out;
+
+  capture::putUint(out, 0x0102, sizeof(uint16_t));
+  capture::putUint(out, 0x01020304, sizeof(uint32_t));
+  ASSERT_EQ(out.size(), 6u);
+  EXPECT_EQ(out, string("\x02\x01\x04\x03\x02\x01", 6));
+}
+
+TEST_F(GTestCapture, uintRoundTrip)
+{
+  const uint64_t values[] = {0, 1, 0xff, 0x100, 0xffffffff, 0x123456789abcdef0,
+                             numeric_limits<uint64_t>::max()};
+  string out;
+
+  for (auto val : values) {
+    capture::putUint(out, val, sizeof(uint64_t));
+  }
+  ASSERT_EQ(out.size(), sizeof(values));
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    EXPECT_EQ(capture::getUint(out.data() + i * sizeof(uint64_t), sizeof(uint64_t)), values[i]);
+  }
+
+  // Only the low bytes are written for smaller sizes
+  out.clear();
+  capture::putUint(out, 0x123456789, sizeof(uint32_t));
+  EXPECT_EQ(capture::getUint(out.data(), sizeof(uint32_t)), 0x23456789u);
+}
+
+TEST_F(GTestCapture, frameHeaderLayout)
+{
+  string out;
+
+  // Frame header as written by CaptureWriter
+  capture::putUint(out, 42, sizeof(uint32_t));
+  capture::putUint(out, static_cast<uint64_t>(capture::FrameType::Envelope), sizeof(uint8_t));
+  capture::putUint(out, 1650000000123456, sizeof(uint64_t));
+  ASSERT_EQ(out.size(), capture::FrameHeaderSize);
+
+  EXPECT_EQ(capture::getUint(out.data(), sizeof(uint32_t)), 42u);
+  EXPECT_EQ(static_cast<capture::FrameType>(capture::getUint(out.data() + 4, sizeof(uint8_t))),
+            capture::FrameType::Envelope);
+  EXPECT_EQ(capture::getUint(out.data() + 5, sizeof(uint64_t)), 1650000000123456u);
+}
+
+TEST_F(GTestCapture, putString)
+{
+  string out;
+
+  capture::putString(out, "device");
+  capture::putString(out, "");
+  ASSERT_EQ(out.size(), 2 + 6 + 2);
+  EXPECT_EQ(capture::getUint(out.data(), sizeof(uint16_t)), 6u);
+  EXPECT_EQ(out.substr(2, 6), "device");
+  EXPECT_EQ(capture::getUint(out.data() + 8, sizeof(uint16_t)), 0u);
+
+  // Strings longer than the u16 size prefix are cut
+  out.clear();
+  capture::putString(out, string(UINT16_MAX + 10, 'x'));
+  EXPECT_EQ(capture::getUint(out.data(), sizeof(uint16_t)), UINT16_MAX);
+  EXPECT_EQ(out.size(), sizeof(uint16_t) + UINT16_MAX);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
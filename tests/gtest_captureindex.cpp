@@ -0,0 +1,317 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     CaptureIndex Unit Tests
+ * @details   GTests for the sparse capture file index and the mapped capture
+ *-
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <taskmonitor/taskmonitor.h>
+#include <utility>
+#include <vector>
+
+#include "../source/Capture.h"
+#include "../source/CaptureIndex.h"
+#include "../source/CaptureMap.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+typedef pair<size_t, size_t> Range;
+
+class GTestCaptureIndex : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_path = ::testing::TempDir() + "gtest_captureindex.cap";
+    m_file.assign(capture::Magic);
+    capture::putUint(m_file, capture::Version, sizeof(uint16_t));
+    m_offsets.clear();
+  }
+  void TearDown() override
+  {
+    remove(m_path.c_str());
+    remove((m_path + ".idx").c_str());
+  }
+
+  // Append a frame as CaptureWriter does and keep its offset
+  void addFrame(capture::FrameType type, uint64_t receiveTime, const string &payload)
+  {
+    m_offsets.push_back(m_file.size());
+    capture::putUint(m_file, payload.size(), sizeof(uint32_t));
+    capture::putUint(m_file, static_cast<uint64_t>(type), sizeof(uint8_t));
+    capture::putUint(m_file, receiveTime, sizeof(uint64_t));
+    m_file.append(payload);
+  }
+
+  void addEnvelopes(size_t count, uint64_t receiveTime)
+  {
+    for (size_t i = 0; i < count; i++) {
+      addFrame(capture::FrameType::Envelope, receiveTime, "envelope");
+    }
+  }
+
+  // Envelope holding a data message, as received from the monitor
+  void addData(uint64_t receiveTime, uint64_t systemTime, uint64_t monotonicTime)
+  {
+    tkm::msg::monitor::Data data;
+    tkm::msg::monitor::Message msg;
+    tkm::msg::Envelope envelope;
+
+    data.set_system_time_sec(systemTime);
+    data.set_monotonic_time_sec(monotonicTime);
+    msg.set_type(tkm::msg::monitor::Message_Type_Data);
+    msg.mutable_payload()->PackFrom(data);
+    envelope.mutable_mesg()->PackFrom(msg);
+    addFrame(capture::FrameType::Envelope, receiveTime, envelope.SerializeAsString());
+  }
+
+  void save(void)
+  {
+    ofstream out(m_path, ofstream::binary | ofstream::trunc);
+    out.write(m_file.data(), static_cast<streamsize>(m_file.size()));
+  }
+
+protected:
+  string m_path;
+  string m_file;
+  vector<uint64_t> m_offsets;
+};
+
+TEST_F(GTestCaptureIndex, entryEveryInterval)
+{
+  addFrame(capture::FrameType::Session, 0, "session");
+  addEnvelopes(CaptureIndex::Interval * 2 + 1, 1000000);
+  save();
+
+  CaptureIndex index(m_path);
+  ASSERT_TRUE(index.open());
+
+  const auto &entries = index.getEntries();
+  ASSERT_EQ(entries.size(), 3u);
+  for (size_t i = 0; i < entries.size(); i++) {
+    EXPECT_EQ(entries[i].offset, m_offsets[1 + i * CaptureIndex::Interval]);
+    EXPECT_EQ(entries[i].receiveTime, 1000000u);
+    EXPECT_EQ(entries[i].sessionOffset, m_offsets[0]);
+  }
+
+  // Each entry ends where the next one starts, the last one at the capture end
+  EXPECT_EQ(index.endOffset(0), entries[1].offset);
+  EXPECT_EQ(index.endOffset(1), entries[2].offset);
+  EXPECT_EQ(index.endOffset(2), m_file.size());
+}
+
+TEST_F(GTestCaptureIndex, sessionOffsets)
+{
+  addEnvelopes(1, 1);
+  addFrame(capture::FrameType::Session, 0, "first");
+  addEnvelopes(CaptureIndex::Interval, 2);
+  addFrame(capture::FrameType::Session, 0, "second");
+  addEnvelopes(1, 3);
+  save();
+
+  CaptureIndex index(m_path);
+  ASSERT_TRUE(index.open());
+
+  // No session before the first entry, then the one in effect at each entry
+  const auto &entries = index.getEntries();
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[0].sessionOffset, 0u);
+  EXPECT_EQ(entries[1].sessionOffset, m_offsets[1]);
+}
+
+TEST_F(GTestCaptureIndex, reuseAndRebuild)
+{
+  addEnvelopes(CaptureIndex::Interval, 1);
+  save();
+
+  {
+    CaptureIndex index(m_path);
+    ASSERT_TRUE(index.open());
+    EXPECT_EQ(index.getEntries().size(), 1u);
+  }
+  ASSERT_TRUE(filesystem::exists(m_path + ".idx"));
+
+  // An up to date index is loaded as saved, not rebuilt from the capture
+  m_file[m_offsets[0] + 4] = static_cast<char>(capture::FrameType::Session);
+  save();
+  {
+    CaptureIndex index(m_path);
+    ASSERT_TRUE(index.open());
+    ASSERT_EQ(index.getEntries().size(), 1u);
+    EXPECT_EQ(index.getEntries()[0].offset, capture::FileHeaderSize);
+    EXPECT_EQ(index.endOffset(0), m_file.size());
+  }
+
+  // Appending to the capture makes the index stale
+  m_file[m_offsets[0] + 4] = static_cast<char>(capture::FrameType::Envelope);
+  addEnvelopes(1, 2);
+  save();
+  {
+    CaptureIndex index(m_path);
+    ASSERT_TRUE(index.open());
+    ASSERT_EQ(index.getEntries().size(), 2u);
+    EXPECT_EQ(index.getEntries()[1].offset, m_offsets.back());
+    EXPECT_EQ(index.endOffset(1), m_file.size());
+  }
+}
+
+TEST_F(GTestCaptureIndex, incompleteLastFrame)
+{
+  addEnvelopes(CaptureIndex::Interval, 1);
+  addEnvelopes(1, 2);
+  m_file.resize(m_file.size() - 1);
+  save();
+
+  // The incomplete frame still starts an entry, readers stop at its end
+  CaptureIndex index(m_path);
+  ASSERT_TRUE(index.open());
+  ASSERT_EQ(index.getEntries().size(), 2u);
+  EXPECT_EQ(index.endOffset(1), m_file.size());
+}
+
+TEST_F(GTestCaptureIndex, notACapture)
+{
+  m_file.assign("not a capture file");
+  save();
+
+  CaptureIndex index(m_path);
+  EXPECT_FALSE(index.open());
+}
+
+TEST_F(GTestCaptureIndex, entryEveryIntervalTime)
+{
+  const uint64_t second = 1000000;
+
+  addData(100 * second, 1000, 10);
+  addData(105 * second, 1005, 15);
+  addData((100 + CaptureIndex::IntervalTime) * second, 1010, 20);
+  addData((100 + CaptureIndex::IntervalTime * 3) * second, 1030, 40);
+  save();
+
+  CaptureIndex index(m_path);
+  ASSERT_TRUE(index.open());
+
+  const auto &entries = index.getEntries();
+  ASSERT_EQ(entries.size(), 3u);
+  EXPECT_EQ(entries[0].offset, m_offsets[0]);
+  EXPECT_EQ(entries[1].offset, m_offsets[2]);
+  EXPECT_EQ(entries[2].offset, m_offsets[3]);
+  EXPECT_EQ(entries[1].receiveTime, (100 + CaptureIndex::IntervalTime) * second);
+}
+
+TEST_F(GTestCaptureIndex, dataTimes)
+{
+  // Entries take the times of their first data message, the ones without
+  // any keep the times of the previous entry
+  addEnvelopes(1, 1);
+  addData(2, 1000, 10);
+  addEnvelopes(CaptureIndex::Interval - 1, 3);
+  addEnvelopes(CaptureIndex::Interval, 4);
+  addEnvelopes(1, 5);
+  addData(6, 2000, 20);
+  save();
+
+  CaptureIndex index(m_path);
+  ASSERT_TRUE(index.open());
+
+  const auto &entries = index.getEntries();
+  ASSERT_EQ(entries.size(), 3u);
+  EXPECT_EQ(entries[0].systemTime, 1000u);
+  EXPECT_EQ(entries[0].monotonicTime, 10u);
+  EXPECT_EQ(entries[1].systemTime, 1000u);
+  EXPECT_EQ(entries[1].monotonicTime, 10u);
+  EXPECT_EQ(entries[2].systemTime, 2000u);
+  EXPECT_EQ(entries[2].monotonicTime, 20u);
+}
+
+TEST_F(GTestCaptureIndex, findRange)
+{
+  const uint64_t second = 1000000;
+
+  for (uint64_t i = 0; i < 5; i++) {
+    addData(i * CaptureIndex::IntervalTime * second, 1000 + i * 100, i);
+  }
+  save();
+
+  CaptureIndex index(m_path);
+  ASSERT_TRUE(index.open());
+  ASSERT_EQ(index.getEntries().size(), 5u);
+
+  // Entries hold system times 1000, 1100, ..., 1400
+  EXPECT_EQ(index.findRange(1000, 1400), Range(0, 5));
+  EXPECT_EQ(index.findRange(1150, 1250), Range(1, 3));
+  EXPECT_EQ(index.findRange(1200, 1200), Range(2, 3));
+  EXPECT_EQ(index.findRange(0, 999), Range(0, 0));
+  EXPECT_EQ(index.findRange(2000, 3000), Range(4, 5));
+}
+
+TEST_F(GTestCaptureIndex, mapFrames)
+{
+  addFrame(capture::FrameType::Session, 0, "session");
+  addFrame(capture::FrameType::Envelope, 1, "first");
+  addFrame(capture::FrameType::Envelope, 2, "second");
+  save();
+
+  CaptureMap map(m_path);
+  ASSERT_TRUE(map.isOpen());
+  EXPECT_EQ(map.getSize(), m_file.size());
+
+  CaptureMap::Frame frame;
+  auto next = map.frameAt(m_offsets[1], frame);
+  EXPECT_EQ(next, m_offsets[2]);
+  EXPECT_EQ(frame.type, capture::FrameType::Envelope);
+  EXPECT_EQ(frame.receiveTime, 1u);
+  EXPECT_EQ(frame.payload, "first");
+
+  next = map.frameAt(m_offsets[0], frame);
+  EXPECT_EQ(frame.type, capture::FrameType::Session);
+  EXPECT_EQ(frame.payload, "session");
+  next = map.frameAt(next, frame);
+  next = map.frameAt(next, frame);
+  EXPECT_EQ(frame.payload, "second");
+  EXPECT_EQ(next, m_file.size());
+  EXPECT_EQ(map.frameAt(next, frame), 0u);
+}
+
+TEST_F(GTestCaptureIndex, mapIncompleteFrame)
+{
+  addFrame(capture::FrameType::Envelope, 1, "complete");
+  addFrame(capture::FrameType::Envelope, 2, "incomplete");
+  m_file.resize(m_file.size() - 1);
+  save();
+
+  CaptureMap map(m_path);
+  ASSERT_TRUE(map.isOpen());
+
+  CaptureMap::Frame frame;
+  EXPECT_EQ(map.frameAt(m_offsets[0], frame), m_offsets[1]);
+  EXPECT_EQ(map.frameAt(m_offsets[1], frame), 0u);
+  EXPECT_EQ(map.frameAt(m_file.size() - 2, frame), 0u);
+}
+
+TEST_F(GTestCaptureIndex, mapNotACapture)
+{
+  m_file.assign("TKMCAP");
+  capture::putUint(m_file, capture::Version + 1, sizeof(uint16_t));
+  save();
+
+  CaptureMap::Frame frame;
+  CaptureMap map(m_path);
+  EXPECT_FALSE(map.isOpen());
+  EXPECT_EQ(map.frameAt(capture::FileHeaderSize, frame), 0u);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
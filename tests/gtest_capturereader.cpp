@@ -0,0 +1,172 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     CaptureReader Unit Tests
+ * @details   GTests for reading raw envelope capture files
+ *-
+ */
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../source/CaptureReader.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+class GTestCaptureReader : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_path = ::testing::TempDir() + "gtest_capturereader.cap";
+    m_file.assign(capture::Magic);
+    capture::putUint(m_file, capture::Version, sizeof(uint16_t));
+  }
+  void TearDown() override { remove(m_path.c_str()); }
+
+  // Append a frame as CaptureWriter does
+  void addFrame(capture::FrameType type, uint64_t receiveTime, const string &payload)
+  {
+    capture::putUint(m_file, payload.size(), sizeof(uint32_t));
+    capture::putUint(m_file, static_cast<uint64_t>(type), sizeof(uint8_t));
+    capture::putUint(m_file, receiveTime, sizeof(uint64_t));
+    m_file.append(payload);
+  }
+
+  void addSession(const vector<string> &fields)
+  {
+    string payload;
+    for (const auto &field : fields) {
+      capture::putString(payload, field);
+    }
+    addFrame(capture::FrameType::Session, 0, payload);
+  }
+
+  void save(void)
+  {
+    ofstream out(m_path, ofstream::binary | ofstream::trunc);
+    out.write(m_file.data(), static_cast<streamsize>(m_file.size()));
+  }
+
+protected:
+  string m_path;
+  string m_file;
+};
+
+TEST_F(GTestCaptureReader, readFrames)
+{
+  addSession({"session", "device", "1.0", "1.1"});
+  addFrame(capture::FrameType::Envelope, 1000000, "first");
+  addFrame(capture::FrameType::Envelope, 2000000, "");
+  addFrame(capture::FrameType::Envelope, 3000000, string(100000, 'x'));
+  save();
+
+  CaptureReader reader(m_path);
+  ASSERT_TRUE(reader.isOpen());
+
+  CaptureReader::Frame frame;
+  vector<string> fields;
+  ASSERT_EQ(reader.next(frame), CaptureReader::Status::Ok);
+  EXPECT_EQ(frame.type, capture::FrameType::Session);
+  ASSERT_TRUE(CaptureReader::parseSession(frame.payload, fields));
+  EXPECT_EQ(fields, (vector<string>{"session", "device", "1.0", "1.1"}));
+
+  ASSERT_EQ(reader.next(frame), CaptureReader::Status::Ok);
+  EXPECT_EQ(frame.type, capture::FrameType::Envelope);
+  EXPECT_EQ(frame.receiveTime, 1000000u);
+  EXPECT_EQ(frame.payload, "first");
+
+  ASSERT_EQ(reader.next(frame), CaptureReader::Status::Ok);
+  EXPECT_EQ(frame.receiveTime, 2000000u);
+  EXPECT_TRUE(frame.payload.empty());
+
+  ASSERT_EQ(reader.next(frame), CaptureReader::Status::Ok);
+  EXPECT_EQ(frame.payload, string(100000, 'x'));
+
+  EXPECT_EQ(reader.next(frame), CaptureReader::Status::EndOfFile);
+}
+
+TEST_F(GTestCaptureReader, incompleteFrameEndsCapture)
+{
+  addFrame(capture::FrameType::Envelope, 1, "complete");
+  addFrame(capture::FrameType::Envelope, 2, "incomplete");
+  m_file.resize(m_file.size() - 3);
+  save();
+
+  CaptureReader reader(m_path);
+  CaptureReader::Frame frame;
+  ASSERT_EQ(reader.next(frame), CaptureReader::Status::Ok);
+  EXPECT_EQ(frame.payload, "complete");
+  EXPECT_EQ(reader.next(frame), CaptureReader::Status::EndOfFile);
+}
+
+TEST_F(GTestCaptureReader, incompleteFrameHeaderEndsCapture)
+{
+  addFrame(capture::FrameType::Envelope, 1, "complete");
+  m_file.append(capture::FrameHeaderSize - 1, '\0');
+  save();
+
+  CaptureReader reader(m_path);
+  CaptureReader::Frame frame;
+  ASSERT_EQ(reader.next(frame), CaptureReader::Status::Ok);
+  EXPECT_EQ(reader.next(frame), CaptureReader::Status::EndOfFile);
+}
+
+TEST_F(GTestCaptureReader, corruptFrameSize)
+{
+  // A size beyond the limit is an error, even if the file claims to hold it
+  capture::putUint(m_file, capture::MaxFrameSize + 1, sizeof(uint32_t));
+  capture::putUint(m_file, static_cast<uint64_t>(capture::FrameType::Envelope), sizeof(uint8_t));
+  capture::putUint(m_file, 1, sizeof(uint64_t));
+  m_file.append(16, 'x');
+  save();
+
+  CaptureReader reader(m_path);
+  CaptureReader::Frame frame;
+  EXPECT_EQ(reader.next(frame), CaptureReader::Status::Error);
+  EXPECT_TRUE(frame.payload.empty());
+}
+
+TEST_F(GTestCaptureReader, unsupportedVersion)
+{
+  m_file.assign(capture::Magic);
+  capture::putUint(m_file, capture::Version + 1, sizeof(uint16_t));
+  addFrame(capture::FrameType::Envelope, 1, "payload");
+  save();
+
+  CaptureReader reader(m_path);
+  CaptureReader::Frame frame;
+  EXPECT_FALSE(reader.isOpen());
+  EXPECT_EQ(reader.next(frame), CaptureReader::Status::Error);
+}
+
+TEST_F(GTestCaptureReader, parseSession)
+{
+  string payload;
+  vector<string> fields;
+
+  for (const auto &field : {"session", "device", "1.0"}) {
+    capture::putString(payload, field);
+  }
+  EXPECT_FALSE(CaptureReader::parseSession(payload, fields));
+
+  capture::putString(payload, "1.1");
+  ASSERT_TRUE(CaptureReader::parseSession(payload, fields));
+  EXPECT_EQ(fields.size(), static_cast<size_t>(capture::SessionField::Count));
+
+  // A field size past the payload end
+  payload.resize(payload.size() - 1);
+  EXPECT_FALSE(CaptureReader::parseSession(payload, fields));
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,282 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     ColumnTable Unit Tests
+ * @details   GTests for row group encoding read back by ColumnReader
+ *-
+ */
+
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "../source/ColumnReader.h"
+#include "../source/ColumnTable.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+class GTestColumnTable : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_path = ::testing::TempDir() + "gtest_columntable.col";
+    m_file.assign(columns::Magic);
+    capture::putUint(m_file, columns::Version, sizeof(uint16_t));
+    m_groups.clear();
+  }
+  void TearDown() override { remove(m_path.c_str()); }
+
+  // Append the pending rows as a row group, as ColumnWriter does
+  void writeGroup(ColumnTable &table)
+  {
+    columns::GroupEntry entry{};
+    auto offset = m_file.size();
+
+    table.encode(m_file, entry);
+    entry.offset = offset;
+    m_groups.push_back(entry);
+  }
+
+  void writeFooter(void)
+  {
+    auto offset = m_file.size();
+
+    capture::putUint(m_file, static_cast<uint32_t>(columns::BlockKind::Footer), sizeof(uint32_t));
+    capture::putUint(m_file,
+                     columns::BlockHeaderSize + sizeof(uint64_t) +
+                         m_groups.size() * columns::GroupEntrySize + columns::TrailerSize,
+                     sizeof(uint64_t));
+    capture::putUint(m_file, m_groups.size(), sizeof(uint64_t));
+    for (const auto &group : m_groups) {
+      capture::putUint(m_file, group.offset, sizeof(uint64_t));
+      capture::putUint(m_file, group.rows, sizeof(uint32_t));
+      capture::putUint(m_file, group.minTime, sizeof(uint64_t));
+      capture::putUint(m_file, group.maxTime, sizeof(uint64_t));
+    }
+    capture::putUint(m_file, offset, sizeof(uint64_t));
+    m_file.append(columns::Trailer);
+  }
+
+  void save(size_t size)
+  {
+    ofstream out(m_path, ios::binary | ios::trunc);
+    out.write(m_file.data(), static_cast<streamsize>(size));
+  }
+  void save(void) { save(m_file.size()); }
+
+  static auto findColumn(const vector<ColumnReader::Column> &chunks, string_view name)
+      -> const ColumnReader::Column *
+  {
+    for (const auto &chunk : chunks) {
+      if (chunk.name == name) {
+        return &chunk;
+      }
+    }
+    return nullptr;
+  }
+
+  // Rows: system_time, an always set uint, a sparse int, a double and a string
+  static void addRows(ColumnTable &table, uint64_t firstTime, size_t rows)
+  {
+    for (size_t i = 0; i < rows; i++) {
+      table.beginRow();
+      table.set(columns::SystemTime, firstTime + i);
+      table.set("counter", static_cast<uint64_t>(i * 1000));
+      if (i % 3 == 0) {
+        table.set("delta", -static_cast<int64_t>(i));
+      }
+      table.set("ratio", static_cast<double>(i) / 4);
+      table.set("name", (i % 2 == 0) ? string("proc") + to_string(i) : string());
+      table.endRow();
+    }
+  }
+
+protected:
+  string m_path{};
+  string m_file{};
+  vector<columns::GroupEntry> m_groups{};
+};
+
+TEST_F(GTestColumnTable, roundTrip)
+{
+  ColumnTable table;
+  addRows(table, 1000, 20);
+  writeGroup(table);
+  EXPECT_EQ(table.getRows(), 0u);
+  writeFooter();
+  save();
+
+  ColumnReader reader(m_path);
+  ASSERT_TRUE(reader.isOpen());
+  EXPECT_TRUE(reader.hasFooter());
+  ASSERT_EQ(reader.getGroups().size(), 1u);
+
+  const auto &group = reader.getGroups().front();
+  EXPECT_EQ(group.rows, 20u);
+  EXPECT_EQ(group.minTime, 1000u);
+  EXPECT_EQ(group.maxTime, 1019u);
+
+  vector<ColumnReader::Column> chunks;
+  ASSERT_TRUE(reader.readColumns(group, {}, chunks));
+  ASSERT_EQ(chunks.size(), 5u);
+
+  auto counter = findColumn(chunks, "counter");
+  auto delta = findColumn(chunks, "delta");
+  auto ratio = findColumn(chunks, "ratio");
+  auto name = findColumn(chunks, "name");
+  ASSERT_NE(counter, nullptr);
+  ASSERT_NE(delta, nullptr);
+  ASSERT_NE(ratio, nullptr);
+  ASSERT_NE(name, nullptr);
+
+  EXPECT_EQ(counter->type, columns::Type::UInt64);
+  EXPECT_EQ(counter->nulls, 0u);
+  EXPECT_EQ(counter->min, 0u);
+  EXPECT_EQ(counter->max, 19000u);
+  EXPECT_EQ(delta->type, columns::Type::Int64);
+  EXPECT_EQ(delta->nulls, 13u);
+  EXPECT_EQ(static_cast<int64_t>(delta->min), -18);
+  EXPECT_EQ(static_cast<int64_t>(delta->max), 0);
+  EXPECT_EQ(ratio->type, columns::Type::Double);
+  EXPECT_EQ(name->type, columns::Type::String);
+
+  for (size_t row = 0; row < 20; row++) {
+    EXPECT_FALSE(ColumnReader::isNull(*counter, row));
+    EXPECT_EQ(ColumnReader::uintAt(*counter, row), row * 1000);
+    EXPECT_EQ(ColumnReader::isNull(*delta, row), (row % 3 != 0));
+    if (row % 3 == 0) {
+      EXPECT_EQ(ColumnReader::intAt(*delta, row), -static_cast<int64_t>(row));
+    }
+    EXPECT_EQ(ColumnReader::doubleAt(*ratio, row), static_cast<double>(row) / 4);
+    EXPECT_EQ(ColumnReader::stringAt(*name, row),
+              (row % 2 == 0) ? string("proc") + to_string(row) : string());
+  }
+}
+
+TEST_F(GTestColumnTable, selectedColumns)
+{
+  ColumnTable table;
+  addRows(table, 1000, 4);
+  writeGroup(table);
+  writeFooter();
+  save();
+
+  ColumnReader reader(m_path);
+  ASSERT_TRUE(reader.isOpen());
+
+  vector<ColumnReader::Column> chunks;
+  ASSERT_TRUE(reader.readColumns(reader.getGroups().front(), {"ratio", "missing"}, chunks));
+  ASSERT_EQ(chunks.size(), 1u);
+  EXPECT_EQ(chunks.front().name, "ratio");
+}
+
+TEST_F(GTestColumnTable, columnsAddedAndDropped)
+{
+  ColumnTable table;
+
+  // A column first set on a later row has nulls before it
+  table.beginRow();
+  table.set(columns::SystemTime, static_cast<uint64_t>(10));
+  table.endRow();
+  table.beginRow();
+  table.set(columns::SystemTime, static_cast<uint64_t>(11));
+  table.set("late", static_cast<uint64_t>(7));
+  table.set("late", static_cast<uint64_t>(8));
+  table.endRow();
+  writeGroup(table);
+
+  // Columns without values in a group are not written
+  table.beginRow();
+  table.set(columns::SystemTime, static_cast<uint64_t>(12));
+  table.endRow();
+  writeGroup(table);
+  save();
+
+  ColumnReader reader(m_path);
+  ASSERT_TRUE(reader.isOpen());
+  EXPECT_FALSE(reader.hasFooter());
+  ASSERT_EQ(reader.getGroups().size(), 2u);
+
+  vector<ColumnReader::Column> chunks;
+  ASSERT_TRUE(reader.readColumns(reader.getGroups()[0], {}, chunks));
+  auto late = findColumn(chunks, "late");
+  ASSERT_NE(late, nullptr);
+  EXPECT_TRUE(ColumnReader::isNull(*late, 0));
+  EXPECT_FALSE(ColumnReader::isNull(*late, 1));
+  EXPECT_EQ(ColumnReader::uintAt(*late, 1), 8u);
+
+  chunks.clear();
+  ASSERT_TRUE(reader.readColumns(reader.getGroups()[1], {}, chunks));
+  EXPECT_EQ(chunks.size(), 1u);
+  EXPECT_EQ(findColumn(chunks, "late"), nullptr);
+}
+
+TEST_F(GTestColumnTable, specialDoubles)
+{
+  ColumnTable table;
+  const vector<double> values{0.0,
+                              -0.0,
+                              numeric_limits<double>::infinity(),
+                              -numeric_limits<double>::infinity(),
+                              numeric_limits<double>::quiet_NaN(),
+                              -1.5};
+
+  for (size_t i = 0; i < values.size(); i++) {
+    table.beginRow();
+    table.set(columns::SystemTime, static_cast<uint64_t>(i));
+    table.set("value", values[i]);
+    table.endRow();
+  }
+  writeGroup(table);
+  save();
+
+  ColumnReader reader(m_path);
+  ASSERT_TRUE(reader.isOpen());
+
+  vector<ColumnReader::Column> chunks;
+  ASSERT_TRUE(reader.readColumns(reader.getGroups().front(), {"value"}, chunks));
+  ASSERT_EQ(chunks.size(), 1u);
+  for (size_t i = 0; i < values.size(); i++) {
+    auto value = ColumnReader::doubleAt(chunks.front(), i);
+    if (std::isnan(values[i])) {
+      EXPECT_TRUE(std::isnan(value));
+    } else {
+      EXPECT_EQ(value, values[i]);
+      EXPECT_EQ(std::signbit(value), std::signbit(values[i]));
+    }
+  }
+}
+
+TEST_F(GTestColumnTable, truncatedGroup)
+{
+  ColumnTable table;
+  addRows(table, 1000, 10);
+  writeGroup(table);
+  auto validSize = m_file.size();
+  addRows(table, 2000, 10);
+  writeGroup(table);
+
+  // A writer killed mid block leaves the complete groups readable
+  save(m_file.size() - 5);
+
+  ColumnReader reader(m_path);
+  ASSERT_TRUE(reader.isOpen());
+  EXPECT_FALSE(reader.hasFooter());
+  ASSERT_EQ(reader.getGroups().size(), 1u);
+  EXPECT_EQ(reader.getGroups().front().minTime, 1000u);
+  EXPECT_EQ(reader.getValidSize(), validSize);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
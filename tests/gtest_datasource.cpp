@@ -0,0 +1,163 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     DataSource Unit Tests
+ * @details   GTests for data source request tracking and intervals
+ *-
+ */
+
+#include <memory>
+#include <string>
+
+#include "../source/DataSource.h"
+#include "../source/Histogram.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+class GTestDataSource : public ::testing::Test
+{
+protected:
+  static auto makeSource(uint64_t intervalUs) -> unique_ptr<DataSource>
+  {
+    return make_unique<DataSource>("SysProcStat",
+                                   intervalUs,
+                                   "stat",
+                                   tkm::msg::collector::Request_Type_GetSysProcStat,
+                                   tkm::msg::monitor::Data_What_SysProcStat);
+  }
+
+  static bool hasStat(const string &stats, const string &stat)
+  {
+    return stats.find(" " + stat) != string::npos;
+  }
+};
+
+TEST_F(GTestDataSource, packedRequest)
+{
+  auto source = makeSource(1000000);
+
+  // The request is packed once and sent as is on every tick
+  const auto &envelope = source->getRequest();
+  EXPECT_EQ(&envelope, &source->getRequest());
+  EXPECT_EQ(envelope.target(), tkm::msg::Envelope_Recipient_Monitor);
+  EXPECT_EQ(envelope.origin(), tkm::msg::Envelope_Recipient_Collector);
+
+  tkm::msg::collector::Request request;
+  ASSERT_TRUE(envelope.mesg().UnpackTo(&request));
+  EXPECT_EQ(request.id(), "stat");
+  EXPECT_EQ(request.type(), tkm::msg::collector::Request_Type_GetSysProcStat);
+  EXPECT_EQ(source->getRequestId(), "stat");
+  EXPECT_EQ(source->getDataType(), tkm::msg::monitor::Data_What_SysProcStat);
+}
+
+TEST_F(GTestDataSource, histogram)
+{
+  Histogram histogram;
+
+  for (uint64_t value : {0UL, 1UL, 3UL, 100UL}) {
+    histogram.add(value);
+  }
+  EXPECT_EQ(histogram.getCount(), 4u);
+  EXPECT_EQ(histogram.getMax(), 100u);
+  EXPECT_EQ(histogram.getMean(), 26u);
+
+  // Percentiles give the upper bound of their power of 2 bucket, at most the max
+  EXPECT_EQ(histogram.getPercentile(50), 2u);
+  EXPECT_EQ(histogram.getPercentile(75), 4u);
+  EXPECT_EQ(histogram.getPercentile(90), 100u);
+  EXPECT_EQ(histogram.toString(), "count=4 mean=26 p50=2 p90=100 p99=100 max=100");
+
+  histogram.reset();
+  EXPECT_EQ(histogram.getCount(), 0u);
+  EXPECT_EQ(histogram.getPercentile(50), 0u);
+}
+
+TEST_F(GTestDataSource, requestInFlight)
+{
+  auto source = makeSource(1000000);
+  EXPECT_TRUE(source->canRequest(1000000));
+
+  // The next request waits for the reply of the previous one
+  source->setRequested();
+  EXPECT_FALSE(source->canRequest(60000000));
+  EXPECT_FALSE(source->canRequest(60000000));
+  source->setReplied();
+  EXPECT_TRUE(source->canRequest(60000000));
+
+  // A late reply of a request already answered is not counted again
+  source->setReplied();
+
+  auto stats = source->getStats();
+  EXPECT_EQ(stats.rfind("SysProcStat latency(usec) count=1 ", 0), 0u) << stats;
+  EXPECT_TRUE(hasStat(stats, "skipped=2")) << stats;
+  EXPECT_TRUE(hasStat(stats, "timeouts=0")) << stats;
+
+  // Statistics are reset once reported
+  stats = source->getStats();
+  EXPECT_TRUE(hasStat(stats, "count=0")) << stats;
+  EXPECT_TRUE(hasStat(stats, "skipped=0")) << stats;
+}
+
+TEST_F(GTestDataSource, requestTimeout)
+{
+  auto source = makeSource(1000000);
+
+  // A request without reply past the timeout no longer blocks the next one
+  source->setRequested();
+  EXPECT_TRUE(source->canRequest(0));
+  source->setReplied();
+
+  auto stats = source->getStats();
+  EXPECT_TRUE(hasStat(stats, "count=0")) << stats;
+  EXPECT_TRUE(hasStat(stats, "skipped=0")) << stats;
+  EXPECT_TRUE(hasStat(stats, "timeouts=1")) << stats;
+}
+
+TEST_F(GTestDataSource, stretchedInterval)
+{
+  auto source = makeSource(1000000);
+  source->setOffset(250000);
+  EXPECT_FALSE(source->isThrottled());
+
+  // Throttle levels multiply the configured interval, the offset is kept
+  source->setThrottled(true);
+  source->setStretch(4);
+  EXPECT_TRUE(source->isThrottled());
+  EXPECT_EQ(source->getInterval(), 4000000u);
+  EXPECT_EQ(source->getBaseInterval(), 1000000u);
+  EXPECT_EQ(source->getOffset(), 250000u);
+
+  // An interval changed meanwhile is stretched as well
+  source->setInterval(500000);
+  EXPECT_EQ(source->getInterval(), 2000000u);
+
+  source->setStretch(0);
+  EXPECT_EQ(source->getInterval(), 500000u);
+}
+
+TEST_F(GTestDataSource, burstInterval)
+{
+  auto source = makeSource(10000000);
+  source->setStretch(2);
+
+  // A burst only ever makes requests more frequent
+  source->setBurstInterval(1000000);
+  EXPECT_EQ(source->getInterval(), 1000000u);
+  source->setBurstInterval(30000000);
+  EXPECT_EQ(source->getInterval(), 20000000u);
+
+  source->setBurstInterval(0);
+  EXPECT_EQ(source->getInterval(), 20000000u);
+  EXPECT_EQ(source->getBaseInterval(), 10000000u);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
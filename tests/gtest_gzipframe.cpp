@@ -0,0 +1,188 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     GzipFrameWriter Unit Tests
+ * @details   GTests for independent gzip frames and their index
+ *-
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#include "../source/GzipFrameWriter.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+typedef struct IndexEntry {
+  uint64_t offset;
+  uint64_t size;
+  time_t firstTime;
+  time_t lastTime;
+  size_t records;
+} IndexEntry;
+
+class GTestGzipFrame : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_path = ::testing::TempDir() + "gtest_gzipframe.json.gz";
+    m_indexPath = m_path + ".idx";
+    filesystem::remove(m_path);
+    filesystem::remove(m_indexPath);
+  }
+
+  void TearDown() override
+  {
+    filesystem::remove(m_path);
+    filesystem::remove(m_indexPath);
+  }
+
+  static auto readFile(const string &path) -> string
+  {
+    ifstream in(path, ifstream::binary);
+    stringstream content;
+    content << in.rdbuf();
+    return content.str();
+  }
+
+  auto readIndex(void) -> vector<IndexEntry>
+  {
+    vector<IndexEntry> entries;
+    ifstream in(m_indexPath);
+    IndexEntry entry{};
+    while (in >> entry.offset >> entry.size >> entry.firstTime >> entry.lastTime >>
+           entry.records) {
+      entries.push_back(entry);
+    }
+    return entries;
+  }
+
+  // Inflate all gzip members in data, as zcat does
+  static auto inflateAll(const string &data) -> string
+  {
+    string output;
+    size_t pos = 0;
+
+    while (pos < data.size()) {
+      z_stream stream{};
+      EXPECT_EQ(inflateInit2(&stream, 15 + 16), Z_OK);
+      stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data() + pos));
+      stream.avail_in = static_cast<uInt>(data.size() - pos);
+
+      int status = Z_OK;
+      char buffer[4096];
+      while (status == Z_OK) {
+        stream.next_out = reinterpret_cast<Bytef *>(buffer);
+        stream.avail_out = sizeof(buffer);
+        status = inflate(&stream, Z_NO_FLUSH);
+        output.append(buffer, sizeof(buffer) - stream.avail_out);
+      }
+      EXPECT_EQ(status, Z_STREAM_END);
+      pos += stream.total_in;
+      inflateEnd(&stream);
+      if (status != Z_STREAM_END) {
+        break;
+      }
+    }
+
+    return output;
+  }
+
+protected:
+  string m_path;
+  string m_indexPath;
+};
+
+TEST_F(GTestGzipFrame, framesBySize)
+{
+  const string header = "{\"schema\":1}\n";
+  {
+    // Frame interval long enough to only close frames by size
+    GzipFrameWriter writer(m_path, m_indexPath, 64, 3600000000);
+    for (int i = 0; i < 10; i++) {
+      writer.write("{\"record\":" + to_string(i) + ",\"padding\":\"xxxxxxxxxxxxxxxx\"}\n",
+                   header,
+                   1000 + i,
+                   1000 + i,
+                   1);
+    }
+    writer.finish();
+    EXPECT_EQ(writer.getSize(), filesystem::file_size(m_path));
+  }
+
+  auto data = readFile(m_path);
+  auto entries = readIndex();
+  ASSERT_GT(entries.size(), 1u);
+
+  // Frames are contiguous and each one decompresses on its own, header first
+  uint64_t offset = 0;
+  size_t records = 0;
+  for (const auto &entry : entries) {
+    EXPECT_EQ(entry.offset, offset);
+    EXPECT_LE(entry.firstTime, entry.lastTime);
+    auto frame = inflateAll(data.substr(entry.offset, entry.size));
+    EXPECT_EQ(frame.compare(0, header.size(), header), 0);
+    offset += entry.size;
+    records += entry.records;
+  }
+  EXPECT_EQ(offset, data.size());
+  EXPECT_EQ(records, 10u);
+  EXPECT_EQ(entries.front().firstTime, 1000);
+  EXPECT_EQ(entries.back().lastTime, 1009);
+
+  // The whole file is still a valid gzip stream
+  auto all = inflateAll(data);
+  EXPECT_NE(all.find("{\"record\":0,"), string::npos);
+  EXPECT_NE(all.find("{\"record\":9,"), string::npos);
+}
+
+TEST_F(GTestGzipFrame, appendKeepsOffsets)
+{
+  {
+    GzipFrameWriter writer(m_path, m_indexPath, 1024, 3600000000);
+    writer.write("{\"record\":0}\n", "", 1, 1, 1);
+  }
+  auto firstSize = filesystem::file_size(m_path);
+  {
+    GzipFrameWriter writer(m_path, m_indexPath, 1024, 3600000000);
+    EXPECT_EQ(writer.getSize(), firstSize);
+    writer.write("{\"record\":1}\n", "", 2, 2, 1);
+  }
+
+  auto entries = readIndex();
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[0].offset, 0u);
+  EXPECT_EQ(entries[1].offset, firstSize);
+
+  auto data = readFile(m_path);
+  EXPECT_EQ(inflateAll(data.substr(entries[1].offset, entries[1].size)), "{\"record\":1}\n");
+  EXPECT_EQ(inflateAll(data), "{\"record\":0}\n{\"record\":1}\n");
+}
+
+TEST_F(GTestGzipFrame, emptyWriteOpensNoFrame)
+{
+  {
+    GzipFrameWriter writer(m_path, m_indexPath, 1024, 3600000000);
+    writer.write("", "{\"schema\":1}\n", 1, 1, 0);
+    writer.finish();
+  }
+
+  EXPECT_EQ(filesystem::file_size(m_path), 0u);
+  EXPECT_TRUE(readIndex().empty());
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
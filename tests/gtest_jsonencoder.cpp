@@ -0,0 +1,147 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     JsonEncoder Unit Tests
+ * @details   GTests for the streaming JSON encoder of the json output
+ *-
+ */
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "../source/JsonEncoder.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+class GTestJsonEncoder : public ::testing::Test
+{
+protected:
+  auto encodeString(string_view str) -> string
+  {
+    m_json.reset();
+    m_json.value(str);
+    return string(m_json.view());
+  }
+  auto encodeDouble(double val) -> string
+  {
+    m_json.reset();
+    m_json.value(val);
+    return string(m_json.view());
+  }
+
+protected:
+  JsonEncoder m_json;
+};
+
+TEST_F(GTestJsonEncoder, objectsAndArrays)
+{
+  m_json.beginObject();
+  m_json.field("a", static_cast<uint64_t>(1));
+  m_json.key("b");
+  m_json.beginArray();
+  m_json.element(static_cast<int64_t>(-1));
+  m_json.element("two");
+  m_json.beginObject();
+  m_json.field("c", true);
+  m_json.endObject();
+  m_json.beginArray();
+  m_json.endArray();
+  m_json.endArray();
+  m_json.key("d");
+  m_json.beginObject();
+  m_json.endObject();
+  m_json.endObject();
+
+  EXPECT_EQ(m_json.view(), R"({"a":1,"b":[-1,"two",{"c":true},[]],"d":{}})");
+
+  // Nothing is left of the previous text once reset
+  m_json.reset();
+  m_json.beginObject();
+  m_json.field("e", false);
+  m_json.endObject();
+  EXPECT_EQ(m_json.view(), R"({"e":false})");
+}
+
+TEST_F(GTestJsonEncoder, sortedObjects)
+{
+  // Runtime keys are ordered as Json::Value orders object members
+  m_json.beginSortedObject();
+  m_json.key(static_cast<int64_t>(9));
+  m_json.beginObject();
+  m_json.field("pid", static_cast<int64_t>(9));
+  m_json.endObject();
+  m_json.key(static_cast<int64_t>(10));
+  m_json.beginSortedObject();
+  m_json.key(string_view("z"));
+  m_json.value(static_cast<uint64_t>(1));
+  m_json.key(string_view("y"));
+  m_json.value(static_cast<uint64_t>(2));
+  m_json.endObject();
+  m_json.key(string_view("cpu"));
+  m_json.value("all");
+  m_json.endObject();
+
+  EXPECT_EQ(m_json.view(), R"({"10":{"y":2,"z":1},"9":{"pid":9},"cpu":"all"})");
+
+  m_json.reset();
+  m_json.beginSortedObject();
+  m_json.endObject();
+  EXPECT_EQ(m_json.view(), "{}");
+}
+
+TEST_F(GTestJsonEncoder, numbers)
+{
+  m_json.beginArray();
+  m_json.element(numeric_limits<uint64_t>::max());
+  m_json.element(numeric_limits<int64_t>::min());
+  m_json.element(static_cast<uint32_t>(7));
+  m_json.element(static_cast<int32_t>(-7));
+  m_json.endArray();
+  EXPECT_EQ(m_json.view(), "[18446744073709551615,-9223372036854775808,7,-7]");
+
+  // Same text as the "%.17g" format of Json::Value
+  EXPECT_EQ(encodeDouble(0.5), "0.5");
+  EXPECT_EQ(encodeDouble(1.0), "1.0");
+  EXPECT_EQ(encodeDouble(-3.0), "-3.0");
+  EXPECT_EQ(encodeDouble(0.1), "0.10000000000000001");
+  EXPECT_EQ(encodeDouble(1e20), "1e+20");
+  EXPECT_EQ(encodeDouble(numeric_limits<double>::quiet_NaN()), "null");
+  EXPECT_EQ(encodeDouble(numeric_limits<double>::infinity()), "1e+9999");
+  EXPECT_EQ(encodeDouble(-numeric_limits<double>::infinity()), "-1e+9999");
+}
+
+TEST_F(GTestJsonEncoder, stringEscaping)
+{
+  EXPECT_EQ(encodeString("plain text"), R"("plain text")");
+  EXPECT_EQ(encodeString("quote\" slash\\"), R"("quote\" slash\\")");
+  EXPECT_EQ(encodeString("\b\f\n\r\t"), R"("\b\f\n\r\t")");
+  EXPECT_EQ(encodeString(string_view("\x01\x00", 2)), R"("\u0001\u0000")");
+
+  // Non ASCII text is written as escaped UTF-16, invalid sequences as U+FFFD
+  EXPECT_EQ(encodeString("\xc3\xa9"), R"("\u00e9")");
+  EXPECT_EQ(encodeString("\xe2\x82\xac"), R"("\u20ac")");
+  EXPECT_EQ(encodeString("\xf0\x9f\x98\x80"), R"("\ud83d\ude00")");
+  EXPECT_EQ(encodeString("\xc0\x80"), R"("\ufffd")");
+  EXPECT_EQ(encodeString("a\xc3"), R"("a\ufffd")");
+  EXPECT_EQ(encodeString("\xed\xa0\x80"), R"("\ufffd")");
+
+  // Keys are escaped the same way
+  m_json.reset();
+  m_json.beginObject();
+  m_json.key(string_view("a\"b"));
+  m_json.value(static_cast<uint64_t>(1));
+  m_json.endObject();
+  EXPECT_EQ(m_json.view(), R"({"a\"b":1})");
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,177 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     JsonFile Unit Tests
+ * @details   GTests for json output file naming, rotation and removal
+ *-
+ */
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../source/JsonFile.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+class GTestJsonFile : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_dir = ::testing::TempDir() + "gtest_jsonfile";
+    filesystem::remove_all(m_dir);
+    filesystem::create_directories(m_dir);
+    m_path = m_dir + "/tkm.json";
+  }
+  void TearDown() override { filesystem::remove_all(m_dir); }
+
+  auto listFiles(void) -> vector<string>
+  {
+    vector<string> names;
+    for (const auto &entry : filesystem::directory_iterator(m_dir)) {
+      names.push_back(entry.path().filename().string());
+    }
+    sort(names.begin(), names.end());
+    return names;
+  }
+
+  auto readFile(const string &name) -> string
+  {
+    ifstream in(m_dir + "/" + name, ifstream::binary);
+    stringstream content;
+    content << in.rdbuf();
+    return content.str();
+  }
+
+  void touch(const string &name) { ofstream(m_dir + "/" + name) << "x"; }
+
+protected:
+  string m_dir;
+  string m_path;
+};
+
+TEST_F(GTestJsonFile, pathWithTag)
+{
+  EXPECT_EQ(JsonFile::pathWithTag("out.json", "SysProcStat", '.'), "out.SysProcStat.json");
+  EXPECT_EQ(JsonFile::pathWithTag("/var/log/out.json.gz", "20220101T000000Z", '-'),
+            "/var/log/out-20220101T000000Z.json.gz");
+  EXPECT_EQ(JsonFile::pathWithTag("/var/log.d/out", "tag", '.'), "/var/log.d/out.tag");
+  EXPECT_EQ(JsonFile::pathWithTag("/tmp/.hidden", "tag", '-'), "/tmp/.hidden-tag");
+  EXPECT_EQ(JsonFile::pathWithTag("/tmp/.hidden.json", "tag", '-'), "/tmp/.hidden-tag.json");
+}
+
+TEST_F(GTestJsonFile, noRotation)
+{
+  JsonFile::Config config{
+      .rotateSize = 0, .rotateInterval = 0, .compress = false, .frameSize = 0, .frameInterval = 0};
+  {
+    JsonFile file(m_path, config);
+    file.write("{\"a\":1}\n", "{\"schema\":1}\n", 1, 1, 1);
+    file.write("{\"a\":2}\n", "{\"schema\":1}\n", 2, 2, 1);
+  }
+
+  // Header lines only start a new file
+  EXPECT_EQ(listFiles(), vector<string>{"tkm.json"});
+  EXPECT_EQ(readFile("tkm.json"), "{\"schema\":1}\n{\"a\":1}\n{\"a\":2}\n");
+}
+
+TEST_F(GTestJsonFile, rotateBySize)
+{
+  JsonFile::Config config{
+      .rotateSize = 24, .rotateInterval = 0, .compress = false, .frameSize = 0, .frameInterval = 0};
+  {
+    JsonFile file(m_path, config);
+    file.write("{\"a\":1}\n", "{\"s\":1}\n", 1, 1, 1);
+    file.write("{\"a\":2}\n{\"a\":3}\n", "{\"s\":1}\n", 2, 3, 2);
+    file.write("{\"a\":4}\n{\"a\":5}\n", "{\"s\":1}\n", 4, 5, 2);
+    file.write("{\"a\":6}\n", "{\"s\":1}\n", 6, 6, 1);
+  }
+
+  // Files rotate after the write reaching the size so records are never
+  // split. Rotations within the same second get a counter.
+  auto names = listFiles();
+  ASSERT_EQ(names.size(), 3u);
+  EXPECT_EQ(names.back(), "tkm.json");
+
+  vector<string> rotated;
+  for (size_t i = 0; i < 2; i++) {
+    EXPECT_EQ(names[i].rfind("tkm-", 0), 0u) << names[i];
+    EXPECT_EQ(names[i].compare(names[i].size() - 5, 5, ".json"), 0) << names[i];
+    rotated.push_back(readFile(names[i]));
+  }
+  sort(rotated.begin(), rotated.end());
+  EXPECT_EQ(rotated[0], "{\"s\":1}\n{\"a\":1}\n{\"a\":2}\n{\"a\":3}\n");
+  EXPECT_EQ(rotated[1], "{\"s\":1}\n{\"a\":4}\n{\"a\":5}\n");
+  EXPECT_EQ(readFile("tkm.json"), "{\"s\":1}\n{\"a\":6}\n");
+}
+
+#ifdef WITH_ZLIB
+TEST_F(GTestJsonFile, rotateCompressedBySize)
+{
+  JsonFile::Config config{.rotateSize = 1,
+                          .rotateInterval = 0,
+                          .compress = true,
+                          .frameSize = 1,
+                          .frameInterval = 3600000000};
+  {
+    JsonFile file(m_path, config);
+    file.write("{\"a\":1}\n", "", 1, 1, 1);
+    file.write("{\"a\":2}\n", "", 2, 2, 1);
+  }
+
+  // Every write closes its frame, so each file holds one frame and its index
+  auto names = listFiles();
+  ASSERT_EQ(names.size(), 4u);
+  for (const auto &name : names) {
+    EXPECT_EQ(name.rfind("tkm-", 0), 0u) << name;
+  }
+  EXPECT_EQ(count_if(names.begin(),
+                     names.end(),
+                     [](const string &name) {
+                       return name.compare(name.size() - 4, 4, ".idx") == 0;
+                     }),
+            2);
+}
+#endif
+
+TEST_F(GTestJsonFile, removeFiles)
+{
+  const vector<string> derived = {"tkm.json",
+                                  "tkm.json.idx",
+                                  "tkm-20220101T000000Z.json",
+                                  "tkm-20220101T000000Z-2.json",
+                                  "tkm-20220101T000000Z.json.idx",
+                                  "tkm.SysProcStat.json",
+                                  "tkm.SysProcStat.json.idx",
+                                  "tkm-20220101T000000Z.SysProcStat.json"};
+  const vector<string> others = {
+      "other.json", "tkm-foo.json", "tkm.db", "tkm.json.bak", "tkmx.json", "tkm.json.idx.old"};
+
+  for (const auto &name : derived) {
+    touch(name);
+  }
+  for (const auto &name : others) {
+    touch(name);
+  }
+
+  JsonFile::removeFiles(m_path);
+
+  auto expected = others;
+  sort(expected.begin(), expected.end());
+  EXPECT_EQ(listFiles(), expected);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,249 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     JsonRecord Unit Tests
+ * @details   GTests for compact records read back by JsonParser
+ *-
+ */
+
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "../source/JsonEncoder.h"
+#include "../source/JsonParser.h"
+#include "../source/JsonRecord.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+class GTestJsonRecord : public ::testing::Test
+{
+protected:
+  GTestJsonRecord() { m_compact.setFormat(JsonRecord::Format::Compact); }
+
+  // Encoders are reset for every record as JsonWriter::getEncoder does
+  void writeVerbose(const string &session, int64_t processes)
+  {
+    m_verboseJson.reset();
+    writeSample(m_verbose, session, processes);
+  }
+  void writeCompact(const string &session, int64_t processes)
+  {
+    m_compactJson.reset();
+    writeSample(m_compact, session, processes);
+  }
+
+  // Fields are written in name order like the data records
+  static void writeSample(JsonRecord &record, const string &session, int64_t processes)
+  {
+    record.begin("sample", session, 100, 200, 300);
+
+    record.beginGroup("cpu");
+    record.field("all", static_cast<uint64_t>(5));
+    record.field("name", "quote\" slash\\ line\n tab\t \xc3\xa9");
+    record.field("ratio", 0.5);
+    record.beginGroup("zone");
+    record.field("free", static_cast<uint64_t>(1) << 40);
+    record.endGroup();
+    record.endGroup();
+
+    for (int64_t pid = 1; pid <= processes; pid++) {
+      record.beginGroup("process", pid, "pid");
+      record.field("comm", string("proc") + to_string(pid));
+      record.field("pid", pid);
+      record.endGroup();
+    }
+
+    record.beginGroup("core", string_view("cpu0"));
+    record.field("usr", static_cast<int64_t>(-3));
+    record.endGroup();
+
+    record.end();
+  }
+
+  // Verbose form of a compact row, as tkmjsonconv writes it
+  static bool expandGroup(JsonEncoder &json, const JsonValue &schema, const JsonValue &group)
+  {
+    const auto &kinds = schema.member("kinds")->items;
+    auto index = strtoul(group.items[0].text.c_str(), nullptr, 10);
+    if (index >= kinds.size()) {
+      return false;
+    }
+
+    const auto &kind = kinds[index];
+    const auto &fields = kind.member("fields")->items;
+    auto keyField = kind.member("key_field");
+    size_t pos = 1;
+
+    if (kind.member("keyed")->text == "false") {
+      json.key(string_view(kind.member("name")->text));
+    } else if (keyField == nullptr) {
+      json.key(string_view(group.items[pos++].text));
+    } else {
+      for (size_t i = 0; i < fields.size(); i++) {
+        if (fields[i].text == keyField->text) {
+          json.key(string_view(group.items[pos + i].text));
+        }
+      }
+    }
+
+    json.beginSortedObject();
+    for (const auto &field : fields) {
+      json.key(string_view(field.text));
+      const auto &value = group.items[pos++];
+      if (value.type == JsonValue::Type::String) {
+        json.value(value.text);
+      } else {
+        json.rawValue(value.text);
+      }
+    }
+    while (pos < group.items.size()) {
+      if (!expandGroup(json, schema, group.items[pos++])) {
+        return false;
+      }
+    }
+    json.endObject();
+
+    return true;
+  }
+
+  static auto expand(const JsonValue &schema, const JsonValue &row) -> string
+  {
+    JsonEncoder json;
+    const auto &head = schema.member("head")->items;
+
+    json.beginSortedObject();
+    json.field("type", row.items[0].text);
+    json.field("session", schema.member("session")->text);
+    for (size_t i = 0; i < head.size(); i++) {
+      json.key(string_view(head[i].text));
+      json.rawValue(row.items[i + 1].text);
+    }
+    for (size_t i = head.size() + 1; i < row.items.size(); i++) {
+      if (!expandGroup(json, schema, row.items[i])) {
+        return string();
+      }
+    }
+    json.endObject();
+
+    return string(json.view());
+  }
+
+protected:
+  JsonEncoder m_verboseJson{};
+  JsonEncoder m_compactJson{};
+  JsonRecord m_verbose{m_verboseJson};
+  JsonRecord m_compact{m_compactJson};
+};
+
+TEST_F(GTestJsonRecord, compactRoundTrip)
+{
+  writeVerbose("abc", 3);
+  writeCompact("abc", 3);
+  EXPECT_TRUE(m_verbose.schema().empty());
+  ASSERT_FALSE(m_compact.schema().empty());
+  EXPECT_EQ(m_compact.type(), "sample");
+
+  JsonValue schema;
+  JsonValue row;
+  ASSERT_TRUE(JsonParser::parse(m_compact.schema(), schema));
+  ASSERT_TRUE(JsonParser::parse(m_compact.view(), row));
+  ASSERT_EQ(schema.type, JsonValue::Type::Object);
+  ASSERT_EQ(row.type, JsonValue::Type::Array);
+  EXPECT_EQ(schema.member("type")->text, "schema");
+  EXPECT_EQ(schema.member("record")->text, "sample");
+  ASSERT_EQ(schema.member("kinds")->items.size(), 4u);
+
+  // Process groups are keyed by their pid field, no separate key is written
+  const auto &process = schema.member("kinds")->items[2];
+  EXPECT_EQ(process.member("name")->text, "process");
+  EXPECT_EQ(process.member("keyed")->text, "true");
+  EXPECT_EQ(process.member("key_field")->text, "pid");
+  EXPECT_EQ(row.items[5].items.size(), 3u);
+
+  EXPECT_EQ(expand(schema, row), m_verbose.view());
+}
+
+TEST_F(GTestJsonRecord, schemaOncePerSession)
+{
+  writeCompact("abc", 2);
+  EXPECT_FALSE(m_compact.schema().empty());
+
+  writeCompact("abc", 2);
+  EXPECT_TRUE(m_compact.schema().empty());
+
+  // A new session gets all schemas again
+  writeCompact("def", 2);
+  ASSERT_FALSE(m_compact.schema().empty());
+
+  JsonValue schema;
+  ASSERT_TRUE(JsonParser::parse(m_compact.schema(), schema));
+  EXPECT_EQ(schema.member("session")->text, "def");
+}
+
+TEST_F(GTestJsonRecord, newKindRewritesSchema)
+{
+  writeCompact("abc", 0);
+  JsonValue schema;
+  ASSERT_TRUE(JsonParser::parse(m_compact.schema(), schema));
+  ASSERT_EQ(schema.member("kinds")->items.size(), 3u);
+
+  // The first process group adds a kind, the schema is complete again
+  writeCompact("abc", 1);
+  ASSERT_FALSE(m_compact.schema().empty());
+  ASSERT_TRUE(JsonParser::parse(m_compact.schema(), schema));
+  ASSERT_EQ(schema.member("kinds")->items.size(), 4u);
+
+  JsonValue row;
+  ASSERT_TRUE(JsonParser::parse(m_compact.view(), row));
+  writeVerbose("abc", 1);
+  EXPECT_EQ(expand(schema, row), m_verbose.view());
+}
+
+TEST_F(GTestJsonRecord, nonFiniteDoubles)
+{
+  m_compact.begin("sample", "abc", 1, 2, 3);
+  m_compact.beginGroup("values");
+  m_compact.field("inf", numeric_limits<double>::infinity());
+  m_compact.field("nan", numeric_limits<double>::quiet_NaN());
+  m_compact.field("neg_inf", -numeric_limits<double>::infinity());
+  m_compact.field("neg_zero", -0.0);
+  m_compact.endGroup();
+  m_compact.end();
+
+  // Written the Json::Value way and kept as number text by the parser
+  JsonValue row;
+  ASSERT_TRUE(JsonParser::parse(m_compact.view(), row));
+  const auto &group = row.items[4];
+  ASSERT_EQ(group.items.size(), 5u);
+  EXPECT_EQ(group.items[1].text, "1e+9999");
+  EXPECT_EQ(group.items[2].text, "null");
+  EXPECT_EQ(group.items[3].text, "-1e+9999");
+  EXPECT_EQ(group.items[4].text, "-0.0");
+}
+
+TEST_F(GTestJsonRecord, parserRejectsInvalid)
+{
+  JsonValue value;
+
+  EXPECT_FALSE(JsonParser::parse("", value));
+  EXPECT_FALSE(JsonParser::parse("[1,2", value));
+  EXPECT_FALSE(JsonParser::parse("{\"a\":}", value));
+  EXPECT_FALSE(JsonParser::parse("{\"a\" 1}", value));
+  EXPECT_FALSE(JsonParser::parse("[\"unterminated]", value));
+  EXPECT_FALSE(JsonParser::parse("[\"\\u12\"]", value));
+  EXPECT_TRUE(JsonParser::parse(" [1, \"\\u00e9\", {\"a\": null}] ", value));
+  EXPECT_EQ(value.items[1].text, "\xc3\xa9");
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,242 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     LatestTable Unit Tests
+ * @details   GTests for reading the shared memory latest values table
+ *-
+ */
+
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+#include "../source/LatestTable.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+class GTestLatestTable : public ::testing::Test
+{
+protected:
+  void SetUp() override { m_name = "/gtest_latesttable." + to_string(::getpid()); }
+  void TearDown() override
+  {
+    if (m_header != nullptr) {
+      ::munmap(m_header, m_size);
+    }
+    ::shm_unlink(m_name.c_str());
+  }
+
+  // Create a table as LatestWriter does, the mapping is sized for mappedSlots
+  void createTable(uint32_t slotCount, uint32_t mappedSlots)
+  {
+    m_size = sizeof(latest::Header) + mappedSlots * sizeof(latest::Slot);
+
+    auto fd = ::shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(::ftruncate(fd, static_cast<off_t>(m_size)), 0);
+    auto addr = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    ASSERT_NE(addr, MAP_FAILED);
+
+    m_header = static_cast<latest::Header *>(addr);
+    m_slots = reinterpret_cast<latest::Slot *>(m_header + 1);
+    memcpy(m_header->magic, latest::Magic.data(), sizeof(m_header->magic));
+    m_header->version = latest::Version;
+    m_header->slotSize = sizeof(latest::Slot);
+    m_header->slotCount = slotCount;
+    strncpy(m_header->device, "device", sizeof(m_header->device) - 1);
+  }
+
+  void setSlot(size_t index,
+               const char *source,
+               const char *entity,
+               const char *field,
+               latest::Type type,
+               uint64_t time,
+               uint64_t value)
+  {
+    auto &slot = m_slots[index];
+    auto seq = slot.seq.load();
+
+    slot.seq.store(seq + 1);
+    slot.type = static_cast<uint8_t>(type);
+    slot.time.store(time);
+    slot.value.store(value);
+    strncpy(slot.source, source, sizeof(slot.source));
+    strncpy(slot.entity, entity, sizeof(slot.entity));
+    strncpy(slot.field, field, sizeof(slot.field));
+    slot.seq.store(seq + 2);
+
+    if (index >= m_header->usedSlots) {
+      m_header->usedSlots = static_cast<uint32_t>(index + 1);
+    }
+    m_header->updateTime = time;
+  }
+
+protected:
+  string m_name;
+  latest::Header *m_header = nullptr;
+  latest::Slot *m_slots = nullptr;
+  size_t m_size = 0;
+};
+
+TEST_F(GTestLatestTable, readSlots)
+{
+  createTable(8, 8);
+  setSlot(0, "SysProcStat", "cpu0", "user", latest::Type::UInt64, 1000, 42);
+  setSlot(1, "SysProcStat", "cpu0", "system", latest::Type::Int64, 1001, static_cast<uint64_t>(-5));
+  double real = 2.5;
+  uint64_t bits;
+  memcpy(&bits, &real, sizeof(bits));
+  setSlot(2, "SysProcPressure", "", "cpu.avg10", latest::Type::Double, 1002, bits);
+
+  latest::LatestTable table;
+  ASSERT_TRUE(table.open(m_name));
+  EXPECT_FALSE(table.isClosed());
+  EXPECT_EQ(table.getDevice(), "device");
+  EXPECT_EQ(table.getUpdateTime(), 1002u);
+  EXPECT_EQ(table.getSlotCount(), 3u);
+
+  latest::Value value;
+  ASSERT_TRUE(table.read(0, value));
+  EXPECT_EQ(value.getSource(), "SysProcStat");
+  EXPECT_EQ(value.getEntity(), "cpu0");
+  EXPECT_EQ(value.getField(), "user");
+  EXPECT_EQ(value.time, 1000u);
+  EXPECT_EQ(value.asUInt64(), 42u);
+
+  ASSERT_TRUE(table.read(1, value));
+  EXPECT_EQ(value.asInt64(), -5);
+  EXPECT_DOUBLE_EQ(value.asDouble(), -5.0);
+
+  size_t index = 0;
+  ASSERT_TRUE(table.find("SysProcPressure", "", "cpu.avg10", index));
+  EXPECT_EQ(index, 2u);
+  ASSERT_TRUE(table.read(index, value));
+  EXPECT_DOUBLE_EQ(value.asDouble(), 2.5);
+  EXPECT_FALSE(table.find("SysProcStat", "cpu1", "user", index));
+  EXPECT_FALSE(table.read(3, value));
+
+  vector<string> fields;
+  table.forEach([&fields](const latest::Value &val) { fields.emplace_back(val.getField()); });
+  EXPECT_EQ(fields, (vector<string>{"user", "system", "cpu.avg10"}));
+
+  // Opening the name without the leading slash maps the same table
+  latest::LatestTable other;
+  ASSERT_TRUE(other.open(m_name.substr(1)));
+  EXPECT_EQ(other.getSlotCount(), 3u);
+}
+
+TEST_F(GTestLatestTable, slotsBeingWritten)
+{
+  createTable(4, 4);
+  setSlot(0, "SysProcStat", "cpu0", "user", latest::Type::UInt64, 1000, 1);
+  setSlot(1, "SysProcStat", "cpu0", "system", latest::Type::UInt64, 1000, 2);
+
+  latest::LatestTable table;
+  ASSERT_TRUE(table.open(m_name));
+
+  // A writer stopped mid update leaves the sequence odd, the read gives up
+  m_slots[0].seq.fetch_add(1);
+  latest::Value value;
+  EXPECT_FALSE(table.read(0, value));
+  EXPECT_TRUE(table.read(1, value));
+
+  size_t index = 0;
+  EXPECT_FALSE(table.find("SysProcStat", "cpu0", "user", index));
+
+  // A slot never written is unused
+  m_header->usedSlots = 3;
+  EXPECT_FALSE(table.read(2, value));
+}
+
+TEST_F(GTestLatestTable, fieldsAlwaysTerminated)
+{
+  createTable(1, 1);
+  setSlot(0, "SysProcStat", "cpu0", "user", latest::Type::UInt64, 1000, 1);
+  memset(m_slots[0].field, 'x', sizeof(m_slots[0].field));
+  memset(m_header->device, 'd', sizeof(m_header->device));
+
+  latest::LatestTable table;
+  ASSERT_TRUE(table.open(m_name));
+  EXPECT_EQ(table.getDevice().size(), sizeof(m_header->device));
+
+  latest::Value value;
+  ASSERT_TRUE(table.read(0, value));
+  EXPECT_EQ(value.getField().size(), latest::FieldSize - 1);
+}
+
+TEST_F(GTestLatestTable, usedSlotsBoundByMapping)
+{
+  createTable(2, 2);
+  setSlot(0, "SysProcStat", "cpu0", "user", latest::Type::UInt64, 1000, 1);
+  setSlot(1, "SysProcStat", "cpu0", "system", latest::Type::UInt64, 1000, 2);
+
+  latest::LatestTable table;
+  ASSERT_TRUE(table.open(m_name));
+
+  // A used count past the slots mapped at open is not followed
+  m_header->usedSlots = 1000;
+  EXPECT_EQ(table.getSlotCount(), 2u);
+  latest::Value value;
+  EXPECT_FALSE(table.read(2, value));
+  size_t visited = 0;
+  table.forEach([&visited](const latest::Value &) { visited++; });
+  EXPECT_EQ(visited, 2u);
+
+  // Nor is a slot count grown after open
+  m_header->slotCount = 1000;
+  EXPECT_EQ(table.getSlotCount(), 2u);
+}
+
+TEST_F(GTestLatestTable, closedTable)
+{
+  createTable(2, 2);
+
+  latest::LatestTable table;
+  ASSERT_TRUE(table.open(m_name));
+  EXPECT_FALSE(table.isClosed());
+  m_header->closed = 1;
+  EXPECT_TRUE(table.isClosed());
+
+  table.close();
+  EXPECT_FALSE(table.isOpen());
+  EXPECT_TRUE(table.isClosed());
+  EXPECT_EQ(table.getSlotCount(), 0u);
+}
+
+TEST_F(GTestLatestTable, invalidTables)
+{
+  latest::LatestTable table;
+  EXPECT_FALSE(table.open(""));
+  EXPECT_FALSE(table.open(m_name));
+
+  // More slots than the object holds
+  createTable(8, 4);
+  EXPECT_FALSE(table.open(m_name));
+
+  m_header->slotCount = 4;
+  EXPECT_TRUE(table.open(m_name));
+
+  m_header->version = latest::Version + 1;
+  EXPECT_FALSE(table.open(m_name));
+  EXPECT_FALSE(table.isOpen());
+
+  m_header->version = latest::Version;
+  m_header->magic[0] = 'X';
+  EXPECT_FALSE(table.open(m_name));
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
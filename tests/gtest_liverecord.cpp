@@ -0,0 +1,170 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     LiveRecord Unit Tests
+ * @details   GTests for the records and entity records kept by the live buffer
+ *-
+ */
+
+#include <string>
+#include <vector>
+
+#include "../source/JsonEncoder.h"
+#include "../source/JsonRecord.h"
+#include "../source/LiveRecord.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+typedef struct Commit {
+  string type;
+  string entity;
+  uint64_t time;
+  string json;
+} Commit;
+
+class GTestLiveRecord : public ::testing::Test
+{
+protected:
+  void SetUp() override { m_commits.clear(); }
+
+  auto makeRecord(void) -> LiveRecord
+  {
+    return LiveRecord(
+        [this](string_view type, string_view entity, uint64_t time, string_view json) {
+          m_commits.push_back(Commit{string(type), string(entity), time, string(json)});
+        });
+  }
+
+  // The json output line of the same record
+  template <class Write>
+  static auto expected(Write write) -> string
+  {
+    JsonEncoder json;
+    JsonRecord record(json);
+    write(record);
+    return string(json.view());
+  }
+
+protected:
+  vector<Commit> m_commits;
+};
+
+TEST_F(GTestLiveRecord, recordWithoutEntities)
+{
+  auto write = [](auto &record) {
+    record.begin("stat", "session", 100, 200, 300);
+    record.beginGroup("cpu");
+    record.field("all", static_cast<uint64_t>(5));
+    record.beginGroup("zone");
+    record.field("free", static_cast<uint64_t>(7));
+    record.endGroup();
+    record.endGroup();
+    record.end();
+  };
+
+  auto record = makeRecord();
+  write(record);
+
+  ASSERT_EQ(m_commits.size(), 1u);
+  EXPECT_EQ(m_commits[0].type, "stat");
+  EXPECT_EQ(m_commits[0].entity, "");
+  EXPECT_EQ(m_commits[0].time, 100u);
+  EXPECT_EQ(m_commits[0].json, expected(write));
+}
+
+TEST_F(GTestLiveRecord, entityRecords)
+{
+  auto writeHead = [](auto &record) { record.begin("procs", "session", 100, 200, 300); };
+  auto writeProcess = [](auto &record, int64_t pid) {
+    record.beginGroup("process", pid, "pid");
+    record.field("comm", string("proc") + to_string(pid));
+    record.beginGroup("mem");
+    record.field("rss", static_cast<uint64_t>(pid * 10));
+    record.endGroup();
+    record.endGroup();
+  };
+  auto writeCore = [](auto &record) {
+    record.beginGroup("core", string_view("cpu0"));
+    record.field("usr", static_cast<int64_t>(-3));
+    record.endGroup();
+  };
+  auto write = [&](auto &record) {
+    writeHead(record);
+    record.beginGroup("cpu");
+    record.field("all", static_cast<uint64_t>(5));
+    record.endGroup();
+    writeProcess(record, 1);
+    writeProcess(record, 2);
+    writeCore(record);
+    record.end();
+  };
+
+  auto record = makeRecord();
+  write(record);
+
+  // Each keyed top level group is committed first, alone under the same head
+  ASSERT_EQ(m_commits.size(), 4u);
+  EXPECT_EQ(m_commits[0].entity, "1");
+  EXPECT_EQ(m_commits[0].json, expected([&](auto &rec) {
+              writeHead(rec);
+              writeProcess(rec, 1);
+              rec.end();
+            }));
+  EXPECT_EQ(m_commits[1].entity, "2");
+  EXPECT_EQ(m_commits[1].json, expected([&](auto &rec) {
+              writeHead(rec);
+              writeProcess(rec, 2);
+              rec.end();
+            }));
+  EXPECT_EQ(m_commits[2].entity, "cpu0");
+  EXPECT_EQ(m_commits[2].json, expected([&](auto &rec) {
+              writeHead(rec);
+              writeCore(rec);
+              rec.end();
+            }));
+
+  EXPECT_EQ(m_commits[3].entity, "");
+  EXPECT_EQ(m_commits[3].json, expected(write));
+  for (const auto &commit : m_commits) {
+    EXPECT_EQ(commit.type, "procs");
+    EXPECT_EQ(commit.time, 100u);
+  }
+}
+
+TEST_F(GTestLiveRecord, reusedForNextRecord)
+{
+  auto record = makeRecord();
+
+  record.begin("procs", "session", 100, 200, 300);
+  record.beginGroup("process", static_cast<int64_t>(1), "pid");
+  record.field("pid", static_cast<int64_t>(1));
+  record.endGroup();
+  record.end();
+
+  auto write = [](auto &rec) {
+    rec.begin("stat", "session", 101, 201, 301);
+    rec.beginGroup("cpu");
+    rec.field("all", static_cast<uint64_t>(1));
+    rec.endGroup();
+    rec.end();
+  };
+  write(record);
+
+  // Nothing of the previous record is left in the next one
+  ASSERT_EQ(m_commits.size(), 3u);
+  EXPECT_EQ(m_commits[2].type, "stat");
+  EXPECT_EQ(m_commits[2].entity, "");
+  EXPECT_EQ(m_commits[2].time, 101u);
+  EXPECT_EQ(m_commits[2].json, expected(write));
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,165 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     MsgPackEncoder Unit Tests
+ * @details   GTests for the MessagePack encoder and records of the msgpack output
+ *-
+ */
+
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <string>
+
+#include "../source/MsgPackEncoder.h"
+#include "../source/MsgPackRecord.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+class GTestMsgPack : public ::testing::Test
+{
+protected:
+  static auto bytes(initializer_list<unsigned> values) -> string
+  {
+    string data;
+    for (auto value : values) {
+      data.push_back(static_cast<char>(value));
+    }
+    return data;
+  }
+
+  template <class T>
+  auto encode(const T &val) -> string
+  {
+    m_encoder.reset();
+    m_encoder.value(val);
+    return string(m_encoder.view());
+  }
+
+protected:
+  MsgPackEncoder m_encoder;
+};
+
+TEST_F(GTestMsgPack, integers)
+{
+  // The smallest integer type holding the value
+  EXPECT_EQ(encode(static_cast<uint64_t>(0)), bytes({0x00}));
+  EXPECT_EQ(encode(static_cast<uint64_t>(127)), bytes({0x7f}));
+  EXPECT_EQ(encode(static_cast<uint64_t>(128)), bytes({0xcc, 0x80}));
+  EXPECT_EQ(encode(static_cast<uint64_t>(256)), bytes({0xcd, 0x01, 0x00}));
+  EXPECT_EQ(encode(static_cast<uint64_t>(65536)), bytes({0xce, 0x00, 0x01, 0x00, 0x00}));
+  EXPECT_EQ(encode(static_cast<uint64_t>(1) << 32),
+            bytes({0xcf, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00}));
+
+  EXPECT_EQ(encode(static_cast<int64_t>(5)), bytes({0x05}));
+  EXPECT_EQ(encode(static_cast<int64_t>(-1)), bytes({0xff}));
+  EXPECT_EQ(encode(static_cast<int64_t>(-32)), bytes({0xe0}));
+  EXPECT_EQ(encode(static_cast<int64_t>(-33)), bytes({0xd0, 0xdf}));
+  EXPECT_EQ(encode(static_cast<int64_t>(-129)), bytes({0xd1, 0xff, 0x7f}));
+  EXPECT_EQ(encode(static_cast<int64_t>(-32769)), bytes({0xd2, 0xff, 0xff, 0x7f, 0xff}));
+  EXPECT_EQ(encode(numeric_limits<int64_t>::min()),
+            bytes({0xd3, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}));
+  EXPECT_EQ(encode(static_cast<int32_t>(-1)), bytes({0xff}));
+  EXPECT_EQ(encode(static_cast<uint32_t>(200)), bytes({0xcc, 0xc8}));
+}
+
+TEST_F(GTestMsgPack, floatsAndBooleans)
+{
+  EXPECT_EQ(encode(1.0), bytes({0xcb, 0x3f, 0xf0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}));
+  EXPECT_EQ(encode(-2.5f), bytes({0xca, 0xc0, 0x20, 0x00, 0x00}));
+  EXPECT_EQ(encode(true), bytes({0xc3}));
+  EXPECT_EQ(encode(false), bytes({0xc2}));
+}
+
+TEST_F(GTestMsgPack, strings)
+{
+  EXPECT_EQ(encode(""), bytes({0xa0}));
+  EXPECT_EQ(encode("abc"), bytes({0xa3, 'a', 'b', 'c'}));
+
+  string text(31, 'x');
+  EXPECT_EQ(encode(text), bytes({0xbf}) + text);
+  text.assign(32, 'x');
+  EXPECT_EQ(encode(text), bytes({0xd9, 0x20}) + text);
+  text.assign(256, 'x');
+  EXPECT_EQ(encode(text), bytes({0xda, 0x01, 0x00}) + text);
+  text.assign(65536, 'x');
+  EXPECT_EQ(encode(text), bytes({0xdb, 0x00, 0x01, 0x00, 0x00}) + text);
+
+  // Strings are copied as is, without escaping
+  EXPECT_EQ(encode(string_view("a\"\n\0", 4)), bytes({0xa4, 'a', '"', '\n', 0x00}));
+}
+
+TEST_F(GTestMsgPack, containers)
+{
+  m_encoder.beginObject();
+  m_encoder.field("a", static_cast<uint64_t>(1));
+  m_encoder.key("b");
+  m_encoder.beginArray();
+  m_encoder.element(static_cast<uint64_t>(1));
+  m_encoder.element("c");
+  m_encoder.beginObject();
+  m_encoder.endObject();
+  m_encoder.endArray();
+  m_encoder.key(static_cast<int64_t>(42));
+  m_encoder.value(false);
+  m_encoder.endObject();
+
+  // Map keys are strings, integer keys included
+  EXPECT_EQ(m_encoder.view(),
+            bytes({0x83, 0xa1, 'a', 0x01, 0xa1, 'b', 0x93, 0x01, 0xa1, 'c', 0x80,
+                   0xa2, '4', '2', 0xc2}));
+
+  // Container sizes past the fixed forms get a 16 bit count
+  m_encoder.reset();
+  m_encoder.beginArray();
+  for (uint64_t i = 0; i < 16; i++) {
+    m_encoder.element(i);
+  }
+  m_encoder.endArray();
+  auto view = m_encoder.view();
+  ASSERT_EQ(view.size(), 19u);
+  EXPECT_EQ(view.substr(0, 4), bytes({0xdc, 0x00, 0x10, 0x00}));
+  EXPECT_EQ(view.back(), 0x0f);
+
+  m_encoder.reset();
+  m_encoder.beginSortedObject();
+  for (int64_t i = 0; i < 16; i++) {
+    m_encoder.key(i);
+    m_encoder.value(i);
+  }
+  m_encoder.endObject();
+  EXPECT_EQ(m_encoder.view().substr(0, 5), bytes({0xde, 0x00, 0x10, 0xa1, '0'}));
+}
+
+TEST_F(GTestMsgPack, record)
+{
+  MsgPackRecord record(m_encoder);
+
+  record.begin("stat", "session", 1, 2, 3);
+  record.beginGroup("cpu");
+  record.field("all", static_cast<uint64_t>(5));
+  record.endGroup();
+  record.beginGroup("process", static_cast<int64_t>(7), "pid");
+  record.field("rss", static_cast<uint64_t>(9));
+  record.endGroup();
+  record.end();
+
+  // Head fields and one nested map per group, keyed groups by their key
+  auto expected = bytes({0x87, 0xa4}) + "type" + bytes({0xa4}) + "stat" + bytes({0xab}) +
+                  "system_time" + bytes({0x01, 0xae}) + "monotonic_time" + bytes({0x02, 0xac}) +
+                  "receive_time" + bytes({0x03, 0xa7}) + "session" + bytes({0xa7}) + "session" +
+                  bytes({0xa3}) + "cpu" + bytes({0x81, 0xa3}) + "all" + bytes({0x05, 0xa1}) +
+                  "7" + bytes({0x81, 0xa3}) + "rss" + bytes({0x09});
+  EXPECT_EQ(record.view(), expected);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,100 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     RingQueue Unit Tests
+ * @details   GTests for the queue between the main loop and the json writer thread
+ *-
+ */
+
+#include <string>
+#include <thread>
+
+#include "../source/RingQueue.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+class GTestRingQueue : public ::testing::Test
+{
+};
+
+TEST_F(GTestRingQueue, pushAndPop)
+{
+  RingQueue<string, 4> queue;
+  string item;
+
+  EXPECT_EQ(queue.capacity(), 4u);
+  EXPECT_EQ(queue.size(), 0u);
+  EXPECT_FALSE(queue.pop(item));
+
+  for (int i = 0; i < 4; i++) {
+    item = "chunk" + to_string(i);
+    ASSERT_TRUE(queue.push(item));
+  }
+  EXPECT_EQ(queue.size(), 4u);
+
+  // A full queue leaves the item with the caller
+  item = "last";
+  EXPECT_FALSE(queue.push(item));
+  EXPECT_EQ(item, "last");
+
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(queue.pop(item));
+    EXPECT_EQ(item, "chunk" + to_string(i));
+  }
+  EXPECT_FALSE(queue.pop(item));
+  EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST_F(GTestRingQueue, wrapAround)
+{
+  RingQueue<int, 2> queue;
+  int item = 0;
+
+  for (int i = 0; i < 10; i++) {
+    item = i;
+    ASSERT_TRUE(queue.push(item));
+    ASSERT_TRUE(queue.pop(item));
+    EXPECT_EQ(item, i);
+  }
+  EXPECT_EQ(queue.size(), 0u);
+}
+
+TEST_F(GTestRingQueue, producerAndConsumerThreads)
+{
+  constexpr size_t count = 100000;
+  RingQueue<size_t, 8> queue;
+
+  // Items are received once and in order, the producer retries when full
+  thread producer([&queue]() {
+    for (size_t i = 0; i < count; i++) {
+      auto item = i;
+      while (!queue.push(item)) {
+        this_thread::yield();
+      }
+    }
+  });
+
+  size_t expected = 0;
+  while (expected < count) {
+    size_t item;
+    if (!queue.pop(item)) {
+      this_thread::yield();
+      continue;
+    }
+    EXPECT_EQ(item, expected);
+    expected++;
+  }
+  producer.join();
+  EXPECT_EQ(queue.size(), 0u);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
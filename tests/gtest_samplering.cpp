@@ -0,0 +1,236 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SampleRing Unit Tests
+ * @details   GTests for the shared memory sample ring producer and consumer
+ *-
+ */
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "../source/SampleRing.h"
+#include "../source/SampleRingBuffer.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+class GTestSampleRing : public ::testing::Test
+{
+protected:
+  void SetUp() override { m_name = "/gtest_samplering." + to_string(::getpid()); }
+  void TearDown() override { m_buffer.close(); }
+
+  // Records of 48 bytes, 85 of them fit the smallest ring
+  void appendUser(uint64_t time)
+  {
+    m_buffer.append("SysProcStat", "cpu0", "user", series::Type::UInt64, time, time * 10);
+  }
+
+protected:
+  string m_name;
+  SampleRingBuffer m_buffer;
+};
+
+TEST_F(GTestSampleRing, readSamples)
+{
+  ASSERT_TRUE(m_buffer.create(m_name, "device", 1000));
+  ring::SampleRing ring;
+  ASSERT_TRUE(ring.open(m_name));
+  EXPECT_EQ(ring.getDevice(), "device");
+
+  double real = 2.5;
+  uint64_t bits;
+  memcpy(&bits, &real, sizeof(bits));
+  m_buffer.append("SysProcStat", "cpu0", "user", series::Type::UInt64, 1000, 42);
+  m_buffer.append(
+      "SysProcStat", "cpu0", "nice", series::Type::Int64, 1001, static_cast<uint64_t>(-5));
+  m_buffer.append("SysProcPressure", "", "cpu.avg10", series::Type::Double, 1002, bits);
+
+  // Nothing is visible before publish
+  ring::Sample sample;
+  EXPECT_FALSE(ring.next(sample));
+  m_buffer.publish();
+
+  ASSERT_TRUE(ring.next(sample));
+  EXPECT_EQ(sample.type, ring::Type::UInt64);
+  EXPECT_EQ(sample.source, "SysProcStat");
+  EXPECT_EQ(sample.entity, "cpu0");
+  EXPECT_EQ(sample.field, "user");
+  EXPECT_EQ(sample.time, 1000u);
+  EXPECT_EQ(sample.asUInt64(), 42u);
+
+  ASSERT_TRUE(ring.next(sample));
+  EXPECT_EQ(sample.field, "nice");
+  EXPECT_EQ(sample.asInt64(), -5);
+  EXPECT_DOUBLE_EQ(sample.asDouble(), -5.0);
+
+  ASSERT_TRUE(ring.next(sample));
+  EXPECT_EQ(sample.source, "SysProcPressure");
+  EXPECT_EQ(sample.entity, "");
+  EXPECT_DOUBLE_EQ(sample.asDouble(), 2.5);
+
+  EXPECT_FALSE(ring.next(sample));
+  EXPECT_EQ(ring.getOverruns(), 0u);
+}
+
+TEST_F(GTestSampleRing, openPosition)
+{
+  ASSERT_TRUE(m_buffer.create(m_name.substr(1), "device", 4096));
+  appendUser(1);
+  m_buffer.publish();
+
+  // A new consumer starts with the next record unless it asks for the oldest
+  ring::SampleRing latest;
+  ring::SampleRing oldest;
+  ASSERT_TRUE(latest.open(m_name));
+  ASSERT_TRUE(oldest.open(m_name, true));
+
+  appendUser(2);
+  m_buffer.publish();
+
+  ring::Sample sample;
+  ASSERT_TRUE(latest.next(sample));
+  EXPECT_EQ(sample.time, 2u);
+  EXPECT_FALSE(latest.next(sample));
+
+  ASSERT_TRUE(oldest.next(sample));
+  EXPECT_EQ(sample.time, 1u);
+  ASSERT_TRUE(oldest.next(sample));
+  EXPECT_EQ(sample.time, 2u);
+}
+
+TEST_F(GTestSampleRing, wrapAround)
+{
+  ASSERT_TRUE(m_buffer.create(m_name, "device", 4096));
+  ring::SampleRing ring;
+  ASSERT_TRUE(ring.open(m_name));
+
+  // A consumer keeping up reads every record across the padding at the end
+  ring::Sample sample;
+  uint64_t expected = 0;
+  for (uint64_t time = 0; time < 1000; time++) {
+    appendUser(time);
+    if ((time % 10) == 9) {
+      m_buffer.publish();
+      while (ring.next(sample)) {
+        ASSERT_EQ(sample.time, expected);
+        ASSERT_EQ(sample.asUInt64(), expected * 10);
+        expected++;
+      }
+    }
+  }
+
+  EXPECT_EQ(expected, 1000u);
+  EXPECT_GT(ring.getPosition(), 4096u * 10);
+  EXPECT_EQ(ring.getOverruns(), 0u);
+  EXPECT_EQ(ring.getLostBytes(), 0u);
+}
+
+TEST_F(GTestSampleRing, overrun)
+{
+  ASSERT_TRUE(m_buffer.create(m_name, "device", 4096));
+  ring::SampleRing ring;
+  ASSERT_TRUE(ring.open(m_name));
+
+  // The producer never waits, a consumer left behind goes on from the oldest kept
+  for (uint64_t time = 0; time < 200; time++) {
+    appendUser(time);
+  }
+  m_buffer.publish();
+
+  ring::Sample sample;
+  ASSERT_TRUE(ring.next(sample));
+  EXPECT_GT(sample.time, 0u);
+  EXPECT_EQ(ring.getOverruns(), 1u);
+  EXPECT_GT(ring.getLostBytes(), 0u);
+
+  auto last = sample.time;
+  while (ring.next(sample)) {
+    EXPECT_EQ(sample.time, last + 1);
+    last = sample.time;
+  }
+  EXPECT_EQ(last, 199u);
+  EXPECT_EQ(ring.getOverruns(), 1u);
+}
+
+TEST_F(GTestSampleRing, longNamesDropped)
+{
+  ASSERT_TRUE(m_buffer.create(m_name, "device", 4096));
+  ring::SampleRing ring;
+  ASSERT_TRUE(ring.open(m_name));
+
+  string entity(256, 'e');
+  m_buffer.append("ProcInfo", entity, "rss", series::Type::UInt64, 1, 1);
+  m_buffer.append("ProcInfo", entity.substr(1), "rss", series::Type::UInt64, 2, 2);
+  m_buffer.publish();
+  EXPECT_EQ(m_buffer.getDropped(), 1u);
+
+  ring::Sample sample;
+  ASSERT_TRUE(ring.next(sample));
+  EXPECT_EQ(sample.time, 2u);
+  EXPECT_EQ(sample.entity.size(), 255u);
+  EXPECT_EQ(sample.field, "rss");
+  EXPECT_FALSE(ring.next(sample));
+}
+
+TEST_F(GTestSampleRing, waitForPublish)
+{
+  ASSERT_TRUE(m_buffer.create(m_name, "device", 4096));
+  ring::SampleRing ring;
+  ASSERT_TRUE(ring.open(m_name));
+  EXPECT_FALSE(ring.wait(10));
+
+  thread producer([this]() {
+    this_thread::sleep_for(chrono::milliseconds(20));
+    appendUser(1);
+    m_buffer.publish();
+  });
+  EXPECT_TRUE(ring.wait(5000));
+  producer.join();
+
+  ring::Sample sample;
+  ASSERT_TRUE(ring.next(sample));
+  EXPECT_EQ(sample.time, 1u);
+}
+
+TEST_F(GTestSampleRing, closedRing)
+{
+  ASSERT_TRUE(m_buffer.create(m_name, "device", 4096));
+  ring::SampleRing ring;
+  ASSERT_TRUE(ring.open(m_name));
+  EXPECT_FALSE(ring.isClosed());
+
+  // A producer restarted on the same name closes the previous ring
+  SampleRingBuffer restarted;
+  ASSERT_TRUE(restarted.create(m_name, "device", 4096));
+  EXPECT_TRUE(ring.isClosed());
+  ASSERT_TRUE(ring.open(m_name));
+  EXPECT_FALSE(ring.isClosed());
+
+  // Appended samples are published on close, then the name is removed
+  restarted.append("SysProcStat", "cpu0", "user", series::Type::UInt64, 1, 1);
+  restarted.close();
+  EXPECT_TRUE(ring.isClosed());
+  ring::Sample sample;
+  EXPECT_TRUE(ring.next(sample));
+  EXPECT_FALSE(ring.wait(5000));
+
+  ring::SampleRing other;
+  EXPECT_FALSE(other.open(m_name));
+  EXPECT_FALSE(other.open(""));
+  EXPECT_FALSE(other.next(sample));
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
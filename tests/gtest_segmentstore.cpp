@@ -0,0 +1,291 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SegmentStore Unit Tests
+ * @details   GTests for segment files, store listing and compaction
+ *-
+ */
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../source/SegmentCompactor.h"
+#include "../source/SegmentFile.h"
+#include "../source/SegmentReader.h"
+#include "../source/SegmentStore.h"
+#include "../source/SeriesCodec.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+typedef pair<uint64_t, uint64_t> Sample;
+
+class GTestSegmentStore : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_dir = ::testing::TempDir() + "gtest_segmentstore";
+    filesystem::remove_all(m_dir);
+    filesystem::create_directories(m_dir);
+  }
+  void TearDown() override { filesystem::remove_all(m_dir); }
+
+  // Append the samples of one series as a block, as SegmentWriter does
+  static bool appendSeries(SegmentFile &file, const string &field, const vector<Sample> &samples)
+  {
+    SeriesEncoder encoder(series::Type::UInt64);
+    encoder.reset();
+    for (const auto &[time, value] : samples) {
+      encoder.append(time, value);
+    }
+
+    SeriesReader::Block block{.type = series::Type::UInt64,
+                              .count = encoder.getCount(),
+                              .firstTime = encoder.getFirstTime(),
+                              .lastTime = encoder.getLastTime(),
+                              .device = "device",
+                              .source = "SysProcStat",
+                              .entity = "cpu0",
+                              .field = field,
+                              .samples = encoder.view()};
+    return file.appendBlock(block);
+  }
+
+  auto writeSegment(uint64_t firstSeq, uint64_t lastSeq, const vector<Sample> &samples) -> string
+  {
+    SegmentFile file;
+    auto path = m_dir + "/" + SegmentStore::getSealedName(firstSeq, lastSeq);
+
+    EXPECT_TRUE(file.create(m_dir + "/" + to_string(firstSeq) + ".open", firstSeq, lastSeq));
+    EXPECT_TRUE(appendSeries(file, "user", samples));
+    EXPECT_TRUE(file.seal(path));
+
+    return path;
+  }
+
+  auto countFiles(void) -> size_t
+  {
+    size_t count = 0;
+    for (auto it = filesystem::directory_iterator(m_dir); it != filesystem::directory_iterator();
+         ++it) {
+      count++;
+    }
+    return count;
+  }
+
+  static auto readSeries(const SegmentReader &reader, const string &field) -> vector<Sample>
+  {
+    vector<Sample> samples;
+    SeriesReader::Block block;
+    string buffer;
+
+    auto series = reader.findSeries("SysProcStat", "cpu0", field);
+    if (series == nullptr) {
+      return samples;
+    }
+    for (const auto &entry : series->blocks) {
+      EXPECT_TRUE(reader.readBlock(entry, block, buffer));
+      SeriesDecoder decoder(block.type, block.samples, block.count);
+      uint64_t time;
+      uint64_t value;
+      while (decoder.next(time, value)) {
+        samples.emplace_back(time, value);
+      }
+    }
+
+    return samples;
+  }
+
+protected:
+  string m_dir;
+};
+
+TEST_F(GTestSegmentStore, sealedSegment)
+{
+  const vector<Sample> user = {{100, 1}, {101, 5}, {102, 9}};
+  const vector<Sample> system = {{100, 7}, {101, 7}};
+  const vector<Sample> userNext = {{103, 12}, {104, 20}};
+  auto openPath = m_dir + "/1.open";
+  auto sealedPath = m_dir + "/" + SegmentStore::getSealedName(1, 2);
+
+  SegmentFile file;
+  ASSERT_TRUE(file.create(openPath, 1, 2));
+  ASSERT_TRUE(appendSeries(file, "user", user));
+  ASSERT_TRUE(appendSeries(file, "system", system));
+  ASSERT_TRUE(appendSeries(file, "user", userNext));
+  EXPECT_EQ(file.getBlockCount(), 3u);
+  ASSERT_TRUE(file.seal(sealedPath));
+  EXPECT_FALSE(filesystem::exists(openPath));
+
+  SegmentReader reader(sealedPath);
+  ASSERT_TRUE(reader.isOpen());
+  EXPECT_TRUE(reader.isSealed());
+  EXPECT_EQ(reader.getFirstSeq(), 1u);
+  EXPECT_EQ(reader.getLastSeq(), 2u);
+  EXPECT_EQ(reader.getSeries().size(), 2u);
+
+  auto expected = user;
+  expected.insert(expected.end(), userNext.begin(), userNext.end());
+  EXPECT_EQ(readSeries(reader, "user"), expected);
+  EXPECT_EQ(readSeries(reader, "system"), system);
+  EXPECT_EQ(reader.findSeries("SysProcStat", "cpu0", "idle"), nullptr);
+}
+
+TEST_F(GTestSegmentStore, openSegment)
+{
+  auto openPath = m_dir + "/1.open";
+  uint64_t validSize = 0;
+  {
+    SegmentFile file;
+    ASSERT_TRUE(file.create(openPath, 1, 1));
+    ASSERT_TRUE(appendSeries(file, "user", {{100, 1}, {101, 2}}));
+    validSize = file.getSize();
+    ASSERT_TRUE(appendSeries(file, "user", {{102, 3}, {103, 4}}));
+    filesystem::copy_file(openPath, openPath + ".copy");
+  }
+
+  // An unsealed file is discarded on destruction, the copy stands for the
+  // file left by a crash. Cut its last block short.
+  EXPECT_FALSE(filesystem::exists(openPath));
+  filesystem::rename(openPath + ".copy", openPath);
+  filesystem::resize_file(openPath, filesystem::file_size(openPath) - 2);
+
+  {
+    SegmentReader reader(openPath);
+    ASSERT_TRUE(reader.isOpen());
+    EXPECT_FALSE(reader.isSealed());
+    EXPECT_EQ(reader.getValidSize(), validSize);
+    EXPECT_EQ(readSeries(reader, "user"), (vector<Sample>{{100, 1}, {101, 2}}));
+  }
+
+  // Recovery drops the cut block and appends after the valid ones
+  SegmentFile file;
+  ASSERT_TRUE(file.recover(openPath));
+  EXPECT_EQ(file.getSize(), validSize);
+  ASSERT_TRUE(appendSeries(file, "user", {{102, 3}}));
+  auto sealedPath = m_dir + "/" + SegmentStore::getSealedName(1, 1);
+  ASSERT_TRUE(file.seal(sealedPath));
+
+  SegmentReader reader(sealedPath);
+  ASSERT_TRUE(reader.isSealed());
+  EXPECT_EQ(readSeries(reader, "user"), (vector<Sample>{{100, 1}, {101, 2}, {102, 3}}));
+}
+
+TEST_F(GTestSegmentStore, segmentNames)
+{
+  uint64_t firstSeq = 0;
+  uint64_t lastSeq = 0;
+
+  auto name = SegmentStore::getSealedName(0x1f, 0xabc);
+  EXPECT_EQ(name, "000000000000001f-0000000000000abc.seg");
+  ASSERT_TRUE(SegmentStore::parseName(name, firstSeq, lastSeq));
+  EXPECT_EQ(firstSeq, 0x1fu);
+  EXPECT_EQ(lastSeq, 0xabcu);
+
+  for (const auto *invalid : {"000000000000001f-0000000000000abc.open",
+                              "000000000000001f-0000000000000abc.tmp",
+                              "0000000000000002-0000000000000001.seg",
+                              "000000000000001F-0000000000000abc.seg",
+                              "1f-abc.seg"}) {
+    EXPECT_FALSE(SegmentStore::parseName(invalid, firstSeq, lastSeq)) << invalid;
+  }
+}
+
+TEST_F(GTestSegmentStore, coveredSegmentsLeftOut)
+{
+  writeSegment(1, 1, {{100, 1}});
+  writeSegment(2, 2, {{101, 2}});
+  writeSegment(1, 2, {{100, 1}, {101, 2}});
+  writeSegment(3, 3, {{102, 3}});
+  SegmentFile open;
+  ASSERT_TRUE(open.create(m_dir + "/4.open", 4, 4));
+
+  // The compacted segment replaces the ones it covers, open segments are not listed
+  auto segments = SegmentStore::listSegments(m_dir);
+  ASSERT_EQ(segments.size(), 2u);
+  EXPECT_EQ(segments[0].firstSeq, 1u);
+  EXPECT_EQ(segments[0].lastSeq, 2u);
+  EXPECT_EQ(segments[1].firstSeq, 3u);
+  EXPECT_EQ(segments[1].lastSeq, 3u);
+
+  SegmentStore store(m_dir);
+  ASSERT_EQ(store.getReaders().size(), 2u);
+  EXPECT_EQ(readSeries(*store.getReaders()[0], "user"), (vector<Sample>{{100, 1}, {101, 2}}));
+}
+
+TEST_F(GTestSegmentStore, compactSmallSegments)
+{
+  vector<Sample> expected;
+  for (uint64_t seq = 1; seq <= 4; seq++) {
+    vector<Sample> samples;
+    for (uint64_t i = 0; i < 10; i++) {
+      samples.emplace_back(seq * 100 + i, seq * i);
+    }
+    writeSegment(seq, seq, samples);
+    expected.insert(expected.end(), samples.begin(), samples.end());
+  }
+
+  SegmentCompactor compactor(SegmentCompactor::Config{.path = m_dir,
+                                                      .compactSize = 1024 * 1024,
+                                                      .compactCount = 4,
+                                                      .segmentSize = 64 * 1024 * 1024,
+                                                      .blockSize = 4096,
+                                                      .archiveAge = 0,
+                                                      .archiveSize = 0,
+                                                      .archiveBlockSize = 0});
+  compactor.start();
+  compactor.notify();
+
+  for (int i = 0; (i < 500) && (countFiles() != 1); i++) {
+    this_thread::sleep_for(chrono::milliseconds(10));
+  }
+  compactor.stop();
+
+  // The merged segment covers the run and the inputs are removed
+  auto segments = SegmentStore::listSegments(m_dir);
+  ASSERT_EQ(countFiles(), 1u);
+  ASSERT_EQ(segments.size(), 1u);
+  EXPECT_EQ(segments[0].firstSeq, 1u);
+  EXPECT_EQ(segments[0].lastSeq, 4u);
+
+  SegmentReader reader(segments[0].path);
+  ASSERT_TRUE(reader.isSealed());
+  EXPECT_EQ(readSeries(reader, "user"), expected);
+}
+
+TEST_F(GTestSegmentStore, shortRunNotCompacted)
+{
+  for (uint64_t seq = 1; seq <= 3; seq++) {
+    writeSegment(seq, seq, {{seq, seq}});
+  }
+
+  SegmentCompactor compactor(SegmentCompactor::Config{.path = m_dir,
+                                                      .compactSize = 1024 * 1024,
+                                                      .compactCount = 4,
+                                                      .segmentSize = 64 * 1024 * 1024,
+                                                      .blockSize = 4096,
+                                                      .archiveAge = 0,
+                                                      .archiveSize = 0,
+                                                      .archiveBlockSize = 0});
+  compactor.start();
+  compactor.notify();
+  this_thread::sleep_for(chrono::milliseconds(100));
+  compactor.stop();
+
+  EXPECT_EQ(countFiles(), 3u);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
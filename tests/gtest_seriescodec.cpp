@@ -0,0 +1,168 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SeriesCodec Unit Tests
+ * @details   GTests for series sample encoding and decoding
+ *-
+ */
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "../source/SeriesCodec.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+typedef pair<uint64_t, uint64_t> Sample;
+
+class GTestSeriesCodec : public ::testing::Test
+{
+protected:
+  static auto doubleBits(double val) -> uint64_t
+  {
+    uint64_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    return bits;
+  }
+
+  // Encode the samples and expect the same samples back
+  static void roundTrip(series::Type type, const vector<Sample> &samples)
+  {
+    SeriesEncoder encoder(type);
+    encoder.reset();
+    for (const auto &[time, value] : samples) {
+      encoder.append(time, value);
+    }
+    ASSERT_EQ(encoder.getCount(), samples.size());
+    ASSERT_EQ(encoder.getFirstTime(), samples.front().first);
+    ASSERT_EQ(encoder.getLastTime(), samples.back().first);
+
+    SeriesDecoder decoder(type, encoder.view(), encoder.getCount());
+    uint64_t time = 0;
+    uint64_t value = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+      ASSERT_TRUE(decoder.next(time, value)) << "sample " << i;
+      EXPECT_EQ(time, samples[i].first) << "sample " << i;
+      EXPECT_EQ(value, samples[i].second) << "sample " << i;
+    }
+    EXPECT_FALSE(decoder.next(time, value));
+  }
+};
+
+TEST_F(GTestSeriesCodec, regularSamples)
+{
+  vector<Sample> samples;
+  for (uint64_t i = 0; i < 1000; i++) {
+    samples.emplace_back(1646128800 + i, 4096 + i / 10);
+  }
+  roundTrip(series::Type::UInt64, samples);
+
+  // Constant interval and value, one bit for each after the second sample
+  SeriesEncoder encoder(series::Type::UInt64);
+  encoder.reset();
+  for (uint64_t i = 0; i < 1000; i++) {
+    encoder.append(1646128800 + i, 42);
+  }
+  EXPECT_LT(encoder.getBytes(), 16 + 2 + 1000 * 2 / 8 + 1);
+}
+
+TEST_F(GTestSeriesCodec, timeGoingBackwards)
+{
+  roundTrip(series::Type::UInt64,
+            {{1000, 1}, {1001, 2}, {999, 3}, {500, 4}, {501, 5}, {0, 6}, {1000000, 7}});
+  roundTrip(series::Type::Double, {{1000, doubleBits(1.5)}, {10, doubleBits(2.5)}});
+}
+
+TEST_F(GTestSeriesCodec, timeDeltaBuckets)
+{
+  // Delta of delta at the edges of the 7, 9 and 12 bit buckets
+  vector<Sample> samples{{0, 0}, {100, 0}};
+  for (int64_t dod : {-63, 64, 65, -64, -255, 256, 257, -256, -2047, 2048, 2049, -2048}) {
+    auto last = samples.back().first;
+    auto delta = static_cast<int64_t>(last - samples[samples.size() - 2].first);
+    samples.emplace_back(last + static_cast<uint64_t>(delta + dod), 0);
+  }
+  roundTrip(series::Type::Int64, samples);
+}
+
+TEST_F(GTestSeriesCodec, wideDeltas)
+{
+  const auto max = numeric_limits<uint64_t>::max();
+
+  roundTrip(series::Type::UInt64,
+            {{0, 0}, {max, max}, {0, 0}, {max / 2, 1}, {max, max / 2 + 7}, {1, max}});
+  roundTrip(series::Type::Int64,
+            {{10, static_cast<uint64_t>(numeric_limits<int64_t>::min())},
+             {20, static_cast<uint64_t>(numeric_limits<int64_t>::max())},
+             {30, static_cast<uint64_t>(numeric_limits<int64_t>::min())},
+             {40, static_cast<uint64_t>(int64_t(-1))}});
+}
+
+TEST_F(GTestSeriesCodec, specialDoubles)
+{
+  const auto inf = numeric_limits<double>::infinity();
+  const auto nan = numeric_limits<double>::quiet_NaN();
+
+  // Values are compared as bits, NaN payloads and the zero signs are kept
+  roundTrip(series::Type::Double,
+            {{1, doubleBits(0.0)},
+             {2, doubleBits(-0.0)},
+             {3, doubleBits(0.0)},
+             {4, doubleBits(nan)},
+             {5, doubleBits(-nan)},
+             {6, doubleBits(nan)},
+             {7, doubleBits(inf)},
+             {8, doubleBits(-inf)},
+             {9, doubleBits(numeric_limits<double>::denorm_min())},
+             {10, doubleBits(numeric_limits<double>::max())},
+             {11, doubleBits(numeric_limits<double>::lowest())},
+             {12, doubleBits(1.0)},
+             {13, 0xffffffffffffffff},
+             {14, 0x0000000000000001}});
+}
+
+TEST_F(GTestSeriesCodec, doubleWindows)
+{
+  // Slow moving gauge, the xor window is reused or widened
+  vector<Sample> samples;
+  double value = 0.25;
+  for (uint64_t i = 0; i < 500; i++) {
+    value += (i % 7 == 0) ? 0.125 : std::sin(static_cast<double>(i)) / 1000;
+    samples.emplace_back(i, doubleBits(value));
+  }
+  roundTrip(series::Type::Double, samples);
+}
+
+TEST_F(GTestSeriesCodec, truncatedStream)
+{
+  SeriesEncoder encoder(series::Type::UInt64);
+  encoder.reset();
+  for (uint64_t i = 0; i < 100; i++) {
+    encoder.append(i * 1000003, i * i * i);
+  }
+
+  // A short stream fails instead of returning made up samples
+  auto data = encoder.view().substr(0, encoder.getBytes() / 2);
+  SeriesDecoder decoder(series::Type::UInt64, data, encoder.getCount());
+  uint64_t time = 0;
+  uint64_t value = 0;
+  size_t decoded = 0;
+  while (decoder.next(time, value)) {
+    decoded++;
+  }
+  EXPECT_LT(decoded, encoder.getCount());
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
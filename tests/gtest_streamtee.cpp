@@ -0,0 +1,213 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     StreamTee Unit Tests
+ * @details   GTests for the monitor stream tee and reading the teed files
+ *-
+ */
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <taskmonitor/taskmonitor.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../source/CaptureReader.h"
+#include "../source/StreamTee.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+typedef tkm::IAsyncEnvelope::Status Status;
+
+class GTestStreamTee : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_dir = ::testing::TempDir() + "gtest_streamtee";
+    filesystem::remove_all(m_dir);
+    filesystem::create_directories(m_dir);
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, m_sockets), 0);
+  }
+  void TearDown() override
+  {
+    closeMonitor();
+    if (m_sockets[0] >= 0) {
+      ::close(m_sockets[0]);
+    }
+    filesystem::remove_all(m_dir);
+  }
+
+  void closeMonitor(void)
+  {
+    if (m_sockets[1] >= 0) {
+      ::close(m_sockets[1]);
+      m_sockets[1] = -1;
+    }
+  }
+
+  // Pump until the monitor side is closed and return what the reader got
+  static auto pumpAll(StreamTee &tee) -> string
+  {
+    string received;
+    char buffer[4096];
+
+    for (;;) {
+      auto status = tee.pump();
+      if (status == Status::EndOfFile) {
+        break;
+      }
+      EXPECT_NE(status, Status::Error);
+      if (status == Status::Again) {
+        this_thread::yield();
+      }
+      ssize_t count;
+      while ((count = ::read(tee.getReaderFD(), buffer, sizeof(buffer))) > 0) {
+        received.append(buffer, static_cast<size_t>(count));
+      }
+    }
+
+    return received;
+  }
+
+  auto listFiles(void) -> vector<string>
+  {
+    vector<string> paths;
+    for (const auto &entry : filesystem::directory_iterator(m_dir)) {
+      paths.push_back(entry.path().string());
+    }
+    sort(paths.begin(), paths.end());
+    return paths;
+  }
+
+  static auto readFile(const string &path) -> string
+  {
+    ifstream in(path, ifstream::binary);
+    stringstream content;
+    content << in.rdbuf();
+    return content.str();
+  }
+
+protected:
+  string m_dir;
+  int m_sockets[2] = {-1, -1};
+};
+
+TEST_F(GTestStreamTee, nothingToPump)
+{
+  StreamTee tee(m_sockets[0]);
+  EXPECT_EQ(tee.pump(), Status::Again);
+
+  closeMonitor();
+  EXPECT_EQ(tee.pump(), Status::EndOfFile);
+}
+
+TEST_F(GTestStreamTee, readerAndFileGetTheStream)
+{
+  StreamTee tee(m_sockets[0]);
+  tee.open(m_dir + "/stream.bin");
+
+  // More than the pipes hold, written while pumping
+  string sent;
+  for (size_t i = 0; sent.size() < 4 * 1024 * 1024; i++) {
+    sent += to_string(i) + "\n";
+  }
+  thread monitor([this, &sent]() {
+    size_t offset = 0;
+    while (offset < sent.size()) {
+      auto count = ::write(m_sockets[1], sent.data() + offset, sent.size() - offset);
+      ASSERT_GT(count, 0);
+      offset += static_cast<size_t>(count);
+    }
+    closeMonitor();
+  });
+  auto received = pumpAll(tee);
+  monitor.join();
+
+  EXPECT_EQ(received, sent);
+  auto files = listFiles();
+  ASSERT_EQ(files.size(), 1u);
+  EXPECT_EQ(files[0].rfind(m_dir + "/stream-", 0), 0u);
+  EXPECT_EQ(readFile(files[0]), sent);
+}
+
+TEST_F(GTestStreamTee, fileForEachConnection)
+{
+  StreamTee tee(m_sockets[0]);
+
+  // Bytes before a file is opened only reach the reader
+  ASSERT_EQ(::write(m_sockets[1], "lost", 4), 4);
+  EXPECT_EQ(tee.pump(), Status::Ok);
+
+  tee.open(m_dir + "/stream.bin");
+  ASSERT_EQ(::write(m_sockets[1], "first", 5), 5);
+  EXPECT_EQ(tee.pump(), Status::Ok);
+
+  tee.open(m_dir + "/stream.bin");
+  ASSERT_EQ(::write(m_sockets[1], "second", 6), 6);
+  EXPECT_EQ(tee.pump(), Status::Ok);
+
+  char buffer[64];
+  auto count = ::read(tee.getReaderFD(), buffer, sizeof(buffer));
+  EXPECT_EQ(string(buffer, static_cast<size_t>(max<ssize_t>(count, 0))), "lostfirstsecond");
+
+  // Files opened within the same second get a counter
+  auto files = listFiles();
+  ASSERT_EQ(files.size(), 2u);
+  string content = readFile(files[0]) + readFile(files[1]);
+  EXPECT_TRUE((content == "firstsecond") || (content == "secondfirst")) << content;
+}
+
+TEST_F(GTestStreamTee, readTeedEnvelopes)
+{
+  StreamTee tee(m_sockets[0]);
+  tee.open(m_dir + "/stream.bin");
+
+  tkm::EnvelopeWriter writer(m_sockets[1]);
+  for (uint64_t i = 1; i <= 3; i++) {
+    tkm::msg::monitor::Data data;
+    tkm::msg::monitor::Message msg;
+    tkm::msg::Envelope envelope;
+
+    data.set_system_time_sec(1000 + i);
+    msg.set_type(tkm::msg::monitor::Message_Type_Data);
+    msg.mutable_payload()->PackFrom(data);
+    envelope.mutable_mesg()->PackFrom(msg);
+    ASSERT_EQ(writer.send(envelope), Status::Ok);
+  }
+  closeMonitor();
+  pumpAll(tee);
+
+  // The teed file has no capture header and is read as envelope stream
+  auto files = listFiles();
+  ASSERT_EQ(files.size(), 1u);
+  CaptureReader reader(files[0]);
+  ASSERT_TRUE(reader.isOpen());
+
+  CaptureReader::Frame frame;
+  for (uint64_t i = 1; i <= 3; i++) {
+    ASSERT_EQ(reader.next(frame), CaptureReader::Status::Ok);
+    EXPECT_EQ(frame.type, capture::FrameType::Envelope);
+    EXPECT_EQ(frame.receiveTime, (1000 + i) * 1000000);
+
+    tkm::msg::Envelope envelope;
+    EXPECT_TRUE(envelope.ParseFromString(frame.payload));
+  }
+  EXPECT_EQ(reader.next(frame), CaptureReader::Status::EndOfFile);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,241 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     TierQuery Unit Tests
+ * @details   GTests for the hot window, archive segments and tiered queries
+ *-
+ */
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../source/HotWindow.h"
+#include "../source/SegmentCompactor.h"
+#include "../source/SegmentFile.h"
+#include "../source/SegmentStore.h"
+#include "../source/SeriesCodec.h"
+#include "../source/TierQuery.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+typedef pair<uint64_t, uint64_t> Sample;
+
+class GTestTierQuery : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    m_dir = ::testing::TempDir() + "gtest_tierquery";
+    filesystem::remove_all(m_dir);
+    filesystem::create_directories(m_dir);
+  }
+  void TearDown() override { filesystem::remove_all(m_dir); }
+
+  // Segment holding the samples of the "user" series in one block
+  void writeSegment(uint64_t seq,
+                    const vector<Sample> &samples,
+                    string_view extension = segments::SealedExtension)
+  {
+    SeriesEncoder encoder(series::Type::UInt64);
+    encoder.reset();
+    for (const auto &[time, value] : samples) {
+      encoder.append(time, value);
+    }
+
+    SeriesReader::Block block{.type = series::Type::UInt64,
+                              .count = encoder.getCount(),
+                              .firstTime = encoder.getFirstTime(),
+                              .lastTime = encoder.getLastTime(),
+                              .device = "device",
+                              .source = "SysProcStat",
+                              .entity = "cpu0",
+                              .field = "user",
+                              .samples = encoder.view()};
+    auto deflate = (extension == segments::ArchiveExtension);
+
+    SegmentFile file;
+    ASSERT_TRUE(file.create(m_dir + "/" + to_string(seq) + ".open", seq, seq));
+    ASSERT_TRUE(file.appendBlock(block, deflate));
+    ASSERT_TRUE(file.seal(m_dir + "/" + SegmentStore::getSealedName(seq, seq, extension)));
+  }
+
+  static auto samplesFrom(uint64_t first, uint64_t last) -> vector<Sample>
+  {
+    vector<Sample> samples;
+    for (auto time = first; time <= last; time++) {
+      samples.emplace_back(time, time * 10);
+    }
+    return samples;
+  }
+
+  static auto query(TierQuery &tiers, uint64_t begin, uint64_t end) -> vector<Sample>
+  {
+    vector<Sample> samples;
+    series::Type type;
+
+    auto found = tiers.query(
+        "SysProcStat", "cpu0", "user", begin, end, type, [&samples](uint64_t time, uint64_t value) {
+          samples.emplace_back(time, value);
+        });
+    EXPECT_TRUE(found);
+    return samples;
+  }
+
+protected:
+  string m_dir;
+};
+
+TEST_F(GTestTierQuery, hotWindowKeepsRecentSamples)
+{
+  HotWindow window(10);
+  series::Type type;
+  vector<Sample> samples;
+  auto visit = [&samples](uint64_t time, uint64_t value) { samples.emplace_back(time, value); };
+
+  for (uint64_t time = 100; time <= 120; time++) {
+    window.append("SysProcStat", "cpu0", "user", series::Type::UInt64, time, time * 10);
+  }
+  // Late samples and samples of another type are dropped
+  window.append("SysProcStat", "cpu0", "user", series::Type::UInt64, 115, 0);
+  window.append("SysProcStat", "cpu0", "user", series::Type::Double, 121, 0);
+
+  uint64_t firstTime = 0;
+  ASSERT_TRUE(window.getFirstTime("SysProcStat", "cpu0", "user", firstTime));
+  EXPECT_EQ(firstTime, 110u);
+  EXPECT_EQ(window.getSampleCount(), 11u);
+
+  ASSERT_TRUE(window.query("SysProcStat", "cpu0", "user", 0, 1000, type, visit));
+  EXPECT_EQ(type, series::Type::UInt64);
+  EXPECT_EQ(samples, samplesFrom(110, 120));
+
+  samples.clear();
+  ASSERT_TRUE(window.query("SysProcStat", "cpu0", "user", 112, 114, type, visit));
+  EXPECT_EQ(samples, samplesFrom(112, 114));
+
+  EXPECT_FALSE(window.query("SysProcStat", "cpu1", "user", 0, 1000, type, visit));
+  EXPECT_FALSE(window.getFirstTime("SysProcStat", "cpu1", "user", firstTime));
+}
+
+TEST_F(GTestTierQuery, hotWindowDropsStoppedSeries)
+{
+  HotWindow window(8);
+
+  window.append("ProcInfo", "42", "rss", series::Type::UInt64, 100, 1);
+  for (uint64_t time = 100; time <= 120; time++) {
+    window.append("SysProcStat", "cpu0", "user", series::Type::UInt64, time, time);
+  }
+
+  // The exited process has no sample in the window and is pruned
+  uint64_t firstTime = 0;
+  EXPECT_EQ(window.getSeriesCount(), 1u);
+  EXPECT_FALSE(window.getFirstTime("ProcInfo", "42", "rss", firstTime));
+}
+
+TEST_F(GTestTierQuery, archiveReplacesSegment)
+{
+  writeSegment(1, samplesFrom(100, 109));
+  writeSegment(1, samplesFrom(100, 109), segments::ArchiveExtension);
+  writeSegment(2, samplesFrom(110, 119));
+
+  auto segments = SegmentStore::listSegments(m_dir);
+  ASSERT_EQ(segments.size(), 2u);
+  EXPECT_TRUE(segments[0].archived);
+  EXPECT_EQ(segments[0].lastSeq, 1u);
+  EXPECT_FALSE(segments[1].archived);
+
+  // Archive blocks are inflated on read
+  TierQuery tiers(m_dir, nullptr);
+  EXPECT_EQ(query(tiers, 0, 1000), samplesFrom(100, 119));
+  EXPECT_EQ(tiers.getStats().archiveSamples, 10u);
+  EXPECT_EQ(tiers.getStats().storeSamples, 10u);
+  EXPECT_EQ(tiers.getStats().blocksRead, 2u);
+}
+
+TEST_F(GTestTierQuery, hotWindowBeforeStore)
+{
+  HotWindow window(15);
+
+  writeSegment(1, samplesFrom(50, 59), segments::ArchiveExtension);
+  writeSegment(2, samplesFrom(100, 109));
+  for (const auto &[time, value] : samplesFrom(105, 120)) {
+    window.append("SysProcStat", "cpu0", "user", series::Type::UInt64, time, value);
+  }
+
+  // The store only answers the part older than the first hot sample
+  TierQuery tiers(m_dir, &window);
+  auto expected = samplesFrom(50, 59);
+  auto recent = samplesFrom(100, 120);
+  expected.insert(expected.end(), recent.begin(), recent.end());
+  EXPECT_EQ(query(tiers, 0, 1000), expected);
+  EXPECT_EQ(tiers.getStats().archiveSamples, 10u);
+  EXPECT_EQ(tiers.getStats().storeSamples, 5u);
+  EXPECT_EQ(tiers.getStats().hotSamples, 16u);
+
+  // Queries within the hot window read no block
+  EXPECT_EQ(query(tiers, 106, 108), samplesFrom(106, 108));
+  EXPECT_EQ(tiers.getStats().blocksRead, 0u);
+  EXPECT_EQ(tiers.getStats().hotSamples, 3u);
+
+  // Blocks outside the range are skipped
+  EXPECT_EQ(query(tiers, 101, 103), samplesFrom(101, 103));
+  EXPECT_EQ(tiers.getStats().blocksRead, 1u);
+  EXPECT_EQ(tiers.getStats().storeSamples, 3u);
+}
+
+TEST_F(GTestTierQuery, archiveOldSegments)
+{
+  // Sample times far in the past are older than any archive age
+  for (uint64_t seq = 1; seq <= 3; seq++) {
+    writeSegment(seq, samplesFrom(seq * 100, seq * 100 + 9));
+  }
+
+  SegmentCompactor compactor(SegmentCompactor::Config{.path = m_dir,
+                                                      .compactSize = 1024 * 1024,
+                                                      .compactCount = 100,
+                                                      .segmentSize = 64 * 1024 * 1024,
+                                                      .blockSize = 4096,
+                                                      .archiveAge = 3600,
+                                                      .archiveSize = 64 * 1024 * 1024,
+                                                      .archiveBlockSize = 65536});
+  compactor.start();
+  compactor.notify();
+
+  vector<SegmentStore::Segment> segments;
+  for (int i = 0; i < 500; i++) {
+    segments = SegmentStore::listSegments(m_dir);
+    if ((segments.size() == 1) && segments[0].archived) {
+      break;
+    }
+    this_thread::sleep_for(chrono::milliseconds(10));
+  }
+  compactor.stop();
+
+  ASSERT_EQ(segments.size(), 1u);
+  EXPECT_TRUE(segments[0].archived);
+  EXPECT_EQ(segments[0].firstSeq, 1u);
+  EXPECT_EQ(segments[0].lastSeq, 3u);
+
+  TierQuery tiers(m_dir, nullptr);
+  auto expected = samplesFrom(100, 109);
+  for (uint64_t seq = 2; seq <= 3; seq++) {
+    auto samples = samplesFrom(seq * 100, seq * 100 + 9);
+    expected.insert(expected.end(), samples.begin(), samples.end());
+  }
+  EXPECT_EQ(query(tiers, 0, 1000), expected);
+  EXPECT_EQ(tiers.getStats().archiveSamples, 30u);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,173 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     TimingWheel Unit Tests
+ * @details   GTests for the data source request timing wheel
+ *-
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../source/TimingWheel.h"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace tkm::reader;
+
+typedef vector<shared_ptr<DataSource>> Due;
+
+// 100 msec ticks as the default scheduler resolution
+static constexpr uint64_t Resolution = 100000;
+
+class GTestTimingWheel : public ::testing::Test
+{
+protected:
+  static auto makeSource(const string &name, uint64_t intervalUs, uint64_t offsetUs = 0)
+      -> shared_ptr<DataSource>
+  {
+    auto source = make_shared<DataSource>(name,
+                                          intervalUs,
+                                          name,
+                                          tkm::msg::collector::Request_Type_GetSysProcStat,
+                                          tkm::msg::monitor::Data_What_SysProcStat);
+    source->setOffset(offsetUs);
+    return source;
+  }
+
+  // Ticks up to last at which the source is due
+  static auto dueTicks(TimingWheel &wheel, const shared_ptr<DataSource> &source, uint64_t last)
+      -> vector<uint64_t>
+  {
+    vector<uint64_t> ticks;
+    for (auto tick = wheel.getTick() + 1; tick <= last; tick++) {
+      Due due;
+      wheel.advanceTo(tick, due);
+      for (const auto &entry : due) {
+        if (entry == source) {
+          ticks.push_back(tick);
+        }
+      }
+    }
+    return ticks;
+  }
+};
+
+TEST_F(GTestTimingWheel, firstRequestAfterOffset)
+{
+  TimingWheel wheel(Resolution);
+  auto source = makeSource("stat", 1000000, 250000);
+
+  // The offset is rounded up to the next tick, then the interval repeats
+  wheel.schedule(source);
+  EXPECT_EQ(dueTicks(wheel, source, 25), (vector<uint64_t>{3, 13, 23}));
+
+  // Without offset the first request is due on the next tick
+  TimingWheel other(Resolution);
+  auto first = makeSource("stat", 1000000);
+  other.schedule(first);
+  EXPECT_EQ(dueTicks(other, first, 12), (vector<uint64_t>{1, 11}));
+}
+
+TEST_F(GTestTimingWheel, disabledSource)
+{
+  TimingWheel wheel(Resolution);
+  auto source = makeSource("stat", 0);
+
+  wheel.schedule(source);
+  EXPECT_TRUE(dueTicks(wheel, source, 100).empty());
+}
+
+TEST_F(GTestTimingWheel, dueOnceWhileCatchingUp)
+{
+  TimingWheel wheel(Resolution);
+  auto fast = makeSource("fast", Resolution);
+  auto slow = makeSource("slow", 10 * Resolution);
+
+  wheel.schedule(fast);
+  wheel.schedule(slow);
+
+  // A late timer processes every elapsed tick, each source is due only once
+  Due due;
+  wheel.advanceTo(50, due);
+  EXPECT_EQ(wheel.getTick(), 50u);
+  ASSERT_EQ(due.size(), 2u);
+  EXPECT_EQ(due[0], fast);
+  EXPECT_EQ(due[1], slow);
+
+  // Both keep their period after catching up
+  EXPECT_EQ(dueTicks(wheel, slow, 61), (vector<uint64_t>{51, 61}));
+}
+
+TEST_F(GTestTimingWheel, rescheduleDropsPendingEntry)
+{
+  TimingWheel wheel(Resolution);
+  auto source = makeSource("stat", 1000000);
+
+  wheel.schedule(source);
+  EXPECT_EQ(dueTicks(wheel, source, 5), (vector<uint64_t>{1}));
+
+  wheel.reschedule(source, 200000);
+  EXPECT_EQ(dueTicks(wheel, source, 20), (vector<uint64_t>{7, 17}));
+
+  // A source disabled meanwhile is not placed again
+  source->setInterval(0);
+  wheel.reschedule(source, 0);
+  EXPECT_TRUE(dueTicks(wheel, source, 40).empty());
+}
+
+TEST_F(GTestTimingWheel, intervalChangeOnNextPeriod)
+{
+  TimingWheel wheel(Resolution);
+  auto source = makeSource("stat", 1000000);
+
+  wheel.schedule(source);
+  EXPECT_EQ(dueTicks(wheel, source, 1), (vector<uint64_t>{1}));
+
+  // The next expiry is already placed, the stretched interval applies after it
+  source->setStretch(3);
+  EXPECT_EQ(dueTicks(wheel, source, 45), (vector<uint64_t>{11, 41}));
+
+  source->setStretch(1);
+  source->setBurstInterval(Resolution);
+  EXPECT_EQ(dueTicks(wheel, source, 75), (vector<uint64_t>{71, 72, 73, 74, 75}));
+}
+
+TEST_F(GTestTimingWheel, longIntervalsCascade)
+{
+  TimingWheel wheel(Resolution);
+  auto hour = makeSource("hour", 3600000000, 3600000000);
+
+  // 36000 ticks are held by the third level and cascaded down
+  wheel.schedule(hour);
+  Due due;
+  wheel.advanceTo(35999, due);
+  EXPECT_TRUE(due.empty());
+  wheel.advanceTo(36000, due);
+  ASSERT_EQ(due.size(), 1u);
+  EXPECT_EQ(dueTicks(wheel, hour, 72001), (vector<uint64_t>{72000}));
+}
+
+TEST_F(GTestTimingWheel, expiryBeyondWheelSpan)
+{
+  TimingWheel wheel(1);
+  auto source = makeSource("month", 1UL << 30, 1UL << 30);
+
+  // Expiries past the 2^24 ticks of the wheel are brought in to its last tick
+  wheel.schedule(source);
+  Due due;
+  wheel.advanceTo((1UL << 24) - 2, due);
+  EXPECT_TRUE(due.empty());
+  wheel.advanceTo((1UL << 24) - 1, due);
+  EXPECT_EQ(due.size(), 1u);
+}
+
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,528 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     CaptureConvert
+ * @details   Convert raw capture files to json or sqlite3 using all cores
+ *-
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sqlite3.h>
+#include <string>
+#include <taskmonitor/Helpers.h>
+#include <thread>
+#include <vector>
+
+#include "CaptureIndex.h"
+#include "CaptureMap.h"
+#include "CaptureReader.h"
+#include "DataRecords.h"
+#include "Defaults.h"
+#include "JsonEncoder.h"
+#include "JsonRecord.h"
+#include "Query.h"
+
+using namespace tkm::reader;
+
+typedef struct Options {
+  std::string capturePath;
+  std::string jsonPath;
+  std::string databasePath;
+  std::string deviceName;
+  std::string deviceFilter;
+  uint64_t beginTime;
+  uint64_t endTime;
+  JsonRecord::Format jsonFormat;
+  size_t threads;
+} Options;
+
+// Chunk output up to the next session start
+typedef struct Segment {
+  std::optional<tkm::msg::monitor::SessionInfo> session;
+  std::string device;
+  uint64_t startTime;
+  std::string json;
+  std::vector<std::string> queries;
+} Segment;
+
+typedef struct Chunk {
+  std::vector<Segment> segments;
+  size_t messages;
+  bool done;
+} Chunk;
+
+// Session info of a SetSession envelope payload
+static bool readSessionInfo(std::string_view payload, tkm::msg::monitor::SessionInfo &sessionInfo)
+{
+  tkm::msg::Envelope envelope;
+  tkm::msg::monitor::Message msg;
+
+  return envelope.ParseFromArray(payload.data(), static_cast<int>(payload.size())) &&
+         (envelope.origin() == tkm::msg::Envelope_Recipient_Monitor) &&
+         envelope.mesg().UnpackTo(&msg) &&
+         (msg.type() == tkm::msg::monitor::Message_Type_SetSession) &&
+         msg.payload().UnpackTo(&sessionInfo);
+}
+
+/*
+ * Take the session and device in effect at the chunk start from the session
+ * frame of the entry. The first chunk of a time window may start within a
+ * session, it gets the session from the SetSession envelope following the
+ * session frame so the output is self contained.
+ */
+static void beginChunk(const CaptureMap &capture,
+                       const CaptureIndex::Entry &entry,
+                       bool windowStart,
+                       Segment &segment,
+                       std::string &session)
+{
+  CaptureMap::Frame frame{};
+  std::vector<std::string> fields;
+
+  if (entry.sessionOffset == 0) {
+    return;
+  }
+
+  auto next = capture.frameAt(entry.sessionOffset, frame);
+  if ((next == 0) || !CaptureReader::parseSession(frame.payload, fields)) {
+    return;
+  }
+  session = fields[static_cast<size_t>(capture::SessionField::Session)];
+  segment.device = fields[static_cast<size_t>(capture::SessionField::Device)];
+
+  tkm::msg::monitor::SessionInfo sessionInfo;
+  if (windowStart && (next < entry.offset) && (capture.frameAt(next, frame) != 0) &&
+      readSessionInfo(frame.payload, sessionInfo)) {
+    segment.startTime = frame.receiveTime / 1000000;
+    sessionInfo.set_name("Replay." + std::to_string(segment.startTime));
+    segment.session = sessionInfo;
+  }
+}
+
+static void convertChunk(const Options &options,
+                         const CaptureMap &capture,
+                         const CaptureIndex &index,
+                         size_t chunkIndex,
+                         bool windowStart,
+                         Chunk &chunk)
+{
+  const auto &entry = index.getEntries()[chunkIndex];
+  auto endOffset = index.endOffset(chunkIndex);
+  CaptureMap::Frame frame{};
+  JsonEncoder encoder{};
+  JsonRecord record{encoder};
+  std::string session{};
+
+  record.setFormat(options.jsonFormat);
+  chunk.segments.push_back(Segment{});
+  beginChunk(capture, entry, windowStart, chunk.segments.back(), session);
+
+  auto device = chunk.segments.back().device;
+  auto selected = options.deviceFilter.empty() || (device == options.deviceFilter);
+  if (!selected) {
+    chunk.segments.back().session.reset();
+  }
+
+  auto offset = entry.offset;
+  while (offset < endOffset) {
+    offset = capture.frameAt(offset, frame);
+    if (offset == 0) {
+      break;
+    }
+
+    if (frame.type == capture::FrameType::Session) {
+      std::vector<std::string> fields;
+      if (CaptureReader::parseSession(frame.payload, fields)) {
+        device = fields[static_cast<size_t>(capture::SessionField::Device)];
+        selected = options.deviceFilter.empty() || (device == options.deviceFilter);
+      }
+      continue;
+    }
+    if ((frame.type != capture::FrameType::Envelope) || !selected) {
+      continue;
+    }
+
+    tkm::msg::Envelope envelope;
+    if (!envelope.ParseFromArray(frame.payload.data(), static_cast<int>(frame.payload.size())) ||
+        (envelope.origin() != tkm::msg::Envelope_Recipient_Monitor)) {
+      continue;
+    }
+
+    tkm::msg::monitor::Message msg;
+    envelope.mesg().UnpackTo(&msg);
+
+    auto receiveSec = frame.receiveTime / 1000000;
+    if (msg.type() == tkm::msg::monitor::Message_Type_SetSession) {
+      tkm::msg::monitor::SessionInfo sessionInfo;
+
+      msg.payload().UnpackTo(&sessionInfo);
+      sessionInfo.set_name("Replay." + std::to_string(receiveSec));
+      session = sessionInfo.hash();
+      chunk.segments.push_back(Segment{.session = sessionInfo,
+                                       .device = device,
+                                       .startTime = receiveSec,
+                                       .json = {},
+                                       .queries = {}});
+      continue;
+    }
+    if (msg.type() != tkm::msg::monitor::Message_Type_Data) {
+      continue;
+    }
+
+    tkm::msg::monitor::Data data;
+    msg.payload().UnpackTo(&data);
+    if ((data.system_time_sec() < options.beginTime) ||
+        (data.system_time_sec() > options.endTime)) {
+      continue;
+    }
+
+    auto &segment = chunk.segments.back();
+    visitData(data, [&](const char *type, const auto &message) {
+      if (!options.jsonPath.empty()) {
+        encoder.reset();
+        record.begin(
+            type, session, data.system_time_sec(), data.monotonic_time_sec(), receiveSec);
+        printRecord(record, message);
+        record.end();
+        if (!record.schema().empty()) {
+          segment.json.append(record.schema());
+          segment.json.push_back('\n');
+        }
+        segment.json.append(record.view());
+        segment.json.push_back('\n');
+      }
+      if (!options.databasePath.empty()) {
+        segment.queries.push_back(tkmQuery.addData(tkm::Query::Type::SQLite3,
+                                                   session,
+                                                   message,
+                                                   data.system_time_sec(),
+                                                   data.monotonic_time_sec(),
+                                                   receiveSec));
+      }
+    });
+    chunk.messages++;
+  }
+}
+
+// More threads than this only add queued chunks and memory
+constexpr size_t MaxThreads = 256;
+
+static bool parseThreads(const std::string &value, size_t &threads)
+{
+  size_t count = 0;
+  auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), count);
+
+  if ((ec != std::errc()) || (ptr != value.data() + value.size()) || (count == 0) ||
+      (count > MaxThreads)) {
+    return false;
+  }
+  threads = count;
+
+  return true;
+}
+
+// Epoch seconds or local 'YYYY-MM-DD HH:MM:SS'
+static bool parseTime(const std::string &value, uint64_t &time)
+{
+  struct tm timeInfo = {};
+
+  if (!value.empty() && (value.find_first_not_of("0123456789") == std::string::npos)) {
+    auto result = std::from_chars(value.data(), value.data() + value.size(), time);
+    return (result.ec == std::errc());
+  }
+
+  auto end = ::strptime(value.c_str(), "%Y-%m-%d %H:%M:%S", &timeInfo);
+  if ((end == nullptr) || (*end != '\0')) {
+    return false;
+  }
+  timeInfo.tm_isdst = -1;
+  time = static_cast<uint64_t>(::mktime(&timeInfo));
+
+  return true;
+}
+
+static bool runQuery(sqlite3 *db, const std::string &sql)
+{
+  char *queryError = nullptr;
+
+  if (::sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &queryError) != SQLITE_OK) {
+    std::cerr << "Database query error: " << queryError << "\n";
+    sqlite3_free(queryError);
+    return false;
+  }
+
+  return true;
+}
+
+/*
+ * Chunks are decoded and formatted by the workers. The main thread writes
+ * them out in capture order, workers stay at most a window of chunks ahead
+ * so memory use is bound by the thread count and not by the capture size.
+ * Only the chunks of the index entries covering the time window are read.
+ */
+static auto convert(const Options &options, const CaptureMap &capture, const CaptureIndex &index)
+    -> size_t
+{
+  const auto [firstChunk, lastChunk] = index.findRange(options.beginTime, options.endTime);
+  const auto window = options.threads * 4;
+  std::vector<Chunk> chunks(lastChunk - firstChunk);
+  std::atomic<size_t> nextChunk = firstChunk;
+  size_t written = firstChunk;
+  std::mutex lock;
+  std::condition_variable chunkDone;
+  std::condition_variable chunkWritten;
+
+  auto worker = [&]() {
+    for (auto i = nextChunk++; i < lastChunk; i = nextChunk++) {
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        chunkWritten.wait(guard, [&]() { return i < written + window; });
+      }
+      Chunk chunk{.segments = {}, .messages = 0, .done = true};
+      convertChunk(options, capture, index, i, (i == firstChunk), chunk);
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        chunks[i - firstChunk] = std::move(chunk);
+      }
+      chunkDone.notify_all();
+    }
+  };
+
+  std::ofstream jsonFile{};
+  if (!options.jsonPath.empty()) {
+    jsonFile.open(options.jsonPath, std::ofstream::out | std::ofstream::trunc);
+    if (!jsonFile.is_open()) {
+      std::cerr << "Cannot open json file " << options.jsonPath << "\n";
+      ::exit(EXIT_FAILURE);
+    }
+  }
+
+  sqlite3 *db = nullptr;
+  // Device hash by name, a capture can hold sessions of several devices
+  std::map<std::string, std::string> deviceHashes{};
+  std::string session{};
+  if (!options.databasePath.empty()) {
+    if (::sqlite3_open(options.databasePath.c_str(), &db) != SQLITE_OK) {
+      std::cerr << "Cannot open database " << options.databasePath << "\n";
+      ::exit(EXIT_FAILURE);
+    }
+    runQuery(db, tkmQuery.createTables(tkm::Query::Type::SQLite3));
+  }
+
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < options.threads; i++) {
+    workers.emplace_back(worker);
+  }
+
+  size_t messages = 0;
+  for (size_t i = firstChunk; i < lastChunk; i++) {
+    auto &slot = chunks[i - firstChunk];
+    Chunk chunk{};
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      chunkDone.wait(guard, [&]() { return slot.done; });
+      chunk = std::move(slot);
+      slot = Chunk{};
+    }
+
+    if (db != nullptr) {
+      runQuery(db, "BEGIN TRANSACTION;");
+    }
+    for (const auto &segment : chunk.segments) {
+      if (segment.session.has_value()) {
+        auto device = options.deviceName.empty() ? segment.device : options.deviceName;
+
+        if (jsonFile.is_open()) {
+          JsonEncoder json{};
+          json.beginObject();
+          json.field("device", device);
+          json.field("session", segment.session->hash());
+          json.field("type", "session");
+          json.endObject();
+          jsonFile << json.view() << '\n';
+        }
+        if (db != nullptr) {
+          if (!session.empty()) {
+            runQuery(db, tkmQuery.endSession(tkm::Query::Type::SQLite3, session));
+          }
+          auto deviceHash = deviceHashes.find(device);
+          if (deviceHash == deviceHashes.end()) {
+            deviceHash =
+                deviceHashes.emplace(device, std::to_string(tkm::jnkHsh(device.c_str()))).first;
+            runQuery(db,
+                     tkmQuery.addDevice(
+                         tkm::Query::Type::SQLite3, deviceHash->second, device, "", 0));
+          }
+          runQuery(db,
+                   tkmQuery.addSession(tkm::Query::Type::SQLite3,
+                                       segment.session.value(),
+                                       deviceHash->second,
+                                       segment.startTime));
+        }
+        session = segment.session->hash();
+      }
+      if (jsonFile.is_open()) {
+        jsonFile.write(segment.json.data(), static_cast<std::streamsize>(segment.json.size()));
+      }
+      if (db != nullptr) {
+        // One query per record, a failing record does not drop the chunk
+        for (const auto &query : segment.queries) {
+          runQuery(db, query);
+        }
+      }
+    }
+    if (db != nullptr) {
+      runQuery(db, "COMMIT;");
+    }
+    messages += chunk.messages;
+
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      written++;
+    }
+    chunkWritten.notify_all();
+  }
+
+  for (auto &thread : workers) {
+    thread.join();
+  }
+
+  if (db != nullptr) {
+    if (!session.empty()) {
+      runQuery(db, tkmQuery.endSession(tkm::Query::Type::SQLite3, session));
+    }
+    sqlite3_close(db);
+  }
+
+  return messages;
+}
+
+auto main(int argc, char **argv) -> int
+{
+  Options options{.capturePath = {},
+                  .jsonPath = {},
+                  .databasePath = {},
+                  .deviceName = {},
+                  .deviceFilter = {},
+                  .beginTime = 0,
+                  .endTime = std::numeric_limits<uint64_t>::max(),
+                  .jsonFormat = JsonRecord::Format::Verbose,
+                  .threads = std::clamp<size_t>(
+                      std::thread::hardware_concurrency(), 1, MaxThreads)};
+  int longIndex = 0;
+  bool version = false;
+  bool help = false;
+  int c;
+
+  struct option longopts[] = {{"json", required_argument, nullptr, 'j'},
+                              {"json-format", required_argument, nullptr, 'f'},
+                              {"database", required_argument, nullptr, 'd'},
+                              {"name", required_argument, nullptr, 'n'},
+                              {"device", required_argument, nullptr, 'D'},
+                              {"begin", required_argument, nullptr, 'b'},
+                              {"end", required_argument, nullptr, 'e'},
+                              {"threads", required_argument, nullptr, 't'},
+                              {"version", no_argument, nullptr, 'v'},
+                              {"help", no_argument, nullptr, 'h'},
+                              {nullptr, 0, nullptr, 0}};
+
+  while ((c = getopt_long(argc, argv, "j:f:d:n:D:b:e:t:vh", longopts, &longIndex)) != -1) {
+    switch (c) {
+    case 'j':
+      options.jsonPath = optarg;
+      break;
+    case 'f':
+      if (std::string(optarg) == "compact") {
+        options.jsonFormat = JsonRecord::Format::Compact;
+      } else if (std::string(optarg) != "verbose") {
+        help = true;
+      }
+      break;
+    case 'd':
+      options.databasePath = optarg;
+      break;
+    case 'n':
+      options.deviceName = optarg;
+      break;
+    case 'D':
+      options.deviceFilter = optarg;
+      break;
+    case 'b':
+      help = help || !parseTime(optarg, options.beginTime);
+      break;
+    case 'e':
+      help = help || !parseTime(optarg, options.endTime);
+      break;
+    case 't':
+      help = help || !parseThreads(optarg, options.threads);
+      break;
+    case 'v':
+      version = true;
+      break;
+    default:
+      help = true;
+      break;
+    }
+  }
+
+  if (version) {
+    std::cout << "tkmcapconv: " << tkmDefaults.getFor(Defaults::Default::Version)
+              << " libtkm: " << TKMLIB_VERSION << "\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  if (optind + 1 == argc) {
+    options.capturePath = argv[optind];
+  }
+
+  if (help || options.capturePath.empty() ||
+      (options.jsonPath.empty() && options.databasePath.empty())) {
+    std::cout << "TaskMonitorReader capture converter: capture file to json or sqlite3\n"
+              << "Version: " << tkmDefaults.getFor(Defaults::Default::Version)
+              << " libtkm: " << TKMLIB_VERSION << "\n\n";
+    std::cout << "Usage: tkmcapconv [OPTIONS] FILE\n\n";
+    std::cout << "  The capture index '<FILE>.idx' is created or updated if needed.\n";
+    std::cout << "  Times are epoch seconds or local 'YYYY-MM-DD HH:MM:SS'.\n\n";
+    std::cout << "     --json, -j      <string>  Path to output json file\n";
+    std::cout << "     --json-format, -f <str>   Json record format: verbose or compact\n";
+    std::cout << "     --database, -d  <string>  Path to output database file\n";
+    std::cout << "     --name, -n      <string>  Device name (default from capture)\n";
+    std::cout << "     --device, -D    <string>  Only convert data from this capture device\n";
+    std::cout << "     --begin, -b     <time>    Skip data with an earlier system time\n";
+    std::cout << "     --end, -e       <time>    Skip data with a later system time\n";
+    std::cout << "     --threads, -t   <int>     Decoding threads, 1 to 256 (default CPU count)\n";
+    std::cout << "     --version, -v             Print version\n";
+    std::cout << "     --help, -h                Print this help\n\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  CaptureMap capture(options.capturePath);
+  CaptureIndex index(options.capturePath);
+  if (!capture.isOpen() || !index.open()) {
+    std::cerr << "Cannot read capture file " << options.capturePath << "\n";
+    return EXIT_FAILURE;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  auto messages = convert(options, capture, index);
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  std::cout << "Converted " << messages << " messages in " << elapsed.count() << " msec\n";
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,364 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     ColumnQuery
+ * @details   Read selected columns and time ranges of column table files
+ *-
+ */
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <ctime>
+#include <getopt.h>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ColumnReader.h"
+#include "Defaults.h"
+
+using namespace tkm::reader;
+
+typedef struct Options {
+  std::string tablePath;
+  std::vector<std::string> columns;
+  uint64_t beginTime;
+  uint64_t endTime;
+  bool list;
+  bool summary;
+} Options;
+
+typedef struct Summary {
+  columns::Type type;
+  uint64_t count;
+  double min;
+  double max;
+  double sum;
+} Summary;
+
+static bool parseTime(const std::string &value, uint64_t &time)
+{
+  struct tm timeInfo = {};
+
+  if (!value.empty() && (value.find_first_not_of("0123456789") == std::string::npos)) {
+    auto result = std::from_chars(value.data(), value.data() + value.size(), time);
+    return (result.ec == std::errc());
+  }
+
+  auto end = ::strptime(value.c_str(), "%Y-%m-%d %H:%M:%S", &timeInfo);
+  if ((end == nullptr) || (*end != '\0')) {
+    return false;
+  }
+  timeInfo.tm_isdst = -1;
+  time = static_cast<uint64_t>(::mktime(&timeInfo));
+
+  return true;
+}
+
+static auto typeName(columns::Type type) -> const char *
+{
+  switch (type) {
+  case columns::Type::UInt64:
+    return "uint64";
+  case columns::Type::Int64:
+    return "int64";
+  case columns::Type::Double:
+    return "double";
+  case columns::Type::String:
+    return "string";
+  default:
+    break;
+  }
+  return "unknown";
+}
+
+static auto numberAt(const ColumnReader::Column &column, size_t row) -> double
+{
+  switch (column.type) {
+  case columns::Type::UInt64:
+    return static_cast<double>(ColumnReader::uintAt(column, row));
+  case columns::Type::Int64:
+    return static_cast<double>(ColumnReader::intAt(column, row));
+  case columns::Type::Double:
+    return ColumnReader::doubleAt(column, row);
+  default:
+    break;
+  }
+  return 0;
+}
+
+static void printValue(const ColumnReader::Column &column, size_t row)
+{
+  if (ColumnReader::isNull(column, row)) {
+    return;
+  }
+
+  switch (column.type) {
+  case columns::Type::UInt64:
+    std::cout << ColumnReader::uintAt(column, row);
+    break;
+  case columns::Type::Int64:
+    std::cout << ColumnReader::intAt(column, row);
+    break;
+  case columns::Type::Double:
+    std::cout << ColumnReader::doubleAt(column, row);
+    break;
+  case columns::Type::String: {
+    auto val = ColumnReader::stringAt(column, row);
+    if (val.find_first_of(",\"\n") == std::string_view::npos) {
+      std::cout << val;
+      break;
+    }
+    std::cout << '"';
+    for (auto ch : val) {
+      std::cout << ((ch == '"') ? "\"\"" : std::string(1, ch));
+    }
+    std::cout << '"';
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+static void listTable(const ColumnReader &reader)
+{
+  std::map<std::string, columns::Type> names;
+  std::vector<ColumnReader::Column> chunks;
+  uint64_t rows = 0;
+
+  for (const auto &group : reader.getGroups()) {
+    reader.readColumns(group, {}, chunks);
+    for (const auto &column : chunks) {
+      names.try_emplace(std::string(column.name), column.type);
+    }
+    rows += group.rows;
+  }
+
+  std::cout << "groups," << reader.getGroups().size() << "\n";
+  std::cout << "rows," << rows << "\n";
+  if (!reader.getGroups().empty()) {
+    std::cout << "begin," << reader.getGroups().front().minTime << "\n";
+    std::cout << "end," << reader.getGroups().back().maxTime << "\n";
+  }
+  for (const auto &[name, type] : names) {
+    std::cout << "column," << name << "," << typeName(type) << "\n";
+  }
+}
+
+static void queryTable(const Options &options, const ColumnReader &reader)
+{
+  std::vector<ColumnReader::Column> chunks;
+  std::vector<std::string> selection = options.columns;
+  std::map<std::string, Summary> summary;
+  bool header = false;
+
+  // All columns of any row group, in the order they first appear
+  if (selection.empty()) {
+    for (const auto &group : reader.getGroups()) {
+      reader.readColumns(group, {}, chunks);
+      for (const auto &column : chunks) {
+        if (std::find(selection.cbegin(), selection.cend(), column.name) == selection.cend()) {
+          selection.emplace_back(column.name);
+        }
+      }
+    }
+  }
+
+  // The time column is needed to filter rows, read it even if not selected
+  auto names = selection;
+  auto filter = (options.beginTime > 0) ||
+                (options.endTime < std::numeric_limits<uint64_t>::max());
+  if (filter && (std::find(names.cbegin(), names.cend(), columns::SystemTime) == names.cend())) {
+    names.emplace_back(columns::SystemTime);
+  }
+
+  for (const auto &group : reader.getGroups()) {
+    // Row groups outside the range are skipped without reading their columns
+    if ((group.maxTime < options.beginTime) || (group.minTime > options.endTime)) {
+      continue;
+    }
+    if (!reader.readColumns(group, names, chunks)) {
+      std::cerr << "Corrupted row group at offset " << group.offset << "\n";
+      continue;
+    }
+
+    // Selected columns in selection order, absent ones are all nulls here
+    std::vector<const ColumnReader::Column *> selected;
+    const ColumnReader::Column *timeColumn = nullptr;
+    for (const auto &name : selection) {
+      auto it = std::find_if(chunks.cbegin(), chunks.cend(), [&name](const auto &column) {
+        return column.name == name;
+      });
+      selected.push_back((it == chunks.cend()) ? nullptr : &(*it));
+    }
+    for (const auto &column : chunks) {
+      if (column.name == columns::SystemTime) {
+        timeColumn = &column;
+      }
+    }
+
+    if (!header && !options.summary) {
+      for (size_t i = 0; i < selected.size(); i++) {
+        std::cout << ((i > 0) ? "," : "") << selection[i];
+      }
+      std::cout << "\n";
+      header = true;
+    }
+
+    for (size_t row = 0; row < group.rows; row++) {
+      if (filter && (timeColumn != nullptr)) {
+        auto time = ColumnReader::uintAt(*timeColumn, row);
+        if ((time < options.beginTime) || (time > options.endTime)) {
+          continue;
+        }
+      }
+      if (!options.summary) {
+        for (size_t i = 0; i < selected.size(); i++) {
+          if (i > 0) {
+            std::cout << ",";
+          }
+          if (selected[i] != nullptr) {
+            printValue(*selected[i], row);
+          }
+        }
+        std::cout << "\n";
+        continue;
+      }
+
+      for (const auto column : selected) {
+        if ((column == nullptr) || ColumnReader::isNull(*column, row)) {
+          continue;
+        }
+        auto &entry = summary.try_emplace(std::string(column->name),
+                                          Summary{.type = column->type,
+                                                  .count = 0,
+                                                  .min = std::numeric_limits<double>::max(),
+                                                  .max = std::numeric_limits<double>::lowest(),
+                                                  .sum = 0})
+                          .first->second;
+        entry.count++;
+        if (column->type != columns::Type::String) {
+          auto val = numberAt(*column, row);
+          entry.min = std::min(entry.min, val);
+          entry.max = std::max(entry.max, val);
+          entry.sum += val;
+        }
+      }
+    }
+  }
+
+  if (options.summary) {
+    std::cout << "column,count,min,max,mean\n";
+    for (const auto &[name, entry] : summary) {
+      std::cout << name << "," << entry.count;
+      if ((entry.type != columns::Type::String) && (entry.count > 0)) {
+        std::cout << "," << entry.min << "," << entry.max << ","
+                  << entry.sum / static_cast<double>(entry.count);
+      } else {
+        std::cout << ",,,";
+      }
+      std::cout << "\n";
+    }
+  }
+}
+
+auto main(int argc, char **argv) -> int
+{
+  Options options{.tablePath = {},
+                  .columns = {},
+                  .beginTime = 0,
+                  .endTime = std::numeric_limits<uint64_t>::max(),
+                  .list = false,
+                  .summary = false};
+  int longIndex = 0;
+  bool version = false;
+  bool help = false;
+  int c;
+
+  struct option longopts[] = {{"list", no_argument, nullptr, 'l'},
+                              {"columns", required_argument, nullptr, 'c'},
+                              {"begin", required_argument, nullptr, 'b'},
+                              {"end", required_argument, nullptr, 'e'},
+                              {"summary", no_argument, nullptr, 's'},
+                              {"version", no_argument, nullptr, 'v'},
+                              {"help", no_argument, nullptr, 'h'},
+                              {nullptr, 0, nullptr, 0}};
+
+  while ((c = getopt_long(argc, argv, "lc:b:e:svh", longopts, &longIndex)) != -1) {
+    switch (c) {
+    case 'l':
+      options.list = true;
+      break;
+    case 'c': {
+      std::stringstream nameStream(optarg);
+      std::string name;
+      while (std::getline(nameStream, name, ',')) {
+        options.columns.push_back(name);
+      }
+      break;
+    }
+    case 'b':
+      help = help || !parseTime(optarg, options.beginTime);
+      break;
+    case 'e':
+      help = help || !parseTime(optarg, options.endTime);
+      break;
+    case 's':
+      options.summary = true;
+      break;
+    case 'v':
+      version = true;
+      break;
+    default:
+      help = true;
+      break;
+    }
+  }
+
+  if (version) {
+    std::cout << "tkmcolumns: " << tkmDefaults.getFor(Defaults::Default::Version) << "\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  if (optind + 1 == argc) {
+    options.tablePath = argv[optind];
+  }
+
+  if (help || options.tablePath.empty()) {
+    std::cout << "TaskMonitorReader column query: column table file to csv\n"
+              << "Version: " << tkmDefaults.getFor(Defaults::Default::Version) << "\n\n";
+    std::cout << "Usage: tkmcolumns [OPTIONS] FILE\n\n";
+    std::cout << "  Times are system time values or local 'YYYY-MM-DD HH:MM:SS'.\n\n";
+    std::cout << "     --list, -l                List row groups and columns\n";
+    std::cout << "     --columns, -c   <list>    Columns to read, default all\n";
+    std::cout << "                               Format: 'system_time,cpu.all'\n";
+    std::cout << "     --begin, -b     <time>    Skip rows with an earlier system time\n";
+    std::cout << "     --end, -e       <time>    Skip rows with a later system time\n";
+    std::cout << "     --summary, -s             Print count, min, max and mean per column\n";
+    std::cout << "     --version, -v             Print version\n";
+    std::cout << "     --help, -h                Print this help\n\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  ColumnReader reader(options.tablePath);
+  if (!reader.isOpen()) {
+    std::cerr << "Cannot read column file " << options.tablePath << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (options.list) {
+    listTable(reader);
+  } else {
+    queryTable(options, reader);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,372 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     JsonConvert
+ * @details   Convert compact tkmreader json output back to the verbose form
+ *-
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#include "Defaults.h"
+#include "JsonEncoder.h"
+#include "JsonParser.h"
+
+using namespace tkm::reader;
+
+typedef struct Kind {
+  std::string name;
+  bool keyed;
+  // Index of the field holding the key, if the key is not written on its own
+  size_t keyField;
+  std::vector<std::string> fields;
+} Kind;
+
+typedef struct Schema {
+  std::string session;
+  std::vector<std::string> head;
+  std::vector<Kind> kinds;
+} Schema;
+
+/*
+ * Read input lines from a file or stdin ("-"). With zlib support gzip
+ * compressed output (--json-compress gzip) is read directly.
+ */
+class LineReader
+{
+public:
+  explicit LineReader(const std::string &path)
+  {
+#ifdef WITH_ZLIB
+    m_file = (path == "-") ? gzdopen(fileno(stdin), "rb") : gzopen(path.c_str(), "rb");
+#else
+    if (path != "-") {
+      m_file = std::make_unique<std::ifstream>(path);
+      m_stream = m_file->is_open() ? m_file.get() : nullptr;
+    }
+#endif
+  }
+
+  ~LineReader()
+  {
+#ifdef WITH_ZLIB
+    if (m_file != nullptr) {
+      gzclose(m_file);
+    }
+#endif
+  }
+
+public:
+  LineReader(LineReader const &) = delete;
+  void operator=(LineReader const &) = delete;
+
+  bool isOpen(void)
+  {
+#ifdef WITH_ZLIB
+    return (m_file != nullptr);
+#else
+    return (m_stream != nullptr);
+#endif
+  }
+
+  bool getLine(std::string &line)
+  {
+#ifdef WITH_ZLIB
+    char buffer[64 * 1024];
+
+    line.clear();
+    while (gzgets(m_file, buffer, sizeof(buffer)) != nullptr) {
+      line.append(buffer);
+      if (line.back() == '\n') {
+        line.pop_back();
+        return true;
+      }
+    }
+    return !line.empty();
+#else
+    return static_cast<bool>(std::getline(*m_stream, line));
+#endif
+  }
+
+private:
+#ifdef WITH_ZLIB
+  gzFile m_file = nullptr;
+#else
+  std::unique_ptr<std::ifstream> m_file = nullptr;
+  std::istream *m_stream = &std::cin;
+#endif
+};
+
+static std::map<std::string, Schema> schemas{};
+
+static bool loadSchema(const JsonValue &record)
+{
+  auto recordType = record.member("record");
+  auto session = record.member("session");
+  auto head = record.member("head");
+  auto kinds = record.member("kinds");
+
+  if ((recordType == nullptr) || (session == nullptr) || (head == nullptr) ||
+      (kinds == nullptr)) {
+    return false;
+  }
+
+  Schema schema{.session = session->text, .head = {}, .kinds = {}};
+  for (const auto &name : head->items) {
+    schema.head.push_back(name.text);
+  }
+
+  for (const auto &kind : kinds->items) {
+    auto name = kind.member("name");
+    auto keyed = kind.member("keyed");
+    auto fields = kind.member("fields");
+
+    if ((name == nullptr) || (keyed == nullptr) || (fields == nullptr)) {
+      return false;
+    }
+
+    auto keyField = kind.member("key_field");
+    Kind entry{.name = name->text,
+               .keyed = (keyed->text == "true"),
+               .keyField = std::string::npos,
+               .fields = {}};
+    for (const auto &field : fields->items) {
+      if ((keyField != nullptr) && (field.text == keyField->text)) {
+        entry.keyField = entry.fields.size();
+      }
+      entry.fields.push_back(field.text);
+    }
+    if ((keyField != nullptr) && (entry.keyField == std::string::npos)) {
+      return false;
+    }
+    schema.kinds.push_back(entry);
+  }
+
+  // A new session or a new group kind replaces the previous schema
+  schemas[recordType->text] = schema;
+  return true;
+}
+
+static void writeValue(JsonEncoder &json, const JsonValue &value)
+{
+  if (value.type == JsonValue::Type::String) {
+    json.value(value.text);
+  } else {
+    json.rawValue(value.text);
+  }
+}
+
+static bool writeGroup(JsonEncoder &json, const Schema &schema, const JsonValue &group)
+{
+  if ((group.type != JsonValue::Type::Array) || group.items.empty() ||
+      (group.items[0].type != JsonValue::Type::Number)) {
+    return false;
+  }
+
+  auto index = std::strtoul(group.items[0].text.c_str(), nullptr, 10);
+  if (index >= schema.kinds.size()) {
+    return false;
+  }
+
+  const auto &kind = schema.kinds[index];
+  size_t pos = 1;
+
+  if (kind.keyed && (kind.keyField == std::string::npos)) {
+    if (group.items.size() < 2) {
+      return false;
+    }
+    json.key(std::string_view(group.items[pos++].text));
+  }
+
+  if (group.items.size() < pos + kind.fields.size()) {
+    return false;
+  }
+
+  if (!kind.keyed) {
+    json.key(std::string_view(kind.name));
+  } else if (kind.keyField != std::string::npos) {
+    json.key(std::string_view(group.items[pos + kind.keyField].text));
+  }
+
+  json.beginSortedObject();
+  for (const auto &name : kind.fields) {
+    json.key(std::string_view(name));
+    writeValue(json, group.items[pos++]);
+  }
+  while (pos < group.items.size()) {
+    if (!writeGroup(json, schema, group.items[pos++])) {
+      return false;
+    }
+  }
+  json.endObject();
+
+  return true;
+}
+
+static bool convertRow(JsonEncoder &json, const JsonValue &row)
+{
+  if (row.items.empty() || (row.items[0].type != JsonValue::Type::String)) {
+    return false;
+  }
+
+  auto schema = schemas.find(row.items[0].text);
+  if (schema == schemas.end()) {
+    return false;
+  }
+
+  const auto &head = schema->second.head;
+  if (row.items.size() < head.size() + 1) {
+    return false;
+  }
+
+  json.reset();
+  json.beginSortedObject();
+  json.field("type", row.items[0].text);
+  json.field("session", schema->second.session);
+  for (size_t i = 0; i < head.size(); i++) {
+    json.key(std::string_view(head[i]));
+    writeValue(json, row.items[i + 1]);
+  }
+  for (size_t i = head.size() + 1; i < row.items.size(); i++) {
+    if (!writeGroup(json, schema->second, row.items[i])) {
+      return false;
+    }
+  }
+  json.endObject();
+
+  return true;
+}
+
+static auto convert(LineReader &reader, std::ostream &out, const std::string &name) -> size_t
+{
+  JsonEncoder json{};
+  JsonValue record{};
+  std::string line{};
+  size_t lineNumber = 0;
+  size_t errors = 0;
+
+  while (reader.getLine(line)) {
+    lineNumber++;
+
+    // Empty lines separate appended runs, keep them
+    if (line.empty() || !JsonParser::parse(line, record)) {
+      if (!line.empty()) {
+        std::cerr << name << ":" << lineNumber << ": invalid json record\n";
+        errors++;
+      }
+      out << line << '\n';
+      continue;
+    }
+
+    if (record.type == JsonValue::Type::Array) {
+      if (convertRow(json, record)) {
+        out << json.view() << '\n';
+      } else {
+        std::cerr << name << ":" << lineNumber << ": row without matching schema\n";
+        errors++;
+      }
+      continue;
+    }
+
+    auto type = record.member("type");
+    if ((type != nullptr) && (type->text == "schema")) {
+      if (!loadSchema(record)) {
+        std::cerr << name << ":" << lineNumber << ": invalid schema record\n";
+        errors++;
+      }
+      continue;
+    }
+
+    // Session and verbose records are already in the verbose form
+    out << line << '\n';
+  }
+
+  return errors;
+}
+
+auto main(int argc, char **argv) -> int
+{
+  std::string outPath{};
+  int longIndex = 0;
+  bool version = false;
+  bool help = false;
+  int c;
+
+  struct option longopts[] = {{"output", required_argument, nullptr, 'o'},
+                              {"version", no_argument, nullptr, 'v'},
+                              {"help", no_argument, nullptr, 'h'},
+                              {nullptr, 0, nullptr, 0}};
+
+  while ((c = getopt_long(argc, argv, "o:vh", longopts, &longIndex)) != -1) {
+    switch (c) {
+    case 'o':
+      outPath = optarg;
+      break;
+    case 'v':
+      version = true;
+      break;
+    default:
+      help = true;
+      break;
+    }
+  }
+
+  if (version) {
+    std::cout << "tkmjsonconv: " << tkmDefaults.getFor(Defaults::Default::Version) << "\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  if (help) {
+    std::cout << "TaskMonitorReader json converter: compact to verbose json records\n"
+              << "Version: " << tkmDefaults.getFor(Defaults::Default::Version) << "\n\n";
+    std::cout << "Usage: tkmjsonconv [OPTIONS] [FILE...]\n\n";
+    std::cout << "  Files are converted in order, rotated files must be passed oldest first.\n";
+    std::cout << "  Standard input is read if no file is set or for '-'.\n\n";
+    std::cout << "     --output, -o <string>     Output file path (default stdout)\n";
+    std::cout << "     --version, -v             Print version\n";
+    std::cout << "     --help, -h                Print this help\n\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  std::ofstream outFile{};
+  if (!outPath.empty()) {
+    outFile.open(outPath, std::ofstream::out | std::ofstream::trunc);
+    if (!outFile.is_open()) {
+      std::cerr << "Cannot open output file " << outPath << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+  std::ostream &out = outPath.empty() ? std::cout : outFile;
+
+  std::vector<std::string> inputs(argv + optind, argv + argc);
+  if (inputs.empty()) {
+    inputs.emplace_back("-");
+  }
+
+  size_t errors = 0;
+  for (const auto &input : inputs) {
+    LineReader reader(input);
+    if (!reader.isOpen()) {
+      std::cerr << "Cannot open input file " << input << "\n";
+      return EXIT_FAILURE;
+    }
+    errors += convert(reader, out, input);
+  }
+
+  out.flush();
+  return (errors == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
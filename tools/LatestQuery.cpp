@@ -0,0 +1,153 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     LatestQuery
+ * @details   Print the shared memory latest value table of a running reader
+ *-
+ */
+
+#include <cstdlib>
+#include <getopt.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+#include "Defaults.h"
+#include "LatestTable.h"
+
+using namespace tkm::reader;
+
+typedef struct Options {
+  std::string tableName;
+  std::string source;
+  std::string entity;
+  std::string field;
+  bool hasEntity;
+  unsigned interval;
+} Options;
+
+static void printValue(const latest::Value &value)
+{
+  std::cout << value.getSource() << "," << value.getEntity() << "," << value.getField() << ","
+            << value.time << ",";
+  switch (value.type) {
+  case latest::Type::Int64:
+    std::cout << value.asInt64();
+    break;
+  case latest::Type::Double:
+    std::cout << value.asDouble();
+    break;
+  case latest::Type::UInt64:
+  default:
+    std::cout << value.asUInt64();
+    break;
+  }
+  std::cout << "\n";
+}
+
+static void printTable(const latest::LatestTable &table, const Options &options)
+{
+  std::cout << "source,entity,field,system_time,value\n";
+  table.forEach([&options](const latest::Value &value) {
+    if ((!options.source.empty() && (value.getSource() != options.source)) ||
+        (options.hasEntity && (value.getEntity() != options.entity)) ||
+        (!options.field.empty() && (value.getField() != options.field))) {
+      return;
+    }
+    printValue(value);
+  });
+  std::cout << std::flush;
+}
+
+auto main(int argc, char **argv) -> int
+{
+  Options options{.tableName = {},
+                  .source = {},
+                  .entity = {},
+                  .field = {},
+                  .hasEntity = false,
+                  .interval = 0};
+  int longIndex = 0;
+  bool version = false;
+  bool help = false;
+  int c;
+
+  struct option longopts[] = {{"source", required_argument, nullptr, 's'},
+                              {"entity", required_argument, nullptr, 'n'},
+                              {"field", required_argument, nullptr, 'f'},
+                              {"interval", required_argument, nullptr, 'i'},
+                              {"version", no_argument, nullptr, 'v'},
+                              {"help", no_argument, nullptr, 'h'},
+                              {nullptr, 0, nullptr, 0}};
+
+  while ((c = getopt_long(argc, argv, "s:n:f:i:vh", longopts, &longIndex)) != -1) {
+    switch (c) {
+    case 's':
+      options.source = optarg;
+      break;
+    case 'n':
+      options.entity = optarg;
+      options.hasEntity = true;
+      break;
+    case 'f':
+      options.field = optarg;
+      break;
+    case 'i':
+      try {
+        options.interval = static_cast<unsigned>(std::stoul(optarg));
+      } catch (const std::exception &) {
+        help = true;
+      }
+      break;
+    case 'v':
+      version = true;
+      break;
+    default:
+      help = true;
+      break;
+    }
+  }
+
+  if (version) {
+    std::cout << "tkmlatest: " << tkmDefaults.getFor(Defaults::Default::Version) << "\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  if (optind + 1 == argc) {
+    options.tableName = argv[optind];
+  }
+
+  if (help || options.tableName.empty()) {
+    std::cout << "TaskMonitorReader latest values: shared memory table to csv\n"
+              << "Version: " << tkmDefaults.getFor(Defaults::Default::Version) << "\n\n";
+    std::cout << "Usage: tkmlatest [OPTIONS] NAME\n\n";
+    std::cout << "     --source, -s    <type>    Select series of a record type\n";
+    std::cout << "     --entity, -n    <key>     Select series of a keyed group entry\n";
+    std::cout << "     --field, -f     <name>    Select series of a field, e.g. 'cpu.all'\n";
+    std::cout << "     --interval, -i  <msec>    Print the table again every interval\n";
+    std::cout << "     --version, -v             Print version\n";
+    std::cout << "     --help, -h                Print this help\n\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  latest::LatestTable table;
+  if (!table.open(options.tableName)) {
+    std::cerr << "Cannot open latest table " << options.tableName << "\n";
+    return EXIT_FAILURE;
+  }
+
+  printTable(table, options);
+  while (options.interval > 0) {
+    ::usleep(options.interval * 1000);
+    // A restarted reader publishes a new table under the same name
+    if (table.isClosed() && !table.open(options.tableName)) {
+      continue;
+    }
+    printTable(table, options);
+  }
+
+  return EXIT_SUCCESS;
+}
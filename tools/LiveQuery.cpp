@@ -0,0 +1,158 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     LiveQuery
+ * @details   Send queries to the live socket of a running reader
+ *-
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <getopt.h>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Defaults.h"
+
+using namespace tkm::reader;
+
+typedef struct Options {
+  std::string socketPath;
+  std::string request;
+  bool timing;
+} Options;
+
+static int connectSocket(const std::string &path)
+{
+  struct sockaddr_un addr = {};
+
+  if (path.size() >= sizeof(addr.sun_path)) {
+    return -1;
+  }
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return -1;
+  }
+
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path, path.c_str(), path.size());
+  if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0) {
+    ::close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+// Answer lines are printed up to the empty line ending the answer
+static bool runQuery(int fd, const Options &options)
+{
+  auto request = options.request + "\n";
+  std::string answer;
+  char buffer[65536];
+
+  auto start = std::chrono::steady_clock::now();
+  if (::send(fd, request.data(), request.size(), MSG_NOSIGNAL) !=
+      static_cast<ssize_t>(request.size())) {
+    return false;
+  }
+
+  while ((answer.size() < 2) || (answer.compare(answer.size() - 2, 2, "\n\n") != 0)) {
+    // An answer to an empty result is a single empty line
+    if (answer == "\n") {
+      break;
+    }
+    auto count = ::recv(fd, buffer, sizeof(buffer), 0);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      return false;
+    }
+    answer.append(buffer, static_cast<size_t>(count));
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  std::cout.write(answer.data(), static_cast<std::streamsize>(answer.size() - 1));
+  if (options.timing) {
+    std::cerr << "Answer " << answer.size() << " bytes in "
+              << std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()
+              << " us\n";
+  }
+
+  return answer.rfind("{\"error\":", 0) != 0;
+}
+
+auto main(int argc, char **argv) -> int
+{
+  Options options{.socketPath = {}, .request = {}, .timing = false};
+  int longIndex = 0;
+  bool version = false;
+  bool help = false;
+  int c;
+
+  struct option longopts[] = {{"time", no_argument, nullptr, 't'},
+                              {"version", no_argument, nullptr, 'v'},
+                              {"help", no_argument, nullptr, 'h'},
+                              {nullptr, 0, nullptr, 0}};
+
+  while ((c = getopt_long(argc, argv, "tvh", longopts, &longIndex)) != -1) {
+    switch (c) {
+    case 't':
+      options.timing = true;
+      break;
+    case 'v':
+      version = true;
+      break;
+    default:
+      help = true;
+      break;
+    }
+  }
+
+  if (version) {
+    std::cout << "tkmlive: " << tkmDefaults.getFor(Defaults::Default::Version) << "\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  if (optind + 1 < argc) {
+    options.socketPath = argv[optind];
+    for (int i = optind + 1; i < argc; i++) {
+      options.request.append((i > optind + 1) ? " " : "").append(argv[i]);
+    }
+  }
+
+  if (help || options.request.empty()) {
+    std::cout << "TaskMonitorReader live query: recent records of a running reader\n"
+              << "Version: " << tkmDefaults.getFor(Defaults::Default::Version) << "\n\n";
+    std::cout << "Usage: tkmlive [OPTIONS] SOCKET REQUEST\n\n";
+    std::cout << "  Requests, since in seconds before the newest record:\n";
+    std::cout << "     <type> [count=<n>] [since=<sec>] [entity=<key>]\n";
+    std::cout << "     series source=<type> field=<name> [entity=<key>] [since=<sec>]\n";
+    std::cout << "     types\n\n";
+    std::cout << "     --time, -t                Print the answer time to stderr\n";
+    std::cout << "     --version, -v             Print version\n";
+    std::cout << "     --help, -h                Print this help\n\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  auto fd = connectSocket(options.socketPath);
+  if (fd < 0) {
+    std::cerr << "Cannot connect to " << options.socketPath << ": " << strerror(errno) << "\n";
+    return EXIT_FAILURE;
+  }
+
+  auto status = runQuery(fd, options);
+  ::close(fd);
+
+  return status ? EXIT_SUCCESS : EXIT_FAILURE;
+}
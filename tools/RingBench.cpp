@@ -0,0 +1,372 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     RingBench
+ * @details   Record throughput of the sample ring against json lines on a pipe
+ *-
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Defaults.h"
+#include "JsonEncoder.h"
+#include "JsonParser.h"
+#include "JsonRecord.h"
+#include "SampleRing.h"
+#include "SampleRingBuffer.h"
+#include "SeriesRecord.h"
+
+using namespace tkm::reader;
+
+typedef struct Options {
+  size_t records;
+  size_t cores;
+  size_t ringSize;
+} Options;
+
+// What the consumer process got, sent back on a pipe
+typedef struct Result {
+  uint64_t records;
+  uint64_t samples;
+  uint64_t overruns;
+  uint64_t lostBytes;
+  double checksum;
+} Result;
+
+typedef struct Measure {
+  double seconds;
+  double producerCpu;
+  double consumerCpu;
+  Result result;
+} Measure;
+
+static const std::string Session = "5f2c8e1d0b7a4c39";
+
+// Same shape as a SysProcStat record
+template <class Record>
+static void printStat(Record &record, const std::vector<std::string> &coreNames, size_t index)
+{
+  auto time = 1650000000 + index;
+  auto value = static_cast<uint32_t>(index % 100);
+
+  record.begin("stat", Session, time, time - 1640000000, time);
+  record.beginGroup("cpu");
+  record.field("all", value);
+  record.field("iow", value / 8);
+  record.field("sys", value / 4);
+  record.field("usr", value / 2);
+  record.endGroup();
+  for (const auto &name : coreNames) {
+    record.beginGroup("core", name);
+    record.field("all", value);
+    record.field("iow", value / 8);
+    record.field("sys", value / 4);
+    record.field("usr", value / 2);
+    record.endGroup();
+  }
+  record.end();
+}
+
+static auto cpuTime(int who) -> double
+{
+  struct rusage usage;
+  ::getrusage(who, &usage);
+  return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+         static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static bool writeAll(int fd, const char *data, size_t size)
+{
+  while (size > 0) {
+    auto written = ::write(fd, data, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+static void sumNumbers(const JsonValue &value, Result &result)
+{
+  if (value.type == JsonValue::Type::Number) {
+    result.samples++;
+    result.checksum += std::strtod(value.text.c_str(), nullptr);
+    return;
+  }
+  for (const auto &item : value.items) {
+    sumNumbers(item, result);
+  }
+}
+
+// Run the consumer in a child process and the producer in this one
+template <class Produce, class Consume>
+static auto runForked(const Produce &produce, const Consume &consume) -> Measure
+{
+  Measure measure{};
+  int resultPipe[2];
+
+  if (::pipe(resultPipe) < 0) {
+    std::cerr << "Cannot create pipe: " << strerror(errno) << "\n";
+    ::exit(EXIT_FAILURE);
+  }
+
+  auto childCpu = cpuTime(RUSAGE_CHILDREN);
+  auto selfCpu = cpuTime(RUSAGE_SELF);
+  auto start = std::chrono::steady_clock::now();
+
+  auto pid = ::fork();
+  if (pid == 0) {
+    ::close(resultPipe[0]);
+    Result result{};
+    consume(result);
+    writeAll(resultPipe[1], reinterpret_cast<const char *>(&result), sizeof(result));
+    ::_exit(EXIT_SUCCESS);
+  }
+  ::close(resultPipe[1]);
+
+  produce();
+  measure.producerCpu = cpuTime(RUSAGE_SELF) - selfCpu;
+
+  if (::read(resultPipe[0], &measure.result, sizeof(measure.result)) !=
+      static_cast<ssize_t>(sizeof(measure.result))) {
+    std::cerr << "Consumer failed\n";
+  }
+  ::waitpid(pid, nullptr, 0);
+  ::close(resultPipe[0]);
+
+  measure.seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  measure.consumerCpu = cpuTime(RUSAGE_CHILDREN) - childCpu;
+
+  return measure;
+}
+
+// Verbose json lines as written by '--json stdout', parsed by the consumer
+static auto runPipe(const Options &options, const std::vector<std::string> &coreNames)
+    -> Measure
+{
+  int dataPipe[2];
+
+  if (::pipe(dataPipe) < 0) {
+    std::cerr << "Cannot create pipe: " << strerror(errno) << "\n";
+    ::exit(EXIT_FAILURE);
+  }
+
+  auto produce = [&]() {
+    ::close(dataPipe[0]);
+    JsonEncoder encoder;
+    JsonRecord record(encoder);
+    std::string line;
+
+    for (size_t i = 0; i < options.records; i++) {
+      encoder.reset();
+      printStat(record, coreNames, i);
+      // Flushed per line, same as the stdout flush policy
+      line.assign(record.view()).push_back('\n');
+      writeAll(dataPipe[1], line.data(), line.size());
+    }
+    ::close(dataPipe[1]);
+  };
+
+  auto consume = [&](Result &result) {
+    ::close(dataPipe[1]);
+    std::vector<char> buffer(65536);
+    std::string pending;
+    ssize_t count;
+
+    while ((count = ::read(dataPipe[0], buffer.data(), buffer.size())) != 0) {
+      if (count < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        break;
+      }
+      pending.append(buffer.data(), static_cast<size_t>(count));
+
+      size_t begin = 0;
+      size_t end;
+      while ((end = pending.find('\n', begin)) != std::string::npos) {
+        JsonValue value;
+        if (JsonParser::parse(std::string_view(pending).substr(begin, end - begin), value)) {
+          result.records++;
+          // Record head fields are not samples
+          for (size_t i = 0; i < value.keys.size(); i++) {
+            if ((value.keys[i] == "cpu") || (value.keys[i] == "core")) {
+              sumNumbers(value.items[i], result);
+            }
+          }
+        }
+        begin = end + 1;
+      }
+      pending.erase(0, begin);
+    }
+  };
+
+  return runForked(produce, consume);
+}
+
+// Binary samples in the shared memory ring, one publish per record
+static auto runRing(const Options &options, const std::vector<std::string> &coreNames)
+    -> Measure
+{
+  SampleRingBuffer ringBuffer;
+  auto name = "/tkmringbench." + std::to_string(::getpid());
+
+  if (!ringBuffer.create(name, "bench", options.ringSize)) {
+    std::cerr << "Cannot create sample ring " << name << ": " << strerror(errno) << "\n";
+    ::exit(EXIT_FAILURE);
+  }
+
+  auto produce = [&]() {
+    SeriesRecord record([&ringBuffer](std::string_view source,
+                                      std::string_view entity,
+                                      std::string_view field,
+                                      series::Type type,
+                                      uint64_t time,
+                                      uint64_t value) {
+      ringBuffer.append(source, entity, field, type, time, value);
+    });
+
+    for (size_t i = 0; i < options.records; i++) {
+      printStat(record, coreNames, i);
+      ringBuffer.publish();
+    }
+    ringBuffer.close();
+  };
+
+  auto consume = [&](Result &result) {
+    ring::SampleRing sampleRing;
+    ring::Sample sample;
+
+    if (!sampleRing.open(name, true)) {
+      return;
+    }
+    for (;;) {
+      if (sampleRing.next(sample)) {
+        result.samples++;
+        result.checksum += sample.asDouble();
+        // Each record starts with its cpu group
+        if ((sample.entity.empty()) && (sample.field == "cpu.all")) {
+          result.records++;
+        }
+        continue;
+      }
+      if (sampleRing.isClosed()) {
+        if (!sampleRing.next(sample)) {
+          break;
+        }
+        continue;
+      }
+      sampleRing.wait(10);
+    }
+    result.overruns = sampleRing.getOverruns();
+    result.lostBytes = sampleRing.getLostBytes();
+  };
+
+  return runForked(produce, consume);
+}
+
+static void printMeasure(const char *name, const Measure &measure, const Options &options)
+{
+  auto records = static_cast<double>(measure.result.records);
+
+  std::cout << std::left << std::setw(8) << name << std::right << std::fixed
+            << std::setprecision(0) << std::setw(14) << records / measure.seconds
+            << std::setprecision(2) << std::setw(14)
+            << measure.producerCpu * 1e6 / static_cast<double>(options.records) << std::setw(14)
+            << measure.consumerCpu * 1e6 / std::max(records, 1.0) << std::setw(10)
+            << measure.result.overruns << "  "
+            << ((measure.result.records == options.records) && (measure.result.overruns == 0)
+                    ? "ok"
+                    : "LOST")
+            << "\n";
+}
+
+auto main(int argc, char **argv) -> int
+{
+  Options options{.records = 200000, .cores = 8, .ringSize = 16777216};
+  int longIndex = 0;
+  bool version = false;
+  bool help = false;
+  int c;
+
+  struct option longopts[] = {{"records", required_argument, nullptr, 'n'},
+                              {"cores", required_argument, nullptr, 'k'},
+                              {"size", required_argument, nullptr, 's'},
+                              {"version", no_argument, nullptr, 'v'},
+                              {"help", no_argument, nullptr, 'h'},
+                              {nullptr, 0, nullptr, 0}};
+
+  while ((c = getopt_long(argc, argv, "n:k:s:vh", longopts, &longIndex)) != -1) {
+    switch (c) {
+    case 'n':
+      options.records = std::strtoul(optarg, nullptr, 10);
+      help = help || (options.records == 0);
+      break;
+    case 'k':
+      options.cores = std::strtoul(optarg, nullptr, 10);
+      break;
+    case 's':
+      options.ringSize = std::strtoul(optarg, nullptr, 10);
+      help = help || (options.ringSize == 0);
+      break;
+    case 'v':
+      version = true;
+      break;
+    default:
+      help = true;
+      break;
+    }
+  }
+
+  if (version) {
+    std::cout << "tkmringbench: " << tkmDefaults.getFor(Defaults::Default::Version) << "\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  if (help) {
+    std::cout << "TaskMonitorReader ring bench: sample ring against json on a pipe\n"
+              << "Version: " << tkmDefaults.getFor(Defaults::Default::Version) << "\n\n";
+    std::cout << "Usage: tkmringbench [OPTIONS]\n\n";
+    std::cout << "     --records, -n   <count>   Stat records streamed, default 200000\n";
+    std::cout << "     --cores, -k     <count>   Cores per stat record, default 8\n";
+    std::cout << "     --size, -s      <bytes>   Sample ring size, default 16777216\n";
+    std::cout << "     --version, -v             Print version\n";
+    std::cout << "     --help, -h                Print this help\n\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  std::vector<std::string> coreNames;
+  for (size_t i = 0; i < options.cores; i++) {
+    coreNames.push_back("cpu" + std::to_string(i));
+  }
+
+  // CPU time is per record, producer and consumer process
+  std::cout << std::left << std::setw(8) << "stream" << std::right << std::setw(14)
+            << "records/s" << std::setw(14) << "producer us" << std::setw(14) << "consumer us"
+            << std::setw(10) << "overruns"
+            << "\n";
+  printMeasure("pipe", runPipe(options, coreNames), options);
+  printMeasure("ring", runRing(options, coreNames), options);
+
+  return EXIT_SUCCESS;
+}
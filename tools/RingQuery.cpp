@@ -0,0 +1,183 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     RingQuery
+ * @details   Follow the shared memory sample ring of a running reader
+ *-
+ */
+
+#include <csignal>
+#include <cstdlib>
+#include <getopt.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+#include "Defaults.h"
+#include "SampleRing.h"
+
+using namespace tkm::reader;
+
+typedef struct Options {
+  std::string ringName;
+  std::string source;
+  std::string entity;
+  std::string field;
+  bool hasEntity;
+  bool oldest;
+  uint64_t count;
+} Options;
+
+static volatile std::sig_atomic_t running = 1;
+
+static void terminate(int signum)
+{
+  static_cast<void>(signum);
+  running = 0;
+}
+
+static void printSample(const ring::Sample &sample)
+{
+  std::cout << sample.source << "," << sample.entity << "," << sample.field << ","
+            << sample.time << ",";
+  switch (sample.type) {
+  case ring::Type::Int64:
+    std::cout << sample.asInt64();
+    break;
+  case ring::Type::Double:
+    std::cout << sample.asDouble();
+    break;
+  case ring::Type::UInt64:
+  default:
+    std::cout << sample.asUInt64();
+    break;
+  }
+  std::cout << "\n";
+}
+
+auto main(int argc, char **argv) -> int
+{
+  Options options{.ringName = {},
+                  .source = {},
+                  .entity = {},
+                  .field = {},
+                  .hasEntity = false,
+                  .oldest = false,
+                  .count = 0};
+  int longIndex = 0;
+  bool version = false;
+  bool help = false;
+  int c;
+
+  struct option longopts[] = {{"source", required_argument, nullptr, 's'},
+                              {"entity", required_argument, nullptr, 'n'},
+                              {"field", required_argument, nullptr, 'f'},
+                              {"oldest", no_argument, nullptr, 'o'},
+                              {"count", required_argument, nullptr, 'c'},
+                              {"version", no_argument, nullptr, 'v'},
+                              {"help", no_argument, nullptr, 'h'},
+                              {nullptr, 0, nullptr, 0}};
+
+  while ((c = getopt_long(argc, argv, "s:n:f:oc:vh", longopts, &longIndex)) != -1) {
+    switch (c) {
+    case 's':
+      options.source = optarg;
+      break;
+    case 'n':
+      options.entity = optarg;
+      options.hasEntity = true;
+      break;
+    case 'f':
+      options.field = optarg;
+      break;
+    case 'o':
+      options.oldest = true;
+      break;
+    case 'c':
+      try {
+        options.count = std::stoull(optarg);
+      } catch (const std::exception &) {
+        help = true;
+      }
+      break;
+    case 'v':
+      version = true;
+      break;
+    default:
+      help = true;
+      break;
+    }
+  }
+
+  if (version) {
+    std::cout << "tkmring: " << tkmDefaults.getFor(Defaults::Default::Version) << "\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  if (optind + 1 == argc) {
+    options.ringName = argv[optind];
+  }
+
+  if (help || options.ringName.empty()) {
+    std::cout << "TaskMonitorReader sample ring: shared memory sample stream to csv\n"
+              << "Version: " << tkmDefaults.getFor(Defaults::Default::Version) << "\n\n";
+    std::cout << "Usage: tkmring [OPTIONS] NAME\n\n";
+    std::cout << "     --source, -s    <type>    Select series of a record type\n";
+    std::cout << "     --entity, -n    <key>     Select series of a keyed group entry\n";
+    std::cout << "     --field, -f     <name>    Select series of a field, e.g. 'cpu.all'\n";
+    std::cout << "     --oldest, -o              Start with the oldest sample kept\n";
+    std::cout << "     --count, -c     <count>   Stop after count samples\n";
+    std::cout << "     --version, -v             Print version\n";
+    std::cout << "     --help, -h                Print this help\n\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  ring::SampleRing sampleRing;
+  if (!sampleRing.open(options.ringName, options.oldest)) {
+    std::cerr << "Cannot open sample ring " << options.ringName << "\n";
+    return EXIT_FAILURE;
+  }
+
+  ::signal(SIGINT, terminate);
+  ::signal(SIGTERM, terminate);
+
+  ring::Sample sample;
+  uint64_t printed = 0;
+  uint64_t overruns = 0;
+
+  std::cout << "source,entity,field,system_time,value\n";
+  while (running && ((options.count == 0) || (printed < options.count))) {
+    if (!sampleRing.next(sample)) {
+      std::cout << std::flush;
+      // A restarted reader publishes a new ring under the same name
+      if (sampleRing.isClosed()) {
+        if (!sampleRing.open(options.ringName)) {
+          ::usleep(100000);
+        }
+        overruns = 0;
+        continue;
+      }
+      sampleRing.wait(100);
+      continue;
+    }
+
+    if (sampleRing.getOverruns() > overruns) {
+      overruns = sampleRing.getOverruns();
+      std::cerr << "Sample ring overrun, " << sampleRing.getLostBytes() << " bytes lost\n";
+    }
+
+    if ((!options.source.empty() && (sample.source != options.source)) ||
+        (options.hasEntity && (sample.entity != options.entity)) ||
+        (!options.field.empty() && (sample.field != options.field))) {
+      continue;
+    }
+    printSample(sample);
+    printed++;
+  }
+  std::cout << std::flush;
+
+  return EXIT_SUCCESS;
+}
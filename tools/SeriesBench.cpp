@@ -0,0 +1,195 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SeriesBench
+ * @details   Encode and decode throughput of the series codec
+ *-
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Defaults.h"
+#include "SeriesCodec.h"
+
+using namespace tkm::reader;
+
+typedef struct Shape {
+  const char *name;
+  series::Type type;
+  std::function<uint64_t(size_t, std::mt19937_64 &)> value;
+} Shape;
+
+static auto doubleBits(double val) -> uint64_t
+{
+  uint64_t bits;
+  std::memcpy(&bits, &val, sizeof(bits));
+  return bits;
+}
+
+// Value shapes seen in monitor data
+static auto getShapes(void) -> std::vector<Shape>
+{
+  return {
+      {.name = "counter",
+       .type = series::Type::UInt64,
+       .value = [](size_t i, std::mt19937_64 &) -> uint64_t { return 1000000 + i * 250; }},
+      {.name = "jiffies",
+       .type = series::Type::UInt64,
+       .value = [](size_t i, std::mt19937_64 &rng) -> uint64_t {
+         return 100000 + i * 100 + rng() % 8;
+       }},
+      {.name = "gauge",
+       .type = series::Type::UInt64,
+       .value = [](size_t i, std::mt19937_64 &) -> uint64_t { return 524288 + (i / 64) * 4; }},
+      {.name = "constant",
+       .type = series::Type::Int64,
+       .value = [](size_t, std::mt19937_64 &) -> uint64_t { return static_cast<uint64_t>(-1); }},
+      {.name = "psi",
+       .type = series::Type::Double,
+       .value = [](size_t i, std::mt19937_64 &rng) -> uint64_t {
+         auto val = (i % 32 < 24) ? 0.0 : static_cast<double>(rng() % 1000) / 100.0;
+         return doubleBits(val);
+       }},
+      {.name = "percent",
+       .type = series::Type::Double,
+       .value = [](size_t i, std::mt19937_64 &) -> uint64_t {
+         return doubleBits(std::round(500.0 + 400.0 * std::sin(static_cast<double>(i) / 50.0)) / 10.0);
+       }},
+      {.name = "random",
+       .type = series::Type::UInt64,
+       .value = [](size_t, std::mt19937_64 &rng) -> uint64_t { return rng(); }},
+  };
+}
+
+static void runShape(const Shape &shape, size_t samples, unsigned rounds)
+{
+  std::mt19937_64 rng(42);
+  std::vector<uint64_t> times(samples);
+  std::vector<uint64_t> values(samples);
+  uint64_t time = 1650000000;
+
+  for (size_t i = 0; i < samples; i++) {
+    // Mostly regular intervals with an occasional late sample
+    time += (rng() % 100 == 0) ? 2u : 1u;
+    times[i] = time;
+    values[i] = shape.value(i, rng);
+  }
+
+  SeriesEncoder encoder(shape.type);
+  std::chrono::duration<double> encodeTime{0};
+  std::chrono::duration<double> decodeTime{0};
+  uint64_t checksum = 0;
+  bool valid = true;
+
+  for (unsigned round = 0; round < rounds; round++) {
+    auto start = std::chrono::steady_clock::now();
+    encoder.reset();
+    for (size_t i = 0; i < samples; i++) {
+      encoder.append(times[i], values[i]);
+    }
+    encodeTime += std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    SeriesDecoder decoder(shape.type, encoder.view(), encoder.getCount());
+    uint64_t sampleTime;
+    uint64_t value;
+    size_t index = 0;
+    while (decoder.next(sampleTime, value)) {
+      valid = valid && (index < samples) && (times[index] == sampleTime) &&
+              (values[index] == value);
+      checksum += value;
+      index++;
+    }
+    decodeTime += std::chrono::steady_clock::now() - start;
+    valid = valid && (index == samples);
+  }
+
+  auto total = static_cast<double>(samples) * rounds;
+  auto bits = static_cast<double>(encoder.getBytes()) * 8 / static_cast<double>(samples);
+
+  std::cout << std::left << std::setw(10) << shape.name << std::right << std::fixed
+            << std::setprecision(2) << std::setw(12) << bits << std::setw(10)
+            << 128.0 / bits << std::setw(14) << total / encodeTime.count() / 1e6
+            << std::setw(14) << total / decodeTime.count() / 1e6 << "  "
+            << (valid ? "ok" : "MISMATCH") << "\n";
+
+  // Keep the decode loop from being optimized out
+  if (checksum == 1) {
+    std::cout << "\n";
+  }
+}
+
+auto main(int argc, char **argv) -> int
+{
+  size_t samples = 100000;
+  unsigned rounds = 10;
+  int longIndex = 0;
+  bool version = false;
+  bool help = false;
+  int c;
+
+  struct option longopts[] = {{"samples", required_argument, nullptr, 'n'},
+                              {"rounds", required_argument, nullptr, 'r'},
+                              {"version", no_argument, nullptr, 'v'},
+                              {"help", no_argument, nullptr, 'h'},
+                              {nullptr, 0, nullptr, 0}};
+
+  while ((c = getopt_long(argc, argv, "n:r:vh", longopts, &longIndex)) != -1) {
+    switch (c) {
+    case 'n':
+      samples = std::strtoul(optarg, nullptr, 10);
+      help = help || (samples == 0);
+      break;
+    case 'r':
+      rounds = static_cast<unsigned>(std::strtoul(optarg, nullptr, 10));
+      help = help || (rounds == 0);
+      break;
+    case 'v':
+      version = true;
+      break;
+    default:
+      help = true;
+      break;
+    }
+  }
+
+  if (version) {
+    std::cout << "tkmseriesbench: " << tkmDefaults.getFor(Defaults::Default::Version) << "\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  if (help) {
+    std::cout << "TaskMonitorReader series bench: codec size and throughput\n"
+              << "Version: " << tkmDefaults.getFor(Defaults::Default::Version) << "\n\n";
+    std::cout << "Usage: tkmseriesbench [OPTIONS]\n\n";
+    std::cout << "     --samples, -n   <count>   Samples per series, default 100000\n";
+    std::cout << "     --rounds, -r    <count>   Encode and decode rounds, default 10\n";
+    std::cout << "     --version, -v             Print version\n";
+    std::cout << "     --help, -h                Print this help\n\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  // Ratio is against 16 bytes for a raw (time, value) pair
+  std::cout << std::left << std::setw(10) << "shape" << std::right << std::setw(12)
+            << "bits/sample" << std::setw(10) << "ratio" << std::setw(14) << "encode M/s"
+            << std::setw(14) << "decode M/s"
+            << "\n";
+  for (const auto &shape : getShapes()) {
+    runShape(shape, samples, rounds);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,306 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *-
+ * @date      2021-2022
+ * @author    Alin Popa <alin.popa@fxdata.ro>
+ * @copyright MIT
+ * @brief     SeriesQuery
+ * @details   Read selected series and time ranges of series files and stores
+ *-
+ */
+
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <functional>
+#include <getopt.h>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <string>
+#include <tuple>
+
+#include "Defaults.h"
+#include "SegmentStore.h"
+#include "SeriesCodec.h"
+#include "SeriesReader.h"
+
+using namespace tkm::reader;
+
+typedef struct Options {
+  std::string seriesPath;
+  std::string source;
+  std::string entity;
+  std::string field;
+  uint64_t beginTime;
+  uint64_t endTime;
+  bool list;
+} Options;
+
+typedef struct Listing {
+  series::Type type;
+  uint64_t blocks;
+  uint64_t samples;
+  uint64_t bytes;
+  uint64_t firstTime;
+  uint64_t lastTime;
+} Listing;
+
+static bool parseTime(const std::string &value, uint64_t &time)
+{
+  struct tm timeInfo = {};
+
+  if (!value.empty() && (value.find_first_not_of("0123456789") == std::string::npos)) {
+    auto result = std::from_chars(value.data(), value.data() + value.size(), time);
+    return (result.ec == std::errc());
+  }
+
+  auto end = ::strptime(value.c_str(), "%Y-%m-%d %H:%M:%S", &timeInfo);
+  if ((end == nullptr) || (*end != '\0')) {
+    return false;
+  }
+  timeInfo.tm_isdst = -1;
+  time = static_cast<uint64_t>(::mktime(&timeInfo));
+
+  return true;
+}
+
+static auto typeName(series::Type type) -> const char *
+{
+  switch (type) {
+  case series::Type::UInt64:
+    return "uint64";
+  case series::Type::Int64:
+    return "int64";
+  case series::Type::Double:
+    return "double";
+  default:
+    break;
+  }
+  return "unknown";
+}
+
+static void printValue(series::Type type, uint64_t value)
+{
+  switch (type) {
+  case series::Type::Int64:
+    std::cout << static_cast<int64_t>(value);
+    break;
+  case series::Type::Double: {
+    double real;
+    std::memcpy(&real, &value, sizeof(real));
+    std::cout << real;
+    break;
+  }
+  default:
+    std::cout << value;
+    break;
+  }
+}
+
+// Empty filters match any value
+static bool isSelected(const Options &options,
+                       std::string_view source,
+                       std::string_view entity,
+                       std::string_view field)
+{
+  return (options.source.empty() || (source == options.source)) &&
+         (options.entity.empty() || (entity == options.entity)) &&
+         (options.field.empty() || (field == options.field));
+}
+
+static bool isInRange(const Options &options, uint64_t firstTime, uint64_t lastTime)
+{
+  return (lastTime >= options.beginTime) && (firstTime <= options.endTime);
+}
+
+/*
+ * Blocks of the selected series within the time range, from a series file
+ * or from the sealed and archive segments of a store directory. Segment
+ * footers locate the blocks of a series, other blocks are not read.
+ */
+static bool visitBlocks(const Options &options,
+                        const std::function<void(const SeriesReader::Block &)> &visit)
+{
+  SeriesReader::Block block;
+  std::string buffer;
+
+  if (std::filesystem::is_directory(options.seriesPath)) {
+    SegmentStore store(options.seriesPath);
+    for (const auto &reader : store.getReaders()) {
+      for (const auto &series : reader->getSeries()) {
+        if (!isSelected(options, series.source, series.entity, series.field)) {
+          continue;
+        }
+        for (const auto &entry : series.blocks) {
+          if (isInRange(options, entry.firstTime, entry.lastTime) &&
+              reader->readBlock(entry, block, buffer)) {
+            visit(block);
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  SeriesReader reader(options.seriesPath);
+  if (!reader.isOpen()) {
+    return false;
+  }
+  for (size_t i = 0; i < reader.getBlockCount(); i++) {
+    if (reader.readBlock(i, block) &&
+        isSelected(options, block.source, block.entity, block.field) &&
+        isInRange(options, block.firstTime, block.lastTime)) {
+      visit(block);
+    }
+  }
+
+  return true;
+}
+
+static bool listSeries(const Options &options)
+{
+  std::map<std::tuple<std::string, std::string, std::string>, Listing> listing;
+  uint64_t blocks = 0;
+
+  auto status = visitBlocks(options, [&listing, &blocks](const SeriesReader::Block &block) {
+    auto &entry = listing
+                      .try_emplace({std::string(block.source),
+                                    std::string(block.entity),
+                                    std::string(block.field)},
+                                   Listing{.type = block.type,
+                                           .blocks = 0,
+                                           .samples = 0,
+                                           .bytes = 0,
+                                           .firstTime = block.firstTime,
+                                           .lastTime = block.lastTime})
+                      .first->second;
+    entry.blocks++;
+    entry.samples += block.count;
+    entry.bytes += block.samples.size();
+    entry.lastTime = block.lastTime;
+    blocks++;
+  });
+  if (!status) {
+    return false;
+  }
+
+  std::cout << "blocks," << blocks << "\n";
+  std::cout << "source,entity,field,type,blocks,samples,bytes,begin,end\n";
+  for (const auto &[key, entry] : listing) {
+    std::cout << std::get<0>(key) << "," << std::get<1>(key) << "," << std::get<2>(key) << ","
+              << typeName(entry.type) << "," << entry.blocks << "," << entry.samples << ","
+              << entry.bytes << "," << entry.firstTime << "," << entry.lastTime << "\n";
+  }
+
+  return true;
+}
+
+static bool querySeries(const Options &options)
+{
+  std::cout << "source,entity,field,system_time,value\n";
+
+  return visitBlocks(options, [&options](const SeriesReader::Block &block) {
+    SeriesDecoder decoder(block.type, block.samples, block.count);
+    uint64_t time;
+    uint64_t value;
+    while (decoder.next(time, value)) {
+      if ((time < options.beginTime) || (time > options.endTime)) {
+        continue;
+      }
+      std::cout << block.source << "," << block.entity << "," << block.field << "," << time
+                << ",";
+      printValue(block.type, value);
+      std::cout << "\n";
+    }
+  });
+}
+
+auto main(int argc, char **argv) -> int
+{
+  Options options{.seriesPath = {},
+                  .source = {},
+                  .entity = {},
+                  .field = {},
+                  .beginTime = 0,
+                  .endTime = std::numeric_limits<uint64_t>::max(),
+                  .list = false};
+  int longIndex = 0;
+  bool version = false;
+  bool help = false;
+  int c;
+
+  struct option longopts[] = {{"list", no_argument, nullptr, 'l'},
+                              {"source", required_argument, nullptr, 's'},
+                              {"entity", required_argument, nullptr, 'n'},
+                              {"field", required_argument, nullptr, 'f'},
+                              {"begin", required_argument, nullptr, 'b'},
+                              {"end", required_argument, nullptr, 'e'},
+                              {"version", no_argument, nullptr, 'v'},
+                              {"help", no_argument, nullptr, 'h'},
+                              {nullptr, 0, nullptr, 0}};
+
+  while ((c = getopt_long(argc, argv, "ls:n:f:b:e:vh", longopts, &longIndex)) != -1) {
+    switch (c) {
+    case 'l':
+      options.list = true;
+      break;
+    case 's':
+      options.source = optarg;
+      break;
+    case 'n':
+      options.entity = optarg;
+      break;
+    case 'f':
+      options.field = optarg;
+      break;
+    case 'b':
+      help = help || !parseTime(optarg, options.beginTime);
+      break;
+    case 'e':
+      help = help || !parseTime(optarg, options.endTime);
+      break;
+    case 'v':
+      version = true;
+      break;
+    default:
+      help = true;
+      break;
+    }
+  }
+
+  if (version) {
+    std::cout << "tkmseries: " << tkmDefaults.getFor(Defaults::Default::Version) << "\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  if (optind + 1 == argc) {
+    options.seriesPath = argv[optind];
+  }
+
+  if (help || options.seriesPath.empty()) {
+    std::cout << "TaskMonitorReader series query: series file or store to csv\n"
+              << "Version: " << tkmDefaults.getFor(Defaults::Default::Version) << "\n\n";
+    std::cout << "Usage: tkmseries [OPTIONS] FILE|STORE\n\n";
+    std::cout << "  Times are system time values or local 'YYYY-MM-DD HH:MM:SS'.\n\n";
+    std::cout << "     --list, -l                List series with block and sample counts\n";
+    std::cout << "     --source, -s    <type>    Select series of a record type\n";
+    std::cout << "     --entity, -n    <key>     Select series of a keyed group entry\n";
+    std::cout << "     --field, -f     <name>    Select series of a field, e.g. 'cpu.all'\n";
+    std::cout << "     --begin, -b     <time>    Skip samples with an earlier system time\n";
+    std::cout << "     --end, -e       <time>    Skip samples with a later system time\n";
+    std::cout << "     --version, -v             Print version\n";
+    std::cout << "     --help, -h                Print this help\n\n";
+    ::exit(EXIT_SUCCESS);
+  }
+
+  auto status = options.list ? listSeries(options) : querySeries(options);
+  if (!status) {
+    std::cerr << "Cannot read series file " << options.seriesPath << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}